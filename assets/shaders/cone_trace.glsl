@@ -0,0 +1,52 @@
+// Voxel cone tracing through the radiance volume (RadianceVolume): rgb =
+// premultiplied radiance of the direct light, a = coverage, over the scene
+// octree bounds with a full mip chain. A cone reads the level whose texels
+// are as wide as the cone at that distance. Included by raycast_common.glsl.
+
+uniform bool u_coneTracing;
+uniform sampler3D u_radianceVolume;
+uniform float u_coneDistance;   // Furthest a cone travels, in voxels
+uniform float u_giStrength;     // Scale of the bounced light
+
+const float DIFFUSE_CONE_APERTURE = 0.577;  // tan(30 degrees): 60 degree cones
+
+// Light (rgb) and occlusion (a) gathered front to back along a cone;
+// aperture is the tangent of its half angle
+vec4 traceCone(vec3 origin, vec3 dir, float aperture) {
+    float extent = u_octreeMax.x - u_octreeMin.x;
+    float texel = extent / float(textureSize(u_radianceVolume, 0).x);
+    float maxLod = float(textureQueryLevels(u_radianceVolume) - 1);
+    vec4 result = vec4(0.0);
+    float t = texel;
+    while (t < u_coneDistance && result.a < 0.95) {
+        float diameter = max(texel, 2.0 * aperture * t);
+        float lod = log2(diameter / texel);
+        if (lod > maxLod) break;
+        vec3 uvw = (origin + dir * t - u_octreeMin) / extent;
+        if (any(lessThan(uvw, vec3(0.0))) || any(greaterThan(uvw, vec3(1.0)))) break;
+        vec4 s = textureLod(u_radianceVolume, uvw, lod);
+
+        // Steps are half a sample wide: correct the coverage for that
+        float alpha = 1.0 - sqrt(max(1.0 - s.a, 0.0));
+        if (s.a > 0.0) result.rgb += (1.0 - result.a) * s.rgb * (alpha / s.a);
+        result.a += (1.0 - result.a) * alpha;
+        t += diameter * 0.5;
+    }
+    return result;
+}
+
+// Cosine-weighted gather over the hemisphere: one cone along the normal and
+// five around it 60 degrees off. rgb = irradiance, a = occlusion.
+vec4 traceDiffuseCones(vec3 pos, vec3 normal) {
+    float texel = (u_octreeMax.x - u_octreeMin.x) / float(textureSize(u_radianceVolume, 0).x);
+    vec3 origin = pos + normal * texel;
+    vec3 t, b;
+    basis(normal, t, b);
+    vec4 result = traceCone(origin, normal, DIFFUSE_CONE_APERTURE) * 0.25;
+    for (int i = 0; i < 5; i++) {
+        float phi = 2.0 * PI * float(i) / 5.0;
+        vec3 dir = normal * 0.5 + (t * cos(phi) + b * sin(phi)) * 0.866;
+        result += traceCone(origin, dir, DIFFUSE_CONE_APERTURE) * 0.15;
+    }
+    return result;
+}
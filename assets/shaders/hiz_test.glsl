@@ -0,0 +1,49 @@
+// ── Hi-Z occlusion (HiZPyramid::bind) ───────────────────────────────────────
+uniform bool u_hizValid;
+uniform sampler2D u_hiz;            // Max linear view depth, one level per halving
+uniform int u_hizLevels;
+uniform mat4 u_hizViewProjection;
+
+// True when the reprojected depth covers the box's whole screen rectangle in
+// front of its nearest corner. Boxes crossing the eye plane are never occluded.
+bool hizOccluded(vec3 bmin, vec3 bmax)
+{
+    if (!u_hizValid) return false;
+    vec2 lo = vec2(1.0);
+    vec2 hi = vec2(0.0);
+    float nearest = 1e30;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = mix(bmin, bmax, bvec3((i & 1) != 0, (i & 2) != 0, (i & 4) != 0));
+        vec4 clip = u_hizViewProjection * vec4(corner, 1.0);
+        if (clip.w <= 0.0) return false;
+        vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+        lo = min(lo, uv);
+        hi = max(hi, uv);
+        nearest = min(nearest, clip.w);
+    }
+
+    // Coarsest level where the rectangle spans at most 2x2 texels; level L
+    // texel i covers level 0 texels [i << L, (i + 1) << L), the last one the rest
+    ivec2 size0 = textureSize(u_hiz, 0);
+    ivec2 p0 = clamp(ivec2(lo * vec2(size0)), ivec2(0), size0 - 1);
+    ivec2 p1 = clamp(ivec2(hi * vec2(size0)), ivec2(0), size0 - 1);
+    int level = 0;
+    ivec2 t0 = p0;
+    ivec2 t1 = p1;
+    for (; level < u_hizLevels; level++) {
+        ivec2 size = textureSize(u_hiz, level);
+        t0 = min(p0 >> level, size - 1);
+        t1 = min(p1 >> level, size - 1);
+        if (all(lessThanEqual(t1 - t0, ivec2(1)))) break;
+    }
+    if (level == u_hizLevels) return false;
+
+    float occluder = 0.0;
+    for (int y = t0.y; y <= t1.y; y++) {
+        for (int x = t0.x; x <= t1.x; x++) {
+            occluder = max(occluder, texelFetch(u_hiz, ivec2(x, y), level).r);
+        }
+    }
+    // Margin for depth buffer precision and the reprojection splat
+    return nearest > occluder * 1.01 + 1.0;
+}
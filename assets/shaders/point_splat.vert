@@ -0,0 +1,29 @@
+#version 460 core
+
+// Debug view: one screen-aligned point per voxel, read from the flat voxel list.
+// Only bound when the point-splat backend is active.
+
+struct VoxelData { vec4 posAndSize; vec4 color; };
+layout(std430, binding = 0) buffer VoxelBuffer
+{
+    int voxelCount;
+    int _pad0; int _pad1; int _pad2;
+    VoxelData voxels[];
+};
+
+uniform mat4 u_viewProjection;
+uniform float u_pointScale;   // viewport height / (2 * tan(fov / 2))
+uniform bool u_useVoxelColor;
+
+out vec3 Color;
+
+void main()
+{
+    VoxelData v = voxels[gl_VertexID];
+    vec3 center = v.posAndSize.xyz + vec3(0.5 * v.posAndSize.w);
+    gl_Position = u_viewProjection * vec4(center, 1.0);
+
+    // Project the voxel side length to pixels
+    gl_PointSize = max(1.0, v.posAndSize.w * u_pointScale / max(gl_Position.w, 1e-3));
+    Color = u_useVoxelColor ? v.color.rgb : vec3(1.0);
+}
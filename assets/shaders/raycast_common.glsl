@@ -0,0 +1,396 @@
+// Shared by raymarching.frag, the deferred passes (visibility.frag,
+// deferred_ao.comp, deferred_lighting.comp) and the compute passes that
+// re-trace camera rays (edge_resolve.comp): scene and debris octree buffers,
+// traversal, shading.
+
+#include "sampling.glsl"
+
+// Camera uniforms
+uniform vec3 u_cameraPos;
+uniform vec3 u_cameraTarget;
+uniform float u_fov;
+uniform vec2 u_resolution;
+uniform mat4 u_viewProjection;      // Same view as getCameraRay(), for the depth output
+uniform bool u_shadow;
+uniform bool u_useVoxelColor;
+uniform int u_aoSampleCount;
+
+// Directional lights (VoxelRenderer::lights), each with its own shadow ray
+const int MAX_LIGHTS = 4;
+uniform int u_lightCount;
+uniform vec3 u_lightDir[MAX_LIGHTS];     // Normalized, towards the light
+uniform vec3 u_lightColor[MAX_LIGHTS];
+
+// Octree bounds (from CPU)
+uniform vec3 u_octreeMin;
+uniform vec3 u_octreeMax;
+const int MAX_AO_SAMPLES = 16;
+const float AO_RADIUS = 4.0;        // Hits further away do not occlude
+
+// Debris cut out of the scene: own octrees in DebrisBuffer, placed by world bounds
+const int MAX_DEBRIS = 32;
+uniform int u_debrisCount;
+// View culling (CPU): the scene is skipped and only the first u_debrisPrimaryCount
+// pieces are tested by primary rays; secondary rays test everything
+uniform bool u_sceneVisible;
+uniform int u_debrisPrimaryCount;
+uniform vec3 u_debrisMin[MAX_DEBRIS];
+uniform vec3 u_debrisMax[MAX_DEBRIS];
+uniform uint u_debrisRoot[MAX_DEBRIS];
+
+// ── SSBO binding 1: compact octree ──────────────────────────────────────────
+// GPUNode layout (matches C++ struct):
+//   childMask : uint  - high 24 bits = index of first child in nodes[]
+//                       low   8 bits = child existence bitmask (bit i = child i exists)
+//   packedColor : uint  - packed RGBA8 (R<<24 | G<<16 | B<<8 | A)
+struct OctreeNode { uint childMask; uint packedColor; };
+layout(std430, binding = 1) buffer OctreeBuffer
+{
+    int nodeCount;
+    int _opad0; int _opad1; int _opad2;
+    OctreeNode nodes[];
+};
+
+// ── SSBO binding 2: debris octrees, same layout ─────────────────────────────
+layout(std430, binding = 2) buffer DebrisBuffer
+{
+    int debrisNodeCount;
+    int _dpad0; int _dpad1; int _dpad2;
+    OctreeNode debrisNodes[];
+};
+
+// ── SSBO binding 8: Hi-Z occlusion of the primary debris pieces ─────────────
+// (instance_cull.comp, one flag per slot below u_debrisPrimaryCount)
+layout(std430, binding = 8) readonly buffer InstanceVisibility
+{
+    uint occludedCount;
+    uint _vpad0; uint _vpad1; uint _vpad2;
+    uint instanceVisible[];
+};
+
+OctreeNode fetchNode(bool debris, uint idx) {
+    return debris ? debrisNodes[idx] : nodes[idx];
+}
+
+// ── Constants ───────────────────────────────────────────────────────────────
+const int   MAX_DEPTH = 16;
+const float EPSILON = 1e-6;
+
+// ── Utility: unpack RGBA8 color ─────────────────────────────────────────────
+#define UNPACK_RGBA(packed) unpackUnorm4x8(packed).abgr
+
+// ── Ray-AABB intersection ───────────────────────────────────────────────────
+// Returns (tMin, tMax). If tMin > tMax, no intersection.
+vec2 rayAABB(vec3 ro, vec3 rd, vec3 bmin, vec3 bmax) {
+    vec3 invDir = 1.0 / (rd + vec3(EPSILON));
+    vec3 t0 = (bmin - ro) * invDir;
+    vec3 t1 = (bmax - ro) * invDir;
+    vec3 tmin = min(t0, t1);
+    vec3 tmax = max(t0, t1);
+    float tNear = max(max(tmin.x, tmin.y), tmin.z);
+    float tFar  = min(min(tmax.x, tmax.y), tmax.z);
+    return vec2(tNear, tFar);
+}
+
+// ── Octree traversal stack entry ────────────────────────────────────────────
+struct StackEntry {
+    uint nodeIdx;
+    vec3 bmin;
+    vec3 bmax;
+    float tEnter;
+    float tExit;
+};
+
+// ── Octree ray casting ──────────────────────────────────────────────────────
+// Node index of the leaf behind the last closer hit traceTree() found
+uint g_hitLeaf = 0u;
+
+// Closest leaf of one tree nearer than closestT. Returns hit color (rgb) and
+// distance (a); if no hit, a = -1 and hitNormal is left as it is.
+vec4 traceTree(bool debris, uint root, vec3 rootMin, vec3 rootMax, vec3 ro, vec3 rd, float closestT,
+               inout vec3 hitNormal) {
+    vec2 tRoot = rayAABB(ro, rd, rootMin, rootMax);
+    if (tRoot.x > tRoot.y || tRoot.y < 0.0 || tRoot.x >= closestT) {
+        return vec4(0.0, 0.0, 0.0, -1.0); // miss
+    }
+
+    // Manual stack for DFS traversal
+    StackEntry stack[64];
+    int sp = 0;
+
+    // Push root
+    stack[sp++] = StackEntry(root, rootMin, rootMax, max(tRoot.x, 0.0), tRoot.y);
+
+    vec4 result = vec4(0.0, 0.0, 0.0, -1.0);
+
+    while (sp > 0) {
+        StackEntry entry = stack[--sp];
+
+        // Skip if this node is farther than current closest hit
+        if (entry.tEnter > closestT) continue;
+
+        OctreeNode node = fetchNode(debris, entry.nodeIdx);
+        uint existMask = node.childMask & 0xFFu;
+
+        // Leaf node: childMask == 0
+        if (existMask == 0u) {
+            // Hit this leaf
+            if (entry.tEnter < closestT) {
+                closestT = entry.tEnter;
+                result = vec4(UNPACK_RGBA(node.packedColor).rgb, entry.tEnter);
+                g_hitLeaf = entry.nodeIdx;
+
+                // Determine entry face from leaf AABB slab test
+                vec3 invDir = 1.0 / rd;
+                vec3 t0 = (entry.bmin - ro) * invDir;
+                vec3 t1 = (entry.bmax - ro) * invDir;
+                vec3 tNearV = min(t0, t1);
+                // The axis with the largest tNear is the entry face
+                if (tNearV.x > tNearV.y && tNearV.x > tNearV.z)
+                    hitNormal = vec3(-sign(rd.x), 0.0, 0.0);
+                else if (tNearV.y > tNearV.z)
+                    hitNormal = vec3(0.0, -sign(rd.y), 0.0);
+                else
+                    hitNormal = vec3(0.0, 0.0, -sign(rd.z));
+            }
+            continue;
+        }
+
+        // Internal node: traverse children
+        uint firstChildIdx = node.childMask >> 8u;
+        vec3 center = (entry.bmin + entry.bmax) * 0.5;
+
+        // Determine ray entry octant to prioritize front-to-back
+        vec3 entryPoint = ro + rd * entry.tEnter;
+        int entryOctant = (entryPoint.x > center.x ? 1 : 0)
+                        | (entryPoint.y > center.y ? 2 : 0)
+                        | (entryPoint.z > center.z ? 4 : 0);
+
+        // Visit children in back-to-front push order so closest ends up on stack top (DFS front-to-back)
+        for (int i = 7; i >= 0; i--) {
+            // Compute child index with XOR to reverse order based on entry octant
+            int childIdx = i ^ entryOctant;
+            if ((existMask & (1u << childIdx)) == 0u) continue;
+
+            // Compute child AABB
+            vec3 cmin = entry.bmin;
+            vec3 cmax = entry.bmax;
+            if ((childIdx & 1) != 0) { cmin.x = center.x; } else { cmax.x = center.x; }
+            if ((childIdx & 2) != 0) { cmin.y = center.y; } else { cmax.y = center.y; }
+            if ((childIdx & 4) != 0) { cmin.z = center.z; } else { cmax.z = center.z; }
+
+            vec2 tChild = rayAABB(ro, rd, cmin, cmax);
+            if (tChild.x <= tChild.y && tChild.y >= 0.0 && tChild.x < closestT) {
+                // Count existing children before this one to find its index in nodes[]
+                uint childOffset = 0u;
+                for (int j = 0; j < childIdx; j++) {
+                    if ((existMask & (1u << j)) != 0u) childOffset++;
+                }
+                uint childNodeIdx = firstChildIdx + childOffset;
+
+                // Push to stack (DFS)
+                if (sp < 64) {
+                    stack[sp++] = StackEntry(childNodeIdx, cmin, cmax, max(tChild.x, 0.0), tChild.y);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// Returns hit color (rgb) and distance (a) over the scene and the debris
+// pieces (only the visible candidates for primary rays). If no hit, a = -1.
+// hitNormal is set to the entry face normal on hit.
+// Object of the last traceOctree() hit: 0 = scene, 1 + slot for debris
+int g_hitObject = 0;
+
+vec4 traceOctree(vec3 ro, vec3 rd, bool primary, out vec3 hitNormal) {
+    hitNormal = vec3(0.0);
+    vec4 result = vec4(0.0, 0.0, 0.0, -1.0);
+    float closestT = 1e10;
+    g_hitObject = 0;
+    if (nodeCount > 0 && (u_sceneVisible || !primary)) {
+        result = traceTree(false, 0u, u_octreeMin, u_octreeMax, ro, rd, closestT, hitNormal);
+        if (result.a >= 0.0) closestT = result.a;
+    }
+    int debrisCount = primary ? u_debrisPrimaryCount : u_debrisCount;
+    for (int i = 0; i < debrisCount; i++) {
+        if (primary && instanceVisible[i] == 0u) continue;
+        vec4 hit = traceTree(true, u_debrisRoot[i], u_debrisMin[i], u_debrisMax[i], ro, rd, closestT, hitNormal);
+        if (hit.a >= 0.0) {
+            result = hit;
+            closestT = hit.a;
+            g_hitObject = 1 + i;
+        }
+    }
+    return result;
+}
+
+bool shadowTree(bool debris, uint root, vec3 rootMin, vec3 rootMax, vec3 ro, vec3 rd) {
+    vec2 tRoot = rayAABB(ro, rd, rootMin, rootMax);
+    if (tRoot.x > tRoot.y || tRoot.y < 0.0) {
+        return false;
+    }
+
+    StackEntry stack[64];
+    int sp = 0;
+    stack[sp++] = StackEntry(root, rootMin, rootMax, max(tRoot.x, 0.0), tRoot.y);
+
+    while (sp > 0) {
+        StackEntry entry = stack[--sp];
+        OctreeNode node = fetchNode(debris, entry.nodeIdx);
+        uint existMask = node.childMask & 0xFFu;
+        if (existMask == 0u) { // leaf
+            return true;
+        }
+        uint firstChildIdx = node.childMask >> 8u;
+        vec3 center = (entry.bmin + entry.bmax) * 0.5;
+        vec3 entryPoint = ro + rd * entry.tEnter;
+        int entryOctant = (entryPoint.x > center.x ? 1 : 0)
+                        | (entryPoint.y > center.y ? 2 : 0)
+                        | (entryPoint.z > center.z ? 4 : 0);
+        for (int i = 7; i >= 0; i--) {
+            int childIdx = i ^ entryOctant;
+            if ((existMask & (1u << childIdx)) == 0u) continue;
+            vec3 cmin = entry.bmin;
+            vec3 cmax = entry.bmax;
+            if ((childIdx & 1) != 0) { cmin.x = center.x; } else { cmax.x = center.x; }
+            if ((childIdx & 2) != 0) { cmin.y = center.y; } else { cmax.y = center.y; }
+            if ((childIdx & 4) != 0) { cmin.z = center.z; } else { cmax.z = center.z; }
+            vec2 tChild = rayAABB(ro, rd, cmin, cmax);
+            if (tChild.x <= tChild.y && tChild.y >= 0.0) {
+                uint childOffset = 0u;
+                for (int j = 0; j < childIdx; j++) {
+                    if ((existMask & (1u << j)) != 0u) childOffset++;
+                }
+                uint childNodeIdx = firstChildIdx + childOffset;
+                if (sp < 64) {
+                    stack[sp++] = StackEntry(childNodeIdx, cmin, cmax, max(tChild.x, 0.0), tChild.y);
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool traceShadow(vec3 ro, vec3 rd) {
+    if (nodeCount > 0 && shadowTree(false, 0u, u_octreeMin, u_octreeMax, ro, rd)) return true;
+    for (int i = 0; i < u_debrisCount; i++) {
+        if (shadowTree(true, u_debrisRoot[i], u_debrisMin[i], u_debrisMax[i], ro, rd)) return true;
+    }
+    return false;
+}
+
+// Fraction of u_aoSampleCount cosine-distributed rays blocked within
+// AO_RADIUS; the rays are the first Sobol points rotated by shift
+float aoShifted(vec3 pos, vec3 norm, vec2 shift) {
+    int count = min(u_aoSampleCount, MAX_AO_SAMPLES);
+    if (count <= 0) return 0.0;
+    vec3 origin = pos + norm * 0.02;
+    int hits = 0;
+    for (int i = 0; i < count; i++) {
+        vec3 dir = cosineHemisphere(fract(sobol(uint(i)) + shift), norm);
+        vec3 dummy;
+        vec4 hit = traceOctree(origin, dir, false, dummy);
+        if (hit.a >= 0.0 && hit.a < AO_RADIUS) hits++;
+    }
+    return float(hits) / float(count);
+}
+
+// One ray set per voxel cell: stable, blocky noise
+float ao(vec3 pos, vec3 norm) {
+    return aoShifted(pos, norm, cellShift(floor(pos)));
+}
+
+// One ray set per pixel from the blue noise mask, for the AO denoiser
+float aoPixel(vec3 pos, vec3 norm, ivec2 pixel) {
+    return aoShifted(pos, norm, blueNoiseShift(pixel));
+}
+
+// ── Camera ray ──────────────────────────────────────────────────────────────
+vec3 getCameraRay(vec2 uv, vec3 camPos, vec3 camTarget, float fov) {
+    vec3 forward = normalize(camTarget - camPos);
+    vec3 right = normalize(cross(vec3(0.0, 1.0, 0.0), forward));
+    vec3 up = cross(forward, right);
+
+    float aspect = u_resolution.x / u_resolution.y;
+    float fovRad = radians(fov);
+    vec2 ndc = uv * 2.0 - 1.0;
+    ndc.x *= aspect;
+
+    return normalize(forward + ndc.x * right * tan(fovRad * 0.5) + ndc.y * up * tan(fovRad * 0.5));
+}
+
+// Axis-aligned normals as face indices: +x, -x, +y, -y, +z, -z
+uint faceIndex(vec3 normal) {
+    int axis = abs(normal.x) > 0.5 ? 0 : (abs(normal.y) > 0.5 ? 1 : 2);
+    return uint(axis * 2) + (normal[axis] < 0.0 ? 1u : 0u);
+}
+
+vec3 faceNormal(uint face) {
+    vec3 normal = vec3(0.0);
+    normal[face >> 1] = (face & 1u) != 0u ? -1.0 : 1.0;
+    return normal;
+}
+
+// Surface id for edge detection: object, face and the plane the face lies
+// in, so pixels on one flat face share it; 0 = background. Call right after
+// the traceOctree() that produced hit.
+uint hitSurfaceId(vec3 ro, vec3 rd, vec4 hit, vec3 normal) {
+    if (hit.a < 0.0) return 0u;
+    vec3 p = ro + rd * hit.a;
+    int axis = abs(normal.x) > 0.5 ? 0 : (abs(normal.y) > 0.5 ? 1 : 2);
+    uint face = faceIndex(normal);
+    uint plane = uint(int(floor(p[axis] + 0.5))) & 0x7FFFFFu;
+    return (uint(g_hitObject + 1) << 26) | (face << 23) | plane;
+}
+
+// ── Shading ─────────────────────────────────────────────────────────────────
+#include "cone_trace.glsl"
+
+vec3 backgroundColor(vec2 uv) {
+    return mix(vec3(0.15, 0.2, 0.35), vec3(0.4, 0.5, 0.6), uv.y);
+}
+
+vec3 surfaceAlbedo(vec3 albedo) {
+    return u_useVoxelColor ? albedo : vec3(1.0);
+}
+
+// Light from every light the point faces that no shadow ray blocks
+vec3 directLight(vec3 pos, vec3 normal) {
+    vec3 light = vec3(0.0);
+    for (int i = 0; i < MAX_LIGHTS; i++) {
+        if (i >= u_lightCount) break;
+        float diff = max(dot(normal, u_lightDir[i]), 0.0);
+        if (diff <= 0.0) continue;
+        if (u_shadow && traceShadow(pos + u_lightDir[i] * 0.02, u_lightDir[i])) continue;
+        light += u_lightColor[i] * diff * 0.7;
+    }
+    return light;
+}
+
+// Ambient plus direct light, all darkened by the occlusion from ao()
+vec3 shadeSurface(vec3 pos, vec3 normal, vec3 albedo, float occlusion) {
+    return surfaceAlbedo(albedo) * (vec3(0.3) + directLight(pos, normal)) * (1.0 - 0.5 * occlusion);
+}
+
+// With cone tracing: the ambient term occluded by the diffuse cones, plus the
+// light they gather from the radiance volume, plus direct light
+vec3 shadeSurfaceCones(vec3 pos, vec3 normal, vec3 albedo) {
+    vec4 cones = traceDiffuseCones(pos, normal);
+    vec3 ambient = vec3(0.3) * (1.0 - cones.a) + cones.rgb * u_giStrength;
+    return surfaceAlbedo(albedo) * (ambient + directLight(pos, normal));
+}
+
+// Color of the camera ray through uv; hit as from traceOctree
+vec3 shadeCameraRay(vec2 uv, vec3 ro, vec3 rd, out vec4 hit, out uint surfaceId) {
+    vec3 normal;
+    hit = traceOctree(ro, rd, true, normal);
+    surfaceId = hitSurfaceId(ro, rd, hit, normal);
+    if (hit.a < 0.0) return backgroundColor(uv);
+
+    vec3 pos = ro + rd * hit.a;
+    if (u_coneTracing) return shadeSurfaceCones(pos, normal, hit.rgb);
+    return shadeSurface(pos, normal, hit.rgb, ao(pos, normal));
+}
@@ -0,0 +1,65 @@
+// Sample points for AO rays, mirrored by Sampling in sampling.cpp; keep the
+// two in step. A ray set is the first points of a 2D Sobol sequence, rotated
+// modulo 1 by a per-pixel blue noise shift (BlueNoise) plus an R2 offset per
+// frame, or by a hash of the voxel cell, and mapped to cosine-distributed
+// directions.
+
+uniform sampler2D u_blueNoise;  // Two independent void-and-cluster masks in r and g
+uniform uint u_noiseFrame;      // Frame offset of the blue noise shift, 0 = the same rays every frame
+
+const float PI = 3.14159265358979;
+const float UNIT_24 = 1.0 / 16777216.0;  // 24-bit fixed point to [0, 1)
+
+// First two Sobol dimensions; every power-of-two prefix is stratified
+vec2 sobol(uint index) {
+    uint y = 0u;
+    for (uint i = index, v = 1u << 31; i != 0u; i >>= 1, v ^= v >> 1) {
+        if ((i & 1u) != 0u) y ^= v;
+    }
+    return vec2(bitfieldReverse(index) >> 8, y >> 8) * UNIT_24;
+}
+
+// R2 sequence (Roberts 2018) in 32-bit fixed point
+vec2 r2(uint index) {
+    return vec2((index * 3242174890u) >> 8, (index * 2447445414u) >> 8) * UNIT_24;
+}
+
+uint mixBits(uint h) {
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Shift of a voxel cell's ray set
+vec2 cellShift(vec3 cell) {
+    ivec3 c = ivec3(floor(cell));
+    uint h = mixBits(uint(c.x) * 73856093u ^ uint(c.y) * 19349663u ^ uint(c.z) * 83492791u);
+    return vec2(h >> 8, mixBits(h) >> 8) * UNIT_24;
+}
+
+// Shift of a pixel's ray set in frame u_noiseFrame
+vec2 blueNoiseShift(ivec2 pixel) {
+    ivec2 size = textureSize(u_blueNoise, 0);
+    return fract(texelFetch(u_blueNoise, pixel & (size - 1), 0).rg + r2(u_noiseFrame));
+}
+
+// Orthonormal basis around n (Duff et al. 2017)
+void basis(vec3 n, out vec3 t, out vec3 b) {
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float c = n.x * n.y * a;
+    t = vec3(1.0 + s * n.x * n.x * a, s * c, -s * n.x);
+    b = vec3(c, s + n.y * n.y * a, -n.y);
+}
+
+// u in [0, 1)^2 to a direction around n with density cos(theta) / pi
+vec3 cosineHemisphere(vec2 u, vec3 n) {
+    vec3 t, b;
+    basis(n, t, b);
+    float r = sqrt(u.x);
+    float phi = 2.0 * PI * u.y;
+    return t * (r * cos(phi)) + b * (r * sin(phi)) + n * sqrt(max(1.0 - u.x, 0.0));
+}
@@ -0,0 +1,51 @@
+#version 460 core
+
+// Deferred shading step 1 (see DeferredShading): traverse only. Hits leave
+// their distance, leaf and surface id in the G-buffer and are appended to the
+// hit list that deferred_ao.comp and deferred_lighting.comp run over;
+// misses get the background color right away.
+
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out uint SurfaceId;
+layout(location = 2) out float HitDistance;
+layout(location = 3) out uvec2 HitLeaf;      // Leaf node index, object << 3 | face
+
+layout(std430, binding = 10) buffer HitList
+{
+    uint groupsX;       // DispatchIndirectCommand of the shading passes
+    uint groupsY;
+    uint groupsZ;
+    uint hitCount;
+    uint hits[];        // x | y << 16
+};
+
+const uint SHADE_GROUP_SIZE = 64u;   // local_size_x of deferred_ao.comp / deferred_lighting.comp
+
+#include "raycast_common.glsl"
+
+void main() {
+    // Pixel centers, exactly as the shading passes reconstruct them
+    vec2 uv = gl_FragCoord.xy / u_resolution;
+    vec3 ro = u_cameraPos;
+    vec3 rd = getCameraRay(uv, u_cameraPos, u_cameraTarget, u_fov);
+
+    vec3 normal;
+    vec4 hit = traceOctree(ro, rd, true, normal);
+    SurfaceId = hitSurfaceId(ro, rd, hit, normal);
+    HitDistance = hit.a;
+    if (hit.a < 0.0) {
+        FragColor = vec4(backgroundColor(uv), 1.0);
+        HitLeaf = uvec2(0u);
+        gl_FragDepth = 1.0;
+        return;
+    }
+    FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    HitLeaf = uvec2(g_hitLeaf, (uint(g_hitObject) << 3) | faceIndex(normal));
+
+    vec4 clip = u_viewProjection * vec4(ro + rd * hit.a, 1.0);
+    gl_FragDepth = clamp(clip.z / clip.w * 0.5 + 0.5, 0.0, 1.0);
+
+    uint index = atomicAdd(hitCount, 1u);
+    hits[index] = uint(gl_FragCoord.x) | (uint(gl_FragCoord.y) << 16);
+    if (index % SHADE_GROUP_SIZE == 0u) atomicAdd(groupsX, 1u);
+}
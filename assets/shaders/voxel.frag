@@ -1,12 +1,15 @@
 #version 460 core
 
-// Input from vertex shader
 in vec3 Color;
+flat in vec3 Normal;
+in float Occlusion;
 
-// Output color
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(Color, 1.0);
+    vec3 lightDir = normalize(vec3(1.0, 1.0, -1.0));
+    float diff = max(dot(Normal, lightDir), 0.0);
+    float ambient = 0.3 * mix(0.4, 1.0, Occlusion);
+    FragColor = vec4(Color * (ambient + diff * 0.7), 1.0);
 }
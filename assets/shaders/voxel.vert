@@ -1,28 +1,61 @@
-#version 330 core
+#version 460 core
 
-// Vertex position
-layout (location = 0) in vec3 aPos;
-// Vertex color
-layout (location = 1) in vec3 aColor;
+// Packed chunk mesh vertex (see MeshVertex in chunk_mesher.h): one quad
+// corner per vertex, relative to the chunk of this draw
+layout (location = 0) in uvec2 aPacked;
+
+struct ChunkInfo {
+    vec4 boundsMin;
+    vec4 boundsMax;
+    ivec4 origin;
+    uint indexCount;
+    uint baseVertex;
+    uint _pad0;
+    uint _pad1;
+};
+// The cull pass stores the chunk index as the draw's base instance
+layout(std430, binding = 3) readonly buffer Chunks { ChunkInfo chunks[]; };
+layout(std430, binding = 6) readonly buffer Palette { uint palette[]; };
 
-// Output to fragment shader
 out vec3 Color;
+flat out vec3 Normal;
+out float Occlusion;
 
-// View-projection matrix
-uniform mat4 viewProjection;
+uniform mat4 u_viewProjection;
+uniform bool u_useVoxelColor;
 
-struct Node {
-    uint childrenMask; // 8位，标记哪个子象限有物体
-    uint childPointer; // 指向子节点在数组中的起始索引
-    vec4 color;        // 当前节点的颜色（或平均色）
-};
-
-layout(std430, binding = 0) buffer OctreeData {
-    Node nodes[]; // 整个八叉树被压扁在这个数组里
-};
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1)
+);
 
 void main()
 {
-    gl_Position = viewProjection * vec4(aPos, 1.0);
-    Color = aColor;
+    uint cellBits = aPacked.x;
+    uvec3 cell = uvec3(cellBits, cellBits >> 6, cellBits >> 12) & 63u;
+    uint face = (cellBits >> 18) & 7u;
+    uint corner = (cellBits >> 21) & 3u;
+    uint ao = (cellBits >> 23) & 3u;
+    uint paletteIndex = aPacked.y & 0xFFFFu;
+    vec2 size = vec2((aPacked.y >> 16) & 31u, (aPacked.y >> 21) & 31u) + 1.0;
+
+    // Corner in the face's (u, v) tangent plane, wound counter-clockwise;
+    // negative faces swap u and v to keep the winding seen from outside
+    uint axis = face >> 1;
+    bool negative = (face & 1u) != 0u;
+    vec2 uv = vec2(corner == 1u || corner == 2u, corner >= 2u);
+    if (negative) uv = uv.yx;
+
+    vec3 local = vec3(cell);
+    local[axis] += negative ? 0.0 : 1.0;
+    local[(axis + 1u) % 3u] += uv.x * size.x;
+    local[(axis + 2u) % 3u] += uv.y * size.y;
+
+    vec3 worldPos = vec3(chunks[gl_BaseInstance].origin.xyz) + local;
+    gl_Position = u_viewProjection * vec4(worldPos, 1.0);
+
+    uint rgba = palette[paletteIndex];
+    vec3 color = vec3((rgba >> 24) & 255u, (rgba >> 16) & 255u, (rgba >> 8) & 255u) / 255.0;
+    Color = u_useVoxelColor ? color : vec3(1.0);
+    Normal = FACE_NORMALS[face];
+    Occlusion = float(ao) / 3.0;
 }
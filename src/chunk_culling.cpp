@@ -0,0 +1,129 @@
+/**
+ * Chunk Culling Implementation
+ */
+
+#include "chunk_culling.h"
+#include "profiler.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CHUNK_CULLING_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+enum class Verdict { Visible, FrustumCulled, DistanceCulled };
+
+/**
+ * One box at a time: the box is outside when its corner farthest along a
+ * plane normal (the p-vertex) is behind that plane
+ */
+Verdict classifyBox(const Frustum& frustum, const glm::vec3& eye, float maxDistance2,
+                    const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    for (const glm::vec4& plane : frustum.planes) {
+        glm::vec3 p(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                    plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                    plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) return Verdict::FrustumCulled;
+    }
+    if (maxDistance2 > 0.0f) {
+        glm::vec3 d = glm::clamp(eye, boxMin, boxMax) - eye;
+        if (glm::dot(d, d) > maxDistance2) return Verdict::DistanceCulled;
+    }
+    return Verdict::Visible;
+}
+
+} // namespace
+
+Frustum Frustum::fromViewProjection(const glm::mat4& m) {
+    // Gribb-Hartmann: rows of the matrix combined with the w row
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    Frustum frustum;
+    frustum.planes[0] = row[3] + row[0];    // Left
+    frustum.planes[1] = row[3] - row[0];    // Right
+    frustum.planes[2] = row[3] + row[1];    // Bottom
+    frustum.planes[3] = row[3] - row[1];    // Top
+    frustum.planes[4] = row[3] + row[2];    // Near
+    frustum.planes[5] = row[3] - row[2];    // Far
+    for (glm::vec4& plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+void ChunkCuller::clear() {
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void ChunkCuller::reserve(size_t count) {
+    minX.reserve(count); minY.reserve(count); minZ.reserve(count);
+    maxX.reserve(count); maxY.reserve(count); maxZ.reserve(count);
+}
+
+uint32_t ChunkCuller::add(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    minX.push_back(boxMin.x); minY.push_back(boxMin.y); minZ.push_back(boxMin.z);
+    maxX.push_back(boxMax.x); maxY.push_back(boxMax.y); maxZ.push_back(boxMax.z);
+    return static_cast<uint32_t>(minX.size() - 1);
+}
+
+CullStats ChunkCuller::cull(const Frustum& frustum, const glm::vec3& eye, float maxDistance,
+                            std::vector<uint32_t>& visible) const {
+    PROFILE_FUNCTION();
+    CullStats stats;
+    const size_t count = size();
+    stats.total = static_cast<int>(count);
+    visible.clear();
+    const float maxDistance2 = maxDistance > 0.0f ? maxDistance * maxDistance : 0.0f;
+
+    size_t i = 0;
+#ifdef CHUNK_CULLING_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eyeX = _mm_set1_ps(eye.x);
+    const __m128 eyeY = _mm_set1_ps(eye.y);
+    const __m128 eyeZ = _mm_set1_ps(eye.z);
+    const __m128 limit = _mm_set1_ps(maxDistance2);
+    for (; i + 4 <= count; i += 4) {
+        __m128 loX = _mm_loadu_ps(&minX[i]), loY = _mm_loadu_ps(&minY[i]), loZ = _mm_loadu_ps(&minZ[i]);
+        __m128 hiX = _mm_loadu_ps(&maxX[i]), hiY = _mm_loadu_ps(&maxY[i]), hiZ = _mm_loadu_ps(&maxZ[i]);
+
+        // Lanes with any p-vertex behind a plane are outside; the p-vertex
+        // corner is picked per plane, so the selects are outside the SIMD math
+        __m128 outside = _mm_setzero_ps();
+        for (const glm::vec4& plane : frustum.planes) {
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane.x >= 0.0f ? hiX : loX, _mm_set1_ps(plane.x)),
+                           _mm_mul_ps(plane.y >= 0.0f ? hiY : loY, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(plane.z >= 0.0f ? hiZ : loZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+        }
+        int outsideMask = _mm_movemask_ps(outside);
+
+        // Squared distance from the eye to the closest point of each box
+        int farMask = 0;
+        if (maxDistance2 > 0.0f) {
+            __m128 dx = _mm_sub_ps(_mm_min_ps(_mm_max_ps(eyeX, loX), hiX), eyeX);
+            __m128 dy = _mm_sub_ps(_mm_min_ps(_mm_max_ps(eyeY, loY), hiY), eyeY);
+            __m128 dz = _mm_sub_ps(_mm_min_ps(_mm_max_ps(eyeZ, loZ), hiZ), eyeZ);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            farMask = _mm_movemask_ps(_mm_cmpgt_ps(d2, limit));
+        }
+
+        for (int lane = 0; lane < 4; ++lane) {
+            if (outsideMask & (1 << lane)) ++stats.frustumCulled;
+            else if (farMask & (1 << lane)) ++stats.distanceCulled;
+            else visible.push_back(static_cast<uint32_t>(i + lane));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        switch (classifyBox(frustum, eye, maxDistance2, glm::vec3(minX[i], minY[i], minZ[i]),
+                            glm::vec3(maxX[i], maxY[i], maxZ[i]))) {
+        case Verdict::Visible: visible.push_back(static_cast<uint32_t>(i)); break;
+        case Verdict::FrustumCulled: ++stats.frustumCulled; break;
+        case Verdict::DistanceCulled: ++stats.distanceCulled; break;
+        }
+    }
+    stats.visible = static_cast<int>(visible.size());
+    return stats;
+}
@@ -0,0 +1,62 @@
+/**
+ * Chunk Culling
+ *
+ * View frustum and distance culling for scenes split into chunks or
+ * instances. Bounding boxes are kept as structure-of-arrays so the plane
+ * tests run four boxes per SSE instruction (scalar fallback elsewhere); the
+ * result is a compact list of visible box indices.
+ */
+
+#ifndef CHUNK_CULLING_H
+#define CHUNK_CULLING_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Six inward-facing planes (xyz = normal, w = offset): a point p is inside
+ * when dot(plane.xyz, p) + plane.w >= 0 for all of them
+ */
+struct Frustum {
+    glm::vec4 planes[6];
+
+    /**
+     * Extract the planes of a projection * view matrix (OpenGL clip space)
+     */
+    static Frustum fromViewProjection(const glm::mat4& viewProjection);
+};
+
+struct CullStats {
+    int total = 0;
+    int visible = 0;
+    int frustumCulled = 0;
+    int distanceCulled = 0;     // Inside the frustum but farther than the cull distance
+    int occlusionCulled = 0;    // Hidden behind the Hi-Z depth (GPU culling only, see HiZPyramid)
+};
+
+class ChunkCuller {
+public:
+    void clear();
+    void reserve(size_t count);
+    /**
+     * Add the box [boxMin, boxMax]
+     * @return Its index
+     */
+    uint32_t add(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    size_t size() const { return minX.size(); }
+
+    /**
+     * Replace visible with the indices of the boxes that intersect the
+     * frustum and lie within maxDistance of eye (maxDistance <= 0: no limit),
+     * in increasing order
+     */
+    CullStats cull(const Frustum& frustum, const glm::vec3& eye, float maxDistance,
+                   std::vector<uint32_t>& visible) const;
+
+private:
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+};
+
+#endif // CHUNK_CULLING_H
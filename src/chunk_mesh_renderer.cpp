@@ -0,0 +1,186 @@
+/**
+ * Chunk Mesh Renderer Implementation
+ */
+
+#include "chunk_mesh_renderer.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr uint32_t CULL_GROUP_SIZE = 64;   // local_size_x of chunk_cull.comp
+constexpr uint32_t MAX_CULL_GROUPS = 65535;
+
+// DrawElementsIndirectCommand
+struct DrawCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+void allocBuffer(GLuint& buffer, GLenum target, size_t bytes, const void* data, GLenum usage) {
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, bytes, data, usage);
+    MemoryStats::trackGLBuffer(buffer, MemoryTag::GpuMeshBuffer, bytes);
+}
+
+} // namespace
+
+ChunkMeshRenderer::ChunkMeshRenderer()
+    : drawShader(nullptr)
+    , cullShader(nullptr)
+    , vao(0)
+    , vertexBuffer(0)
+    , indexBuffer(0)
+    , chunkBuffer(0)
+    , paletteBuffer(0)
+    , commandBuffer(0)
+    , counterBuffer(0)
+    , chunkCount(0)
+{
+}
+
+ChunkMeshRenderer::~ChunkMeshRenderer()
+{
+    cleanup();
+}
+
+void ChunkMeshRenderer::init()
+{
+    drawShader = new Shader("assets/shaders/voxel.vert", "assets/shaders/voxel.frag");
+    cullShader = new Shader("assets/shaders/chunk_cull.comp");
+
+    glGenVertexArrays(1, &vao);
+    allocBuffer(counterBuffer, GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t) * 4, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    readback.init(sizeof(uint32_t) * 4, MemoryTag::GpuMeshBuffer);
+}
+
+void ChunkMeshRenderer::cleanup()
+{
+    release();
+    freeGLBuffer(counterBuffer);
+    readback.cleanup();
+    if (vao != 0) { glDeleteVertexArrays(1, &vao); vao = 0; }
+    delete drawShader; drawShader = nullptr;
+    delete cullShader; cullShader = nullptr;
+}
+
+void ChunkMeshRenderer::release()
+{
+    freeGLBuffer(vertexBuffer);
+    freeGLBuffer(indexBuffer);
+    freeGLBuffer(chunkBuffer);
+    freeGLBuffer(paletteBuffer);
+    freeGLBuffer(commandBuffer);
+    chunkCount = 0;
+    stats = CullStats();
+}
+
+void ChunkMeshRenderer::upload(const std::vector<ChunkMesh>& meshes, const std::vector<uint32_t>& palette)
+{
+    PROFILE_FUNCTION();
+    release();
+    if (meshes.empty() || vao == 0) return;
+
+    // One vertex buffer, each chunk at its own base vertex
+    size_t totalVertices = 0;
+    size_t maxQuads = 0;
+    std::vector<GPUChunk> chunks;
+    chunks.reserve(meshes.size());
+    for (const ChunkMesh& mesh : meshes) {
+        size_t quads = mesh.vertices.size() / 4;
+        chunks.push_back(GPUChunk{glm::vec4(mesh.boundsMin, 0.0f), glm::vec4(mesh.boundsMax, 0.0f),
+                                  glm::ivec4(mesh.origin, 0), static_cast<uint32_t>(quads * 6),
+                                  static_cast<uint32_t>(totalVertices), {0, 0}});
+        totalVertices += mesh.vertices.size();
+        maxQuads = std::max(maxQuads, quads);
+    }
+    allocBuffer(vertexBuffer, GL_ARRAY_BUFFER, totalVertices * sizeof(MeshVertex), nullptr, GL_STATIC_DRAW);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        glBufferSubData(GL_ARRAY_BUFFER, chunks[i].baseVertex * sizeof(MeshVertex),
+                        meshes[i].vertices.size() * sizeof(MeshVertex), meshes[i].vertices.data());
+    }
+
+    // Shared quad pattern (0, 1, 2), (0, 2, 3) for the largest chunk
+    std::vector<uint32_t> indices(maxQuads * 6);
+    for (size_t q = 0; q < maxQuads; ++q) {
+        uint32_t v = static_cast<uint32_t>(q * 4);
+        uint32_t* out = indices.data() + q * 6;
+        out[0] = v; out[1] = v + 1; out[2] = v + 2;
+        out[3] = v; out[4] = v + 2; out[5] = v + 3;
+    }
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    allocBuffer(indexBuffer, GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(MeshVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunkCount = static_cast<uint32_t>(std::min<size_t>(chunks.size(), size_t(MAX_CULL_GROUPS) * CULL_GROUP_SIZE));
+    allocBuffer(chunkBuffer, GL_SHADER_STORAGE_BUFFER, chunkCount * sizeof(GPUChunk), chunks.data(), GL_STATIC_DRAW);
+    allocBuffer(commandBuffer, GL_SHADER_STORAGE_BUFFER, chunkCount * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+    allocBuffer(paletteBuffer, GL_SHADER_STORAGE_BUFFER, palette.size() * sizeof(uint32_t), palette.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ChunkMeshRenderer::render(const glm::mat4& viewProjection, const Frustum& frustum, const glm::vec3& eye,
+                               float maxDistance, bool culling, const HiZPyramid& hiz, bool occlusion,
+                               bool useVoxelColor)
+{
+    PROFILE_FUNCTION();
+    if (chunkCount == 0) return;
+
+    // Cull: one invocation per chunk appends its draw command
+    const uint32_t zero[4] = {0, 0, 0, 0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    cullShader->use();
+    cullShader->setUint("u_chunkCount", chunkCount);
+    cullShader->setBool("u_culling", culling);
+    for (int i = 0; i < 6; ++i) cullShader->setVec4("u_planes[" + std::to_string(i) + "]", frustum.planes[i]);
+    cullShader->setVec3("u_eye", eye);
+    cullShader->setFloat("u_maxDistance2", maxDistance > 0.0f ? maxDistance * maxDistance : 0.0f);
+    hiz.bind(*cullShader, 0, occlusion);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_INFO_BINDING, chunkBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_COMMAND_BINDING, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_COUNTER_BINDING, counterBuffer);
+    glDispatchCompute((chunkCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    uint32_t counters[4];
+    if (readback.readback(counterBuffer, 0, counters)) {
+        stats.total = static_cast<int>(chunkCount);
+        stats.visible = static_cast<int>(counters[0]);
+        stats.frustumCulled = static_cast<int>(counters[1]);
+        stats.distanceCulled = static_cast<int>(counters[2]);
+        stats.occlusionCulled = static_cast<int>(counters[3]);
+    }
+
+    // Draw: the GPU reads both the commands and their count
+    drawShader->use();
+    drawShader->setMat4("u_viewProjection", viewProjection);
+    drawShader->setBool("u_useVoxelColor", useVoxelColor);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_INFO_BINDING, chunkBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_PALETTE_BINDING, paletteBuffer);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, counterBuffer);
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(chunkCount), 0);
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,96 @@
+/**
+ * Chunk Mesh Renderer
+ *
+ * GPU-driven raster path for chunked voxel meshes (see ChunkMesher). All
+ * chunk meshes live in one vertex buffer of packed 8-byte vertices, each
+ * chunk a contiguous range addressed by its base vertex; quads share one
+ * index pattern sized for the largest chunk. Vertices are chunk-local: the
+ * vertex shader finds the chunk origin through the draw's base instance,
+ * which the cull pass sets to the chunk index, and the color in a palette
+ * buffer. Every frame a compute pass (chunk_cull.comp) tests the
+ * chunk bounds against the view frustum, cull distance and the Hi-Z depth
+ * pyramid (HiZPyramid) and appends a
+ * DrawElementsIndirectCommand per visible chunk, and a single
+ * glMultiDrawElementsIndirectCount draws them: CPU submission cost does not
+ * depend on the chunk count.
+ *
+ * The culling counters are copied into a small ring of buffers and read back
+ * READBACK_LATENCY frames later so the CPU never waits for the GPU.
+ */
+
+#ifndef CHUNK_MESH_RENDERER_H
+#define CHUNK_MESH_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "chunk_culling.h"
+#include "chunk_mesher.h"
+#include "gl_utils.h"
+#include "hiz_culling.h"
+#include "shader.h"
+
+// SSBO binding points of chunk_cull.comp
+constexpr GLuint CHUNK_INFO_BINDING = 3;
+constexpr GLuint CHUNK_COMMAND_BINDING = 4;
+constexpr GLuint CHUNK_COUNTER_BINDING = 5;
+// Palette of voxel.vert
+constexpr GLuint CHUNK_PALETTE_BINDING = 6;
+
+class ChunkMeshRenderer {
+public:
+    ChunkMeshRenderer();
+    ~ChunkMeshRenderer();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Upload new chunk meshes and the palette their vertices index,
+     * replacing the previous ones
+     */
+    void upload(const std::vector<ChunkMesh>& meshes, const std::vector<uint32_t>& palette);
+    void release();
+    bool empty() const { return chunkCount == 0; }
+
+    /**
+     * Cull on the GPU and draw the visible chunks
+     * @param culling false draws every chunk (the compute pass still writes the commands)
+     * @param maxDistance cull distance, <= 0 for none
+     * @param occlusion also test chunks against hiz (built for viewProjection)
+     */
+    void render(const glm::mat4& viewProjection, const Frustum& frustum, const glm::vec3& eye, float maxDistance,
+                bool culling, const HiZPyramid& hiz, bool occlusion, bool useVoxelColor);
+
+    /**
+     * Counters of the frame READBACK_LATENCY frames ago
+     */
+    const CullStats& getStats() const { return stats; }
+
+private:
+    // GPU-side chunk record (matches ChunkInfo in chunk_cull.comp and voxel.vert)
+    struct GPUChunk {
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        glm::ivec4 origin;
+        uint32_t indexCount;
+        uint32_t baseVertex;
+        uint32_t pad[2];
+    };
+
+    Shader* drawShader;
+    Shader* cullShader;
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint chunkBuffer;
+    GLuint paletteBuffer;
+    GLuint commandBuffer;
+    GLuint counterBuffer;   // visible (draw count), frustum culled, distance culled, occlusion culled
+    ReadbackRing readback;
+    uint32_t chunkCount;
+    CullStats stats;
+};
+
+#endif // CHUNK_MESH_RENDERER_H
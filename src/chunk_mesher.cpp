@@ -0,0 +1,239 @@
+/**
+ * Chunk Mesher Implementation
+ */
+
+#include "chunk_mesher.h"
+#include "job_system.h"
+#include "octree.h"
+#include "profiler.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr int CS = ChunkMesher::CHUNK_SIZE;
+constexpr size_t CELLS_PER_CHUNK = static_cast<size_t>(CS) * CS * CS;
+constexpr size_t WORDS_PER_CHUNK = CELLS_PER_CHUNK / 32;
+static_assert(CS <= 32, "quad sizes and cells are packed into 5 and 6 bits");
+
+// Face directions: +x, -x, +y, -y, +z, -z
+const glm::ivec3 FACE_DIRS[6] = {
+    {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+};
+
+inline uint64_t chunkKey(const glm::ivec3& chunk) {
+    glm::ivec3 biased = (chunk + glm::ivec3(1 << 20)) & glm::ivec3(0x1FFFFF);
+    return (static_cast<uint64_t>(biased.z) << 42) | (static_cast<uint64_t>(biased.y) << 21) |
+           static_cast<uint64_t>(biased.x);
+}
+
+inline glm::ivec3 chunkOf(const glm::ivec3& p) {
+    return glm::ivec3(glm::floor(glm::vec3(p) / static_cast<float>(CS)));
+}
+
+inline size_t cellIndex(const glm::ivec3& local) {
+    return (static_cast<size_t>(local.z) * CS + local.y) * CS + local.x;
+}
+
+// Corner offsets of a quad in its (u, v) tangent plane; negative faces wind
+// the other way so both stay counter-clockwise seen from outside
+const int CORNER_UV[2][4][2] = {
+    {{0, 0}, {1, 0}, {1, 1}, {0, 1}},
+    {{0, 0}, {0, 1}, {1, 1}, {1, 0}},
+};
+
+inline MeshVertex packVertex(const glm::ivec3& cell, int face, int corner, uint32_t ao, uint32_t palette,
+                             int width, int height) {
+    MeshVertex v;
+    v.position = static_cast<uint32_t>(cell.x) | (static_cast<uint32_t>(cell.y) << 6) |
+                 (static_cast<uint32_t>(cell.z) << 12) | (static_cast<uint32_t>(face) << 18) |
+                 (static_cast<uint32_t>(corner) << 21) | (ao << 23);
+    v.attributes = palette | (static_cast<uint32_t>(width - 1) << 16) | (static_cast<uint32_t>(height - 1) << 21);
+    return v;
+}
+
+struct ChunkInfo {
+    glm::ivec3 origin;
+    size_t begin;         // Range in the sorted voxel order
+    size_t end;
+    int neighbors[27];    // Chunk at offset (dx, dy, dz) in [-1, 1]^3, -1 if none
+};
+
+} // namespace
+
+std::vector<ChunkMesh> ChunkMesher::build(const VoxelList& voxels, std::vector<uint32_t>& palette) {
+    PROFILE_FUNCTION();
+    std::vector<ChunkMesh> meshes;
+    palette.clear();
+    if (voxels.empty()) return meshes;
+
+    // Palette of the packed colors, quantized if the scene has too many
+    std::vector<uint32_t> colorIndex(voxels.size());
+    for (int pass = 0; pass < 2; ++pass) {
+        std::unordered_map<uint32_t, uint32_t> lookup;
+        palette.clear();
+        for (size_t i = 0; i < voxels.size() && palette.size() <= MAX_PALETTE_SIZE; ++i) {
+            uint32_t color = packColor(voxels[i].getColor());
+            if (pass == 1) color = (color & 0xF8F8F800u) | 0x040404FFu;
+            auto inserted = lookup.emplace(color, static_cast<uint32_t>(palette.size()));
+            if (inserted.second) palette.push_back(color);
+            colorIndex[i] = inserted.first->second;
+        }
+        if (palette.size() <= MAX_PALETTE_SIZE) break;
+    }
+
+    // Group the voxels by chunk
+    std::vector<std::pair<uint64_t, uint32_t>> order(voxels.size());
+    for (size_t i = 0; i < voxels.size(); ++i)
+        order[i] = {chunkKey(chunkOf(voxels[i].getPosition())), static_cast<uint32_t>(i)};
+    std::sort(order.begin(), order.end());
+
+    std::vector<ChunkInfo> chunks;
+    std::unordered_map<uint64_t, int> chunkIndex;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && order[i].first == order[i - 1].first) continue;
+        if (!chunks.empty()) chunks.back().end = i;
+        chunkIndex[order[i].first] = static_cast<int>(chunks.size());
+        chunks.push_back(ChunkInfo{chunkOf(voxels[order[i].second].getPosition()) * CS, i, order.size(), {}});
+    }
+    for (ChunkInfo& chunk : chunks) {
+        for (int n = 0; n < 27; ++n) {
+            glm::ivec3 offset(n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1);
+            auto it = chunkIndex.find(chunkKey(chunk.origin / CS + offset));
+            chunk.neighbors[n] = it != chunkIndex.end() ? it->second : -1;
+        }
+    }
+
+    // Occupancy bitsets, then the faces of every chunk against them
+    std::vector<uint32_t> bits(chunks.size() * WORDS_PER_CHUNK, 0u);
+    JobSystem::instance().parallelFor(0, chunks.size(), 4, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            uint32_t* words = bits.data() + c * WORDS_PER_CHUNK;
+            for (size_t i = chunks[c].begin; i < chunks[c].end; ++i) {
+                size_t bit = cellIndex(voxels[order[i].second].getPosition() - chunks[c].origin);
+                words[bit >> 5] |= 1u << (bit & 31u);
+            }
+        }
+    });
+
+    meshes.resize(chunks.size());
+    JobSystem::instance().parallelFor(0, chunks.size(), 4, [&](size_t begin, size_t end) {
+        // Palette index + 1 per cell of the current chunk, and one slice of face keys
+        std::vector<uint32_t> cells(CELLS_PER_CHUNK);
+        std::vector<uint32_t> mask(static_cast<size_t>(CS) * CS);
+
+        for (size_t c = begin; c < end; ++c) {
+            const ChunkInfo& chunk = chunks[c];
+            ChunkMesh& mesh = meshes[c];
+            mesh.origin = chunk.origin;
+
+            std::fill(cells.begin(), cells.end(), 0u);
+            bool sliceUsed[3][CS] = {};
+            for (size_t i = chunk.begin; i < chunk.end; ++i) {
+                glm::ivec3 local = voxels[order[i].second].getPosition() - chunk.origin;
+                cells[cellIndex(local)] = colorIndex[order[i].second] + 1;
+                for (int axis = 0; axis < 3; ++axis) sliceUsed[axis][local[axis]] = true;
+            }
+
+            // Cells up to one chunk outside are looked up in the neighbours
+            auto solid = [&](glm::ivec3 local) {
+                glm::ivec3 offset = glm::ivec3(glm::greaterThanEqual(local, glm::ivec3(CS))) -
+                                    glm::ivec3(glm::lessThan(local, glm::ivec3(0)));
+                int owner = chunk.neighbors[(offset.x + 1) + (offset.y + 1) * 3 + (offset.z + 1) * 9];
+                if (owner < 0) return false;
+                size_t bit = cellIndex(local - offset * CS);
+                return (bits[static_cast<size_t>(owner) * WORDS_PER_CHUNK + (bit >> 5)] >> (bit & 31u) & 1u) != 0;
+            };
+
+            glm::ivec3 lo(std::numeric_limits<int>::max());
+            glm::ivec3 hi(std::numeric_limits<int>::min());
+            for (int face = 0; face < 6; ++face) {
+                const int axis = face / 2;
+                const int u = (axis + 1) % 3;
+                const int v = (axis + 2) % 3;
+                const glm::ivec3 normal = FACE_DIRS[face];
+                glm::ivec3 du(0), dv(0);
+                du[u] = 1;
+                dv[v] = 1;
+
+                for (int d = 0; d < CS; ++d) {
+                    if (!sliceUsed[axis][d]) continue;
+
+                    // Key per exposed face: palette index + 1, then the AO of its
+                    // corners (u, v) in {0, 1}^2 at bits 2 * (u + 2v)
+                    for (int j = 0; j < CS; ++j) {
+                        for (int i = 0; i < CS; ++i) {
+                            glm::ivec3 cell(0);
+                            cell[axis] = d; cell[u] = i; cell[v] = j;
+                            uint32_t color = cells[cellIndex(cell)];
+                            uint32_t& key = mask[static_cast<size_t>(j) * CS + i];
+                            key = 0;
+                            if (color == 0 || solid(cell + normal)) continue;
+
+                            uint32_t ao = 0;
+                            glm::ivec3 above = cell + normal;
+                            for (int k = 0; k < 4; ++k) {
+                                glm::ivec3 su = du * ((k & 1) * 2 - 1);
+                                glm::ivec3 sv = dv * ((k >> 1) * 2 - 1);
+                                int side1 = solid(above + su), side2 = solid(above + sv);
+                                int corner = solid(above + su + sv);
+                                uint32_t value = (side1 && side2) ? 0u : static_cast<uint32_t>(3 - side1 - side2 - corner);
+                                ao |= value << (2 * k);
+                            }
+                            key = (color << 8) | ao;
+                        }
+                    }
+
+                    // Greedy merge: grow each run along u, then along v while the row matches
+                    for (int j = 0; j < CS; ++j) {
+                        for (int i = 0; i < CS;) {
+                            uint32_t key = mask[static_cast<size_t>(j) * CS + i];
+                            if (key == 0) { ++i; continue; }
+                            int w = 1;
+                            while (i + w < CS && mask[static_cast<size_t>(j) * CS + i + w] == key) ++w;
+                            int h = 1;
+                            for (; j + h < CS; ++h) {
+                                const uint32_t* row = mask.data() + static_cast<size_t>(j + h) * CS + i;
+                                if (!std::all_of(row, row + w, [key](uint32_t k) { return k == key; })) break;
+                            }
+                            for (int y = j; y < j + h; ++y)
+                                std::fill_n(mask.begin() + static_cast<size_t>(y) * CS + i, w, 0u);
+
+                            glm::ivec3 cell(0);
+                            cell[axis] = d; cell[u] = i; cell[v] = j;
+                            uint32_t color = (key >> 8) - 1;
+                            uint32_t ao[4];
+                            for (int k = 0; k < 4; ++k) ao[k] = (key >> (2 * k)) & 3u;
+
+                            // Corners in winding order, rotated so the diagonal
+                            // splits the quad along its darker corners
+                            const int (*uv)[2] = CORNER_UV[face & 1];
+                            uint32_t cornerAo[4];
+                            for (int k = 0; k < 4; ++k) cornerAo[k] = ao[uv[k][0] + 2 * uv[k][1]];
+                            int first = (cornerAo[0] + cornerAo[2] < cornerAo[1] + cornerAo[3]) ? 1 : 0;
+                            for (int k = 0; k < 4; ++k) {
+                                int corner = (first + k) & 3;
+                                mesh.vertices.push_back(packVertex(cell, face, corner, cornerAo[corner], color, w, h));
+                            }
+
+                            glm::ivec3 extent = du * (w - 1) + dv * (h - 1);
+                            lo = glm::min(lo, cell);
+                            hi = glm::max(hi, cell + extent + glm::ivec3(1));
+                            i += w;
+                        }
+                    }
+                }
+            }
+            if (!mesh.vertices.empty()) {
+                mesh.boundsMin = glm::vec3(chunk.origin + lo);
+                mesh.boundsMax = glm::vec3(chunk.origin + hi);
+            }
+        }
+    });
+
+    meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [](const ChunkMesh& m) { return m.vertices.empty(); }),
+                 meshes.end());
+    return meshes;
+}
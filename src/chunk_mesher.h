@@ -0,0 +1,62 @@
+/**
+ * Chunk Mesher
+ *
+ * Turns a voxel list into one quad mesh per CHUNK_SIZE^3 chunk for the
+ * raster backend. Faces whose neighbour (possibly in the next chunk) is empty
+ * are merged greedily within each slice into rectangles of equal color and
+ * ambient occlusion, and emitted directly in the packed 8-byte vertex format
+ * voxel.vert decodes. Chunks are meshed as parallel jobs against per-chunk
+ * occupancy bitsets.
+ *
+ * Quads are 4 vertices in the order (0, 1, 2), (0, 2, 3) with
+ * counter-clockwise front faces, so every chunk can share one quad index
+ * pattern (see ChunkMeshRenderer).
+ */
+
+#ifndef CHUNK_MESHER_H
+#define CHUNK_MESHER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel.h"
+
+/**
+ * Packed quad corner (location 0 of voxel.vert, a uvec2):
+ *   x:  bits 0-17  cell of the quad's min corner in the chunk (6 bits per axis)
+ *       bits 18-20 face (+x, -x, +y, -y, +z, -z)
+ *       bits 21-22 corner of the quad (0-3, counter-clockwise)
+ *       bits 23-24 ambient occlusion of the corner (0 = occluded, 3 = open)
+ *   y:  bits 0-15  palette index
+ *       bits 16-20 quad width - 1 along the face's first tangent axis
+ *       bits 21-25 quad height - 1 along the second tangent axis
+ * The chunk origin comes from the per-draw chunk record, not the vertex.
+ */
+struct MeshVertex {
+    uint32_t position;
+    uint32_t attributes;
+};
+static_assert(sizeof(MeshVertex) == 8, "MeshVertex must stay 8 bytes");
+
+struct ChunkMesh {
+    glm::ivec3 origin = glm::ivec3(0);      // Min corner of the chunk cell
+    glm::vec3 boundsMin = glm::vec3(0.0f);  // Tight bounds of the emitted faces
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    std::vector<MeshVertex> vertices;       // 4 per quad
+};
+
+class ChunkMesher {
+public:
+    static constexpr int CHUNK_SIZE = 32;
+    static constexpr size_t MAX_PALETTE_SIZE = 1u << 16;
+
+    /**
+     * Mesh every chunk that has at least one visible face
+     * @param palette receives the packed RGBA8 colors the vertices index;
+     *        scenes with more colors than MAX_PALETTE_SIZE are quantized to
+     *        5 bits per channel
+     */
+    static std::vector<ChunkMesh> build(const VoxelList& voxels, std::vector<uint32_t>& palette);
+};
+
+#endif // CHUNK_MESHER_H
@@ -0,0 +1,220 @@
+/**
+ * Deferred Shading Implementation
+ */
+
+#include "deferred_shading.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr size_t HIT_HEADER_BYTES = sizeof(uint32_t) * 4;
+
+} // namespace
+
+DeferredShading::DeferredShading()
+    : visibilityShader(nullptr)
+    , aoShader(nullptr)
+    , lightingShader(nullptr)
+    , denoiseShader(nullptr)
+    , framebuffer(0)
+    , distanceTexture(0)
+    , leafTexture(0)
+    , idTexture(0)
+    , colorTexture(0)
+    , aoTexture(0)
+    , aoScratch(0)
+    , occlusionTexture(0)
+    , depthTexture(0)
+    , hitBuffer(0)
+    , width(0)
+    , height(0)
+    , hitCount(0)
+{
+}
+
+DeferredShading::~DeferredShading()
+{
+    cleanup();
+}
+
+void DeferredShading::init()
+{
+    visibilityShader = new Shader("assets/shaders/raymarching.vert", "assets/shaders/visibility.frag");
+    aoShader = new Shader("assets/shaders/deferred_ao.comp");
+    lightingShader = new Shader("assets/shaders/deferred_lighting.comp");
+    denoiseShader = new Shader("assets/shaders/ao_denoise.comp");
+    timer.init(TIMER_PASS_COUNT);
+    readback.init(sizeof(uint32_t));
+}
+
+void DeferredShading::cleanup()
+{
+    release();
+    readback.cleanup();
+    delete visibilityShader; visibilityShader = nullptr;
+    delete aoShader; aoShader = nullptr;
+    delete lightingShader; lightingShader = nullptr;
+    delete denoiseShader; denoiseShader = nullptr;
+    timer.cleanup();
+}
+
+void DeferredShading::release()
+{
+    if (framebuffer != 0) { glDeleteFramebuffers(1, &framebuffer); framebuffer = 0; }
+    freeGLTexture(distanceTexture);
+    freeGLTexture(leafTexture);
+    freeGLTexture(idTexture);
+    freeGLTexture(colorTexture);
+    freeGLTexture(aoTexture);
+    freeGLTexture(aoScratch);
+    occlusionTexture = 0;
+    freeGLTexture(depthTexture);
+    freeGLBuffer(hitBuffer);
+    width = height = 0;
+}
+
+void DeferredShading::allocate(int newWidth, int newHeight)
+{
+    release();
+    width = newWidth;
+    height = newHeight;
+    colorTexture = createTexture2D(GL_RGBA8, width, height, 4);
+    idTexture = createTexture2D(GL_R32UI, width, height, 4);
+    distanceTexture = createTexture2D(GL_R32F, width, height, 4);
+    leafTexture = createTexture2D(GL_RG32UI, width, height, 8);
+    aoTexture = createTexture2D(GL_R16F, width, height, 2);
+    aoScratch = createTexture2D(GL_R16F, width, height, 2);
+    depthTexture = createTexture2D(GL_DEPTH_COMPONENT24, width, height, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Attachment order matches the outputs of visibility.frag
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, idTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, distanceTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, leafTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[4] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2,
+                                   GL_COLOR_ATTACHMENT3};
+    glDrawBuffers(4, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Deferred shading framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Worst case every pixel is a hit
+    const size_t hitBytes = HIT_HEADER_BYTES + sizeof(uint32_t) * static_cast<size_t>(width) * height;
+    glGenBuffers(1, &hitBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, hitBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, hitBytes, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(hitBuffer, MemoryTag::GpuOther, hitBytes);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void DeferredShading::visibility(int newWidth, int newHeight, GLuint quadVAO,
+                                 const std::function<void(const Shader&)>& setUniforms)
+{
+    PROFILE_FUNCTION();
+    if (newWidth != width || newHeight != height) allocate(newWidth, newHeight);
+    timer.beginFrame();
+
+    // groupsX counts up as hits are appended; y and z stay 1
+    const uint32_t header[4] = {0, 1, 1, 0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, hitBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, HIT_LIST_BINDING, hitBuffer);
+
+    // Every pixel is written, only the depth needs a clear for pixels the quad misses
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    const GLfloat farDepth = 1.0f;
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+
+    visibilityShader->use();
+    setUniforms(*visibilityShader);
+
+    // Hits write their depth for the next frame's Hi-Z pyramid
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_ALWAYS);
+    glBindVertexArray(quadVAO);
+    timer.begin(TIMER_VISIBILITY);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    timer.end();
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_DEPTH_TEST);
+}
+
+void DeferredShading::shade(const std::function<void(const Shader&)>& setUniforms, int denoiseIterations,
+                            bool coneTracing)
+{
+    PROFILE_FUNCTION();
+    if (framebuffer == 0) return;
+    denoiseIterations = std::max(0, std::min(denoiseIterations, MAX_DENOISE_ITERATIONS));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // Every pass covers only the hit pixels, without reading the count back
+    glBindImageTexture(0, distanceTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, leafTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32UI);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, hitBuffer);
+
+    GLuint occlusion = aoTexture;
+    if (!coneTracing) {
+        aoShader->use();
+        setUniforms(*aoShader);
+        aoShader->setBool("u_pixelSeed", denoiseIterations > 0);
+        glBindImageTexture(2, aoTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+        timer.begin(TIMER_AO);
+        glDispatchComputeIndirect(0);
+        timer.end();
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    // À-trous iterations ping-pong between the two AO targets, taps 1, 2, 4, ... apart
+    if (!coneTracing && denoiseIterations > 0) {
+        denoiseShader->use();
+        setUniforms(*denoiseShader);
+        denoiseShader->setFloat("u_depthSigma", DENOISE_DEPTH_SIGMA);
+        glBindImageTexture(1, idTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+        for (int i = 0; i < denoiseIterations; ++i) {
+            GLuint target = occlusion == aoTexture ? aoScratch : aoTexture;
+            denoiseShader->setInt("u_step", 1 << i);
+            glBindImageTexture(2, occlusion, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16F);
+            glBindImageTexture(3, target, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+            timer.begin(TIMER_DENOISE + i);
+            glDispatchComputeIndirect(0);
+            timer.end();
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            occlusion = target;
+        }
+        glBindImageTexture(1, leafTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32UI);
+    }
+
+    occlusionTexture = coneTracing ? 0 : occlusion;
+    lightingShader->use();
+    setUniforms(*lightingShader);
+    glBindImageTexture(2, occlusion, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16F);
+    glBindImageTexture(3, colorTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    timer.begin(TIMER_LIGHTING);
+    glDispatchComputeIndirect(0);
+    timer.end();
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    uint32_t count = 0;
+    if (readback.readback(hitBuffer, sizeof(uint32_t) * 3, &count)) hitCount = static_cast<int>(count);
+}
+
+void DeferredShading::present()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
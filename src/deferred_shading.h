@@ -0,0 +1,120 @@
+/**
+ * Deferred Shading
+ *
+ * Splits the ray caster into visibility and shading. visibility.frag only
+ * traverses: per pixel it writes the hit distance, the hit leaf (node index,
+ * object and face), the surface id for edge detection and the depth, and
+ * appends every hit pixel to a compact list whose header doubles as an
+ * indirect dispatch. deferred_ao.comp and deferred_lighting.comp then run over
+ * that list only: AO first into its own target, then lighting from every
+ * light with its shadow rays. Background pixels cost one traversal, and the
+ * divergent AO and shadow loops run in full compute groups of hit pixels.
+ *
+ * Optionally the AO is traced with per-pixel rays (blue noise shifted, see
+ * Sampling) and filtered by ao_denoise.comp, an edge-aware à-trous wavelet
+ * guided by ray distance and surface ids, so a few AO rays per pixel look
+ * like many. Every pass is
+ * timed on the GPU (GpuTimer).
+ */
+
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include "gl_utils.h"
+#include "gpu_timer.h"
+#include "shader.h"
+
+// SSBO binding point of the hit pixel list (visibility.frag, deferred_*.comp)
+constexpr GLuint HIT_LIST_BINDING = 10;
+
+class DeferredShading {
+public:
+    static constexpr int MAX_DENOISE_ITERATIONS = 5;
+    static constexpr float DENOISE_DEPTH_SIGMA = 4.0f;
+
+    // Passes timed by getPassMilliseconds(); denoise iteration i is TIMER_DENOISE + i
+    enum TimedPass {
+        TIMER_VISIBILITY,
+        TIMER_AO,
+        TIMER_LIGHTING,
+        TIMER_DENOISE,
+        TIMER_PASS_COUNT = TIMER_DENOISE + MAX_DENOISE_ITERATIONS
+    };
+
+    DeferredShading();
+    ~DeferredShading();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Run the visibility pass into the G-buffer, reallocated when the size
+     * changes; the G-buffer framebuffer stays bound
+     * @param quadVAO full screen quad for raymarching.vert (6 vertices)
+     * @param setUniforms sets the ray casting uniforms (raycast_common.glsl)
+     */
+    void visibility(int width, int height, GLuint quadVAO, const std::function<void(const Shader&)>& setUniforms);
+
+    /**
+     * AO, then lighting and shadows of the hit pixels into the color target
+     * @param denoiseIterations à-trous iterations over the AO (at most
+     *        MAX_DENOISE_ITERATIONS); 0 keeps the per-voxel AO of the forward path
+     * @param coneTracing the lighting pass takes occlusion and bounced light
+     *        from cones (RadianceVolume), so the AO passes are skipped
+     */
+    void shade(const std::function<void(const Shader&)>& setUniforms, int denoiseIterations, bool coneTracing);
+
+    /**
+     * Copy the color to the default framebuffer and bind that again
+     */
+    void present();
+
+    GLuint getFramebuffer() const { return framebuffer; }
+    GLuint getColorTexture() const { return colorTexture; }
+    GLuint getSurfaceIdTexture() const { return idTexture; }
+
+    /**
+     * The (denoised) occlusion the last shade() lit the hit pixels with, 0
+     * when cone tracing replaced it
+     */
+    GLuint getOcclusionTexture() const { return occlusionTexture; }
+
+    /**
+     * Hit pixels of the frame READBACK_LATENCY frames ago
+     */
+    int getHitCount() const { return hitCount; }
+
+    /**
+     * GPU time of a TimedPass, READBACK_LATENCY frames ago; 0 if it did not run
+     */
+    double getPassMilliseconds(int pass) const { return timer.getMilliseconds(pass); }
+
+private:
+    void allocate(int width, int height);
+    void release();
+
+    Shader* visibilityShader;
+    Shader* aoShader;
+    Shader* lightingShader;
+    Shader* denoiseShader;
+    GLuint framebuffer;
+    GLuint distanceTexture; // r32f hit distance along the camera ray, < 0 = background
+    GLuint leafTexture;     // rg32ui: leaf node index, object << 3 | face
+    GLuint idTexture;       // r32ui surface ids, 0 = background
+    GLuint colorTexture;    // rgba8: background from the visibility pass, hits from lighting
+    GLuint aoTexture;       // r16f occlusion of the hit pixels
+    GLuint aoScratch;       // r16f, the other half of the denoiser's ping-pong
+    GLuint occlusionTexture; // aoTexture or aoScratch, whichever the lighting read
+    GLuint depthTexture;
+    GLuint hitBuffer;       // dispatch command, count, then one packed pixel per hit
+    ReadbackRing readback;
+    int width;
+    int height;
+    int hitCount;
+    GpuTimer timer;
+};
+
+#endif // DEFERRED_SHADING_H
@@ -0,0 +1,161 @@
+/**
+ * Edge Supersampler Implementation
+ */
+
+#include "edge_supersampler.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <iostream>
+
+namespace {
+
+constexpr GLuint DETECT_GROUP_SIZE = 8;    // local_size_x/y of edge_detect.comp
+constexpr size_t EDGE_HEADER_BYTES = sizeof(uint32_t) * 4;
+
+} // namespace
+
+EdgeSupersampler::EdgeSupersampler()
+    : detectShader(nullptr)
+    , resolveShader(nullptr)
+    , framebuffer(0)
+    , colorTexture(0)
+    , idTexture(0)
+    , depthTexture(0)
+    , edgeBuffer(0)
+    , edgeCapacity(0)
+    , width(0)
+    , height(0)
+    , edgeCount(0)
+{
+}
+
+EdgeSupersampler::~EdgeSupersampler()
+{
+    cleanup();
+}
+
+void EdgeSupersampler::init()
+{
+    detectShader = new Shader("assets/shaders/edge_detect.comp");
+    resolveShader = new Shader("assets/shaders/edge_resolve.comp");
+    readback.init(sizeof(uint32_t));
+}
+
+void EdgeSupersampler::cleanup()
+{
+    release();
+    readback.cleanup();
+    delete detectShader; detectShader = nullptr;
+    delete resolveShader; resolveShader = nullptr;
+}
+
+void EdgeSupersampler::release()
+{
+    if (framebuffer != 0) { glDeleteFramebuffers(1, &framebuffer); framebuffer = 0; }
+    freeGLTexture(colorTexture);
+    freeGLTexture(idTexture);
+    freeGLTexture(depthTexture);
+    freeGLBuffer(edgeBuffer);
+    edgeCapacity = 0;
+    width = height = 0;
+}
+
+void EdgeSupersampler::allocate(int newWidth, int newHeight)
+{
+    release();
+    width = newWidth;
+    height = newHeight;
+    colorTexture = createTexture2D(GL_RGBA8, width, height, 4);
+    idTexture = createTexture2D(GL_R32UI, width, height, 4);
+    depthTexture = createTexture2D(GL_DEPTH_COMPONENT24, width, height, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, idTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Edge supersampling framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void EdgeSupersampler::begin(int newWidth, int newHeight)
+{
+    if (newWidth != width || newHeight != height) allocate(newWidth, newHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    const GLuint background = 0;
+    const GLfloat farDepth = 1.0f;
+    glClearBufferuiv(GL_COLOR, 1, &background);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void EdgeSupersampler::resolve(int sampleCount, const std::function<void(const Shader&)>& setUniforms)
+{
+    if (framebuffer == 0) return;
+    resolve(colorTexture, idTexture, width, height, sampleCount, setUniforms);
+}
+
+void EdgeSupersampler::resolve(GLuint color, GLuint surfaceIds, int targetWidth, int targetHeight, int sampleCount,
+                               const std::function<void(const Shader&)>& setUniforms, GLuint occlusion)
+{
+    PROFILE_FUNCTION();
+
+    // Worst case every pixel is an edge
+    const size_t pixels = static_cast<size_t>(targetWidth) * targetHeight;
+    if (pixels > edgeCapacity) {
+        freeGLBuffer(edgeBuffer);
+        const size_t edgeBytes = EDGE_HEADER_BYTES + sizeof(uint32_t) * pixels;
+        glGenBuffers(1, &edgeBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, edgeBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, edgeBytes, nullptr, GL_DYNAMIC_DRAW);
+        MemoryStats::trackGLBuffer(edgeBuffer, MemoryTag::GpuOther, edgeBytes);
+        edgeCapacity = pixels;
+    }
+
+    // groupsX counts up as edges are appended; y and z stay 1
+    const uint32_t header[4] = {0, 1, 1, 0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, edgeBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, EDGE_LIST_BINDING, edgeBuffer);
+
+    detectShader->use();
+    detectShader->setFloat("u_contrast", EDGE_CONTRAST);
+    glBindImageTexture(0, surfaceIds, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindImageTexture(1, color, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
+    glDispatchCompute((targetWidth + DETECT_GROUP_SIZE - 1) / DETECT_GROUP_SIZE,
+                      (targetHeight + DETECT_GROUP_SIZE - 1) / DETECT_GROUP_SIZE, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // Only as many groups as there are edges, without reading the count back
+    resolveShader->use();
+    setUniforms(*resolveShader);
+    resolveShader->setInt("u_sampleCount", sampleCount >= 8 ? 8 : 4);
+    resolveShader->setBool("u_deferredOcclusion", occlusion != 0);
+    glBindImageTexture(1, color, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    if (occlusion != 0) {
+        glBindImageTexture(0, surfaceIds, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+        glBindImageTexture(2, occlusion, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16F);
+    }
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, edgeBuffer);
+    glDispatchComputeIndirect(0);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    uint32_t count = 0;
+    if (readback.readback(edgeBuffer, sizeof(uint32_t) * 3, &count)) edgeCount = static_cast<int>(count);
+}
+
+void EdgeSupersampler::end()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,94 @@
+/**
+ * Edge Supersampler
+ *
+ * Adaptive antialiasing for the ray caster. The frame is cast once per pixel
+ * into an offscreen target that also stores a surface id per pixel (object,
+ * face and face plane, see raymarching.frag); the deferred G-buffer
+ * (DeferredShading) brings its own. edge_detect.comp marks pixels
+ * whose neighbours show another surface or contrast in luma and appends them
+ * to a compact list; edge_resolve.comp, dispatched indirectly over that list,
+ * traces 4 or 8 sub-pixel rays for each of them. Silhouettes get
+ * supersampling quality while the cost scales with the edge pixels only.
+ *
+ * Over the deferred G-buffer the sub-pixel rays take their occlusion from
+ * the deferred AO target (denoised when enabled) at the pixel or neighbour
+ * that shows the same surface, so edge pixels match the shading around them;
+ * only surfaces no pixel there shows fall back to the per-voxel AO of the
+ * forward path.
+ */
+
+#ifndef EDGE_SUPERSAMPLER_H
+#define EDGE_SUPERSAMPLER_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include "gl_utils.h"
+#include "shader.h"
+
+// SSBO binding point of the edge list (edge_detect.comp, edge_resolve.comp)
+constexpr GLuint EDGE_LIST_BINDING = 9;
+
+class EdgeSupersampler {
+public:
+    static constexpr float EDGE_CONTRAST = 0.08f;   // Luma step that counts as an edge
+
+    EdgeSupersampler();
+    ~EdgeSupersampler();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Bind and clear the offscreen target (color, surface ids, depth),
+     * reallocated when the size changes
+     */
+    void begin(int width, int height);
+
+    /**
+     * Find the edge pixels and re-trace each with sampleCount (4 or 8) rays
+     * @param setUniforms sets the ray casting uniforms (raycast_common.glsl)
+     *        on the resolve shader
+     */
+    void resolve(int sampleCount, const std::function<void(const Shader&)>& setUniforms);
+
+    /**
+     * Same on another width x height target: color (rgba8) and its surface
+     * ids (r32ui), e.g. the deferred G-buffer
+     * @param occlusion r16f occlusion the target was shaded with, or 0 to
+     *        trace the per-voxel AO
+     */
+    void resolve(GLuint color, GLuint surfaceIds, int width, int height, int sampleCount,
+                 const std::function<void(const Shader&)>& setUniforms, GLuint occlusion = 0);
+
+    /**
+     * Copy the color to the default framebuffer and bind that again
+     */
+    void end();
+
+    GLuint getFramebuffer() const { return framebuffer; }
+
+    /**
+     * Edge pixels of the frame READBACK_LATENCY frames ago
+     */
+    int getEdgeCount() const { return edgeCount; }
+
+private:
+    void allocate(int width, int height);
+    void release();
+
+    Shader* detectShader;
+    Shader* resolveShader;
+    GLuint framebuffer;
+    GLuint colorTexture;    // rgba8
+    GLuint idTexture;       // r32ui surface ids, 0 = background
+    GLuint depthTexture;
+    GLuint edgeBuffer;      // dispatch command, count, then one packed pixel per edge
+    size_t edgeCapacity;    // Pixels the edge buffer has room for
+    ReadbackRing readback;
+    int width;
+    int height;
+    int edgeCount;
+};
+
+#endif // EDGE_SUPERSAMPLER_H
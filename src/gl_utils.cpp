@@ -0,0 +1,85 @@
+/**
+ * GL Utilities Implementation
+ */
+
+#include "gl_utils.h"
+
+GLuint createTexture2D(GLenum format, int width, int height, size_t bytesPerTexel)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    MemoryStats::trackGLTexture(texture, MemoryTag::GpuTexture, static_cast<size_t>(width) * height * bytesPerTexel);
+    return texture;
+}
+
+void freeGLTexture(GLuint& texture)
+{
+    if (texture == 0) return;
+    MemoryStats::untrackGLTexture(texture);
+    glDeleteTextures(1, &texture);
+    texture = 0;
+}
+
+void freeGLBuffer(GLuint& buffer)
+{
+    if (buffer == 0) return;
+    MemoryStats::untrackGLBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+ReadbackRing::ReadbackRing()
+    : buffers{}
+    , size(0)
+    , frame(0)
+{
+}
+
+ReadbackRing::~ReadbackRing()
+{
+    cleanup();
+}
+
+void ReadbackRing::init(size_t bytes, MemoryTag tag)
+{
+    cleanup();
+    size = bytes;
+    for (GLuint& buffer : buffers) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        MemoryStats::trackGLBuffer(buffer, tag, bytes);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ReadbackRing::cleanup()
+{
+    for (GLuint& buffer : buffers) freeGLBuffer(buffer);
+    size = 0;
+    frame = 0;
+}
+
+bool ReadbackRing::readback(GLuint source, GLintptr offset, void* out)
+{
+    if (size == 0) return false;
+    // Orders the copy after the compute passes that wrote source
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[frame % (READBACK_LATENCY + 1)]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, static_cast<GLsizeiptr>(size));
+    // The oldest buffer is the one written next frame
+    const bool ready = frame >= READBACK_LATENCY;
+    if (ready) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers[(frame + 1) % (READBACK_LATENCY + 1)]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(size), out);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    ++frame;
+    return ready;
+}
@@ -0,0 +1,59 @@
+/**
+ * GL Utilities
+ *
+ * Helpers shared by the GPU passes: textures and buffers created and freed
+ * together with their MemoryStats entries, and ReadbackRing for reading
+ * small GPU results (counters, sums) back without stalling the pipeline.
+ */
+
+#ifndef GL_UTILS_H
+#define GL_UTILS_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include "memory_stats.h"
+
+// Frames between a GPU result being written and the CPU reading it
+constexpr int READBACK_LATENCY = 2;
+
+/**
+ * Single-level 2D texture with nearest filtering, tracked as GpuTexture;
+ * leaves it bound to GL_TEXTURE_2D
+ */
+GLuint createTexture2D(GLenum format, int width, int height, size_t bytesPerTexel);
+
+/**
+ * Delete and untrack; no-op for 0, resets the handle to 0
+ */
+void freeGLTexture(GLuint& texture);
+void freeGLBuffer(GLuint& buffer);
+
+/**
+ * Reads a few bytes of a GPU buffer every frame without waiting for the GPU:
+ * each frame's bytes are copied into one of READBACK_LATENCY + 1 buffers and
+ * the copy made READBACK_LATENCY frames earlier, long finished, is read.
+ */
+class ReadbackRing {
+public:
+    ReadbackRing();
+    ~ReadbackRing();
+
+    void init(size_t bytes, MemoryTag tag = MemoryTag::GpuOther);
+    void cleanup();
+
+    /**
+     * Copy the bytes at offset of source into this frame's buffer, and read
+     * the copy from READBACK_LATENCY frames ago into out. Shader writes to
+     * source issued before the call are visible to the copy.
+     * @return false (out untouched) for the first READBACK_LATENCY frames
+     */
+    bool readback(GLuint source, GLintptr offset, void* out);
+
+private:
+    GLuint buffers[READBACK_LATENCY + 1];
+    size_t size;
+    uint64_t frame;
+};
+
+#endif // GL_UTILS_H
@@ -0,0 +1,315 @@
+/**
+ * GPU Octree Builder Implementation
+ */
+
+#include "gpu_octree_builder.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <algorithm>
+#include <iostream>
+
+static constexpr uint32_t GROUP_SIZE = 256;
+static constexpr uint32_t SCAN_BLOCK = 512;
+static constexpr uint32_t RADIX_BITS = 4;
+static constexpr uint32_t MAX_GROUPS_X = 65535;
+static constexpr uint32_t MAX_NODES = 1u << 24;   // 24-bit first-child index
+
+enum BuildMode { MODE_FLAGS = 0, MODE_LEVEL_START = 1, MODE_EMIT = 2 };
+
+static uint32_t divUp(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+
+static void allocBuffer(GLuint& buffer, size_t bytes) {
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+    MemoryStats::trackGLBuffer(buffer, MemoryTag::GpuOther, bytes);
+}
+
+// Upper bound of the node count: level l holds at most min(N, 8^l) nodes
+static uint64_t nodeBound(uint32_t voxelCount, int levels) {
+    uint64_t total = 0, levelMax = 1;
+    for (int l = 0; l <= levels; ++l) {
+        total += std::min<uint64_t>(voxelCount, levelMax);
+        levelMax = std::min<uint64_t>(levelMax * 8, UINT32_MAX);
+    }
+    return total;
+}
+
+GpuOctreeBuilder::GpuOctreeBuilder()
+    : mortonShader(nullptr)
+    , radixShader(nullptr)
+    , scanShader(nullptr)
+    , buildShader(nullptr)
+    , inputBuffer(0)
+    , keys{0, 0}
+    , values{0, 0}
+    , histBuffer(0)
+    , scanBuffers{0, 0}
+    , levelBuffer(0)
+    , capacity(0)
+    , nodeCapacity(0)
+{
+}
+
+GpuOctreeBuilder::~GpuOctreeBuilder()
+{
+    cleanup();
+}
+
+void GpuOctreeBuilder::init()
+{
+    mortonShader = new Shader("assets/shaders/octree_morton.comp");
+    radixShader = new Shader("assets/shaders/radix_sort.comp");
+    scanShader = new Shader("assets/shaders/prefix_sum.comp");
+    buildShader = new Shader("assets/shaders/octree_build.comp");
+}
+
+void GpuOctreeBuilder::cleanup()
+{
+    freeGLBuffer(inputBuffer);
+    for (int i = 0; i < 2; ++i) {
+        freeGLBuffer(keys[i]);
+        freeGLBuffer(values[i]);
+        freeGLBuffer(scanBuffers[i]);
+    }
+    freeGLBuffer(histBuffer);
+    freeGLBuffer(levelBuffer);
+    for (GLuint& b : blockSums) freeGLBuffer(b);
+    blockSums.clear();
+    capacity = 0;
+
+    delete mortonShader; mortonShader = nullptr;
+    delete radixShader; radixShader = nullptr;
+    delete scanShader; scanShader = nullptr;
+    delete buildShader; buildShader = nullptr;
+}
+
+bool GpuOctreeBuilder::supports(size_t voxelCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    float extent = boundsMax.x - boundsMin.x;
+    if (voxelCount == 0 || extent > static_cast<float>(1 << MAX_LEVELS)) return false;
+    int levels = 0;
+    while ((1 << levels) < static_cast<int>(extent)) ++levels;
+    return nodeBound(static_cast<uint32_t>(voxelCount), levels) < MAX_NODES;
+}
+
+void GpuOctreeBuilder::ensureCapacity(uint32_t voxelCount)
+{
+    if (voxelCount <= capacity) return;
+    capacity = std::max(voxelCount, capacity + capacity / 2);
+
+    for (int i = 0; i < 2; ++i) {
+        allocBuffer(keys[i], capacity * sizeof(uint32_t));
+        allocBuffer(values[i], capacity * sizeof(uint32_t));
+        allocBuffer(scanBuffers[i], capacity * sizeof(uint32_t));
+    }
+    allocBuffer(histBuffer, (1u << RADIX_BITS) * divUp(capacity, GROUP_SIZE) * sizeof(uint32_t));
+    allocBuffer(levelBuffer, (MAX_LEVELS + 2) * sizeof(uint32_t));
+
+    // Block sums for every recursion level of scan(); histograms are the larger input
+    for (GLuint& b : blockSums) freeGLBuffer(b);
+    blockSums.clear();
+    uint32_t n = std::max(capacity, (1u << RADIX_BITS) * divUp(capacity, GROUP_SIZE));
+    do {
+        n = divUp(n, SCAN_BLOCK);
+        blockSums.push_back(0);
+        allocBuffer(blockSums.back(), std::max<uint32_t>(n, 1) * sizeof(uint32_t));
+    } while (n > 1);
+}
+
+void GpuOctreeBuilder::dispatch(uint32_t groups)
+{
+    // Shaders linearize gl_WorkGroupID.xy, so large dispatches wrap into y
+    uint32_t x = std::min(groups, MAX_GROUPS_X);
+    uint32_t y = divUp(groups, x);
+    glDispatchCompute(x, y, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuOctreeBuilder::scan(GLuint buffer, uint32_t count, size_t level)
+{
+    uint32_t blocks = divUp(count, SCAN_BLOCK);
+
+    scanShader->use();
+    scanShader->setUint("u_count", count);
+    scanShader->setInt("u_mode", 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, blockSums[level]);
+    dispatch(blocks);
+
+    if (blocks <= 1) return;
+
+    scan(blockSums[level], blocks, level + 1);
+
+    scanShader->use();
+    scanShader->setUint("u_count", count);
+    scanShader->setInt("u_mode", 1);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, blockSums[level]);
+    dispatch(blocks);
+}
+
+bool GpuOctreeBuilder::build(const VoxelList& voxels, const glm::vec3& boundsMin, const glm::vec3& boundsMax, GLuint octreeBuffer)
+{
+    PROFILE_FUNCTION();
+    if (!supports(voxels.size(), boundsMin, boundsMax)) return false;
+
+    int levels = 0;
+    while ((1 << levels) < static_cast<int>(boundsMax.x - boundsMin.x)) ++levels;
+
+    std::vector<glm::uvec2> packed(voxels.size());
+    glm::ivec3 origin(boundsMin);
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        glm::uvec3 p(voxels[i].getPosition() - origin);
+        packed[i] = glm::uvec2(p.x | (p.y << 10) | (p.z << 20), packColor(voxels[i].getColor()));
+    }
+
+    size_t bytes = packed.size() * sizeof(glm::uvec2);
+    if (inputBuffer == 0) glGenBuffers(1, &inputBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, packed.data(), GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(inputBuffer, MemoryTag::GpuOther, bytes);
+
+    return build(inputBuffer, static_cast<uint32_t>(voxels.size()), levels, octreeBuffer);
+}
+
+bool GpuOctreeBuilder::build(GLuint voxelBuffer, uint32_t voxelCount, int levels, GLuint octreeBuffer)
+{
+    PROFILE_ZONE("GpuOctreeBuilder::build (dispatch)");
+    if (voxelCount == 0 || levels > MAX_LEVELS) return false;
+    uint64_t bound = nodeBound(voxelCount, levels);
+    if (bound >= MAX_NODES) return false;
+
+    ensureCapacity(voxelCount);
+    const uint32_t groups = divUp(voxelCount, GROUP_SIZE);
+
+    // 1. Morton codes
+    mortonShader->use();
+    mortonShader->setUint("u_count", voxelCount);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, voxelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, values[0]);
+    dispatch(groups);
+
+    // 2. Radix sort over the 3 * levels significant bits
+    const uint32_t histCount = (1u << RADIX_BITS) * groups;
+    const uint32_t passes = divUp(3u * static_cast<uint32_t>(levels), RADIX_BITS);
+    int src = 0;
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        int dst = src ^ 1;
+
+        radixShader->use();
+        radixShader->setUint("u_count", voxelCount);
+        radixShader->setUint("u_shift", pass * RADIX_BITS);
+        radixShader->setUint("u_numBlocks", groups);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keys[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, values[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, keys[dst]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, values[dst]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, histBuffer);
+        radixShader->setInt("u_mode", 0);
+        dispatch(groups);
+
+        scan(histBuffer, histCount);
+
+        radixShader->use();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keys[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, values[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, keys[dst]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, values[dst]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, histBuffer);
+        radixShader->setInt("u_mode", 1);
+        dispatch(groups);
+
+        src = dst;
+    }
+
+    // 3. Output buffer: 16-byte header + zeroed nodes (EMIT ORs bits into them)
+    nodeCapacity = static_cast<uint32_t>(bound);
+    size_t headerSize = sizeof(int) * 4;
+    size_t outBytes = headerSize + bound * sizeof(GPUNode);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, outBytes, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(octreeBuffer, MemoryTag::GpuOctreeBuffer, outBytes);
+    GLuint zero = 0;
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, levelBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    auto bindBuild = [&](GLuint scanLevel, GLuint scanChild) {
+        buildShader->use();
+        buildShader->setUint("u_count", voxelCount);
+        buildShader->setUint("u_leafLevel", static_cast<uint32_t>(levels));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, voxelBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, values[src]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, scanLevel);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, scanChild);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, levelBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, octreeBuffer);
+    };
+
+    auto markLevel = [&](GLuint target, int level) {
+        bindBuild(target, target);
+        buildShader->setUint("u_level", static_cast<uint32_t>(level));
+        buildShader->setInt("u_mode", MODE_FLAGS);
+        dispatch(groups);
+        scan(target, voxelCount);
+    };
+
+    // Level l needs the scans of l and l + 1; ping-pong between two buffers
+    int cur = 0;
+    markLevel(scanBuffers[cur], 0);
+    for (int level = 0; level <= levels; ++level) {
+        int child = cur ^ 1;
+
+        bindBuild(scanBuffers[cur], scanBuffers[child]);
+        buildShader->setUint("u_level", static_cast<uint32_t>(level));
+        buildShader->setInt("u_mode", MODE_LEVEL_START);
+        dispatch(1);
+
+        if (level < levels) markLevel(scanBuffers[child], level + 1);
+
+        bindBuild(scanBuffers[cur], scanBuffers[child]);
+        buildShader->setUint("u_level", static_cast<uint32_t>(level));
+        buildShader->setInt("u_mode", MODE_EMIT);
+        dispatch(groups);
+
+        cur = child;
+    }
+
+    return true;
+}
+
+bool GpuOctreeBuilder::validate(GLuint octreeBuffer, const GPUNodeList& reference)
+{
+    PROFILE_FUNCTION();
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeBuffer);
+
+    uint32_t count = 0;
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &count);
+    if (count != reference.size()) {
+        std::cerr << "GPU octree validation: node count " << count
+                  << " != CPU " << reference.size() << std::endl;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return false;
+    }
+
+    std::vector<GPUNode> nodes(count);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * 4, count * sizeof(GPUNode), nodes.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (nodes[i].childMask != reference[i].childMask || nodes[i].color != reference[i].color) {
+            std::cerr << "GPU octree validation: node " << i << " differs (childMask "
+                      << nodes[i].childMask << " vs " << reference[i].childMask << ", color "
+                      << nodes[i].color << " vs " << reference[i].color << ")" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "GPU octree validation passed: " << count << " nodes match" << std::endl;
+    return true;
+}
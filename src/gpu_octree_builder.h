@@ -0,0 +1,95 @@
+/**
+ * GPU Octree Builder
+ *
+ * Builds the flattened octree (GPUNode layout, see octree.h) entirely with
+ * compute shaders, without reading anything back to the CPU:
+ *   1. 30-bit Morton code per voxel            (octree_morton.comp)
+ *   2. stable 4-bit LSD radix sort of the codes (radix_sort.comp + prefix_sum.comp)
+ *   3. per level: mark unique prefixes, scan them, emit the level's nodes
+ *                                               (octree_build.comp + prefix_sum.comp)
+ *
+ * The output is node-for-node identical to buildOctree() + flattenOctree(),
+ * which validate() checks by reading the result back.
+ *
+ * Limits: octree extent <= 1024 (10 levels, 30-bit codes) and < 2^24 nodes
+ * (the 24-bit first-child index). Larger scenes use the CPU builder.
+ */
+
+#ifndef GPU_OCTREE_BUILDER_H
+#define GPU_OCTREE_BUILDER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "octree.h"
+#include "shader.h"
+#include "voxel.h"
+
+class GpuOctreeBuilder {
+public:
+    static constexpr int MAX_LEVELS = 10;
+
+    GpuOctreeBuilder();
+    ~GpuOctreeBuilder();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Check whether a scene fits the GPU builder's limits
+     */
+    static bool supports(size_t voxelCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    /**
+     * Upload voxels and build the octree into octreeBuffer
+     * @param voxels Scene voxels (only positions and colors are used)
+     * @param boundsMin Octree min corner (from computeOctreeBounds)
+     * @param boundsMax Octree max corner
+     * @param octreeBuffer SSBO in the raymarching.frag layout; reallocated
+     * @return false if the scene exceeds the builder's limits
+     */
+    bool build(const VoxelList& voxels, const glm::vec3& boundsMin, const glm::vec3& boundsMax, GLuint octreeBuffer);
+
+    /**
+     * Build from voxels already resident on the GPU
+     * @param voxelBuffer uvec2 per voxel: x = x | y << 10 | z << 20 relative to the octree min,
+     *                    y = packed RGBA8 color
+     * @param levels log2 of the octree extent
+     */
+    bool build(GLuint voxelBuffer, uint32_t voxelCount, int levels, GLuint octreeBuffer);
+
+    /**
+     * Read octreeBuffer back and compare it with a CPU-built node array
+     * @return true if node count and every node match
+     */
+    static bool validate(GLuint octreeBuffer, const GPUNodeList& reference);
+
+    /**
+     * Node capacity reserved by the last build (upper bound of the node count)
+     */
+    uint32_t getNodeCapacity() const { return nodeCapacity; }
+
+private:
+    void ensureCapacity(uint32_t voxelCount);
+    void dispatch(uint32_t groups);
+    void scan(GLuint buffer, uint32_t count, size_t level = 0);
+
+    Shader* mortonShader;
+    Shader* radixShader;
+    Shader* scanShader;
+    Shader* buildShader;
+
+    GLuint inputBuffer;
+    GLuint keys[2];
+    GLuint values[2];
+    GLuint histBuffer;
+    GLuint scanBuffers[2];
+    GLuint levelBuffer;
+    std::vector<GLuint> blockSums;   // one per recursion level of scan()
+
+    uint32_t capacity;      // voxels the scratch buffers can hold
+    uint32_t nodeCapacity;
+};
+
+#endif // GPU_OCTREE_BUILDER_H
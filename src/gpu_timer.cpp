@@ -0,0 +1,77 @@
+/**
+ * GPU Timer Implementation
+ */
+
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer()
+    : passCount(0)
+    , frame(0)
+    , activePass(-1)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    cleanup();
+}
+
+void GpuTimer::init(int count)
+{
+    cleanup();
+    passCount = count;
+    queries.resize(static_cast<size_t>(passCount) * (READBACK_LATENCY + 1));
+    issued.assign(queries.size(), 0);
+    milliseconds.assign(passCount, 0.0);
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+void GpuTimer::cleanup()
+{
+    if (!queries.empty()) glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    queries.clear();
+    issued.clear();
+    milliseconds.clear();
+    passCount = 0;
+    frame = 0;
+    activePass = -1;
+}
+
+void GpuTimer::beginFrame()
+{
+    if (passCount == 0) return;
+    ++frame;
+
+    // The slot about to be reused holds the oldest frame's queries
+    const size_t slot = static_cast<size_t>(frame % (READBACK_LATENCY + 1)) * passCount;
+    for (int pass = 0; pass < passCount; ++pass) {
+        if (!issued[slot + pass]) {
+            milliseconds[pass] = 0.0;
+            continue;
+        }
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries[slot + pass], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[slot + pass], GL_QUERY_RESULT, &ns);
+            milliseconds[pass] = static_cast<double>(ns) * 1e-6;
+        }
+        issued[slot + pass] = 0;
+    }
+}
+
+void GpuTimer::begin(int pass)
+{
+    if (pass < 0 || pass >= passCount || activePass >= 0) return;
+    const size_t index = static_cast<size_t>(frame % (READBACK_LATENCY + 1)) * passCount + pass;
+    glBeginQuery(GL_TIME_ELAPSED, queries[index]);
+    issued[index] = 1;
+    activePass = pass;
+}
+
+void GpuTimer::end()
+{
+    if (activePass < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    activePass = -1;
+}
@@ -0,0 +1,49 @@
+/**
+ * GPU Timer
+ *
+ * Per-pass GPU times from GL_TIME_ELAPSED queries. Every frame gets its own
+ * set of queries; results are read READBACK_LATENCY frames later, and only if
+ * the GPU already has them, so timing never stalls the pipeline. Passes may
+ * not nest.
+ */
+
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "gl_utils.h"
+
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void init(int passCount);
+    void cleanup();
+
+    /**
+     * Start the next frame's queries, picking up the results that are ready
+     */
+    void beginFrame();
+
+    void begin(int pass);
+    void end();
+
+    /**
+     * GPU time of a pass, READBACK_LATENCY frames ago; 0 if it did not run
+     */
+    double getMilliseconds(int pass) const { return pass < static_cast<int>(milliseconds.size()) ? milliseconds[pass] : 0.0; }
+
+private:
+    int passCount;
+    std::vector<GLuint> queries;    // [slot * passCount + pass]
+    std::vector<uint8_t> issued;    // Same indexing: the query ran in that slot's frame
+    std::vector<double> milliseconds;
+    uint64_t frame;
+    int activePass;
+};
+
+#endif // GPU_TIMER_H
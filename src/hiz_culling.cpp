@@ -0,0 +1,236 @@
+/**
+ * Hi-Z Occlusion Culling Implementation
+ */
+
+#include "hiz_culling.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <algorithm>
+
+namespace {
+
+constexpr GLuint GROUP_SIZE = 8;   // local_size_x/y of the Hi-Z compute shaders
+constexpr GLuint INSTANCE_GROUP_SIZE = 64;   // local_size_x of instance_cull.comp
+constexpr uint32_t FAR_BITS = 0x7F800000u;   // +infinity, cleared into the reprojection target
+
+GLuint groups(int size) {
+    return (static_cast<GLuint>(size) + GROUP_SIZE - 1) / GROUP_SIZE;
+}
+
+} // namespace
+
+HiZPyramid::HiZPyramid()
+    : reprojectShader(nullptr)
+    , downsampleShader(nullptr)
+    , depthTexture(0)
+    , reprojectedTexture(0)
+    , pyramidTexture(0)
+    , width(0)
+    , height(0)
+    , levels(0)
+    , captured(false)
+    , built(false)
+    , capturedViewProjection(1.0f)
+    , builtViewProjection(1.0f)
+{
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    cleanup();
+}
+
+void HiZPyramid::init()
+{
+    reprojectShader = new Shader("assets/shaders/hiz_reproject.comp");
+    downsampleShader = new Shader("assets/shaders/hiz_downsample.comp");
+}
+
+void HiZPyramid::cleanup()
+{
+    release();
+    delete reprojectShader; reprojectShader = nullptr;
+    delete downsampleShader; downsampleShader = nullptr;
+}
+
+void HiZPyramid::release()
+{
+    freeGLTexture(depthTexture);
+    freeGLTexture(reprojectedTexture);
+    freeGLTexture(pyramidTexture);
+    width = height = levels = 0;
+    captured = built = false;
+}
+
+void HiZPyramid::allocate(int newWidth, int newHeight)
+{
+    release();
+    width = newWidth;
+    height = newHeight;
+    levels = 1;
+    while ((std::max(width, height) >> levels) > 0) ++levels;
+    const size_t texels = static_cast<size_t>(width) * height;
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    MemoryStats::trackGLTexture(depthTexture, MemoryTag::GpuTexture, texels * 4);
+
+    glGenTextures(1, &reprojectedTexture);
+    glBindTexture(GL_TEXTURE_2D, reprojectedTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+    MemoryStats::trackGLTexture(reprojectedTexture, MemoryTag::GpuTexture, texels * 4);
+
+    // Levels halve with rounding down; the last texel of an odd row covers three
+    glGenTextures(1, &pyramidTexture);
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    size_t pyramidBytes = 0;
+    for (int level = 0; level < levels; ++level)
+        pyramidBytes += static_cast<size_t>(std::max(width >> level, 1)) * std::max(height >> level, 1) * 4;
+    MemoryStats::trackGLTexture(pyramidTexture, MemoryTag::GpuTexture, pyramidBytes);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HiZPyramid::captureDepth(int newWidth, int newHeight, const glm::mat4& viewProjection, GLuint framebuffer)
+{
+    PROFILE_FUNCTION();
+    if (newWidth <= 0 || newHeight <= 0) return;
+    if (newWidth != width || newHeight != height) allocate(newWidth, newHeight);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    capturedViewProjection = viewProjection;
+    captured = true;
+}
+
+bool HiZPyramid::build(const glm::mat4& viewProjection)
+{
+    PROFILE_FUNCTION();
+    built = false;
+    if (!captured || reprojectShader == nullptr) return false;
+
+    // Splat the previous frame's samples into the current view
+    glClearTexImage(reprojectedTexture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &FAR_BITS);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    reprojectShader->use();
+    reprojectShader->setMat4("u_reprojection", viewProjection * glm::inverse(capturedViewProjection));
+    reprojectShader->setInt("u_depth", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glBindImageTexture(0, reprojectedTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+    glDispatchCompute(groups(width), groups(height), 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // Level 0 converts the float bits, every further level keeps the max of its source texels
+    downsampleShader->use();
+    glBindImageTexture(0, reprojectedTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    for (int level = 0; level < levels; ++level) {
+        int w = std::max(width >> level, 1);
+        int h = std::max(height >> level, 1);
+        downsampleShader->setInt("u_level", level);
+        downsampleShader->setVec2("u_sourceSize", glm::vec2(std::max(width >> std::max(level - 1, 0), 1),
+                                                            std::max(height >> std::max(level - 1, 0), 1)));
+        glBindImageTexture(1, pyramidTexture, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(2, pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(groups(w), groups(h), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    builtViewProjection = viewProjection;
+    built = true;
+    return true;
+}
+
+void HiZPyramid::bind(const Shader& shader, GLuint unit, bool enabled) const
+{
+    shader.setBool("u_hizValid", enabled && built);
+    shader.setInt("u_hiz", static_cast<int>(unit));
+    shader.setInt("u_hizLevels", levels);
+    shader.setMat4("u_hizViewProjection", builtViewProjection);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+HiZInstanceCuller::HiZInstanceCuller()
+    : cullShader(nullptr)
+    , boxBuffer(0)
+    , visibilityBuffer(0)
+    , capacity(0)
+    , occludedCount(0)
+{
+}
+
+HiZInstanceCuller::~HiZInstanceCuller()
+{
+    cleanup();
+}
+
+void HiZInstanceCuller::init(int maxInstances)
+{
+    cullShader = new Shader("assets/shaders/instance_cull.comp");
+    capacity = maxInstances;
+
+    const size_t boxBytes = sizeof(glm::vec4) * 2 * capacity;
+    const size_t visibilityBytes = sizeof(uint32_t) * (4 + capacity);
+    glGenBuffers(1, &boxBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, boxBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, boxBytes, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(boxBuffer, MemoryTag::GpuOther, boxBytes);
+    glGenBuffers(1, &visibilityBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, visibilityBytes, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(visibilityBuffer, MemoryTag::GpuOther, visibilityBytes);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    readback.init(sizeof(uint32_t));
+}
+
+void HiZInstanceCuller::cleanup()
+{
+    freeGLBuffer(boxBuffer);
+    freeGLBuffer(visibilityBuffer);
+    readback.cleanup();
+    delete cullShader; cullShader = nullptr;
+    capacity = 0;
+}
+
+void HiZInstanceCuller::cull(const std::vector<glm::vec3>& boxes, const HiZPyramid& pyramid, bool enabled)
+{
+    PROFILE_FUNCTION();
+    if (cullShader == nullptr) return;
+    const uint32_t count = static_cast<uint32_t>(std::min<size_t>(boxes.size() / 2, static_cast<size_t>(capacity)));
+
+    // Flags default to visible so instances past count (or a skipped pass) still draw
+    std::vector<uint32_t> visibility(4 + capacity, 1u);
+    visibility[0] = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, visibility.size() * sizeof(uint32_t), visibility.data());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_VISIBILITY_BINDING, visibilityBuffer);
+
+    if (count > 0 && enabled) {
+        std::vector<glm::vec4> packed(count * 2);
+        for (uint32_t i = 0; i < count * 2; ++i) packed[i] = glm::vec4(boxes[i], 0.0f);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, boxBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, packed.size() * sizeof(glm::vec4), packed.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BOX_BINDING, boxBuffer);
+
+        cullShader->use();
+        cullShader->setUint("u_instanceCount", count);
+        pyramid.bind(*cullShader, 0, enabled);
+        glDispatchCompute((count + INSTANCE_GROUP_SIZE - 1) / INSTANCE_GROUP_SIZE, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    uint32_t occluded = 0;
+    if (readback.readback(visibilityBuffer, 0, &occluded)) occludedCount = static_cast<int>(occluded);
+}
@@ -0,0 +1,115 @@
+/**
+ * Hi-Z Occlusion Culling
+ *
+ * Hierarchical depth pyramid for occlusion tests of chunk and instance
+ * bounding boxes in compute shaders. At the end of a frame the depth buffer
+ * is copied together with its view-projection; at the start of the next one
+ * hiz_reproject.comp splats every depth sample into the new view, keeping
+ * the nearest linear view depth per texel, and hiz_downsample.comp reduces it
+ * to a max-depth mip chain. Texels nothing lands on (disocclusions, the
+ * background) stay at infinity, so a box is only rejected when reprojected
+ * surfaces cover its whole screen rectangle in front of it.
+ *
+ * Shaders test boxes with hizOccluded() (chunk_cull.comp, instance_cull.comp)
+ * after bind() has set their u_hiz* uniforms. HiZInstanceCuller runs the
+ * test for a handful of instance boxes and leaves one visibility flag per
+ * instance in an SSBO, so the draw that follows can skip occluded instances
+ * without a CPU round trip.
+ */
+
+#ifndef HIZ_CULLING_H
+#define HIZ_CULLING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "gl_utils.h"
+#include "shader.h"
+
+// SSBO binding points of instance_cull.comp (visibility is read by raymarching.frag)
+constexpr GLuint INSTANCE_BOX_BINDING = 7;
+constexpr GLuint INSTANCE_VISIBILITY_BINDING = 8;
+
+class HiZPyramid {
+public:
+    HiZPyramid();
+    ~HiZPyramid();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Keep the depth buffer of the frame just drawn (lower left width x
+     * height of framebuffer, 0 = default) for the next build()
+     */
+    void captureDepth(int width, int height, const glm::mat4& viewProjection, GLuint framebuffer = 0);
+
+    /**
+     * Reproject the captured depth into viewProjection and rebuild the pyramid
+     * @return false if there is no captured depth yet
+     */
+    bool build(const glm::mat4& viewProjection);
+
+    /**
+     * Drop the captured depth (e.g. when the scene is replaced)
+     */
+    void invalidate() { captured = false; }
+
+    /**
+     * Set the u_hiz* uniforms of a culling shader and bind the pyramid to
+     * texture unit `unit`; enabled = false makes hizOccluded() always fail
+     */
+    void bind(const Shader& shader, GLuint unit, bool enabled) const;
+
+private:
+    void allocate(int width, int height);
+    void release();
+
+    Shader* reprojectShader;
+    Shader* downsampleShader;
+    GLuint depthTexture;        // Copy of the previous frame's depth buffer
+    GLuint reprojectedTexture;  // r32ui, float bits of the nearest view depth per texel
+    GLuint pyramidTexture;      // r32f, max view depth per texel, one level per halving
+    int width;
+    int height;
+    int levels;
+    bool captured;
+    bool built;
+    glm::mat4 capturedViewProjection;
+    glm::mat4 builtViewProjection;      // View the pyramid was reprojected into
+};
+
+class HiZInstanceCuller {
+public:
+    HiZInstanceCuller();
+    ~HiZInstanceCuller();
+
+    /**
+     * @param maxInstances capacity of the box and visibility buffers
+     */
+    void init(int maxInstances);
+    void cleanup();
+
+    /**
+     * Test boxes (min, max pairs, at most maxInstances) against the pyramid
+     * and bind the visibility flags to INSTANCE_VISIBILITY_BINDING; with
+     * enabled = false every instance is visible
+     */
+    void cull(const std::vector<glm::vec3>& boxes, const HiZPyramid& pyramid, bool enabled);
+
+    /**
+     * Instances found occluded READBACK_LATENCY frames ago
+     */
+    int getOccludedCount() const { return occludedCount; }
+
+private:
+    Shader* cullShader;
+    GLuint boxBuffer;
+    GLuint visibilityBuffer;    // occluded count, 3 pad, then one flag per instance
+    ReadbackRing readback;
+    int capacity;
+    int occludedCount;
+};
+
+#endif // HIZ_CULLING_H
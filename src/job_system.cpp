@@ -0,0 +1,362 @@
+/**
+ * Job System Implementation
+ */
+
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+#include <string>
+
+struct Job {
+    std::function<void()> fn;
+    bool mainThread = false;
+
+    // Unfinished dependencies + 1 while the job is still being set up
+    std::atomic<int> pendingDeps{1};
+
+    std::mutex lock;
+    bool done = false;
+    std::vector<Job*> continuations;
+
+    // Keeps the job alive while it sits in a queue; released after it finished
+    std::shared_ptr<Job> self;
+};
+
+// Index of the worker owned by the current thread, -1 for non-worker threads
+static thread_local int tlsWorkerIndex = -1;
+static thread_local JobSystem* tlsWorkerOwner = nullptr;
+
+bool JobHandle::isDone() const {
+    if (!job) return true;
+    std::lock_guard<std::mutex> guard(job->lock);
+    return job->done;
+}
+
+// ============================================================================
+// WorkStealingDeque
+// ============================================================================
+
+WorkStealingDeque::WorkStealingDeque(size_t capacityPow2)
+    : buffer(capacityPow2)
+    , mask(static_cast<int64_t>(capacityPow2) - 1)
+    , top(0)
+    , bottom(0)
+{
+}
+
+bool WorkStealingDeque::push(Job* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t > mask) return false;
+    buffer[b & mask].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Job* WorkStealingDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // Deque was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last element: race against thieves
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+bool WorkStealingDeque::empty() const {
+    return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+}
+
+// ============================================================================
+// JobSystem
+// ============================================================================
+
+JobSystem& JobSystem::instance() {
+    static JobSystem system(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    return system;
+}
+
+JobSystem::JobSystem(int workerCount)
+    : statsEpoch(std::chrono::steady_clock::now())
+{
+    workerCount = std::max(1, workerCount);
+    workerState.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        workerState.push_back(std::make_unique<Worker>());
+    }
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> guard(sleepMutex);
+        running.store(false);
+    }
+    sleepCv.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+
+    // Drop whatever was never run so the self references are released
+    for (Job* job : injectQueue) job->self.reset();
+    for (Job* job : mainQueue) job->self.reset();
+}
+
+JobHandle JobSystem::submit(std::function<void()> fn, std::initializer_list<JobHandle> deps) {
+    return submitImpl(std::move(fn), deps.begin(), deps.size(), false);
+}
+
+JobHandle JobSystem::submit(std::function<void()> fn, const std::vector<JobHandle>& deps) {
+    return submitImpl(std::move(fn), deps.data(), deps.size(), false);
+}
+
+JobHandle JobSystem::submitMain(std::function<void()> fn, std::initializer_list<JobHandle> deps) {
+    return submitImpl(std::move(fn), deps.begin(), deps.size(), true);
+}
+
+JobHandle JobSystem::submitImpl(std::function<void()> fn, const JobHandle* deps, size_t depCount, bool mainThread) {
+    auto job = std::make_shared<Job>();
+    job->fn = std::move(fn);
+    job->mainThread = mainThread;
+    job->self = job;
+
+    // Register as continuation of every unfinished dependency
+    for (size_t i = 0; i < depCount; ++i) {
+        Job* dep = deps[i].job.get();
+        if (!dep) continue;
+        std::lock_guard<std::mutex> guard(dep->lock);
+        if (!dep->done) {
+            job->pendingDeps.fetch_add(1, std::memory_order_relaxed);
+            dep->continuations.push_back(job.get());
+        }
+    }
+
+    // Drop the setup reference; schedule if nothing is outstanding
+    if (job->pendingDeps.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        schedule(job.get());
+    }
+    return JobHandle(job);
+}
+
+void JobSystem::schedule(Job* job) {
+    if (job->mainThread) {
+        std::lock_guard<std::mutex> guard(mainMutex);
+        mainQueue.push_back(job);
+        return;
+    }
+
+    pendingJobs.fetch_add(1, std::memory_order_release);
+    if (tlsWorkerOwner == this && tlsWorkerIndex >= 0 &&
+        workerState[tlsWorkerIndex]->deque.push(job)) {
+        wake();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(injectMutex);
+        injectQueue.push_back(job);
+    }
+    wake();
+}
+
+void JobSystem::wake() {
+    // Taking the lock orders the notify after a worker's predicate check
+    { std::lock_guard<std::mutex> guard(sleepMutex); }
+    sleepCv.notify_one();
+}
+
+void JobSystem::execute(Job* job) {
+    if (job->fn) job->fn();
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    std::vector<Job*> ready;
+    {
+        std::lock_guard<std::mutex> guard(job->lock);
+        job->done = true;
+        ready.swap(job->continuations);
+    }
+    for (Job* next : ready) {
+        if (next->pendingDeps.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(next);
+        }
+    }
+    job->fn = nullptr;
+    job->self.reset(); // may destroy the job
+}
+
+Job* JobSystem::findWork(int selfIndex) {
+    Job* job = nullptr;
+
+    if (selfIndex >= 0) {
+        job = workerState[selfIndex]->deque.pop();
+        if (job) return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(injectMutex);
+        if (!injectQueue.empty()) {
+            job = injectQueue.front();
+            injectQueue.pop_front();
+            return job;
+        }
+    }
+
+    // Steal, starting after our own slot so thieves spread across victims
+    const int count = static_cast<int>(workerState.size());
+    const int start = selfIndex >= 0 ? selfIndex + 1 : 0;
+    for (int i = 0; i < count; ++i) {
+        int victim = (start + i) % count;
+        if (victim == selfIndex) continue;
+        job = workerState[victim]->deque.steal();
+        if (job) {
+            if (selfIndex >= 0) workerState[selfIndex]->steals.fetch_add(1, std::memory_order_relaxed);
+            else externalSteals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    if (selfIndex >= 0) workerState[selfIndex]->failedSteals.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+bool JobSystem::tryRunOne() {
+    int self = (tlsWorkerOwner == this) ? tlsWorkerIndex : -1;
+    Job* job = findWork(self);
+    if (!job) return false;
+
+    pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+    execute(job);
+    if (self >= 0) workerState[self]->executed.fetch_add(1, std::memory_order_relaxed);
+    else externalExecuted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    tlsWorkerIndex = index;
+    tlsWorkerOwner = this;
+    Worker& self = *workerState[index];
+
+#ifdef HOMOGENEOUS_PROFILER
+    std::string threadName = "Worker " + std::to_string(index);
+    PROFILE_THREAD_NAME(threadName.c_str());
+#endif
+
+    while (running.load(std::memory_order_acquire)) {
+        if (tryRunOne()) continue;
+
+        auto idleStart = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCv.wait_for(lock, std::chrono::milliseconds(2), [this] {
+                return !running.load(std::memory_order_acquire) ||
+                       pendingJobs.load(std::memory_order_acquire) > 0;
+            });
+        }
+        auto idleNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - idleStart).count();
+        self.idleNs.fetch_add(static_cast<uint64_t>(idleNs), std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::wait(const JobHandle& handle) {
+    while (!handle.isDone()) {
+        if (!tryRunOne()) std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain,
+                            const std::function<void(size_t, size_t)>& body) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(1, grain);
+    if (end - begin <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    // Recursive halving: each job keeps the left half and publishes the right
+    // half, so idle workers steal large ranges first.
+    std::atomic<size_t> remaining(end - begin);
+    std::function<void(size_t, size_t)> split = [&](size_t b, size_t e) {
+        while (e - b > grain) {
+            size_t mid = b + (e - b) / 2;
+            size_t rb = mid, re = e;
+            submit([&split, rb, re] { split(rb, re); });
+            e = mid;
+        }
+        body(b, e);
+        remaining.fetch_sub(e - b, std::memory_order_acq_rel);
+    };
+
+    split(begin, end);
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne()) std::this_thread::yield();
+    }
+}
+
+int JobSystem::pumpMainThread() {
+    std::deque<Job*> batch;
+    {
+        std::lock_guard<std::mutex> guard(mainMutex);
+        batch.swap(mainQueue);
+    }
+    for (Job* job : batch) execute(job);
+    return static_cast<int>(batch.size());
+}
+
+JobSystem::Stats JobSystem::getStats() const {
+    Stats s;
+    s.workerCount = static_cast<int>(workerState.size());
+    for (const auto& w : workerState) {
+        s.jobsExecuted += w->executed.load(std::memory_order_relaxed);
+        s.steals += w->steals.load(std::memory_order_relaxed);
+        s.failedSteals += w->failedSteals.load(std::memory_order_relaxed);
+        s.idleSeconds += w->idleNs.load(std::memory_order_relaxed) * 1e-9;
+    }
+    s.jobsExecuted += externalExecuted.load(std::memory_order_relaxed);
+    s.steals += externalSteals.load(std::memory_order_relaxed);
+    s.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsEpoch).count();
+    return s;
+}
+
+void JobSystem::resetStats() {
+    for (auto& w : workerState) {
+        w->executed.store(0, std::memory_order_relaxed);
+        w->steals.store(0, std::memory_order_relaxed);
+        w->failedSteals.store(0, std::memory_order_relaxed);
+        w->idleNs.store(0, std::memory_order_relaxed);
+    }
+    externalExecuted.store(0, std::memory_order_relaxed);
+    externalSteals.store(0, std::memory_order_relaxed);
+    statsEpoch = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,179 @@
+/**
+ * Job System
+ *
+ * Engine-wide worker pool shared by the loader, octree builder and any other
+ * CPU-heavy stage. Each worker owns a Chase-Lev work-stealing deque; idle
+ * workers steal from the top of other workers' deques, while the owner pushes
+ * and pops at the bottom without locking.
+ *
+ * Features:
+ * - submit() with optional dependencies; a job runs once all of them finished
+ * - then() continuations
+ * - parallelFor() with a grain size (recursive range splitting)
+ * - main-thread jobs for OpenGL work, drained by pumpMainThread() every frame
+ * - steal / idle counters for the control panel
+ */
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+/**
+ * Shared handle to a submitted job. An empty handle counts as finished.
+ */
+class JobHandle {
+public:
+    JobHandle() = default;
+    bool valid() const { return job != nullptr; }
+    bool isDone() const;
+
+private:
+    friend class JobSystem;
+    explicit JobHandle(std::shared_ptr<Job> j) : job(std::move(j)) {}
+    std::shared_ptr<Job> job;
+};
+
+/**
+ * Fixed-capacity Chase-Lev deque of job pointers.
+ * push()/pop() may only be called by the owning worker, steal() by anyone.
+ */
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacityPow2 = 4096);
+
+    bool push(Job* job);   // false when the ring is full
+    Job* pop();            // owner side (LIFO)
+    Job* steal();          // thief side (FIFO), nullptr when empty or on a lost race
+    bool empty() const;
+
+private:
+    std::vector<std::atomic<Job*>> buffer;
+    int64_t mask;
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+};
+
+class JobSystem {
+public:
+    /**
+     * Counters accumulated since the last resetStats()
+     */
+    struct Stats {
+        uint64_t jobsExecuted = 0;
+        uint64_t steals = 0;         // Jobs taken from another worker's deque
+        uint64_t failedSteals = 0;   // Steal attempts that found nothing
+        double idleSeconds = 0.0;    // Summed over all workers
+        double wallSeconds = 0.0;    // Time since the counters were reset
+        int workerCount = 0;
+
+        double stealRate() const { return jobsExecuted ? double(steals) / double(jobsExecuted) : 0.0; }
+        double idleFraction() const {
+            return (wallSeconds > 0.0 && workerCount > 0) ? idleSeconds / (wallSeconds * workerCount) : 0.0;
+        }
+    };
+
+    /**
+     * Global pool, created on first use with hardware_concurrency() - 1 workers
+     */
+    static JobSystem& instance();
+
+    explicit JobSystem(int workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * Schedule a job on the worker pool
+     * @param fn Work to run
+     * @param deps Jobs that must finish before fn starts
+     */
+    JobHandle submit(std::function<void()> fn, std::initializer_list<JobHandle> deps = {});
+    JobHandle submit(std::function<void()> fn, const std::vector<JobHandle>& deps);
+
+    /**
+     * Schedule a job on the main thread (e.g. GL uploads); it runs during
+     * pumpMainThread() once its dependencies have finished
+     */
+    JobHandle submitMain(std::function<void()> fn, std::initializer_list<JobHandle> deps = {});
+
+    /**
+     * Continuation: run fn after dep has finished
+     */
+    JobHandle then(const JobHandle& dep, std::function<void()> fn) { return submit(std::move(fn), {dep}); }
+
+    /**
+     * Block until the job finished, executing other jobs meanwhile.
+     * Never call from a worker while waiting on a main-thread job.
+     */
+    void wait(const JobHandle& handle);
+
+    /**
+     * Run body(rangeBegin, rangeEnd) over [begin, end) in chunks of at most grain
+     * elements and block until all chunks are done
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * Execute queued main-thread jobs. Call once per frame from the GL thread.
+     * @return Number of jobs executed
+     */
+    int pumpMainThread();
+
+    int getWorkerCount() const { return static_cast<int>(workers.size()); }
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    void workerLoop(int index);
+    void schedule(Job* job);
+    void execute(Job* job);
+    void finish(Job* job);
+    bool tryRunOne();
+    Job* findWork(int selfIndex);
+    JobHandle submitImpl(std::function<void()> fn, const JobHandle* deps, size_t depCount, bool mainThread);
+    void wake();
+
+    struct Worker {
+        WorkStealingDeque deque;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> failedSteals{0};
+        std::atomic<uint64_t> idleNs{0};
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Worker>> workerState;
+
+    // Jobs submitted from non-worker threads
+    std::mutex injectMutex;
+    std::deque<Job*> injectQueue;
+
+    std::mutex mainMutex;
+    std::deque<Job*> mainQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int> pendingJobs{0};
+    std::atomic<bool> running{true};
+
+    std::atomic<uint64_t> externalExecuted{0};
+    std::atomic<uint64_t> externalSteals{0};
+    std::chrono::steady_clock::time_point statsEpoch;
+};
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,25 @@
+/**
+ * Lighting
+ *
+ * Light sources shared by the ray caster shading (raycast_common.glsl) and
+ * the path tracer (PathTracer, GPU and CPU reference).
+ */
+
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <glm/glm.hpp>
+
+// Lights the shaders take (MAX_LIGHTS in raycast_common.glsl)
+constexpr int MAX_LIGHTS = 4;
+
+/**
+ * Sun-like light at infinity; color is the irradiance it delivers to a
+ * surface facing it
+ */
+struct DirectionalLight {
+    glm::vec3 direction;  // Towards the light, normalized on upload
+    glm::vec3 color;
+};
+
+#endif // LIGHTING_H
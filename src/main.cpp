@@ -2,7 +2,12 @@
 #include <vector>
 #include <climits>
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -14,6 +19,12 @@
 #include "voxel_renderer.h"
 #include "voxel.h"
 #include "vox_reader.h"
+#include "vox_writer.h"
+#include "mesh_voxelizer.h"
+#include "point_cloud_importer.h"
+#include "volume_importer.h"
+#include "job_system.h"
+#include "profiler.h"
 
 #define GLFW_EXPOSE_NATIVE_WIN32
 #define NOMINMAX  // Prevent Windows.h from defining min/max macros
@@ -29,6 +40,8 @@ struct FPSCamera {
     float speed  = 50.0f;
     float sensitivity = 0.1f;
     float fov = 45.0f;
+    bool collision = false;     // Collide and slide against the octree
+    float radius = 1.0f;        // Half extent of the collision box
 
     bool mouseCaptured = false;
     double lastMouseX = 0.0, lastMouseY = 0.0;
@@ -51,8 +64,28 @@ struct FPSCamera {
 
 static FPSCamera camera;
 static std::string vox_path = "assets/voxes/pieta.vox";
+static int importResolution = 256;
+static int volumeThreshold = 1;
+static bool volumeHollow = false;
+static std::string save_path = "assets/voxes/saved.vox";
+static Brush brush;
+static std::string csg_path = "assets/voxes/aiz.vox";
+static int csgOp = 0;
+static int pathReferenceSamples = 64;
+static std::vector<AoErrorPoint> aoConvergence;
+
+// View ray through a framebuffer pixel, matching getCameraRay() in raymarching.frag
+glm::vec3 pixelRay(const FPSCamera& cam, float px, float py, int width, int height) {
+    glm::vec3 forward = cam.front();
+    glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), forward));
+    glm::vec3 up = glm::cross(forward, right);
+    float tanHalf = tan(glm::radians(cam.fov) * 0.5f);
+    float ndcX = (px / static_cast<float>(width) * 2.0f - 1.0f) * static_cast<float>(width) / static_cast<float>(height);
+    float ndcY = 1.0f - py / static_cast<float>(height) * 2.0f;
+    return glm::normalize(forward + ndcX * right * tanHalf + ndcY * up * tanHalf);
+}
 
-// Open Windows file dialog to select .vox file
+// Open Windows file dialog to select a .vox, mesh, point cloud or volume file
 bool openFileDialog(std::string& outPath, GLFWwindow* window) {
     OPENFILENAMEA ofn;
     char szFile[260] = { 0 };
@@ -62,7 +95,7 @@ bool openFileDialog(std::string& outPath, GLFWwindow* window) {
     ofn.hwndOwner = glfwGetWin32Window(window);
     ofn.lpstrFile = szFile;
     ofn.nMaxFile = sizeof(szFile);
-    ofn.lpstrFilter = "VOX Files (*.vox)\0*.vox\0All Files (*.*)\0*.*\0";
+    ofn.lpstrFilter = "Voxel Scenes (*.vox;*.obj;*.ply;*.xyz;*.pts;*.raw;*.binvox)\0*.vox;*.obj;*.ply;*.xyz;*.pts;*.raw;*.binvox\0VOX Files (*.vox)\0*.vox\0Meshes (*.obj;*.ply)\0*.obj;*.ply\0Point Clouds (*.ply;*.xyz;*.pts)\0*.ply;*.xyz;*.pts\0Volumes (*.raw;*.binvox)\0*.raw;*.binvox\0All Files (*.*)\0*.*\0";
     ofn.nFilterIndex = 1;
     ofn.lpstrFileTitle = NULL;
     ofn.nMaxFileTitle = 0;
@@ -76,7 +109,8 @@ bool openFileDialog(std::string& outPath, GLFWwindow* window) {
     return false;
 }
 
-int loadVoxFile(std::vector<Voxel>& voxels) {
+int loadVoxFile(VoxelList& voxels) {
+    PROFILE_FUNCTION();
     try {
         voxels.clear();
         std::cout << "Loading .vox..." << std::endl;
@@ -85,53 +119,90 @@ int loadVoxFile(std::vector<Voxel>& voxels) {
         std::cout << "VOX file version: " << voxFile.version << std::endl;
         std::cout << "Number of models: " << voxFile.models.size() << std::endl;
 
-        // Merge all sub-models with their scene graph transforms
-        size_t totalVoxelCount = 0;
-        for (const auto& m : voxFile.models) totalVoxelCount += m.voxels.size();
-        voxels.reserve(totalVoxelCount);
+        // Merge all sub-models with their scene graph transforms.
+        // modelOffsets[mi] is the first output slot of model mi, so every voxel
+        // has a fixed destination and the merge can run on the job system.
+        std::vector<size_t> modelOffsets(voxFile.models.size() + 1, 0);
+        for (size_t mi = 0; mi < voxFile.models.size(); ++mi)
+            modelOffsets[mi + 1] = modelOffsets[mi] + voxFile.models[mi].voxels.size();
+        size_t totalVoxelCount = modelOffsets.back();
+        voxels.resize(totalVoxelCount);
+
+        // Visit voxels [b, e) of the merged list as (model, local index) pairs
+        auto forEachVoxel = [&](size_t b, size_t e, auto&& fn) {
+            size_t mi = std::upper_bound(modelOffsets.begin(), modelOffsets.end(), b) - modelOffsets.begin() - 1;
+            for (size_t i = b; i < e; ++i) {
+                while (i >= modelOffsets[mi + 1]) ++mi;
+                fn(i, voxFile.models[mi], voxFile.modelTransforms[mi], voxFile.models[mi].voxels[i - modelOffsets[mi]]);
+            }
+        };
+
+        JobSystem& jobs = JobSystem::instance();
+        constexpr size_t grain = 64 * 1024;
 
         // Compute overall bounding box center for centering
-        int minX = INT_MAX, minY = INT_MAX, minZ = INT_MAX;
-        int maxX = INT_MIN, maxY = INT_MIN, maxZ = INT_MIN;
-
-        for (size_t mi = 0; mi < voxFile.models.size(); ++mi) {
-            const VoxelModel& model = voxFile.models[mi];
-            const ModelTransform& tr = voxFile.modelTransforms[mi];
-            for (const auto& v : model.voxels) {
+        std::mutex boundsMutex;
+        glm::ivec3 bmin(INT_MAX), bmax(INT_MIN);
+        jobs.parallelFor(0, totalVoxelCount, grain, [&](size_t b, size_t e) {
+            glm::ivec3 lmin(INT_MAX), lmax(INT_MIN);
+            forEachVoxel(b, e, [&](size_t, const VoxelModel& model, const ModelTransform& tr, const VoxData& v) {
                 // VOX scene graph translation is in world space
                 // Voxel local coords are [0, size), transform gives the model origin offset
-                int wx = static_cast<int>(v.x) + tr.tx - model.sizeX / 2;
-                int wy = static_cast<int>(v.y) + tr.ty - model.sizeY / 2;
-                int wz = static_cast<int>(v.z) + tr.tz - model.sizeZ / 2;
-                minX = std::min(minX, wx); maxX = std::max(maxX, wx);
-                minY = std::min(minY, wy); maxY = std::max(maxY, wy);
-                minZ = std::min(minZ, wz); maxZ = std::max(maxZ, wz);
+                glm::ivec3 w(static_cast<int>(v.x) + tr.tx - model.sizeX / 2,
+                             static_cast<int>(v.y) + tr.ty - model.sizeY / 2,
+                             static_cast<int>(v.z) + tr.tz - model.sizeZ / 2);
+                lmin = glm::min(lmin, w);
+                lmax = glm::max(lmax, w);
+            });
+            std::lock_guard<std::mutex> guard(boundsMutex);
+            bmin = glm::min(bmin, lmin);
+            bmax = glm::max(bmax, lmax);
+        });
+
+        // MATL chunks as written by VoxWriter: emission, or metallic with its roughness
+        std::array<VoxelMaterial, 256> indexMaterial{};
+        for (const VoxMaterial& material : voxFile.materials) {
+            if (material.id < 1 || material.id > 255) continue;
+            auto property = [&](const char* name, float fallback) {
+                auto it = material.properties.find(name);
+                return it != material.properties.end() ? std::strtof(it->second.c_str(), nullptr) : fallback;
+            };
+            auto type = material.properties.find("_type");
+            if (type == material.properties.end()) continue;
+            VoxelMaterial& target = indexMaterial[material.id];
+            if (type->second == "_emit") {
+                target.emission = property("_emit", 0.0f);
+            } else if (type->second == "_metal") {
+                target.metallic = property("_metal", 0.0f);
+                target.roughness = property("_rough", target.roughness);
             }
         }
 
-        int centerX = (minX + maxX) / 2;
-        int centerY = (minY + maxY) / 2;
-        int centerZ = (minZ + maxZ) / 2;
+        int centerX = (bmin.x + bmax.x) / 2;
+        int centerY = (bmin.y + bmax.y) / 2;
+        int centerZ = (bmin.z + bmax.z) / 2;
 
-        for (size_t mi = 0; mi < voxFile.models.size(); ++mi) {
-            const VoxelModel& model = voxFile.models[mi];
-            const ModelTransform& tr = voxFile.modelTransforms[mi];
-            for (const auto& voxData : model.voxels) {
+        jobs.parallelFor(0, totalVoxelCount, grain, [&](size_t b, size_t e) {
+            forEachVoxel(b, e, [&](size_t i, const VoxelModel& model, const ModelTransform& tr, const VoxData& voxData) {
                 int wx = static_cast<int>(voxData.x) + tr.tx - model.sizeX / 2 - centerX;
                 int wy = static_cast<int>(voxData.y) + tr.ty - model.sizeY / 2 - centerY;
                 int wz = static_cast<int>(voxData.z) + tr.tz - model.sizeZ / 2 - centerZ;
 
                 const RGBAColor& paletteColor = voxFile.palette[voxData.colorIndex - 1];
-                Voxel voxel(
+                voxels[i] = Voxel(
                     wx, wy, wz,
                     paletteColor.r / 255.0f,
                     paletteColor.g / 255.0f,
                     paletteColor.b / 255.0f,
                     paletteColor.a / 255.0f
                 );
-                voxels.push_back(voxel);
-            }
-        }
+                voxels[i].setColorIndex(voxData.colorIndex);
+                const VoxelMaterial& material = indexMaterial[voxData.colorIndex];
+                voxels[i].setRoughness(material.roughness);
+                voxels[i].setMetallic(material.metallic);
+                voxels[i].setEmission(material.emission);
+            });
+        });
 
         std::cout << "Successfully loaded " << voxels.size() << " voxels from "
                   << voxFile.models.size() << " sub-models" << std::endl;
@@ -142,8 +213,182 @@ int loadVoxFile(std::vector<Voxel>& voxels) {
     }
 }
 
-int main()
+int loadMeshFile(VoxelList& voxels) {
+    PROFILE_FUNCTION();
+    try {
+        std::cout << "Loading mesh..." << std::endl;
+        MeshData mesh = MeshReader::load(vox_path);
+
+        MeshVoxelizer::Options options;
+        options.resolution = std::max(1, importResolution);
+        MeshVoxelizer::voxelize(mesh, options, voxels);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading mesh file: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int loadPointCloudFile(VoxelList& voxels) {
+    PROFILE_FUNCTION();
+    try {
+        std::cout << "Streaming point cloud..." << std::endl;
+        PointCloudImporter::Options options;
+        options.resolution = std::max(1, importResolution);
+        PointCloudImporter::import(vox_path, options, voxels);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading point cloud: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// Load vox_path with the importer matching its extension
+int loadSceneFile(VoxelList& voxels) {
+    if (VolumeImporter::isVolumeFile(vox_path)) {
+        std::cerr << "Volumes are built straight into the octree and have no voxel list" << std::endl;
+        return -1;
+    }
+    // Vertex-only .ply files are point clouds, the rest are meshes
+    if (PointCloudImporter::isPointCloudFile(vox_path)) return loadPointCloudFile(voxels);
+    if (MeshReader::isMeshFile(vox_path)) return loadMeshFile(voxels);
+    return loadVoxFile(voxels);
+}
+
+// Save the current voxels to save_path and check the file with VoxReader
+int saveVoxFile(VoxelList& voxels) {
+    PROFILE_FUNCTION();
+    if (voxels.empty() && loadSceneFile(voxels) != 0) return -1;
+    try {
+        VoxFile voxFile = VoxWriter::fromVoxels(voxels);
+        VoxWriter::save(save_path, voxFile);
+        return VoxWriter::verify(save_path, voxFile) ? 0 : -1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving VOX file: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// A scene file imported on the worker pool, waiting for the GL thread
+struct LoadedScene {
+    bool volume = false;
+    int status = -1;
+    VoxelList voxels;
+    GPUNodeList nodes;      // Octree; empty when the renderer builds it (GPU builder)
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    int solidCount = 0;
+};
+
+// Volumes skip the voxel list and build their octree directly
+int loadVolumeFile(LoadedScene& scene) {
+    PROFILE_FUNCTION();
+    try {
+        std::cout << "Loading volume..." << std::endl;
+        VolumeImporter::Options options;
+        options.threshold = static_cast<uint32_t>(std::max(1, volumeThreshold));
+        options.hollow = volumeHollow;
+        VolumeImporter::Result volume = VolumeImporter::import(vox_path, options);
+        scene.nodes = std::move(volume.nodes);
+        scene.boundsMin = volume.boundsMin;
+        scene.boundsMax = volume.boundsMax;
+        scene.solidCount = static_cast<int>(std::min<size_t>(volume.solidCount, INT_MAX));
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading volume: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// Load csg_path as an octree (centered on the origin) for CSG with the scene
+int loadCsgOperand(GPUNodeList& nodes, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    PROFILE_FUNCTION();
+    std::swap(vox_path, csg_path); // the loaders read vox_path
+    int status = 0;
+    if (VolumeImporter::isVolumeFile(vox_path)) {
+        try {
+            VolumeImporter::Options options;
+            options.threshold = static_cast<uint32_t>(std::max(1, volumeThreshold));
+            VolumeImporter::Result volume = VolumeImporter::import(vox_path, options);
+            nodes = std::move(volume.nodes);
+            boundsMin = volume.boundsMin;
+            boundsMax = volume.boundsMax;
+        } catch (const std::exception& e) {
+            std::cerr << "Error loading volume: " << e.what() << std::endl;
+            status = -1;
+        }
+    } else {
+        VoxelList voxels;
+        status = loadSceneFile(voxels);
+        if (status == 0 && !voxels.empty()) {
+            computeOctreeBounds(voxels, boundsMin, boundsMax);
+            flattenOctree(buildOctree(voxels, boundsMin, boundsMax, 0), nodes);
+        }
+    }
+    std::swap(vox_path, csg_path);
+    return status;
+}
+
+// Jobs of a scene load: the import and octree build on the workers, the
+// renderer update on the main thread
+struct SceneLoad {
+    JobHandle built;
+    JobHandle uploaded;
+};
+
+// Load vox_path: import it on the workers, build the CPU octree as a
+// continuation and hand both to the renderer from pumpMainThread(), which
+// sets status. vox_path and the import settings must not change before
+// uploaded has finished.
+SceneLoad loadScene(VoxelRenderer& renderer, VoxelList& voxels, int& status) {
+    JobSystem& jobs = JobSystem::instance();
+    auto scene = std::make_shared<LoadedScene>();
+    scene->volume = VolumeImporter::isVolumeFile(vox_path);
+    const bool cpuOctree = !renderer.gpuOctreeBuild;
+    MemoryStats::beginPeakWindow();
+
+    SceneLoad load;
+    JobHandle imported = jobs.submit([scene] {
+        scene->status = scene->volume ? loadVolumeFile(*scene) : loadSceneFile(scene->voxels);
+    });
+    load.built = jobs.then(imported, [scene, cpuOctree] {
+        if (scene->volume || scene->status != 0 || !cpuOctree || scene->voxels.empty()) return;
+        PROFILE_ZONE("Build octree");
+        computeOctreeBounds(scene->voxels, scene->boundsMin, scene->boundsMax);
+        flattenOctree(buildOctree(scene->voxels, scene->boundsMin, scene->boundsMax, 0), scene->nodes);
+    });
+    load.uploaded = jobs.submitMain([scene, &renderer, &voxels, &status] {
+        status = scene->status;
+        if (status != 0) {
+            std::cerr << "Failed to load voxel model" << std::endl;
+            MemoryStats::endPeakWindow();
+            return;
+        }
+        if (scene->volume) {
+            releaseVector(voxels);
+            renderer.setOctree(std::move(scene->nodes), scene->boundsMin, scene->boundsMax, scene->solidCount);
+        } else {
+            voxels.swap(scene->voxels);
+            renderer.setVoxels(voxels, std::move(scene->nodes), scene->boundsMin, scene->boundsMax);
+            if (renderer.lowMemoryMode) releaseVector(voxels);
+        }
+        std::cout << "Load peak memory: " << MemoryStats::endPeakWindow() / (1024.0 * 1024.0) << " MB" << std::endl;
+    }, {load.built});
+    return load;
+}
+
+int main(int argc, char** argv)
 {
+    // Homogeneous [scene file] [--validate-gpu-octree]; the flag builds the
+    // scene's octree with GpuOctreeBuilder in a hidden window, compares it
+    // node for node with the CPU builder and exits with 0 when they match
+    bool validateOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--validate-gpu-octree") validateOnly = true;
+        else vox_path = arg;
+    }
+
     std::cout << "Hello, Homogeneous!" << std::endl;
     std::cout << "Initializing GLFW..." << std::endl;
 
@@ -158,6 +403,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (validateOnly) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // Create window
     GLFWwindow* window = glfwCreateWindow(1280, 768, "Homogeneous", nullptr, nullptr);
@@ -197,16 +443,31 @@ int main()
     // Initialize VoxelRenderer
     VoxelRenderer renderer;
     renderer.init();
+    if (validateOnly) renderer.gpuOctreeBuild = true;
 
     // Load voxel model
-    std::vector<Voxel> voxels;
+    VoxelList voxels;
 
-    if (loadVoxFile(voxels) != 0) {
-        std::cerr << "Failed to load voxel model. Exiting." << std::endl;
+    int loadStatus = -1;
+    SceneLoad sceneLoad = loadScene(renderer, voxels, loadStatus);
+    while (!sceneLoad.uploaded.isDone()) {
+        JobSystem::instance().wait(sceneLoad.built);
+        JobSystem::instance().pumpMainThread();
+    }
+    if (loadStatus != 0) {
+        std::cerr << "Exiting." << std::endl;
         return -1;
     }
-
-    renderer.setVoxels(voxels);
+    if (validateOnly) {
+        bool match = renderer.validateGpuOctree(voxels);
+        renderer.cleanup();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return match ? 0 : 1;
+    }
 
     // Set clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -216,16 +477,27 @@ int main()
     std::cout << "WASD to move, Space to go up, Shift to go down." << std::endl;
 
     float lastFrameTime = static_cast<float>(glfwGetTime());
+    bool brushWasDown = false;
+    bool undoWasDown = false, redoWasDown = false;
 
     // Main loop
     while (!glfwWindowShouldClose(window))
     {
+        PROFILE_FRAME();
+        PROFILE_ZONE("Frame");
+
         // Delta time
         float currentTime = static_cast<float>(glfwGetTime());
         float deltaTime = currentTime - lastFrameTime;
         lastFrameTime = currentTime;
 
-        glfwPollEvents();
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
+
+        // Run GL work queued by background jobs
+        JobSystem::instance().pumpMainThread();
 
         // Right-click to toggle mouse capture
         if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
@@ -265,19 +537,26 @@ int main()
             glm::vec3 frontXZ = glm::normalize(glm::vec3(camera.front().x, 0.0f, camera.front().z));
             glm::vec3 rightDir = camera.right();
             float moveSpeed = camera.speed * deltaTime;
+            glm::vec3 move(0.0f);
 
             if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-                camera.position += frontXZ * moveSpeed;
+                move += frontXZ * moveSpeed;
             if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-                camera.position -= frontXZ * moveSpeed;
+                move -= frontXZ * moveSpeed;
             if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-                camera.position += rightDir * moveSpeed;
+                move += rightDir * moveSpeed;
             if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-                camera.position -= rightDir * moveSpeed;
+                move -= rightDir * moveSpeed;
             if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-                camera.position.y += moveSpeed;
+                move.y += moveSpeed;
             if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-                camera.position.y -= moveSpeed;
+                move.y -= moveSpeed;
+
+            OctreeQuery query = renderer.getQuery();
+            if (camera.collision && !query.empty())
+                camera.position = query.slideAABB(camera.position, glm::vec3(camera.radius), move);
+            else
+                camera.position += move;
         }
 
         // Update renderer camera
@@ -295,6 +574,46 @@ int main()
         int renderWidth = width - static_cast<int>(uiPanelWidth);
         if (renderWidth < 1) renderWidth = 1;
 
+        // Voxel under the cursor (the crosshair while looking around)
+        glm::vec3 pickDir = camera.front();
+        bool cursorInView = false;
+        if (!camera.mouseCaptured && !io.WantCaptureMouse) {
+            double mx, my;
+            int windowWidth, windowHeight;
+            glfwGetCursorPos(window, &mx, &my);
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            float px = static_cast<float>(mx) * width / std::max(windowWidth, 1);
+            float py = static_cast<float>(my) * height / std::max(windowHeight, 1);
+            cursorInView = px >= 0.0f && px < renderWidth && py >= 0.0f && py < height;
+            if (cursorInView) pickDir = pixelRay(camera, px, py, renderWidth, std::max(height, 1));
+        }
+        RayHit pick = renderer.getQuery().raycast(camera.position, pickDir);
+
+        // Left click / drag applies the brush; the next stroke waits for the last one.
+        // Everything from press to release is one undo step.
+        bool brushDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (brushDown && cursorInView && pick.hit && !renderer.isEditing()) {
+            brush.center = camera.position + pickDir * pick.distance;
+            if (brush.mode == BrushMode::Add) brush.center += pick.normal * 0.5f;
+            if (!renderer.applyBrush(brush))
+                std::cerr << "Editing needs the CPU octree (disable GPU build and low-memory mode)" << std::endl;
+        }
+        if (!brushDown && brushWasDown) renderer.endEdit();
+        brushWasDown = brushDown;
+
+        // Ctrl+Z / Ctrl+Y
+        if (!io.WantCaptureKeyboard) {
+            bool ctrl = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS ||
+                        glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS;
+            bool undoKey = ctrl && glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS;
+            bool redoKey = ctrl && glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS;
+            if (undoKey && !undoWasDown) renderer.undoEdit();
+            if (redoKey && !redoWasDown) renderer.redoEdit();
+            undoWasDown = undoKey;
+            redoWasDown = redoKey;
+        }
+        renderer.updateDebris(deltaTime);
+
         // Render viewport excludes UI panel area
         glViewport(0, 0, renderWidth, height);
 
@@ -321,6 +640,45 @@ int main()
         ImGui::Text("%.3f ms/frame (%.1f FPS)",
                     1000.0f / io.Framerate, io.Framerate);
         ImGui::Text("Voxel count: %d", renderer.getVoxelCount());
+        // The loader jobs read the scene path and import settings
+        const bool loading = !sceneLoad.uploaded.isDone();
+        if (loading) ImGui::Text("Loading %s...", vox_path.c_str());
+        ImGui::BeginDisabled(loading);
+
+        ImGui::SeparatorText("Job System");
+        {
+            JobSystem::Stats js = JobSystem::instance().getStats();
+            ImGui::Text("Workers: %d  Jobs: %llu", js.workerCount,
+                        static_cast<unsigned long long>(js.jobsExecuted));
+            ImGui::Text("Steal rate: %.1f%%  Idle: %.1f%%",
+                        js.stealRate() * 100.0, js.idleFraction() * 100.0);
+            if (ImGui::Button("Reset Job Stats"))
+                JobSystem::instance().resetStats();
+        }
+
+        if (ImGui::CollapsingHeader("Memory")) {
+            if (ImGui::Checkbox("Low-memory mode", &renderer.lowMemoryMode) && renderer.lowMemoryMode) {
+                releaseVector(voxels);
+                renderer.releaseCpuMirrors();
+            }
+            MemoryStats::drawImGui();
+        }
+
+#ifdef HOMOGENEOUS_PROFILER
+        if (ImGui::CollapsingHeader("CPU Profiler")) {
+            bool recordZones = Profiler::enabled.load(std::memory_order_relaxed);
+            if (ImGui::Checkbox("Record zones", &recordZones))
+                Profiler::enabled.store(recordZones, std::memory_order_relaxed);
+            if (ImGui::Button("Export Chrome Trace")) {
+                const char* tracePath = "homogeneous_trace.json";
+                if (Profiler::exportChromeTrace(tracePath))
+                    std::cout << "Wrote " << tracePath << std::endl;
+                else
+                    std::cerr << "Failed to write " << tracePath << std::endl;
+            }
+            Profiler::drawFlameChart();
+        }
+#endif
 
         ImGui::Separator();
         ImGui::Text("Camera");
@@ -329,17 +687,198 @@ int main()
         ImGui::SliderFloat("Speed", &camera.speed, 5.0f, 200.0f);
         ImGui::SliderFloat("Sensitivity", &camera.sensitivity, 0.01f, 0.5f);
         ImGui::SliderFloat("FOV", &camera.fov, 30.0f, 120.0f);
+        ImGui::Checkbox("Camera Collision", &camera.collision);
+        if (pick.hit) {
+            glm::vec4 c = unpackColor(pick.leaf.color);
+            ImGui::Text("Pick: (%.0f, %.0f, %.0f) at %.1f", pick.leaf.min.x, pick.leaf.min.y, pick.leaf.min.z, pick.distance);
+            ImGui::ColorButton("##pickColor", ImVec4(c.r, c.g, c.b, c.a));
+        } else {
+            ImGui::Text("Pick: none");
+        }
+        ImGui::SeparatorText("Brush");
+        {
+            const char* modeNames[] = {"Add", "Remove", "Paint"};
+            const char* shapeNames[] = {"Sphere", "Box"};
+            int mode = static_cast<int>(brush.mode);
+            int shape = static_cast<int>(brush.shape);
+            if (ImGui::Combo("Mode", &mode, modeNames, 3)) brush.mode = static_cast<BrushMode>(mode);
+            if (ImGui::Combo("Shape", &shape, shapeNames, 2)) brush.shape = static_cast<BrushShape>(shape);
+            ImGui::SliderFloat("Radius", &brush.radius, 0.5f, 64.0f);
+            ImGui::ColorEdit4("Brush Color", &brush.color.x);
+            ImGui::SliderFloat("Edit Budget (ms)", &renderer.editBudgetMs, 0.5f, 16.0f);
+            ImGui::BeginDisabled(!renderer.canUndo() || renderer.isEditing());
+            if (ImGui::Button("Undo")) renderer.undoEdit();
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            ImGui::BeginDisabled(!renderer.canRedo() || renderer.isEditing());
+            if (ImGui::Button("Redo")) renderer.redoEdit();
+            ImGui::EndDisabled();
+            if (renderer.isEditing()) ImGui::Text("Applying stroke...");
+            ImGui::Checkbox("Detach Debris", &renderer.detachDebris);
+            ImGui::SameLine();
+            ImGui::Text("(%d pieces)", renderer.getDebrisCount());
+        }
+        ImGui::SeparatorText("CSG");
+        {
+            const char* opNames[] = {"Union", "Subtract", "Intersect"};
+            ImGui::PushItemWidth(-1.0f);
+            ImGui::InputText("##csgpath", &csg_path);
+            ImGui::PopItemWidth();
+            ImGui::Combo("Operation", &csgOp, opNames, 3);
+            // The operand is centered on the picked point (or the origin)
+            if (ImGui::Button("Apply at Pick")) {
+                GPUNodeList operandNodes;
+                OctreeCSG::Operand operand;
+                if (loadCsgOperand(operandNodes, operand.boundsMin, operand.boundsMax) != 0) {
+                    std::cerr << "Failed to load CSG operand " << csg_path << std::endl;
+                } else {
+                    glm::vec3 offset = pick.hit ? glm::round(camera.position + pickDir * pick.distance) : glm::vec3(0.0f);
+                    operand.nodes = operandNodes.data();
+                    operand.nodeCount = operandNodes.size();
+                    operand.boundsMin += offset;
+                    operand.boundsMax += offset;
+                    try {
+                        if (!renderer.applyCsg(static_cast<OctreeCSG::Op>(csgOp), operand))
+                            std::cerr << "CSG needs the CPU octree (disable GPU build and low-memory mode, use an octree backend)" << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cerr << "CSG failed: " << e.what() << std::endl;
+                    }
+                }
+            }
+        }
         ImGui::SeparatorText("Shader Options");
+        {
+            int backendIndex = static_cast<int>(renderer.getBackend());
+            const char* backendNames[static_cast<int>(RenderBackend::Count)];
+            for (int i = 0; i < static_cast<int>(RenderBackend::Count); ++i)
+                backendNames[i] = backendDesc(static_cast<RenderBackend>(i)).name;
+            if (ImGui::Combo("Backend", &backendIndex, backendNames, static_cast<int>(RenderBackend::Count))) {
+                RenderBackend next = static_cast<RenderBackend>(backendIndex);
+                if (backendDesc(next).needsVoxels() && renderer.hasEdits())
+                    renderer.extractVoxels(voxels);
+                else if (backendDesc(next).needsVoxels() && voxels.empty() && loadSceneFile(voxels) != 0)
+                    std::cerr << "Failed to reload voxels for " << backendDesc(next).name << std::endl;
+                renderer.setBackend(next, voxels);
+                if (renderer.lowMemoryMode) releaseVector(voxels);
+            }
+        }
+        ImGui::Checkbox("Build Octree on GPU", &renderer.gpuOctreeBuild);
+        ImGui::SameLine();
+        if (ImGui::Button("Validate")) {
+            if (voxels.empty() && loadSceneFile(voxels) != 0)
+                std::cerr << "Failed to reload voxels for validation" << std::endl;
+            renderer.validateGpuOctree(voxels);
+            if (renderer.lowMemoryMode) releaseVector(voxels);
+        }
         ImGui::Checkbox("Raycasting Shadows", &renderer.shadow);
         ImGui::Checkbox("Use Voxel Colors", &renderer.useVoxelColor);
         ImGui::InputInt("AO Sample Count", &renderer.aoSampleCount);
+        ImGui::Checkbox("Deferred Shading", &renderer.deferredShading);
+        if (renderer.deferredShading) {
+            ImGui::SliderInt("AO Denoise Iterations", &renderer.aoDenoiseIterations, 0,
+                             DeferredShading::MAX_DENOISE_ITERATIONS);
+            if (renderer.aoDenoiseIterations > 0) ImGui::Checkbox("Animate AO Noise", &renderer.animateNoise);
+        }
+        ImGui::Checkbox("Cone Traced GI", &renderer.coneTracedGI);
+        if (renderer.coneTracedGI) {
+            ImGui::SliderInt("GI Slices per Frame", &renderer.giSlicesPerFrame, 1, RadianceVolume::MAX_RESOLUTION);
+            ImGui::SliderFloat("GI Strength", &renderer.giStrength, 0.0f, 4.0f);
+            ImGui::SliderFloat("Cone Distance", &renderer.coneDistance, 4.0f, 256.0f);
+            if (renderer.getRadianceResolution() > 0) {
+                ImGui::Text("Radiance volume %d^3, GPU: inject %.2f ms, mips %.2f ms", renderer.getRadianceResolution(),
+                            renderer.getRadiancePassMilliseconds(RadianceVolume::TIMER_INJECT),
+                            renderer.getRadiancePassMilliseconds(RadianceVolume::TIMER_MIPMAP));
+            }
+        }
+        if (ImGui::Button("Measure AO Convergence")) {
+            if (!renderer.measureAoConvergence(renderWidth, height, aoConvergence)) {
+                std::cerr << "AO measurement needs the CPU octree (not GPU-built or released)" << std::endl;
+            } else {
+                std::cout << "AO noise (RMS) by rays per pixel: hash / random cosine / blue noise Sobol" << std::endl;
+                for (const AoErrorPoint& p : aoConvergence)
+                    std::cout << "  " << p.samples << ": " << p.hashError << " / " << p.randomError << " / "
+                              << p.sequenceError << std::endl;
+            }
+        }
+        if (!aoConvergence.empty() && ImGui::TreeNode("AO noise by rays per pixel")) {
+            for (const AoErrorPoint& p : aoConvergence)
+                ImGui::Text("%2d: hash %.4f, random %.4f, blue noise Sobol %.4f", p.samples, p.hashError,
+                            p.randomError, p.sequenceError);
+            ImGui::TreePop();
+        }
+        if (renderer.deferredShading && renderer.getBackend() == RenderBackend::RayCast) {
+            ImGui::Text("Shaded pixels %d (%.1f%%)", renderer.getHitPixelCount(),
+                        100.0f * renderer.getHitPixelCount() / std::max(renderWidth * height, 1));
+            double denoiseMs = 0.0;
+            for (int i = 0; i < DeferredShading::MAX_DENOISE_ITERATIONS; ++i)
+                denoiseMs += renderer.getDeferredPassMilliseconds(DeferredShading::TIMER_DENOISE + i);
+            ImGui::Text("GPU: visibility %.2f ms, AO %.2f ms, denoise %.2f ms, lighting %.2f ms",
+                        renderer.getDeferredPassMilliseconds(DeferredShading::TIMER_VISIBILITY),
+                        renderer.getDeferredPassMilliseconds(DeferredShading::TIMER_AO), denoiseMs,
+                        renderer.getDeferredPassMilliseconds(DeferredShading::TIMER_LIGHTING));
+            if (renderer.aoDenoiseIterations > 0 && ImGui::TreeNode("Denoise iterations")) {
+                for (int i = 0; i < std::min(renderer.aoDenoiseIterations, DeferredShading::MAX_DENOISE_ITERATIONS); ++i)
+                    ImGui::Text("Step %d: %.3f ms", 1 << i,
+                                renderer.getDeferredPassMilliseconds(DeferredShading::TIMER_DENOISE + i));
+                ImGui::TreePop();
+            }
+        }
+        ImGui::SliderInt("Lights", &renderer.lightCount, 1, MAX_LIGHTS);
+        for (int i = 0; i < renderer.lightCount; ++i) {
+            ImGui::PushID(i);
+            ImGui::DragFloat3("Light Direction", &renderer.lights[i].direction.x, 0.01f, -1.0f, 1.0f);
+            ImGui::ColorEdit3("Light Color", &renderer.lights[i].color.x);
+            ImGui::PopID();
+        }
+        if (renderer.getBackend() == RenderBackend::PathTrace) {
+            PathTraceSettings& path = renderer.pathSettings;
+            ImGui::SliderInt("Path Bounces", &path.maxBounces, 0, 16);
+            ImGui::SliderInt("Paths per Frame", &path.samplesPerFrame, 1, 16);
+            ImGui::InputInt("Max Paths per Pixel", &path.maxSamples);
+            ImGui::SliderFloat("Emission Scale", &path.emissionScale, 0.0f, 32.0f);
+            ImGui::Text("%d paths/pixel, %.1f Mpaths/s, noise %.2f%%", renderer.getPathSampleCount(),
+                        renderer.getPathSamplesPerSecond() * 1e-6, 100.0f * renderer.getPathRelativeError());
+            if (ImGui::Button("Render CPU Reference")) {
+                std::vector<glm::vec3> image;
+                auto start = std::chrono::steady_clock::now();
+                if (!renderer.renderPathReference(renderWidth, height, pathReferenceSamples, image)) {
+                    std::cerr << "CPU reference needs the CPU octree (not GPU-built or released)" << std::endl;
+                } else if (!PathTracer::writePPM("path_reference.ppm", image, renderWidth, height)) {
+                    std::cerr << "Failed to write path_reference.ppm" << std::endl;
+                } else {
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    std::cout << "Wrote path_reference.ppm (" << pathReferenceSamples << " paths/pixel, "
+                              << seconds << " s)" << std::endl;
+                }
+            }
+            ImGui::SameLine();
+            ImGui::InputInt("Reference Paths", &pathReferenceSamples);
+        }
+        {
+            const char* edgeModes[] = {"Off", "4x", "8x"};
+            int edgeMode = renderer.edgeSamples >= 8 ? 2 : (renderer.edgeSamples > 0 ? 1 : 0);
+            if (ImGui::Combo("Edge Supersampling", &edgeMode, edgeModes, 3))
+                renderer.edgeSamples = edgeMode == 0 ? 0 : (edgeMode == 1 ? 4 : 8);
+            if (renderer.edgeSamples > 0 && renderer.getBackend() == RenderBackend::RayCast)
+                ImGui::Text("Edge pixels %d (%.1f%%)", renderer.getEdgePixelCount(),
+                            100.0f * renderer.getEdgePixelCount() / std::max(renderWidth * height, 1));
+        }
+        ImGui::Checkbox("View Culling", &renderer.viewCulling);
+        ImGui::SliderFloat("Cull Distance", &renderer.cullDistance, 0.0f, 4096.0f, renderer.cullDistance > 0.0f ? "%.0f" : "off");
+        ImGui::Checkbox("Occlusion Culling (Hi-Z)", &renderer.occlusionCulling);
+        {
+            const CullStats& cull = renderer.getCullStats();
+            ImGui::Text("Visible %d / %d (frustum culled %d, distance culled %d)", cull.visible, cull.total,
+                        cull.frustumCulled, cull.distanceCulled);
+            ImGui::Text("Occlusion culled %d", cull.occlusionCulled);
+        }
 
         ImGui::Separator();
         if (ImGui::Button("Close"))
             glfwSetWindowShouldClose(window, true);
 
         // File path input with browse button
-        ImGui::Text("VOX File:");
+        ImGui::Text("Scene File (.vox/.obj/.ply/.xyz/.raw/.binvox):");
         ImGui::PushItemWidth(-80.0f);
         ImGui::InputText("##voxpath", &vox_path);
         ImGui::PopItemWidth();
@@ -351,29 +890,48 @@ int main()
             }
         }
 
+        ImGui::InputInt("Import Resolution", &importResolution);
+        ImGui::InputInt("Volume Threshold", &volumeThreshold);
+        // Hollowed volumes are for viewing: edits would cut into the dropped interior
+        ImGui::Checkbox("Hollow Volumes (view only)", &volumeHollow);
+        // The current scene stays up until the new one is uploaded
         if (ImGui::Button("Reload"))
-        {
-            if (loadVoxFile(voxels) != 0) {
-                std::cerr << "Failed to load voxel model. Exiting." << std::endl;
-                return -1;
-            }
-            renderer.setVoxels(voxels);
+            sceneLoad = loadScene(renderer, voxels, loadStatus);
+
+        ImGui::Text("Save As:");
+        ImGui::PushItemWidth(-80.0f);
+        ImGui::InputText("##savepath", &save_path);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) {
+            if (renderer.hasEdits()) renderer.extractVoxels(voxels);
+            if (saveVoxFile(voxels) != 0)
+                std::cerr << "Failed to save " << save_path << std::endl;
+            if (renderer.lowMemoryMode) releaseVector(voxels);
         }
+        ImGui::EndDisabled();
         ImGui::End();
 
         // Render ImGui
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_ZONE("ImGui render");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // Swap buffers
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
 
         // Check for ESC key
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
     }
 
-    // Cleanup
+    // Cleanup, GL objects while the context is still current
+    renderer.cleanup();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
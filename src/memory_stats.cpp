@@ -0,0 +1,190 @@
+/**
+ * Memory Accounting Implementation
+ */
+
+#include "memory_stats.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <imgui.h>
+
+namespace {
+
+constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+struct TagDesc {
+    const char* name;
+    bool gpu;
+};
+
+constexpr TagDesc TAG_DESCS[TAG_COUNT] = {
+    {"Other",               false},
+    {"VOX file models",     false},
+    {"Voxel list",          false},
+    {"GPUVoxel mirror",     false},
+    {"Octree build",        false},
+    {"Octree nodes",        false},
+    {"Point cloud bins",    false},
+    {"Voxel SSBO",          true},
+    {"Octree SSBO",         true},
+    {"Chunk mesh buffers",  true},
+    {"GL textures",         true},
+    {"Other GL buffers",    true},
+};
+
+std::atomic<size_t> current[TAG_COUNT];
+std::atomic<size_t> peak[TAG_COUNT];
+std::atomic<size_t> cpuTotal{0};
+std::atomic<size_t> cpuPeak{0};
+std::atomic<size_t> gpuTotal{0};
+std::atomic<size_t> gpuPeak{0};
+
+std::atomic<bool> windowOpen{false};
+std::atomic<size_t> windowPeak{0};
+std::atomic<size_t> lastPeak{0};
+
+struct GLObjectEntry {
+    MemoryTag tag;
+    size_t bytes;
+};
+std::mutex glMutex;
+std::unordered_map<uint32_t, GLObjectEntry> glBuffers;
+std::unordered_map<uint32_t, GLObjectEntry> glTextures;
+
+void raise(std::atomic<size_t>& target, size_t value) {
+    size_t prev = target.load(std::memory_order_relaxed);
+    while (prev < value && !target.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+}
+
+void add(MemoryTag tag, size_t bytes) {
+    size_t i = static_cast<size_t>(tag);
+    raise(peak[i], current[i].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+
+    std::atomic<size_t>& total = TAG_DESCS[i].gpu ? gpuTotal : cpuTotal;
+    std::atomic<size_t>& totalPeak = TAG_DESCS[i].gpu ? gpuPeak : cpuPeak;
+    raise(totalPeak, total.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+
+    if (windowOpen.load(std::memory_order_relaxed)) {
+        raise(windowPeak, cpuTotal.load(std::memory_order_relaxed) + gpuTotal.load(std::memory_order_relaxed));
+    }
+}
+
+void sub(MemoryTag tag, size_t bytes) {
+    size_t i = static_cast<size_t>(tag);
+    current[i].fetch_sub(bytes, std::memory_order_relaxed);
+    (TAG_DESCS[i].gpu ? gpuTotal : cpuTotal).fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void track(std::unordered_map<uint32_t, GLObjectEntry>& objects, uint32_t name, MemoryTag tag, size_t bytes) {
+    std::lock_guard<std::mutex> guard(glMutex);
+    auto it = objects.find(name);
+    if (it != objects.end()) {
+        sub(it->second.tag, it->second.bytes);
+        it->second = GLObjectEntry{tag, bytes};
+    } else {
+        objects.emplace(name, GLObjectEntry{tag, bytes});
+    }
+    add(tag, bytes);
+}
+
+void untrack(std::unordered_map<uint32_t, GLObjectEntry>& objects, uint32_t name) {
+    std::lock_guard<std::mutex> guard(glMutex);
+    auto it = objects.find(name);
+    if (it == objects.end()) return;
+    sub(it->second.tag, it->second.bytes);
+    objects.erase(it);
+}
+
+} // namespace
+
+const char* MemoryStats::tagName(MemoryTag tag) {
+    return TAG_DESCS[static_cast<size_t>(tag)].name;
+}
+
+bool MemoryStats::isGpuTag(MemoryTag tag) {
+    return TAG_DESCS[static_cast<size_t>(tag)].gpu;
+}
+
+void MemoryStats::onAllocate(MemoryTag tag, size_t bytes) {
+    add(tag, bytes);
+}
+
+void MemoryStats::onFree(MemoryTag tag, size_t bytes) {
+    sub(tag, bytes);
+}
+
+void MemoryStats::trackGLBuffer(uint32_t buffer, MemoryTag tag, size_t bytes) {
+    track(glBuffers, buffer, tag, bytes);
+}
+
+void MemoryStats::untrackGLBuffer(uint32_t buffer) {
+    untrack(glBuffers, buffer);
+}
+
+void MemoryStats::trackGLTexture(uint32_t texture, MemoryTag tag, size_t bytes) {
+    track(glTextures, texture, tag, bytes);
+}
+
+void MemoryStats::untrackGLTexture(uint32_t texture) {
+    untrack(glTextures, texture);
+}
+
+MemoryStats::TagInfo MemoryStats::getTag(MemoryTag tag) {
+    size_t i = static_cast<size_t>(tag);
+    return TagInfo{TAG_DESCS[i].name, TAG_DESCS[i].gpu,
+                   current[i].load(std::memory_order_relaxed),
+                   peak[i].load(std::memory_order_relaxed)};
+}
+
+MemoryStats::Totals MemoryStats::getTotals() {
+    Totals t;
+    t.cpuCurrent = cpuTotal.load(std::memory_order_relaxed);
+    t.cpuPeak = cpuPeak.load(std::memory_order_relaxed);
+    t.gpuCurrent = gpuTotal.load(std::memory_order_relaxed);
+    t.gpuPeak = gpuPeak.load(std::memory_order_relaxed);
+    return t;
+}
+
+void MemoryStats::beginPeakWindow() {
+    windowPeak.store(cpuTotal.load() + gpuTotal.load(), std::memory_order_relaxed);
+    windowOpen.store(true);
+}
+
+size_t MemoryStats::endPeakWindow() {
+    windowOpen.store(false);
+    size_t p = windowPeak.load();
+    lastPeak.store(p);
+    return p;
+}
+
+size_t MemoryStats::lastWindowPeak() {
+    return lastPeak.load();
+}
+
+void MemoryStats::drawImGui() {
+    auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+    Totals t = getTotals();
+    ImGui::Text("CPU: %.2f MB (peak %.2f MB)", mb(t.cpuCurrent), mb(t.cpuPeak));
+    ImGui::Text("GPU: %.2f MB (peak %.2f MB)", mb(t.gpuCurrent), mb(t.gpuPeak));
+    ImGui::Text("Last load peak: %.2f MB", mb(lastWindowPeak()));
+
+    if (ImGui::BeginTable("memtags", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Tag");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < TAG_COUNT; ++i) {
+            TagInfo info = getTag(static_cast<MemoryTag>(i));
+            if (info.peak == 0) continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s%s", info.gpu ? "[GPU] " : "", info.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", mb(info.current));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", mb(info.peak));
+        }
+        ImGui::EndTable();
+    }
+}
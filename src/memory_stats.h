@@ -0,0 +1,149 @@
+/**
+ * Memory Accounting
+ *
+ * Tagged byte counters for the big CPU containers and GPU buffers.
+ * CPU containers opt in through TrackedAllocator (e.g. VoxelList), GPU buffers
+ * are reported with trackGLBuffer() right after glBufferData().
+ *
+ * Per tag the current and peak byte counts are kept; a peak window
+ * (beginPeakWindow / endPeakWindow) reports the high-water mark of a load.
+ */
+
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * Subsystem that owns an allocation
+ */
+enum class MemoryTag : uint8_t {
+    Other = 0,
+    VoxFile,          // Parsed VOX models (VoxData lists)
+    Voxels,           // Merged std::vector<Voxel> scene list
+    VoxelMirror,      // GPUVoxel CPU mirror in VoxelRenderer
+    OctreeBuild,      // Transient pointer octree + per-node voxel buckets
+    OctreeNodes,      // Flattened GPUNode array
+    PointCloudBins,   // Per-voxel accumulators of the streaming point-cloud importer
+    GpuVoxelBuffer,   // SSBO binding 0
+    GpuOctreeBuffer,  // SSBO binding 1
+    GpuMeshBuffer,    // Chunk mesh vertex, index and indirect draw buffers
+    GpuTexture,       // Depth copies, depth pyramids and other render targets
+    GpuOther,         // Vertex buffers and other small GL objects
+    Count
+};
+
+class MemoryStats {
+public:
+    struct TagInfo {
+        const char* name;
+        bool gpu;
+        size_t current;
+        size_t peak;
+    };
+
+    struct Totals {
+        size_t cpuCurrent = 0;
+        size_t cpuPeak = 0;     // Peak of the CPU total, not the sum of tag peaks
+        size_t gpuCurrent = 0;
+        size_t gpuPeak = 0;
+    };
+
+    static const char* tagName(MemoryTag tag);
+    static bool isGpuTag(MemoryTag tag);
+
+    // CPU side (called by TrackedAllocator)
+    static void onAllocate(MemoryTag tag, size_t bytes);
+    static void onFree(MemoryTag tag, size_t bytes);
+
+    /**
+     * Record the size of a GL buffer (replaces the previous size of the same id)
+     * @param buffer GL buffer name
+     * @param tag Owning subsystem, should be a GPU tag
+     * @param bytes Size passed to glBufferData
+     */
+    static void trackGLBuffer(uint32_t buffer, MemoryTag tag, size_t bytes);
+    static void untrackGLBuffer(uint32_t buffer);
+    /**
+     * Same for a GL texture (texture and buffer names are separate namespaces)
+     * @param bytes Size of all levels of the texture
+     */
+    static void trackGLTexture(uint32_t texture, MemoryTag tag, size_t bytes);
+    static void untrackGLTexture(uint32_t texture);
+
+    static TagInfo getTag(MemoryTag tag);
+    static Totals getTotals();
+
+    /**
+     * Start measuring the combined CPU + GPU high-water mark (e.g. around a load)
+     */
+    static void beginPeakWindow();
+    /**
+     * @return Highest CPU + GPU total seen since beginPeakWindow()
+     */
+    static size_t endPeakWindow();
+    static size_t lastWindowPeak();
+
+    /**
+     * Draw the per-tag breakdown into the current ImGui window
+     */
+    static void drawImGui();
+};
+
+/**
+ * std::allocator replacement that reports to MemoryStats.
+ * DefaultTag applies to default-constructed allocators; a different tag can be
+ * chosen per container instance by passing TrackedAllocator(tag).
+ */
+template <typename T, MemoryTag DefaultTag = MemoryTag::Other>
+class TrackedAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind { using other = TrackedAllocator<U, DefaultTag>; };
+
+    TrackedAllocator() noexcept : tag(DefaultTag) {}
+    explicit TrackedAllocator(MemoryTag t) noexcept : tag(t) {}
+    template <typename U>
+    TrackedAllocator(const TrackedAllocator<U, DefaultTag>& other) noexcept : tag(other.tag) {}
+
+    T* allocate(size_t n) {
+        T* p = std::allocator<T>().allocate(n);
+        MemoryStats::onAllocate(tag, n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        MemoryStats::onFree(tag, n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const TrackedAllocator<U, DefaultTag>& other) const noexcept { return tag == other.tag; }
+    template <typename U>
+    bool operator!=(const TrackedAllocator<U, DefaultTag>& other) const noexcept { return tag != other.tag; }
+
+    MemoryTag tag;
+};
+
+template <typename T, MemoryTag Tag>
+using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+/**
+ * Release a vector's storage (clear() keeps the capacity)
+ */
+template <typename V>
+void releaseVector(V& v) {
+    V empty(v.get_allocator());
+    v.swap(empty);
+}
+
+#endif // MEMORY_STATS_H
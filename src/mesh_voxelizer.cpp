@@ -0,0 +1,655 @@
+/**
+ * Triangle Mesh Importer / Voxelizer Implementation
+ */
+
+#include "mesh_voxelizer.h"
+#include "job_system.h"
+#include "octree.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+// ============================================================================
+// File helpers
+// ============================================================================
+
+static std::string readWholeFile(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open mesh file: " + filepath);
+    }
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&data[0], static_cast<std::streamsize>(data.size()));
+    return data;
+}
+
+static std::string lowerExtension(const std::string& filepath) {
+    size_t dot = filepath.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string ext = filepath.substr(dot + 1);
+    for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext;
+}
+
+static std::string directoryOf(const std::string& filepath) {
+    size_t slash = filepath.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : filepath.substr(0, slash + 1);
+}
+
+// Cursor over a null-terminated text buffer
+struct TextCursor {
+    const char* p;
+
+    void skipSpaces() { while (*p == ' ' || *p == '\t' || *p == '\r') ++p; }
+    void skipLine() { while (*p && *p != '\n') ++p; if (*p) ++p; }
+    bool atLineEnd() { skipSpaces(); return *p == '\0' || *p == '\n' || *p == '#'; }
+
+    float readFloat() {
+        skipSpaces();
+        char* end;
+        float v = std::strtof(p, &end);
+        p = end;
+        return v;
+    }
+
+    long readInt() {
+        skipSpaces();
+        char* end;
+        long v = std::strtol(p, &end, 10);
+        p = end;
+        return v;
+    }
+
+    std::string readToken() {
+        skipSpaces();
+        const char* start = p;
+        while (*p && !std::isspace(static_cast<unsigned char>(*p))) ++p;
+        return std::string(start, p);
+    }
+};
+
+// ============================================================================
+// MeshReader
+// ============================================================================
+
+bool MeshReader::isMeshFile(const std::string& filepath) {
+    std::string ext = lowerExtension(filepath);
+    return ext == "obj" || ext == "ply";
+}
+
+MeshData MeshReader::load(const std::string& filepath) {
+    PROFILE_FUNCTION();
+    std::string ext = lowerExtension(filepath);
+    if (ext == "obj") return loadOBJ(filepath);
+    if (ext == "ply") return loadPLY(filepath);
+    throw std::runtime_error("Unsupported mesh format: " + filepath);
+}
+
+static std::map<std::string, glm::vec4> loadMTL(const std::string& filepath) {
+    std::map<std::string, glm::vec4> materials;
+    std::string data;
+    try {
+        data = readWholeFile(filepath);
+    } catch (const std::exception&) {
+        std::cerr << "Warning: material library not found: " << filepath << std::endl;
+        return materials;
+    }
+
+    std::string current;
+    TextCursor c{data.c_str()};
+    while (*c.p) {
+        c.skipSpaces();
+        if (std::strncmp(c.p, "newmtl", 6) == 0 && std::isspace(static_cast<unsigned char>(c.p[6]))) {
+            c.p += 6;
+            current = c.readToken();
+            materials[current] = glm::vec4(1.0f);
+        } else if (c.p[0] == 'K' && c.p[1] == 'd' && std::isspace(static_cast<unsigned char>(c.p[2])) && !current.empty()) {
+            c.p += 2;
+            float r = c.readFloat(), g = c.readFloat(), b = c.readFloat();
+            materials[current] = glm::vec4(r, g, b, 1.0f);
+        }
+        c.skipLine();
+    }
+    return materials;
+}
+
+MeshData MeshReader::loadOBJ(const std::string& filepath) {
+    std::string data = readWholeFile(filepath);
+    MeshData mesh;
+    std::map<std::string, glm::vec4> materials;
+    glm::vec4 materialColor(1.0f);
+    bool hasVertexColors = false;
+    bool hasMaterials = false;
+    std::vector<glm::vec4> faceColors;
+    std::vector<long> face;
+
+    TextCursor c{data.c_str()};
+    while (*c.p) {
+        c.skipSpaces();
+        if (c.p[0] == 'v' && (c.p[1] == ' ' || c.p[1] == '\t')) {
+            c.p += 1;
+            glm::vec3 pos;
+            pos.x = c.readFloat(); pos.y = c.readFloat(); pos.z = c.readFloat();
+            mesh.positions.push_back(pos);
+            // Common extension: "v x y z r g b"
+            if (!c.atLineEnd()) {
+                float r = c.readFloat(), g = c.readFloat(), b = c.readFloat();
+                mesh.colors.emplace_back(r, g, b, 1.0f);
+                hasVertexColors = true;
+            } else {
+                mesh.colors.emplace_back(1.0f);
+            }
+        } else if (c.p[0] == 'f' && (c.p[1] == ' ' || c.p[1] == '\t')) {
+            c.p += 1;
+            face.clear();
+            while (!c.atLineEnd()) {
+                long idx = c.readInt();
+                // Skip "/vt/vn"
+                while (*c.p && !std::isspace(static_cast<unsigned char>(*c.p))) ++c.p;
+                long count = static_cast<long>(mesh.positions.size());
+                long resolved = idx < 0 ? count + idx : idx - 1;
+                if (resolved < 0 || resolved >= count) {
+                    throw std::runtime_error("Invalid OBJ face index in " + filepath);
+                }
+                face.push_back(resolved);
+            }
+            // Fan triangulation
+            for (size_t i = 2; i < face.size(); ++i) {
+                mesh.indices.push_back(static_cast<uint32_t>(face[0]));
+                mesh.indices.push_back(static_cast<uint32_t>(face[i - 1]));
+                mesh.indices.push_back(static_cast<uint32_t>(face[i]));
+                faceColors.push_back(materialColor);
+            }
+        } else if (std::strncmp(c.p, "mtllib", 6) == 0) {
+            c.p += 6;
+            auto lib = loadMTL(directoryOf(filepath) + c.readToken());
+            materials.insert(lib.begin(), lib.end());
+        } else if (std::strncmp(c.p, "usemtl", 6) == 0) {
+            c.p += 6;
+            auto it = materials.find(c.readToken());
+            materialColor = it != materials.end() ? it->second : glm::vec4(1.0f);
+            hasMaterials = hasMaterials || it != materials.end();
+        }
+        c.skipLine();
+    }
+
+    // Material colors apply per face; split shared vertices so they survive
+    // the per-vertex color representation (vertex colors take precedence).
+    if (!hasVertexColors && hasMaterials) {
+        MeshData split;
+        split.positions.reserve(mesh.indices.size());
+        split.colors.reserve(mesh.indices.size());
+        split.indices.reserve(mesh.indices.size());
+        for (size_t i = 0; i < mesh.indices.size(); ++i) {
+            split.positions.push_back(mesh.positions[mesh.indices[i]]);
+            split.colors.push_back(faceColors[i / 3]);
+            split.indices.push_back(static_cast<uint32_t>(i));
+        }
+        mesh = std::move(split);
+    }
+
+    std::cout << "OBJ: " << mesh.positions.size() << " vertices, " << mesh.triangleCount() << " triangles" << std::endl;
+    return mesh;
+}
+
+namespace {
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+PlyType parsePlyType(const std::string& s) {
+    if (s == "char" || s == "int8") return PlyType::Int8;
+    if (s == "uchar" || s == "uint8") return PlyType::UInt8;
+    if (s == "short" || s == "int16") return PlyType::Int16;
+    if (s == "ushort" || s == "uint16") return PlyType::UInt16;
+    if (s == "int" || s == "int32") return PlyType::Int32;
+    if (s == "uint" || s == "uint32") return PlyType::UInt32;
+    if (s == "float" || s == "float32") return PlyType::Float32;
+    if (s == "double" || s == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+size_t plyTypeSize(PlyType t) {
+    switch (t) {
+        case PlyType::Int8: case PlyType::UInt8: return 1;
+        case PlyType::Int16: case PlyType::UInt16: return 2;
+        case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        default: return 0;
+    }
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Invalid;
+    bool isList = false;
+    PlyType countType = PlyType::Invalid;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+// Reads PLY scalars from either the ASCII body or the binary body
+struct PlyBodyReader {
+    const char* p;
+    const char* end;
+    bool ascii;
+    bool bigEndian;
+
+    double read(PlyType type) {
+        if (ascii) {
+            TextCursor c{p};
+            while (*c.p == '\n' || *c.p == ' ' || *c.p == '\r' || *c.p == '\t') ++c.p;
+            char* e;
+            double v = std::strtod(c.p, &e);
+            p = e;
+            return v;
+        }
+
+        size_t n = plyTypeSize(type);
+        if (static_cast<size_t>(end - p) < n) throw std::runtime_error("Truncated PLY body");
+        unsigned char b[8];
+        std::memcpy(b, p, n);
+        p += n;
+        if (bigEndian) std::reverse(b, b + n);
+
+        switch (type) {
+            case PlyType::Int8:   { int8_t v; std::memcpy(&v, b, 1); return v; }
+            case PlyType::UInt8:  { uint8_t v; std::memcpy(&v, b, 1); return v; }
+            case PlyType::Int16:  { int16_t v; std::memcpy(&v, b, 2); return v; }
+            case PlyType::UInt16: { uint16_t v; std::memcpy(&v, b, 2); return v; }
+            case PlyType::Int32:  { int32_t v; std::memcpy(&v, b, 4); return v; }
+            case PlyType::UInt32: { uint32_t v; std::memcpy(&v, b, 4); return v; }
+            case PlyType::Float32:{ float v; std::memcpy(&v, b, 4); return v; }
+            case PlyType::Float64:{ double v; std::memcpy(&v, b, 8); return v; }
+            default: throw std::runtime_error("Invalid PLY property type");
+        }
+    }
+};
+
+} // namespace
+
+MeshData MeshReader::loadPLY(const std::string& filepath) {
+    std::string data = readWholeFile(filepath);
+    if (data.compare(0, 3, "ply") != 0) {
+        throw std::runtime_error("Invalid PLY file: missing magic in " + filepath);
+    }
+
+    // Header
+    std::vector<PlyElement> elements;
+    bool ascii = true, bigEndian = false;
+    TextCursor c{data.c_str()};
+    c.skipLine();
+    for (;;) {
+        if (!*c.p) throw std::runtime_error("Invalid PLY file: missing end_header");
+        std::string keyword = c.readToken();
+        if (keyword == "format") {
+            std::string fmt = c.readToken();
+            ascii = fmt == "ascii";
+            bigEndian = fmt == "binary_big_endian";
+        } else if (keyword == "element") {
+            PlyElement el;
+            el.name = c.readToken();
+            el.count = static_cast<size_t>(c.readInt());
+            elements.push_back(el);
+        } else if (keyword == "property" && !elements.empty()) {
+            PlyProperty prop;
+            std::string type = c.readToken();
+            if (type == "list") {
+                prop.isList = true;
+                prop.countType = parsePlyType(c.readToken());
+                prop.type = parsePlyType(c.readToken());
+            } else {
+                prop.type = parsePlyType(type);
+            }
+            prop.name = c.readToken();
+            elements.back().properties.push_back(prop);
+        } else if (keyword == "end_header") {
+            c.skipLine();
+            break;
+        }
+        c.skipLine();
+    }
+
+    MeshData mesh;
+    PlyBodyReader body{c.p, data.c_str() + data.size(), ascii, bigEndian};
+    std::vector<uint32_t> polygon;
+
+    for (const auto& el : elements) {
+        bool isVertex = el.name == "vertex";
+        bool isFace = el.name == "face";
+        if (isVertex) {
+            mesh.positions.reserve(el.count);
+            mesh.colors.reserve(el.count);
+        }
+
+        for (size_t i = 0; i < el.count; ++i) {
+            glm::vec3 pos(0.0f);
+            glm::vec4 col(1.0f);
+            for (const auto& prop : el.properties) {
+                if (prop.isList) {
+                    size_t n = static_cast<size_t>(body.read(prop.countType));
+                    bool indices = isFace && (prop.name == "vertex_indices" || prop.name == "vertex_index");
+                    polygon.clear();
+                    for (size_t k = 0; k < n; ++k) {
+                        double v = body.read(prop.type);
+                        if (indices) polygon.push_back(static_cast<uint32_t>(v));
+                    }
+                    for (size_t k = 2; indices && k < polygon.size(); ++k) {
+                        mesh.indices.push_back(polygon[0]);
+                        mesh.indices.push_back(polygon[k - 1]);
+                        mesh.indices.push_back(polygon[k]);
+                    }
+                    continue;
+                }
+
+                double v = body.read(prop.type);
+                if (!isVertex) continue;
+                // Integer color channels are 0-255, float channels 0-1
+                double norm = (prop.type == PlyType::Float32 || prop.type == PlyType::Float64) ? 1.0 : 1.0 / 255.0;
+                if (prop.name == "x") pos.x = static_cast<float>(v);
+                else if (prop.name == "y") pos.y = static_cast<float>(v);
+                else if (prop.name == "z") pos.z = static_cast<float>(v);
+                else if (prop.name == "red" || prop.name == "r") col.r = static_cast<float>(v * norm);
+                else if (prop.name == "green" || prop.name == "g") col.g = static_cast<float>(v * norm);
+                else if (prop.name == "blue" || prop.name == "b") col.b = static_cast<float>(v * norm);
+                else if (prop.name == "alpha" || prop.name == "a") col.a = static_cast<float>(v * norm);
+            }
+            if (isVertex) {
+                mesh.positions.push_back(pos);
+                mesh.colors.push_back(col);
+            }
+        }
+    }
+
+    for (uint32_t idx : mesh.indices) {
+        if (idx >= mesh.positions.size()) throw std::runtime_error("Invalid PLY face index in " + filepath);
+    }
+
+    std::cout << "PLY: " << mesh.positions.size() << " vertices, " << mesh.triangleCount() << " triangles" << std::endl;
+    return mesh;
+}
+
+// ============================================================================
+// Triangle / box overlap (Akenine-Moller, separating axis theorem)
+// ============================================================================
+
+static bool planeBoxOverlap(const glm::vec3& normal, const glm::vec3& vert, const glm::vec3& half) {
+    glm::vec3 vmin, vmax;
+    for (int q = 0; q < 3; ++q) {
+        float v = vert[q];
+        if (normal[q] > 0.0f) { vmin[q] = -half[q] - v; vmax[q] = half[q] - v; }
+        else                  { vmin[q] = half[q] - v;  vmax[q] = -half[q] - v; }
+    }
+    if (glm::dot(normal, vmin) > 0.0f) return false;
+    return glm::dot(normal, vmax) >= 0.0f;
+}
+
+static bool axisSeparates(const glm::vec3& axis, const glm::vec3& v0, const glm::vec3& v1,
+                          const glm::vec3& v2, const glm::vec3& half) {
+    float p0 = glm::dot(axis, v0), p1 = glm::dot(axis, v1), p2 = glm::dot(axis, v2);
+    float r = half.x * std::abs(axis.x) + half.y * std::abs(axis.y) + half.z * std::abs(axis.z);
+    return std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r;
+}
+
+static bool triBoxOverlap(const glm::vec3& center, const glm::vec3& half,
+                          const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 v0 = a - center, v1 = b - center, v2 = c - center;
+    glm::vec3 e[3] = {v1 - v0, v2 - v1, v0 - v2};
+
+    // 9 cross-product axes
+    static const glm::vec3 boxAxes[3] = {glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1)};
+    for (const auto& edge : e) {
+        for (const auto& axis : boxAxes) {
+            glm::vec3 test = glm::cross(axis, edge);
+            if (test != glm::vec3(0.0f) && axisSeparates(test, v0, v1, v2, half)) return false;
+        }
+    }
+
+    // Box face normals (triangle AABB vs box)
+    for (int q = 0; q < 3; ++q) {
+        if (std::min(v0[q], std::min(v1[q], v2[q])) > half[q]) return false;
+        if (std::max(v0[q], std::max(v1[q], v2[q])) < -half[q]) return false;
+    }
+
+    // Triangle plane
+    return planeBoxOverlap(glm::cross(e[0], e[1]), v0, half);
+}
+
+// Barycentric coordinates of the projection of p onto triangle abc, clamped to the triangle
+static glm::vec3 closestBarycentric(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 v0 = b - a, v1 = c - a, v2 = p - a;
+    float d00 = glm::dot(v0, v0), d01 = glm::dot(v0, v1), d11 = glm::dot(v1, v1);
+    float d20 = glm::dot(v2, v0), d21 = glm::dot(v2, v1);
+    float denom = d00 * d11 - d01 * d01;
+    if (std::abs(denom) < 1e-12f) return glm::vec3(1.0f, 0.0f, 0.0f);
+    float v = (d11 * d20 - d01 * d21) / denom;
+    float w = (d00 * d21 - d01 * d20) / denom;
+    glm::vec3 bary(1.0f - v - w, v, w);
+    bary = glm::max(bary, glm::vec3(0.0f));
+    float sum = bary.x + bary.y + bary.z;
+    return sum > 0.0f ? bary / sum : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+// ============================================================================
+// MeshVoxelizer
+// ============================================================================
+
+namespace {
+
+struct TileVoxel {
+    glm::ivec3 pos;
+    uint32_t color;  // packed RGBA8
+};
+
+} // namespace
+
+MeshVoxelizer::Result MeshVoxelizer::voxelize(const MeshData& mesh, const Options& options, VoxelList& out) {
+    PROFILE_FUNCTION();
+    Result result;
+    out.clear();
+    if (mesh.positions.empty() || mesh.indices.empty()) return result;
+
+    JobSystem& jobs = JobSystem::instance();
+    const size_t triCount = mesh.triangleCount();
+
+    // Fit the mesh into the grid
+    glm::vec3 bmin(1e30f), bmax(-1e30f);
+    for (const auto& p : mesh.positions) { bmin = glm::min(bmin, p); bmax = glm::max(bmax, p); }
+    glm::vec3 extent = bmax - bmin;
+    float longest = std::max(extent.x, std::max(extent.y, extent.z));
+    float scale = longest > 0.0f ? static_cast<float>(options.resolution) / longest : 1.0f;
+
+    glm::ivec3 grid = glm::max(glm::ivec3(glm::ceil(extent * scale)), glm::ivec3(1));
+    grid = glm::min(grid, glm::ivec3(options.resolution));
+    result.gridSize = grid;
+    const glm::ivec3 tiles = (grid + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tileCount = static_cast<size_t>(tiles.x) * tiles.y * tiles.z;
+
+    auto toGrid = [&](uint32_t idx) { return (mesh.positions[idx] - bmin) * scale; };
+    auto cellRange = [&](size_t t, glm::ivec3& lo, glm::ivec3& hi) {
+        glm::vec3 a = toGrid(mesh.indices[3 * t]), b = toGrid(mesh.indices[3 * t + 1]), c = toGrid(mesh.indices[3 * t + 2]);
+        lo = glm::clamp(glm::ivec3(glm::floor(glm::min(a, glm::min(b, c)))), glm::ivec3(0), grid - 1);
+        hi = glm::clamp(glm::ivec3(glm::floor(glm::max(a, glm::max(b, c)))), glm::ivec3(0), grid - 1);
+    };
+    auto tileIndex = [&](int tx, int ty, int tz) {
+        return (static_cast<size_t>(tz) * tiles.y + ty) * tiles.x + tx;
+    };
+
+    // Bin triangles into tiles: count, scan, fill (CSR)
+    std::vector<uint32_t> tileOffsets(tileCount + 1, 0);
+    std::vector<uint32_t> tileTriangles;
+    {
+        PROFILE_ZONE("Bin triangles");
+        std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[tileCount]);
+        for (size_t i = 0; i < tileCount; ++i) counts[i].store(0, std::memory_order_relaxed);
+
+        auto forEachTile = [&](size_t t, auto&& fn) {
+            glm::ivec3 lo, hi;
+            cellRange(t, lo, hi);
+            glm::ivec3 tlo = lo / TILE_SIZE, thi = hi / TILE_SIZE;
+            for (int z = tlo.z; z <= thi.z; ++z)
+                for (int y = tlo.y; y <= thi.y; ++y)
+                    for (int x = tlo.x; x <= thi.x; ++x)
+                        fn(tileIndex(x, y, z));
+        };
+
+        jobs.parallelFor(0, triCount, 16 * 1024, [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; ++t)
+                forEachTile(t, [&](size_t tile) { counts[tile].fetch_add(1, std::memory_order_relaxed); });
+        });
+
+        for (size_t i = 0; i < tileCount; ++i) tileOffsets[i + 1] = tileOffsets[i] + counts[i].load();
+        tileTriangles.resize(tileOffsets.back());
+        for (size_t i = 0; i < tileCount; ++i) counts[i].store(tileOffsets[i], std::memory_order_relaxed);
+
+        jobs.parallelFor(0, triCount, 16 * 1024, [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; ++t)
+                forEachTile(t, [&](size_t tile) {
+                    tileTriangles[counts[tile].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(t);
+                });
+        });
+
+        // Chunks race for the slots of a shared tile; restore file order
+        jobs.parallelFor(0, tileCount, 64, [&](size_t b, size_t e) {
+            for (size_t tile = b; tile < e; ++tile)
+                std::sort(tileTriangles.begin() + tileOffsets[tile], tileTriangles.begin() + tileOffsets[tile + 1]);
+        });
+    }
+
+    // Voxelize tiles in parallel; triangles keep their file order inside a
+    // tile so the first triangle touching a cell decides its color.
+    std::vector<std::vector<TileVoxel>> tileVoxels(tileCount);
+    {
+        PROFILE_ZONE("Voxelize tiles");
+        const glm::vec3 half(0.5f);
+        jobs.parallelFor(0, tileCount, 1, [&](size_t b, size_t e) {
+            std::vector<uint32_t> cellColor(TILE_SIZE * TILE_SIZE * TILE_SIZE);
+            std::vector<uint8_t> occupied(TILE_SIZE * TILE_SIZE * TILE_SIZE);
+
+            for (size_t tile = b; tile < e; ++tile) {
+                if (tileOffsets[tile] == tileOffsets[tile + 1]) continue;
+                std::fill(occupied.begin(), occupied.end(), 0);
+
+                glm::ivec3 tcoord(static_cast<int>(tile % tiles.x),
+                                  static_cast<int>((tile / tiles.x) % tiles.y),
+                                  static_cast<int>(tile / (static_cast<size_t>(tiles.x) * tiles.y)));
+                glm::ivec3 tileMin = tcoord * TILE_SIZE;
+                glm::ivec3 tileMax = glm::min(tileMin + TILE_SIZE, grid) - 1;
+
+                for (uint32_t k = tileOffsets[tile]; k < tileOffsets[tile + 1]; ++k) {
+                    size_t t = tileTriangles[k];
+                    uint32_t ia = mesh.indices[3 * t], ib = mesh.indices[3 * t + 1], ic = mesh.indices[3 * t + 2];
+                    glm::vec3 a = toGrid(ia), bb = toGrid(ib), c = toGrid(ic);
+                    glm::ivec3 lo, hi;
+                    cellRange(t, lo, hi);
+                    lo = glm::max(lo, tileMin);
+                    hi = glm::min(hi, tileMax);
+
+                    for (int z = lo.z; z <= hi.z; ++z)
+                    for (int y = lo.y; y <= hi.y; ++y)
+                    for (int x = lo.x; x <= hi.x; ++x) {
+                        glm::ivec3 local = glm::ivec3(x, y, z) - tileMin;
+                        size_t cell = (static_cast<size_t>(local.z) * TILE_SIZE + local.y) * TILE_SIZE + local.x;
+                        if (occupied[cell]) continue;
+
+                        glm::vec3 center = glm::vec3(x, y, z) + half;
+                        if (!triBoxOverlap(center, half, a, bb, c)) continue;
+
+                        glm::vec3 w = closestBarycentric(center, a, bb, c);
+                        glm::vec4 color = mesh.colors[ia] * w.x + mesh.colors[ib] * w.y + mesh.colors[ic] * w.z;
+                        occupied[cell] = 1;
+                        cellColor[cell] = packColor(color);
+                    }
+                }
+
+                auto& outTile = tileVoxels[tile];
+                for (size_t cell = 0; cell < occupied.size(); ++cell) {
+                    if (!occupied[cell]) continue;
+                    glm::ivec3 local(static_cast<int>(cell % TILE_SIZE),
+                                     static_cast<int>((cell / TILE_SIZE) % TILE_SIZE),
+                                     static_cast<int>(cell / (TILE_SIZE * TILE_SIZE)));
+                    outTile.push_back(TileVoxel{tileMin + local, cellColor[cell]});
+                }
+            }
+        });
+    }
+
+    // Palette: the 255 most common 4-bit-per-channel bins, averaged
+    std::vector<uint8_t> binToPalette(4096, 1);
+    if (options.buildPalette) {
+        PROFILE_ZONE("Build palette");
+        std::vector<uint64_t> binCount(4096, 0);
+        std::vector<glm::dvec3> binSum(4096, glm::dvec3(0.0));
+        auto binOf = [](uint32_t packed) {
+            return ((packed >> 28) << 8) | (((packed >> 20) & 0xF) << 4) | ((packed >> 12) & 0xF);
+        };
+        for (const auto& tv : tileVoxels)
+            for (const auto& v : tv) {
+                uint32_t bin = binOf(v.color);
+                binCount[bin]++;
+                binSum[bin] += glm::dvec3(glm::vec3(unpackColor(v.color)));
+            }
+
+        std::vector<uint32_t> order;
+        for (uint32_t bin = 0; bin < 4096; ++bin) if (binCount[bin]) order.push_back(bin);
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return binCount[x] > binCount[y]; });
+        if (order.size() > 255) order.resize(255);
+
+        result.palette.fill(glm::vec4(0.0f));
+        result.paletteSize = static_cast<int>(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            glm::dvec3 avg = binSum[order[i]] / static_cast<double>(binCount[order[i]]);
+            result.palette[i + 1] = glm::vec4(glm::vec3(avg), 1.0f);
+        }
+
+        // Every bin maps to its nearest palette entry
+        for (uint32_t bin = 0; bin < 4096 && !order.empty(); ++bin) {
+            glm::vec3 binColor((bin >> 8) / 15.0f, ((bin >> 4) & 0xF) / 15.0f, (bin & 0xF) / 15.0f);
+            float best = 1e30f;
+            for (size_t i = 0; i < order.size(); ++i) {
+                glm::vec3 d = glm::vec3(result.palette[i + 1]) - binColor;
+                float dist = glm::dot(d, d);
+                if (dist < best) { best = dist; binToPalette[bin] = static_cast<uint8_t>(i + 1); }
+            }
+        }
+
+        for (auto& tv : tileVoxels)
+            for (auto& v : tv) {
+                uint32_t bin = binOf(v.color);
+                v.color = binToPalette[bin];  // reuse the field as palette index
+            }
+    }
+
+    // Gather, centered on the origin like loadVoxFile()
+    size_t total = 0;
+    for (const auto& tv : tileVoxels) total += tv.size();
+    out.reserve(total);
+    glm::ivec3 center = grid / 2;
+    for (const auto& tv : tileVoxels) {
+        for (const auto& v : tv) {
+            if (options.buildPalette) {
+                Voxel voxel(v.pos - center, result.palette[v.color]);
+                voxel.setColorIndex(static_cast<uint8_t>(v.color));
+                out.push_back(voxel);
+            } else {
+                out.emplace_back(v.pos - center, unpackColor(v.color));
+            }
+        }
+    }
+
+    std::cout << "Voxelized " << triCount << " triangles into " << out.size() << " voxels ("
+              << grid.x << "x" << grid.y << "x" << grid.z << ", " << result.paletteSize << " colors)" << std::endl;
+    return result;
+}
@@ -0,0 +1,166 @@
+/**
+ * Octree Construction Implementation
+ */
+
+#include "octree.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <queue>
+
+// Subtrees above this depth are built as parallel jobs (8^2 = 64 tasks)
+constexpr int PARALLEL_BUILD_DEPTH = 2;
+
+bool allPointsSameColor(const VoxelList& points) {
+    if (points.empty()) return true;
+    glm::vec4 firstColor = points[0].getColor();
+    for (const auto& p : points) {
+        if (p.getColor() != firstColor) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// build tree in [min, max]
+std::shared_ptr<OctreeNode> buildOctree(const VoxelList& points, glm::vec3 min, glm::vec3 max, int depth) {
+    if (points.empty()) return nullptr;
+
+#ifdef HOMOGENEOUS_PROFILER
+    // Only the parallel top levels get zones; deeper recursion would flood the rings
+    std::unique_ptr<ProfileZone> zone;
+    if (depth < PARALLEL_BUILD_DEPTH) zone = std::make_unique<ProfileZone>("buildOctree");
+#endif
+
+    auto node = std::allocate_shared<OctreeNode>(TrackedAllocator<OctreeNode, MemoryTag::OctreeBuild>());
+
+    // leaf: create leaf when node size reaches voxel resolution (1x1x1) or at max depth
+    float nodeSize = max.x - min.x;
+    if (depth >= OCTREE_MAX_DEPTH || nodeSize <= 1.0f) {
+        node->leaf = true;
+        node->color = points[0].getColor();
+        return node;
+    }
+
+    glm::vec3 center = (min + max) * 0.5f;
+    // distribute points to 8 sub-cubes
+    std::vector<VoxelList> subPoints(8, VoxelList(VoxelAllocator(MemoryTag::OctreeBuild)));
+    for (const auto& p : points) {
+        glm::vec3 pos = glm::vec3(p.getPosition());
+        int idx = (pos.x >= center.x ? 1 : 0) |
+                  (pos.y >= center.y ? 2 : 0) |
+                  (pos.z >= center.z ? 4 : 0);
+        subPoints[idx].push_back(p);
+    }
+
+    auto buildChild = [&](int i) {
+        glm::vec3 subMin = min, subMax = max;
+
+        subMin.x = (i & 1) ? center.x : min.x;
+        subMax.x = (i & 1) ? max.x : center.x;
+        subMin.y = (i & 2) ? center.y : min.y;
+        subMax.y = (i & 2) ? max.y : center.y;
+        subMin.z = (i & 4) ? center.z : min.z;
+        subMax.z = (i & 4) ? max.z : center.z;
+
+        node->children[i] = buildOctree(subPoints[i], subMin, subMax, depth + 1);
+    };
+
+    if (depth < PARALLEL_BUILD_DEPTH) {
+        JobSystem::instance().parallelFor(0, 8, 1, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) buildChild(static_cast<int>(i));
+        });
+    } else {
+        for (int i = 0; i < 8; ++i) buildChild(i);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) {
+            node->childMask |= (1 << i);
+        }
+    }
+    return node;
+}
+
+uint32_t packColor(const glm::vec4& color) {
+    uint8_t r = static_cast<uint8_t>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f);
+    uint8_t g = static_cast<uint8_t>(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f);
+    uint8_t b = static_cast<uint8_t>(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f);
+    uint8_t a = static_cast<uint8_t>(glm::clamp(color.a, 0.0f, 1.0f) * 255.0f);
+    return (r << 24) | (g << 16) | (b << 8) | a;
+}
+
+glm::vec4 unpackColor(uint32_t packed) {
+    return glm::vec4((packed >> 24) & 0xFF, (packed >> 16) & 0xFF, (packed >> 8) & 0xFF, packed & 0xFF) / 255.0f;
+}
+
+void computeOctreeBounds(const VoxelList& points, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    // Compute per-axis bounding box
+    glm::vec3 bmin(1e9f), bmax(-1e9f);
+    for (const auto& v : points) {
+        glm::vec3 pos = glm::vec3(v.getPosition());
+        bmin = glm::min(bmin, pos);
+        bmax = glm::max(bmax, pos);
+    }
+
+    // Each voxel at integer position P occupies [P, P+1), so the octree must cover
+    // [bmin, bmax+1). Round the extent up to a power of two and keep min integer-aligned
+    // so that every subdivision boundary falls on an integer — matching voxel grid coords.
+    float extent = glm::max(glm::max(bmax.x - bmin.x + 1.0f, bmax.y - bmin.y + 1.0f), bmax.z - bmin.z + 1.0f);
+    float pot = 1.0f;
+    while (pot < extent) pot *= 2.0f;
+
+    boundsMin = glm::floor(bmin);
+    boundsMax = boundsMin + glm::vec3(pot);
+}
+
+void flattenOctree(const std::shared_ptr<OctreeNode>& octreeRoot, GPUNodeList& out) {
+    PROFILE_ZONE("BFS flatten");
+    out.clear();
+    if (!octreeRoot) return;
+
+    // BFS: collect nodes in level-order, track each node's index in out
+    // and which out slot needs its childMask updated with the first child index.
+    struct QueueEntry {
+        std::shared_ptr<OctreeNode> node;
+        uint32_t selfIdx; // index in out for this node
+    };
+
+    std::queue<QueueEntry> queue;
+
+    // Allocate root slot
+    out.push_back(GPUNode{0, 0});
+    QueueEntry rootEntry;
+    rootEntry.node = octreeRoot;
+    rootEntry.selfIdx = 0;
+    queue.push(rootEntry);
+
+    while (!queue.empty()) {
+        QueueEntry entry = queue.front();
+        queue.pop();
+
+        out[entry.selfIdx].color = packColor(entry.node->color);
+
+        if (entry.node->leaf) {
+            // Leaf: childMask stays 0
+            out[entry.selfIdx].childMask = 0;
+        } else {
+            // Allocate contiguous slots for all existing children
+            uint32_t firstChildIdx = static_cast<uint32_t>(out.size());
+
+            for (int i = 0; i < 8; ++i) {
+                if (entry.node->children[i]) {
+                    uint32_t childSlot = static_cast<uint32_t>(out.size());
+                    out.push_back(GPUNode{0, 0});
+
+                    QueueEntry childEntry;
+                    childEntry.node = entry.node->children[i];
+                    childEntry.selfIdx = childSlot;
+                    queue.push(childEntry);
+                }
+            }
+
+            // Encode: upper 24 bits = first child index, lower 8 bits = existence mask
+            out[entry.selfIdx].childMask = (firstChildIdx << 8) | static_cast<uint32_t>(entry.node->childMask);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * Sparse Voxel Octree
+ *
+ * CPU construction of the pointer octree and its flattened GPU layout.
+ *
+ * Flattened layout (GPUNode[]):
+ * - the root is node 0
+ * - childMask: upper 24 bits = index of the first child, lower 8 bits = child
+ *   existence mask (bit i = octant i with x = bit 0, y = bit 1, z = bit 2)
+ * - color: packed RGBA8 (R << 24 | G << 16 | B << 8 | A)
+ * - a node with an empty existence mask is a solid leaf
+ * - the children of a node are stored contiguously in octant order
+ *
+ * Nothing else about the order is guaranteed: flattenOctree() and the GPU
+ * builder emit level order, but the editor, CSG and the volume importer's
+ * brick subtrees place child blocks anywhere in the array.
+ */
+
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include <cstdint>
+#include <memory>
+#include <glm/glm.hpp>
+#include "memory_stats.h"
+#include "voxel.h"
+
+constexpr int OCTREE_MAX_DEPTH = 16;
+
+struct OctreeNode {
+    uint8_t childMask = 0;
+    std::shared_ptr<OctreeNode> children[8];
+    glm::vec4 color = glm::vec4(0.0f);
+    bool leaf = false;
+}; // only for cpu & memory.
+
+/**
+ * Flattened node, matches the OctreeNode struct in the shaders
+ */
+struct GPUNode
+{
+    uint32_t childMask;
+    uint32_t color; // Packed RGBA as uint32_t
+};
+
+using GPUNodeList = TrackedVector<GPUNode, MemoryTag::OctreeNodes>;
+
+inline uint32_t nodeExistMask(const GPUNode& node) { return node.childMask & 0xFFu; }
+inline uint32_t nodeFirstChild(const GPUNode& node) { return node.childMask >> 8; }
+inline bool nodeIsLeaf(const GPUNode& node) { return nodeExistMask(node) == 0u; }
+
+/**
+ * Index in the node array of octant `octant` of `node` (which must exist)
+ */
+inline uint32_t nodeChildIndex(const GPUNode& node, int octant) {
+    uint32_t below = nodeExistMask(node) & ((1u << octant) - 1u);
+    uint32_t offset = 0;
+    for (; below; below &= below - 1u) ++offset;
+    return nodeFirstChild(node) + offset;
+}
+
+uint32_t packColor(const glm::vec4& color);
+glm::vec4 unpackColor(uint32_t packed);
+
+bool allPointsSameColor(const VoxelList& points);
+
+// build tree in [min, max]
+std::shared_ptr<OctreeNode> buildOctree(const VoxelList& points, glm::vec3 min, glm::vec3 max, int depth);
+
+/**
+ * Power-of-two, integer-aligned cube covering every voxel cell [P, P+1)
+ */
+void computeOctreeBounds(const VoxelList& points, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+/**
+ * Flatten a pointer octree into the GPU layout (BFS / level order)
+ */
+void flattenOctree(const std::shared_ptr<OctreeNode>& root, GPUNodeList& out);
+
+#endif // OCTREE_H
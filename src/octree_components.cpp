@@ -0,0 +1,339 @@
+/**
+ * Octree Connected Components Implementation
+ */
+
+#include "octree_components.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Set on a root's parent entry once it has been given a component index
+constexpr uint32_t COMPONENT_TAG = 0x80000000u;
+
+// Bricks per job of the union and flatten passes
+constexpr size_t LABEL_GRAIN = 16;
+
+struct Box {
+    glm::ivec3 min;
+    glm::ivec3 max;     // Exclusive
+
+    glm::ivec3 size() const { return max - min; }
+    size_t volume() const {
+        glm::ivec3 s = size();
+        return static_cast<size_t>(s.x) * static_cast<size_t>(s.y) * static_cast<size_t>(s.z);
+    }
+    bool empty() const { return glm::any(glm::lessThanEqual(max, min)); }
+    Box clip(const Box& other) const { return Box{glm::max(min, other.min), glm::min(max, other.max)}; }
+};
+
+struct Component {
+    size_t count = 0;
+    glm::ivec3 min = glm::ivec3(INT32_MAX);
+    glm::ivec3 max = glm::ivec3(INT32_MIN);  // Inclusive
+    bool open = false;      // Reaches a face of the box that is not a face of the scene
+    bool touches = false;   // Has a voxel next to the edit
+};
+
+/**
+ * Lock-free union-find over voxel indices. Roots are always the smallest
+ * index of their set: links only go from a larger root to a smaller one.
+ */
+uint32_t findRoot(std::atomic<uint32_t>* parent, uint32_t x) {
+    for (;;) {
+        uint32_t p = parent[x].load(std::memory_order_relaxed);
+        if (p == x) return x;
+        uint32_t grand = parent[p].load(std::memory_order_relaxed);
+        // Path halving; losing the race to another writer is harmless
+        if (grand != p) parent[x].compare_exchange_weak(p, grand, std::memory_order_relaxed);
+        x = grand;
+    }
+}
+
+void unite(std::atomic<uint32_t>* parent, uint32_t a, uint32_t b) {
+    for (;;) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        uint32_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+/**
+ * Dense occupancy, colors and labels of one box of the octree grid
+ */
+class RegionGrid {
+public:
+    explicit RegionGrid(const Box& box)
+        : box(box)
+        , size(box.size())
+        , bricks((size + glm::ivec3(OctreeComponents::LABEL_BRICK - 1)) / OctreeComponents::LABEL_BRICK)
+        , solid(box.volume(), 0)
+        , color(box.volume())
+        , parent(box.volume())
+        , brickOccupied(static_cast<size_t>(bricks.x) * bricks.y * bricks.z, 0)
+    {
+    }
+
+    size_t index(const glm::ivec3& local) const {
+        return (static_cast<size_t>(local.z) * size.y + local.y) * size.x + local.x;
+    }
+
+    void fill(const GPUNode* nodes, const glm::ivec3& rootMin, int rootSize) {
+        PROFILE_FUNCTION();
+        struct Item {
+            uint32_t node;
+            glm::ivec3 min;
+            int size;
+        };
+        std::vector<Item> stack;
+        stack.push_back(Item{0, rootMin, rootSize});
+        while (!stack.empty()) {
+            Item item = stack.back();
+            stack.pop_back();
+            Box cell = Box{item.min, item.min + glm::ivec3(item.size)}.clip(box);
+            if (cell.empty()) continue;
+
+            const GPUNode& node = nodes[item.node];
+            if (nodeIsLeaf(node)) {
+                writeLeaf(Box{cell.min - box.min, cell.max - box.min}, node.color);
+                continue;
+            }
+            int half = item.size / 2;
+            uint32_t mask = nodeExistMask(node);
+            uint32_t child = nodeFirstChild(node);
+            for (int octant = 0; octant < 8; ++octant) {
+                if (mask & (1u << octant))
+                    stack.push_back(Item{child++, item.min + glm::ivec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1) * half, half});
+            }
+        }
+    }
+
+    /**
+     * Union every solid voxel with its -x, -y and -z neighbours, one job per
+     * run of bricks; afterwards every voxel points straight at its root
+     */
+    void label() {
+        PROFILE_FUNCTION();
+        std::atomic<uint32_t>* p = parent.data();
+        const size_t strideY = static_cast<size_t>(size.x);
+        const size_t strideZ = strideY * size.y;
+        JobSystem::instance().parallelFor(0, brickOccupied.size(), LABEL_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                if (!brickOccupied[b]) continue;
+                Box local = brickBox(b);
+                for (int z = local.min.z; z < local.max.z; ++z)
+                    for (int y = local.min.y; y < local.max.y; ++y)
+                        for (int x = local.min.x; x < local.max.x; ++x) {
+                            size_t i = index(glm::ivec3(x, y, z));
+                            if (!solid[i]) continue;
+                            uint32_t v = static_cast<uint32_t>(i);
+                            if (x > 0 && solid[i - 1]) unite(p, v, static_cast<uint32_t>(i - 1));
+                            if (y > 0 && solid[i - strideY]) unite(p, v, static_cast<uint32_t>(i - strideY));
+                            if (z > 0 && solid[i - strideZ]) unite(p, v, static_cast<uint32_t>(i - strideZ));
+                        }
+            }
+        });
+        JobSystem::instance().parallelFor(0, brickOccupied.size(), LABEL_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                if (!brickOccupied[b]) continue;
+                Box local = brickBox(b);
+                for (int z = local.min.z; z < local.max.z; ++z)
+                    for (int y = local.min.y; y < local.max.y; ++y)
+                        for (int x = local.min.x; x < local.max.x; ++x) {
+                            size_t i = index(glm::ivec3(x, y, z));
+                            if (solid[i]) p[i].store(findRoot(p, static_cast<uint32_t>(i)), std::memory_order_relaxed);
+                        }
+            }
+        });
+    }
+
+    /**
+     * Number the components in index order (a root precedes its set) and
+     * gather their extent; dirty is in local coordinates
+     */
+    std::vector<Component> collect(const Box& dirty, const Box& scene) {
+        PROFILE_FUNCTION();
+        std::vector<Component> components;
+        glm::bvec3 openLo = glm::greaterThan(box.min, scene.min);
+        glm::bvec3 openHi = glm::lessThan(box.max, scene.max);
+        for (int z = 0; z < size.z; ++z)
+            for (int y = 0; y < size.y; ++y)
+                for (int x = 0; x < size.x; ++x) {
+                    glm::ivec3 local(x, y, z);
+                    size_t i = index(local);
+                    if (!solid[i]) continue;
+                    uint32_t root = parent[i].load(std::memory_order_relaxed);
+                    uint32_t id;
+                    if (root == i) {
+                        id = static_cast<uint32_t>(components.size());
+                        components.emplace_back();
+                        parent[i].store(id | COMPONENT_TAG, std::memory_order_relaxed);
+                    } else {
+                        id = parent[root].load(std::memory_order_relaxed) & ~COMPONENT_TAG;
+                    }
+                    Component& c = components[id];
+                    ++c.count;
+                    c.min = glm::min(c.min, local);
+                    c.max = glm::max(c.max, local);
+                    for (int axis = 0; axis < 3; ++axis) {
+                        if ((openLo[axis] && local[axis] == 0) || (openHi[axis] && local[axis] == size[axis] - 1))
+                            c.open = true;
+                    }
+                    if (glm::all(glm::greaterThanEqual(local, dirty.min)) && glm::all(glm::lessThan(local, dirty.max)))
+                        c.touches = true;
+                }
+        return components;
+    }
+
+    /**
+     * Component index of a solid voxel after collect()
+     */
+    uint32_t componentOf(size_t i) const {
+        uint32_t value = parent[i].load(std::memory_order_relaxed);
+        if (!(value & COMPONENT_TAG)) value = parent[value].load(std::memory_order_relaxed);
+        return value & ~COMPONENT_TAG;
+    }
+
+    const Box box;
+    const glm::ivec3 size;
+    const glm::ivec3 bricks;
+    std::vector<uint8_t> solid;
+    std::vector<uint32_t> color;
+
+private:
+    void writeLeaf(const Box& local, uint32_t packed) {
+        for (int z = local.min.z; z < local.max.z; ++z)
+            for (int y = local.min.y; y < local.max.y; ++y)
+                for (int x = local.min.x; x < local.max.x; ++x) {
+                    size_t i = index(glm::ivec3(x, y, z));
+                    solid[i] = 1;
+                    color[i] = packed;
+                    parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+                }
+        glm::ivec3 lo = local.min / OctreeComponents::LABEL_BRICK;
+        glm::ivec3 hi = (local.max - glm::ivec3(1)) / OctreeComponents::LABEL_BRICK;
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    brickOccupied[(static_cast<size_t>(z) * bricks.y + y) * bricks.x + x] = 1;
+    }
+
+    Box brickBox(size_t b) const {
+        glm::ivec3 brick(static_cast<int>(b % bricks.x), static_cast<int>((b / bricks.x) % bricks.y),
+                         static_cast<int>(b / (static_cast<size_t>(bricks.x) * bricks.y)));
+        glm::ivec3 lo = brick * OctreeComponents::LABEL_BRICK;
+        return Box{lo, glm::min(lo + glm::ivec3(OctreeComponents::LABEL_BRICK), size)};
+    }
+
+    std::vector<std::atomic<uint32_t>> parent;
+    std::vector<uint8_t> brickOccupied;
+};
+
+} // namespace
+
+std::vector<OctreeComponents::Detached> OctreeComponents::findDetached(const GPUNode* nodes, size_t nodeCount,
+                                                                       const glm::vec3& boundsMin,
+                                                                       const glm::vec3& boundsMax,
+                                                                       const glm::ivec3& dirtyMin,
+                                                                       const glm::ivec3& dirtyMax,
+                                                                       size_t maxCount, Stats* stats) {
+    PROFILE_FUNCTION();
+    std::vector<Detached> detached;
+    if (nodes == nullptr || nodeCount == 0 || maxCount == 0) return detached;
+
+    glm::ivec3 rootMin = glm::ivec3(glm::floor(boundsMin));
+    int rootSize = static_cast<int>(boundsMax.x - boundsMin.x);
+    Box scene{rootMin, rootMin + glm::ivec3(rootSize)};
+    // Voxels next to a removed one are the only ones whose connectivity changed
+    Box touched = Box{dirtyMin - glm::ivec3(1), dirtyMax + glm::ivec3(1)}.clip(scene);
+    if (touched.empty()) return detached;
+
+    std::unique_ptr<RegionGrid> grid;
+    std::vector<Component> components;
+    for (int margin = REGION_MARGIN;; margin *= 2) {
+        Box box = Box{touched.min - glm::ivec3(margin), touched.max + glm::ivec3(margin)}.clip(scene);
+        if (box.volume() > MAX_REGION_VOXELS) {
+            if (!grid) return detached; // The edit alone is too large to label
+            break;
+        }
+        grid.reset(new RegionGrid(box));
+        grid->fill(nodes, rootMin, rootSize);
+        grid->label();
+        components = grid->collect(Box{touched.min - box.min, touched.max - box.min}, scene);
+        if (stats) {
+            stats->regionVoxels = box.volume();
+            stats->components = components.size();
+            ++stats->passes;
+        }
+
+        bool growing = false;
+        for (const Component& c : components) growing |= c.touches && c.open;
+        if (!growing || (box.min == scene.min && box.max == scene.max)) break;
+    }
+
+    // Pieces still reaching out of the box are attached to the rest of the scene;
+    // without any, the largest piece around the edit stays
+    std::vector<uint32_t> candidates;
+    bool anyOpen = false;
+    size_t largest = SIZE_MAX;
+    for (size_t i = 0; i < components.size(); ++i) {
+        const Component& c = components[i];
+        if (!c.touches) continue;
+        anyOpen |= c.open;
+        if (!c.open) candidates.push_back(static_cast<uint32_t>(i));
+        if (largest == SIZE_MAX || c.count > components[largest].count) largest = i;
+    }
+    if (!anyOpen) {
+        candidates.erase(std::remove(candidates.begin(), candidates.end(), static_cast<uint32_t>(largest)),
+                         candidates.end());
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&](uint32_t a, uint32_t b) { return components[a].count > components[b].count; });
+    if (candidates.size() > maxCount) candidates.resize(maxCount);
+    if (candidates.empty()) return detached;
+
+    // One more sweep over the box sorts the voxels of the detached pieces
+    std::vector<int> slot(components.size(), -1);
+    std::vector<VoxelList> voxels(candidates.size());
+    detached.resize(candidates.size());
+    for (size_t k = 0; k < candidates.size(); ++k) {
+        const Component& c = components[candidates[k]];
+        slot[candidates[k]] = static_cast<int>(k);
+        voxels[k].reserve(c.count);
+        auto mask = std::make_shared<VoxelMask>();
+        mask->min = grid->box.min + c.min;
+        mask->size = c.max - c.min + glm::ivec3(1);
+        mask->bits.assign(static_cast<size_t>(mask->size.x) * mask->size.y * mask->size.z, 0);
+        detached[k].mask = std::move(mask);
+        detached[k].solidCount = c.count;
+    }
+    for (int z = 0; z < grid->size.z; ++z)
+        for (int y = 0; y < grid->size.y; ++y)
+            for (int x = 0; x < grid->size.x; ++x) {
+                glm::ivec3 local(x, y, z);
+                size_t i = grid->index(local);
+                if (!grid->solid[i]) continue;
+                int k = slot[grid->componentOf(i)];
+                if (k < 0) continue;
+                glm::ivec3 p = grid->box.min + local;
+                VoxelMask& mask = *detached[k].mask;
+                glm::ivec3 m = p - mask.min;
+                mask.bits[(static_cast<size_t>(m.z) * mask.size.y + m.y) * mask.size.x + m.x] = 1;
+                voxels[k].emplace_back(p, unpackColor(grid->color[i]));
+            }
+    grid.reset();
+
+    for (size_t k = 0; k < detached.size(); ++k) {
+        Detached& piece = detached[k];
+        computeOctreeBounds(voxels[k], piece.boundsMin, piece.boundsMax);
+        flattenOctree(buildOctree(voxels[k], piece.boundsMin, piece.boundsMax, 0), piece.nodes);
+    }
+    return detached;
+}
@@ -0,0 +1,60 @@
+/**
+ * Octree Connected Components
+ *
+ * Finds the solid pieces a removal edit cut loose from the rest of an octree
+ * (GPUNode layout, see octree.h) so they can be turned into separate objects.
+ *
+ * Only the neighbourhood of the edit is examined. The octree's occupancy in a
+ * box around the edited region is expanded into a dense grid and labeled with
+ * a lock-free union-find (6-connectivity) over LABEL_BRICK^3 bricks in
+ * parallel; empty bricks are skipped. A component that reaches a face of the
+ * box may continue outside it, so while such a component touches the edit the
+ * box grows (up to MAX_REGION_VOXELS) and is labeled again. Components that
+ * still reach out are attached to the rest of the scene; when none does, the
+ * largest piece around the edit stays. Every other closed component touching
+ * the edit is detached.
+ */
+
+#ifndef OCTREE_COMPONENTS_H
+#define OCTREE_COMPONENTS_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "octree.h"
+#include "octree_editor.h"
+
+class OctreeComponents {
+public:
+    static constexpr int LABEL_BRICK = 8;
+    static constexpr size_t MAX_REGION_VOXELS = size_t(1) << 22;
+    // Initial distance the labeled box extends past the edited region
+    static constexpr int REGION_MARGIN = 16;
+
+    struct Detached {
+        std::shared_ptr<VoxelMask> mask;    // Its voxels, to remove it from the source tree
+        GPUNodeList nodes;                  // Its own octree
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        size_t solidCount = 0;
+    };
+
+    struct Stats {
+        size_t regionVoxels = 0;    // Cells of the last labeled box
+        size_t components = 0;      // Components in the last labeled box
+        int passes = 0;             // Labeling passes (one per box size)
+    };
+
+    /**
+     * Components around the voxels [dirtyMin, dirtyMax) of the octree covering
+     * [boundsMin, boundsMax) that are no longer connected to the rest of it,
+     * largest first and at most maxCount of them
+     */
+    static std::vector<Detached> findDetached(const GPUNode* nodes, size_t nodeCount,
+                                              const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                                              const glm::ivec3& dirtyMin, const glm::ivec3& dirtyMax,
+                                              size_t maxCount, Stats* stats = nullptr);
+};
+
+#endif // OCTREE_COMPONENTS_H
@@ -0,0 +1,311 @@
+/**
+ * Octree CSG Implementation
+ */
+
+#include "octree_csg.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+
+// Result levels above this depth are built as parallel jobs (8^2 = 64 tasks)
+constexpr int CSG_PARALLEL_DEPTH = 2;
+
+// Child indices are 24 bits wide
+constexpr size_t CSG_MAX_NODES = size_t(1) << 24;
+
+struct Cursor {
+    uint32_t node;
+    glm::vec3 min;
+    float size;
+};
+
+/**
+ * Operand nodes overlapping one result cell of size s. Interior nodes larger
+ * than s are refined away, so the list holds disjoint operand cells of size
+ * >= s (or the operand root when it is smaller): at most 2 per axis.
+ */
+struct CursorList {
+    Cursor items[8];
+    int count = 0;
+};
+
+struct Coverage {
+    enum Kind { Empty, Full, Mixed } kind;
+    uint32_t color;     // Full only
+};
+
+struct Value {
+    bool present;
+    GPUNode node;
+};
+
+struct Emitter {
+    GPUNodeList nodes;
+    uint64_t solid = 0;
+};
+
+inline glm::vec3 octantOffset(int octant) {
+    return glm::vec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+}
+
+inline bool overlaps(const glm::vec3& minA, float sizeA, const glm::vec3& minB, float sizeB) {
+    return glm::all(glm::lessThan(minA, minB + glm::vec3(sizeB))) &&
+           glm::all(glm::greaterThan(minA + glm::vec3(sizeA), minB));
+}
+
+class CsgBuilder {
+public:
+    CsgBuilder(OctreeCSG::Op op, const OctreeCSG::Operand& a, const OctreeCSG::Operand& b)
+        : op(op), a(a), b(b)
+    {
+    }
+
+    /**
+     * Operand nodes of `list` (from `nodes`) that overlap the cell, refined to the cell size
+     */
+    static void narrow(const GPUNode* nodes, const CursorList& list, const glm::vec3& cellMin, float cellSize,
+                       CursorList& out) {
+        out.count = 0;
+        for (int i = 0; i < list.count; ++i) refineInto(nodes, list.items[i], cellMin, cellSize, out);
+    }
+
+    Value combine(const CursorList& la, const CursorList& lb, const glm::vec3& min, float size, int depth,
+                  Emitter& out) {
+        if (overflow.load(std::memory_order_relaxed)) return Value{false, GPUNode{0, 0}};
+
+        Coverage ca = classify(a.nodes, la, min, size);
+        Coverage cb = classify(b.nodes, lb, min, size);
+        const Value empty{false, GPUNode{0, 0}};
+        auto solid = [&](uint32_t color) {
+            out.solid += static_cast<uint64_t>(size) * static_cast<uint64_t>(size) * static_cast<uint64_t>(size);
+            return Value{true, GPUNode{0, color}};
+        };
+
+        switch (op) {
+        case OctreeCSG::Op::Union:
+            if (ca.kind == Coverage::Full) return solid(ca.color);
+            if (ca.kind == Coverage::Empty) {
+                if (cb.kind == Coverage::Empty) return empty;
+                if (cb.kind == Coverage::Full) return solid(cb.color);
+                if (isCell(lb, min, size)) return copySubtree(b.nodes, lb.items[0].node, size, out);
+            } else if (cb.kind == Coverage::Empty && isCell(la, min, size)) {
+                return copySubtree(a.nodes, la.items[0].node, size, out);
+            }
+            break;
+        case OctreeCSG::Op::Subtract:
+            if (ca.kind == Coverage::Empty || cb.kind == Coverage::Full) return empty;
+            if (cb.kind == Coverage::Empty) {
+                if (ca.kind == Coverage::Full) return solid(ca.color);
+                if (isCell(la, min, size)) return copySubtree(a.nodes, la.items[0].node, size, out);
+            }
+            break;
+        case OctreeCSG::Op::Intersect:
+            if (ca.kind == Coverage::Empty || cb.kind == Coverage::Empty) return empty;
+            if (ca.kind == Coverage::Full && cb.kind == Coverage::Full) return solid(ca.color);
+            if (cb.kind == Coverage::Full && isCell(la, min, size))
+                return copySubtree(a.nodes, la.items[0].node, size, out);
+            break;
+        }
+        return descend(la, lb, min, size, depth, out);
+    }
+
+    std::atomic<bool> overflow{false};
+
+private:
+    static void refineInto(const GPUNode* nodes, const Cursor& cursor, const glm::vec3& cellMin, float cellSize,
+                           CursorList& out) {
+        if (!overlaps(cursor.min, cursor.size, cellMin, cellSize)) return;
+        const GPUNode& node = nodes[cursor.node];
+        if (nodeIsLeaf(node) || cursor.size <= cellSize) {
+            out.items[out.count++] = cursor;
+            return;
+        }
+        float half = cursor.size * 0.5f;
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (mask & (1u << octant))
+                refineInto(nodes, Cursor{child++, cursor.min + octantOffset(octant) * half, half}, cellMin, cellSize, out);
+        }
+    }
+
+    static Coverage classify(const GPUNode* nodes, const CursorList& list, const glm::vec3& min, float size) {
+        if (list.count == 0) return Coverage{Coverage::Empty, 0};
+        glm::vec3 max = min + glm::vec3(size);
+        for (int i = 0; i < list.count; ++i) {
+            const Cursor& c = list.items[i];
+            const GPUNode& node = nodes[c.node];
+            if (nodeIsLeaf(node) && glm::all(glm::lessThanEqual(c.min, min)) &&
+                glm::all(glm::greaterThanEqual(c.min + glm::vec3(c.size), max)))
+                return Coverage{Coverage::Full, node.color};
+        }
+        return Coverage{Coverage::Mixed, 0};
+    }
+
+    /**
+     * True if the list is one operand node that is exactly this cell (aligned operands)
+     */
+    static bool isCell(const CursorList& list, const glm::vec3& min, float size) {
+        return list.count == 1 && list.items[0].size == size && list.items[0].min == min;
+    }
+
+    Value descend(const CursorList& la, const CursorList& lb, const glm::vec3& min, float size, int depth,
+                  Emitter& out) {
+        float half = size * 0.5f;
+        Value children[8];
+        auto buildChild = [&](int octant, Emitter& emitter) {
+            glm::vec3 childMin = min + octantOffset(octant) * half;
+            CursorList ca, cb;
+            narrow(a.nodes, la, childMin, half, ca);
+            narrow(b.nodes, lb, childMin, half, cb);
+            children[octant] = combine(ca, cb, childMin, half, depth + 1, emitter);
+        };
+
+        if (depth < CSG_PARALLEL_DEPTH) {
+            // Each child builds into its own list; the chunks are rebased into out afterwards
+            Emitter local[8];
+            JobSystem::instance().parallelFor(0, 8, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) buildChild(static_cast<int>(i), local[i]);
+            });
+            for (int octant = 0; octant < 8; ++octant) {
+                uint32_t base = static_cast<uint32_t>(out.nodes.size());
+                if (out.nodes.size() + local[octant].nodes.size() >= CSG_MAX_NODES) {
+                    overflow = true;
+                    return Value{false, GPUNode{0, 0}};
+                }
+                for (GPUNode node : local[octant].nodes) {
+                    if (!nodeIsLeaf(node)) node.childMask += base << 8;
+                    out.nodes.push_back(node);
+                }
+                if (children[octant].present && !nodeIsLeaf(children[octant].node))
+                    children[octant].node.childMask += base << 8;
+                out.solid += local[octant].solid;
+            }
+        } else {
+            for (int octant = 0; octant < 8; ++octant) buildChild(octant, out);
+        }
+        return emitBlock(children, out);
+    }
+
+    Value copySubtree(const GPUNode* nodes, uint32_t index, float size, Emitter& out) {
+        const GPUNode& node = nodes[index];
+        if (nodeIsLeaf(node)) {
+            out.solid += static_cast<uint64_t>(size) * static_cast<uint64_t>(size) * static_cast<uint64_t>(size);
+            return Value{true, node};
+        }
+        Value children[8];
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            children[octant] = (mask & (1u << octant)) ? copySubtree(nodes, child++, size * 0.5f, out)
+                                                       : Value{false, GPUNode{0, 0}};
+        }
+        return emitBlock(children, out);
+    }
+
+    /**
+     * Emit the present children as one block (children first, parents after)
+     */
+    Value emitBlock(const Value (&children)[8], Emitter& out) {
+        uint32_t mask = 0;
+        for (int octant = 0; octant < 8; ++octant) {
+            if (children[octant].present) mask |= 1u << octant;
+        }
+        if (mask == 0) return Value{false, GPUNode{0, 0}};
+
+        // Eight equal solid leaves collapse into their parent
+        if (mask == 0xFFu) {
+            bool uniform = true;
+            for (int octant = 0; octant < 8 && uniform; ++octant) {
+                uniform = nodeIsLeaf(children[octant].node) && children[octant].node.color == children[0].node.color;
+            }
+            if (uniform) return Value{true, GPUNode{0, children[0].node.color}};
+        }
+
+        if (out.nodes.size() + 8 >= CSG_MAX_NODES) {
+            overflow = true;
+            return Value{false, GPUNode{0, 0}};
+        }
+        uint32_t first = static_cast<uint32_t>(out.nodes.size());
+        for (int octant = 0; octant < 8; ++octant) {
+            if (children[octant].present) out.nodes.push_back(children[octant].node);
+        }
+        return Value{true, GPUNode{(first << 8) | mask, 0}};
+    }
+
+    OctreeCSG::Op op;
+    const OctreeCSG::Operand& a;
+    const OctreeCSG::Operand& b;
+};
+
+inline bool containsBounds(const OctreeCSG::Operand& outer, const OctreeCSG::Operand& inner) {
+    return glm::all(glm::lessThanEqual(outer.boundsMin, inner.boundsMin)) &&
+           glm::all(glm::greaterThanEqual(outer.boundsMax, inner.boundsMax));
+}
+
+} // namespace
+
+OctreeCSG::Result OctreeCSG::apply(Op op, const Operand& a, const Operand& b) {
+    PROFILE_FUNCTION();
+    Result result;
+    bool hasA = a.nodeCount > 0;
+    bool hasB = b.nodeCount > 0;
+
+    // Result cube: A's own cube (placed even when A is empty) so its subtrees copy
+    // straight across. A union doubles it toward B until B fits, which keeps A's cube
+    // a cell of the result; OctreeEditor::commitTree re-roots its history on that.
+    const bool placedA = a.boundsMax.x > a.boundsMin.x;
+    const Operand& base = placedA ? a : b;
+    result.boundsMin = base.boundsMin;
+    result.boundsMax = base.boundsMax;
+    if (op == Op::Union && placedA && hasB && !containsBounds(a, b)) {
+        glm::vec3 lo = a.boundsMin;
+        float size = a.boundsMax.x - a.boundsMin.x;
+        while (size <= static_cast<float>(1 << OCTREE_MAX_DEPTH) &&
+               !(glm::all(glm::lessThanEqual(lo, b.boundsMin)) &&
+                 glm::all(glm::greaterThanEqual(lo + glm::vec3(size), b.boundsMax)))) {
+            // Per axis, grow toward the side B overhangs more
+            for (int axis = 0; axis < 3; ++axis) {
+                float below = lo[axis] - b.boundsMin[axis];
+                float above = b.boundsMax[axis] - (lo[axis] + size);
+                if (below > 0.0f && below > above) lo[axis] -= size;
+            }
+            size *= 2.0f;
+        }
+        result.boundsMin = lo;
+        result.boundsMax = lo + glm::vec3(size);
+    }
+    if (!hasA && (op != Op::Union || !hasB)) return result;
+
+    float rootSize = result.boundsMax.x - result.boundsMin.x;
+    if (rootSize > static_cast<float>(1 << OCTREE_MAX_DEPTH))
+        throw std::runtime_error("CSG result exceeds the maximum octree depth");
+
+    auto rootList = [&](const Operand& operand, CursorList& out) {
+        out.count = 0;
+        if (operand.nodeCount == 0) return;
+        CursorList root;
+        root.items[root.count++] = Cursor{0, operand.boundsMin, operand.boundsMax.x - operand.boundsMin.x};
+        CsgBuilder::narrow(operand.nodes, root, result.boundsMin, rootSize, out);
+    };
+    CursorList la, lb;
+    rootList(a, la);
+    rootList(b, lb);
+
+    CsgBuilder builder(op, a, b);
+    Emitter out;
+    out.nodes.push_back(GPUNode{0, 0}); // The root must stay at index 0
+    Value root = builder.combine(la, lb, result.boundsMin, rootSize, 0, out);
+    if (builder.overflow) throw std::runtime_error("CSG result exceeds the 24-bit octree child index");
+
+    if (root.present) {
+        out.nodes[0] = root.node;
+        result.nodes = std::move(out.nodes);
+        result.solidCount = static_cast<size_t>(out.solid);
+    }
+    return result;
+}
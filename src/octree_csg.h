@@ -0,0 +1,67 @@
+/**
+ * Octree CSG
+ *
+ * Boolean operations (union, subtraction, intersection) between two
+ * flattened octrees (GPUNode layout, see octree.h), without going through
+ * voxel lists.
+ *
+ * Both trees are walked together over the cells of the result tree. At each
+ * cell every operand is classified as empty, full (one solid leaf covers the
+ * cell) or mixed; empty and full cells short-circuit, and a subtree only one
+ * operand contributes to is copied without descending the other. The cost is
+ * therefore proportional to the region where both operands are mixed.
+ * Operands may sit anywhere on the integer grid: when their cells do not
+ * line up with the result cells each cell tracks the (at most 8) operand
+ * nodes overlapping it.
+ *
+ * The top levels are processed as parallel jobs and stitched into one new
+ * compact tree; eight equal solid leaves are merged into their parent.
+ */
+
+#ifndef OCTREE_CSG_H
+#define OCTREE_CSG_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "octree.h"
+
+class OctreeCSG {
+public:
+    enum class Op {
+        Union,      // A or B; A's colors win where both are solid
+        Subtract,   // A and not B
+        Intersect   // A and B, with A's colors
+    };
+
+    /**
+     * Read-only operand: a flattened octree covering [boundsMin, boundsMax),
+     * an integer-aligned power-of-two cube. Shift both bounds by an integer
+     * offset to place the tree.
+     */
+    struct Operand {
+        const GPUNode* nodes = nullptr;
+        size_t nodeCount = 0;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+    };
+
+    /**
+     * The result covers A's cube (B's when A has no bounds); a union that
+     * reaches outside it doubles the cube toward B, so A's cube stays one of
+     * its cells.
+     */
+    struct Result {
+        GPUNodeList nodes;                  // Empty if no voxel remains
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        size_t solidCount = 0;              // Solid unit voxels
+    };
+
+    /**
+     * @throws std::runtime_error if the result exceeds the octree depth or
+     *         the 24-bit child index
+     */
+    static Result apply(Op op, const Operand& a, const Operand& b);
+};
+
+#endif // OCTREE_CSG_H
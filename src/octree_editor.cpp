@@ -0,0 +1,595 @@
+/**
+ * Octree Editing Implementation
+ */
+
+#include "octree_editor.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Upper bound on nodes one brick can append: a full 32^3 subtree plus a new
+// child block on every level above it
+constexpr size_t BRICK_NODE_BUDGET = 8 + 64 + 512 + 4096 + 32768 + 8 * OCTREE_MAX_DEPTH;
+
+// Garbage below this is not worth a full re-upload
+constexpr size_t MIN_COMPACT_GARBAGE = 1 << 16;
+
+// Dirty ranges closer than this are uploaded as one
+constexpr uint32_t DIRTY_MERGE_GAP = 32;
+
+enum class Coverage { Outside, Partial, Inside };
+
+struct Source {
+    enum Kind : uint8_t { Empty, Solid, Interior } kind;
+    GPUNode node;
+};
+
+struct Result {
+    bool present;
+    bool changed;   // Value differs from the source, the parent must store it
+    GPUNode node;
+};
+
+inline Source sourceOf(const GPUNode& node) {
+    return Source{nodeIsLeaf(node) ? Source::Solid : Source::Interior, node};
+}
+
+inline float cellVolume(float size) { return size * size * size; }
+
+inline void appendRange(std::vector<NodeRange>& ranges, uint32_t begin, uint32_t end) {
+    if (!ranges.empty() && ranges.back().end == begin) ranges.back().end = end;
+    else ranges.push_back(NodeRange{begin, end});
+}
+
+inline int popcount(uint32_t mask) {
+    int n = 0;
+    for (; mask; mask &= mask - 1u) ++n;
+    return n;
+}
+
+// Nodes below root (not counting it), each once: versions are trees
+size_t countBelow(const GPUNodeList& nodes, const GPUNode& root) {
+    size_t count = 0;
+    std::vector<GPUNode> stack{root};
+    while (!stack.empty()) {
+        GPUNode node = stack.back();
+        stack.pop_back();
+        if (nodeIsLeaf(node)) continue;
+        uint32_t first = nodeFirstChild(node);
+        for (int k = 0, n = popcount(nodeExistMask(node)); k < n; ++k) stack.push_back(nodes[first + k]);
+        count += static_cast<size_t>(popcount(nodeExistMask(node)));
+    }
+    return count;
+}
+
+class BrickEditor {
+public:
+    BrickEditor(GPUNodeList& nodes, uint32_t frozenEnd, const Brush& brush, const glm::vec3& clipMin, float clipSize,
+                std::vector<NodeRange>& dirty)
+        : nodes(nodes)
+        , frozenEnd(frozenEnd)
+        , brush(brush)
+        , clipMin(clipMin)
+        , clipMax(clipMin + glm::vec3(clipSize))
+        , dirty(dirty)
+        , brushLeaf{0, packColor(brush.color)}
+    {
+    }
+
+    Result apply(const Source& src, const glm::vec3& min, float size, int depth) {
+        const Result unchanged{src.kind != Source::Empty, false, src.node};
+        Coverage coverage = classify(min, size, depth);
+        if (coverage == Coverage::Outside) return unchanged;
+
+        if (coverage == Coverage::Inside) {
+            switch (brush.mode) {
+            case BrushMode::Add:
+                if (src.kind == Source::Solid && src.node.color == brushLeaf.color) return unchanged;
+                release(src, size);
+                voxelDelta += static_cast<int64_t>(cellVolume(size));
+                return Result{true, true, brushLeaf};
+            case BrushMode::Remove:
+                if (src.kind == Source::Empty) return unchanged;
+                release(src, size);
+                return Result{false, true, GPUNode{0, 0}};
+            case BrushMode::Paint:
+                if (src.kind == Source::Empty) return unchanged;
+                if (src.kind == Source::Solid) {
+                    if (src.node.color == brushLeaf.color) return unchanged;
+                    return Result{true, true, brushLeaf};
+                }
+                break; // Interior: recolor the leaves below
+            }
+        } else {
+            if (src.kind == Source::Empty && brush.mode != BrushMode::Add) return unchanged;
+            // A leaf the brush would leave as it is need not be split
+            if (src.kind == Source::Solid && brush.mode != BrushMode::Remove && src.node.color == brushLeaf.color)
+                return unchanged;
+        }
+
+        // Descend; a solid leaf splits into 8 virtual solid children, empty space into 8 empty ones
+        uint32_t oldMask = src.kind == Source::Interior ? nodeExistMask(src.node) : 0u;
+        uint32_t childIndex[8] = {};
+        Result results[8];
+        bool anyChanged = false;
+        float half = size * 0.5f;
+        uint32_t next = nodeFirstChild(src.node);
+        for (int octant = 0; octant < 8; ++octant) {
+            Source child{Source::Empty, GPUNode{0, 0}};
+            if (src.kind == Source::Interior) {
+                if (oldMask & (1u << octant)) {
+                    childIndex[octant] = next;
+                    child = sourceOf(nodes[next++]);
+                }
+            } else if (src.kind == Source::Solid) {
+                child = src;
+            }
+            glm::vec3 childMin = min + glm::vec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1) * half;
+            results[octant] = apply(child, childMin, half, depth + 1);
+            anyChanged |= results[octant].changed;
+        }
+        if (!anyChanged) return unchanged;
+
+        uint32_t newMask = 0;
+        for (int octant = 0; octant < 8; ++octant) {
+            if (results[octant].present) newMask |= 1u << octant;
+        }
+
+        // Same child set in a block this edit owns: overwrite the changed children where they are
+        if (src.kind == Source::Interior && newMask == oldMask && nodeFirstChild(src.node) >= frozenEnd) {
+            for (int octant = 0; octant < 8; ++octant) {
+                if (!results[octant].changed) continue;
+                nodes[childIndex[octant]] = results[octant].node;
+                markDirty(childIndex[octant], childIndex[octant] + 1);
+            }
+            return Result{true, false, src.node};
+        }
+
+        if (src.kind == Source::Interior) {
+            for (int k = 0, n = popcount(oldMask); k < n; ++k) drop(nodeFirstChild(src.node) + k);
+        }
+        if (newMask == 0) return Result{false, true, GPUNode{0, 0}};
+
+        // New child set or a shared block: emit a fresh block into the slack at the end,
+        // unchanged children keep pointing at their (shared) subtrees
+        uint32_t first = static_cast<uint32_t>(nodes.size());
+        for (int octant = 0; octant < 8; ++octant) {
+            if (results[octant].present) nodes.push_back(results[octant].node);
+        }
+        created += nodes.size() - first;
+        markDirty(first, static_cast<uint32_t>(nodes.size()));
+        uint32_t color = src.kind == Source::Interior ? src.node.color : 0u;
+        return Result{true, true, GPUNode{(first << 8) | newMask, color}};
+    }
+
+    void markDirty(uint32_t begin, uint32_t end) {
+        appendRange(dirty, begin, end);
+        ++writes;
+    }
+
+    size_t writes = 0;      // Stores into the node array
+    size_t created = 0;     // Nodes appended
+    size_t garbage = 0;     // Dropped nodes this edit owned: unreachable from any version
+    size_t replaced = 0;    // Dropped nodes of earlier versions: still referenced by history
+    int64_t voxelDelta = 0;
+
+private:
+    void drop(uint32_t index) {
+        if (index < frozenEnd) ++replaced;
+        else ++garbage;
+    }
+
+    /**
+     * Classify a cell by its voxel centers against the brush, clipped to the brick
+     */
+    Coverage classify(const glm::vec3& min, float size, int depth) const {
+        glm::vec3 max = min + glm::vec3(size);
+        if (glm::any(glm::lessThanEqual(max, clipMin)) || glm::any(glm::greaterThanEqual(min, clipMax)))
+            return Coverage::Outside;
+        bool insideClip = glm::all(glm::greaterThanEqual(min, clipMin)) && glm::all(glm::lessThanEqual(max, clipMax));
+
+        // Cells that cannot be split any further go by their center
+        if (size <= 1.0f || depth >= OCTREE_MAX_DEPTH)
+            return contains(min + glm::vec3(size * 0.5f)) ? Coverage::Inside : Coverage::Outside;
+
+        glm::vec3 lo = min + glm::vec3(0.5f);
+        glm::vec3 hi = max - glm::vec3(0.5f);
+        Coverage coverage;
+        if (brush.shape == BrushShape::Mask) {
+            // Only unit cells are tested against the mask
+            glm::vec3 bmin = glm::vec3(brush.mask->min);
+            glm::vec3 bmax = glm::vec3(brush.mask->min + brush.mask->size);
+            if (glm::any(glm::lessThanEqual(max, bmin)) || glm::any(glm::greaterThanEqual(min, bmax)))
+                return Coverage::Outside;
+            return Coverage::Partial;
+        } else if (brush.shape == BrushShape::Sphere) {
+            glm::vec3 nearest = glm::clamp(brush.center, lo, hi) - brush.center;
+            glm::vec3 farthest = glm::max(glm::abs(lo - brush.center), glm::abs(hi - brush.center));
+            float r2 = brush.radius * brush.radius;
+            if (glm::dot(nearest, nearest) > r2) return Coverage::Outside;
+            coverage = glm::dot(farthest, farthest) <= r2 ? Coverage::Inside : Coverage::Partial;
+        } else {
+            glm::vec3 bmin = brush.center - glm::vec3(brush.radius);
+            glm::vec3 bmax = brush.center + glm::vec3(brush.radius);
+            if (glm::any(glm::lessThan(hi, bmin)) || glm::any(glm::greaterThan(lo, bmax))) return Coverage::Outside;
+            coverage = glm::all(glm::greaterThanEqual(lo, bmin)) && glm::all(glm::lessThanEqual(hi, bmax))
+                ? Coverage::Inside : Coverage::Partial;
+        }
+        return coverage == Coverage::Inside && !insideClip ? Coverage::Partial : coverage;
+    }
+
+    bool contains(const glm::vec3& p) const {
+        if (glm::any(glm::lessThan(p, clipMin)) || glm::any(glm::greaterThanEqual(p, clipMax))) return false;
+        if (brush.shape == BrushShape::Mask) return brush.mask->test(glm::ivec3(glm::floor(p)));
+        glm::vec3 d = p - brush.center;
+        if (brush.shape == BrushShape::Sphere) return glm::dot(d, d) <= brush.radius * brush.radius;
+        return glm::all(glm::lessThanEqual(glm::abs(d), glm::vec3(brush.radius)));
+    }
+
+    /**
+     * Account for a subtree that is being dropped: its voxels and its nodes below the root
+     */
+    void release(const Source& src, float size) {
+        if (src.kind == Source::Empty) return;
+        if (src.kind == Source::Solid) {
+            voxelDelta -= static_cast<int64_t>(cellVolume(size));
+            return;
+        }
+        uint32_t mask = nodeExistMask(src.node);
+        uint32_t child = nodeFirstChild(src.node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (!(mask & (1u << octant))) continue;
+            drop(child);
+            release(sourceOf(nodes[child++]), size * 0.5f);
+        }
+    }
+
+    GPUNodeList& nodes;
+    uint32_t frozenEnd;     // Nodes below this belong to committed versions and are never written
+    const Brush& brush;
+    glm::vec3 clipMin;
+    glm::vec3 clipMax;
+    std::vector<NodeRange>& dirty;
+    GPUNode brushLeaf;
+};
+
+} // namespace
+
+void OctreeEditor::beginStroke(const Brush& brush, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    float rootSize = boundsMax.x - boundsMin.x;
+    if (rootSize <= 0.0f) return;
+    glm::vec3 brushMin = brush.center - glm::vec3(brush.radius);
+    glm::vec3 brushMax = brush.center + glm::vec3(brush.radius);
+    if (brush.shape == BrushShape::Mask) {
+        if (!brush.mask || glm::any(glm::lessThanEqual(brush.mask->size, glm::ivec3(0)))) return;
+        brushMin = glm::vec3(brush.mask->min);
+        brushMax = glm::vec3(brush.mask->min + brush.mask->size) - glm::vec3(0.5f);
+    } else if (brush.radius <= 0.0f) {
+        return;
+    }
+
+    // Brick cells of the octree grid overlapping the brush bounds
+    float brickSize = std::min(static_cast<float>(BRICK_SIZE), rootSize);
+    int bricksPerAxis = static_cast<int>(rootSize / brickSize);
+    glm::ivec3 lo = glm::ivec3(glm::floor((brushMin - boundsMin) / brickSize));
+    glm::ivec3 hi = glm::ivec3(glm::floor((brushMax - boundsMin) / brickSize));
+    lo = glm::max(lo, glm::ivec3(0));
+    hi = glm::min(hi, glm::ivec3(bricksPerAxis - 1));
+
+    for (int z = lo.z; z <= hi.z; ++z)
+        for (int y = lo.y; y <= hi.y; ++y)
+            for (int x = lo.x; x <= hi.x; ++x)
+                pending.push_back(BrickWork{brush, boundsMin, rootSize,
+                                            boundsMin + glm::vec3(x, y, z) * brickSize, brickSize});
+}
+
+bool OctreeEditor::step(GPUNodeList& nodes, double budgetMs) {
+    PROFILE_FUNCTION();
+    ensureBaseVersion(nodes);
+    auto start = std::chrono::steady_clock::now();
+    while (!pending.empty()) {
+        if (nodes.size() + BRICK_NODE_BUDGET > MAX_NODES) {
+            // The caller compacts first; if that was not enough the stroke cannot continue
+            if (needsCompaction(nodes)) return true;
+            cancel();
+            break;
+        }
+
+        BrickWork work = pending.front();
+        pending.pop_front();
+        applyBrick(nodes, work);
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMs) break;
+    }
+    if (pending.empty() && commitRequested) commitVersion(nodes);
+    return !pending.empty();
+}
+
+void OctreeEditor::applyBrick(GPUNodeList& nodes, const BrickWork& work) {
+    if (nodes.empty()) {
+        nodes.push_back(GPUNode{0, 0}); // The root must stay at index 0
+        emptyRoot = true;
+    }
+    Source root = emptyRoot ? Source{Source::Empty, GPUNode{0, 0}} : sourceOf(nodes[0]);
+
+    BrickEditor editor(nodes, frozenEnd, work.brush, work.brickMin, work.brickSize, dirty);
+    Result result = editor.apply(root, work.rootMin, work.rootSize, 0);
+    garbage += editor.garbage;
+    voxelDelta += editor.voxelDelta;
+    voxelTotal += editor.voxelDelta;
+    editCreated += editor.created;
+    editGarbage += editor.garbage;
+    editReplaced += editor.replaced;
+    if (!result.changed && editor.writes == 0) return;
+
+    editOpen = true;
+    if (result.changed) {
+        // Removing everything leaves slot 0 stale; the node count signals the empty tree
+        emptyRoot = !result.present;
+        nodes[0] = result.present ? result.node : GPUNode{0, 0};
+        markDirty(0, 1);
+    }
+}
+
+void OctreeEditor::cancel() {
+    pending.clear();
+}
+
+void OctreeEditor::endEdit(GPUNodeList& nodes) {
+    if (pending.empty()) commitVersion(nodes);
+    else commitRequested = true;
+}
+
+void OctreeEditor::ensureBaseVersion(const GPUNodeList& nodes) {
+    if (!versions.empty()) return;
+    bool empty = nodes.empty() || emptyRoot;
+    versions.push_back(Version{0, empty ? GPUNode{0, 0} : nodes[0], empty, 0, 0, 0});
+    current = 0;
+    frozenEnd = static_cast<uint32_t>(nodes.size());
+}
+
+void OctreeEditor::commitVersion(GPUNodeList& nodes) {
+    commitRequested = false;
+    if (!editOpen) return;
+
+    // A new edit drops the redo branch and everything only it referenced
+    for (size_t i = current + 1; i < versions.size(); ++i) garbage += versions[i].liveCreated;
+    versions.resize(current + 1);
+
+    versions.push_back(Version{nextId++, nodes[0], emptyRoot, voxelTotal, editCreated - editGarbage, editReplaced});
+    ++current;
+
+    // Nodes only the oldest version referenced are the ones its successor replaced
+    if (versions.size() > static_cast<size_t>(MAX_HISTORY) + 1) {
+        garbage += versions[1].replaced;
+        versions.erase(versions.begin());
+        --current;
+    }
+
+    frozenEnd = static_cast<uint32_t>(nodes.size());
+    editOpen = false;
+    editCreated = editGarbage = editReplaced = 0;
+}
+
+void OctreeEditor::showVersion(GPUNodeList& nodes, size_t index) {
+    const Version& version = versions[index];
+    current = index;
+    emptyRoot = version.empty;
+    nodes[0] = version.root;
+    markDirty(0, 1);
+    voxelDelta += version.voxelTotal - voxelTotal;
+    voxelTotal = version.voxelTotal;
+}
+
+bool OctreeEditor::undo(GPUNodeList& nodes) {
+    if (busy() || nodes.empty()) return false;
+    ensureBaseVersion(nodes);
+    commitVersion(nodes);
+    if (current == 0) return false;
+    showVersion(nodes, current - 1);
+    return true;
+}
+
+bool OctreeEditor::redo(GPUNodeList& nodes) {
+    if (busy() || nodes.empty()) return false;
+    ensureBaseVersion(nodes);
+    commitVersion(nodes);
+    if (current + 1 >= versions.size()) return false;
+    showVersion(nodes, current + 1);
+    return true;
+}
+
+bool OctreeEditor::commitTree(GPUNodeList& nodes, const GPUNodeList& tree, int64_t voxelChange,
+                              const glm::vec3& boundsMin, float rootSize, const glm::vec3& newMin, float newSize) {
+    PROFILE_FUNCTION();
+    if (busy()) return false;
+    if (nodes.empty()) {
+        nodes.push_back(GPUNode{0, 0}); // The root must stay at index 0
+        emptyRoot = true;
+    }
+    ensureBaseVersion(nodes);
+    commitVersion(nodes);
+
+    // Octants leading from the new root down to the current cube
+    std::vector<uint32_t> path;
+    glm::vec3 cellMin = newMin;
+    for (float size = newSize; size > rootSize; size *= 0.5f) {
+        float half = size * 0.5f;
+        glm::bvec3 upper = glm::greaterThanEqual(boundsMin, cellMin + glm::vec3(half));
+        path.push_back((upper.x ? 1u : 0u) | (upper.y ? 2u : 0u) | (upper.z ? 4u : 0u));
+        cellMin += glm::vec3(upper) * half;
+    }
+    size_t treeNodes = tree.empty() ? 0 : tree.size() - 1;
+    if (nodes.size() + treeNodes + path.size() * (current + 1) > MAX_NODES) return false;
+
+    // Hang every retained version below a chain of single-child nodes; the redo
+    // branch is dropped by the commit anyway
+    uint32_t first = static_cast<uint32_t>(nodes.size());
+    if (!path.empty()) {
+        for (size_t i = 0; i <= current; ++i) {
+            Version& version = versions[i];
+            if (version.empty) continue;
+            GPUNode node = version.root;
+            for (size_t level = path.size(); level-- > 0;) {
+                uint32_t slot = static_cast<uint32_t>(nodes.size());
+                nodes.push_back(node);
+                node = GPUNode{(slot << 8) | (1u << path[level]), version.root.color};
+            }
+            version.root = node;
+            // Only this version references its chain
+            version.liveCreated += path.size();
+            if (i + 1 < versions.size()) versions[i + 1].replaced += path.size();
+        }
+    }
+    const Version& shown = versions[current];
+    size_t replacedNodes = shown.empty ? 0 : countBelow(nodes, shown.root);
+
+    // tree[i] lands in slot offset + i, its root in slot 0
+    uint32_t offset = static_cast<uint32_t>(nodes.size()) - 1;
+    auto relink = [offset](const GPUNode& node) {
+        if (nodeIsLeaf(node)) return node;
+        return GPUNode{((nodeFirstChild(node) + offset) << 8) | nodeExistMask(node), node.color};
+    };
+    for (size_t i = 1; i < tree.size(); ++i) nodes.push_back(relink(tree[i]));
+    if (nodes.size() > first) markDirty(first, static_cast<uint32_t>(nodes.size()));
+
+    emptyRoot = tree.empty();
+    nodes[0] = emptyRoot ? GPUNode{0, 0} : relink(tree[0]);
+    markDirty(0, 1);
+    voxelDelta += voxelChange;
+    voxelTotal += voxelChange;
+
+    editOpen = true;
+    editCreated = treeNodes;
+    editGarbage = 0;
+    editReplaced = replacedNodes;
+    commitVersion(nodes);
+    return true;
+}
+
+bool OctreeEditor::canUndo() const {
+    return editOpen || current > 0;
+}
+
+bool OctreeEditor::canRedo() const {
+    return !editOpen && current + 1 < versions.size();
+}
+
+OctreeEditor::VersionState OctreeEditor::versionState(uint64_t id) const {
+    if (id >= nextId) return VersionState::Pending;
+    // Versions that fell off the front of the history were ancestors of the displayed one
+    if (versions.empty() || id < versions.front().id) return VersionState::Shown;
+    for (size_t i = 0; i < versions.size(); ++i) {
+        if (versions[i].id == id) return i <= current ? VersionState::Shown : VersionState::Undone;
+    }
+    return VersionState::Dropped;
+}
+
+bool OctreeEditor::needsCompaction(const GPUNodeList& nodes) const {
+    if (garbage == 0) return false;
+    if (nodes.size() + BRICK_NODE_BUDGET > MAX_NODES) return true;
+    // Between edits only: compaction freezes every node, including the open edit's
+    return !editOpen && garbage >= MIN_COMPACT_GARBAGE && garbage * 2 > nodes.size();
+}
+
+void OctreeEditor::markDirty(uint32_t begin, uint32_t end) {
+    appendRange(dirty, begin, end);
+}
+
+std::vector<NodeRange> OctreeEditor::takeDirtyRanges() {
+    std::vector<NodeRange> ranges;
+    ranges.swap(dirty);
+    if (ranges.empty()) return ranges;
+
+    std::sort(ranges.begin(), ranges.end(), [](const NodeRange& a, const NodeRange& b) { return a.begin < b.begin; });
+    size_t out = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        if (ranges[i].begin <= ranges[out].end + DIRTY_MERGE_GAP) {
+            ranges[out].end = std::max(ranges[out].end, ranges[i].end);
+        } else {
+            ranges[++out] = ranges[i];
+        }
+    }
+    ranges.resize(out + 1);
+    return ranges;
+}
+
+int64_t OctreeEditor::takeVoxelDelta() {
+    int64_t delta = voxelDelta;
+    voxelDelta = 0;
+    return delta;
+}
+
+void OctreeEditor::compact(GPUNodeList& nodes) {
+    PROFILE_FUNCTION();
+    if (nodes.empty()) return;
+
+    // Blocks are keyed by their old first index so shared subtrees are copied once
+    GPUNodeList out;
+    out.reserve(nodes.size() - std::min(garbage, nodes.size() - 1));
+    std::vector<uint32_t> remap(nodes.size(), UINT32_MAX);
+    auto relink = [&](const GPUNode& node) {
+        if (nodeIsLeaf(node)) return node;
+        uint32_t first = nodeFirstChild(node);
+        if (remap[first] == UINT32_MAX) {
+            remap[first] = static_cast<uint32_t>(out.size());
+            for (int k = 0, n = popcount(nodeExistMask(node)); k < n; ++k) out.push_back(nodes[first + k]);
+        }
+        return GPUNode{(remap[first] << 8) | nodeExistMask(node), node.color};
+    };
+
+    out.push_back(emptyRoot ? GPUNode{0, 0} : nodes[0]);
+    for (Version& version : versions) {
+        if (!version.empty) version.root = relink(version.root);
+    }
+    // Copied nodes still hold old child pointers until they are visited
+    for (size_t i = 0; i < out.size(); ++i) {
+        GPUNode node = relink(out[i]);
+        out[i] = node;
+    }
+
+    nodes.swap(out);
+    garbage = 0;
+    frozenEnd = static_cast<uint32_t>(nodes.size());
+    dirty.clear();
+}
+
+void OctreeEditor::extractVoxels(const GPUNodeList& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                                 VoxelList& out) {
+    PROFILE_FUNCTION();
+    out.clear();
+    if (nodes.empty()) return;
+
+    struct Item {
+        uint32_t node;
+        glm::vec3 min;
+        float size;
+    };
+    std::vector<Item> stack;
+    stack.push_back(Item{0, boundsMin, boundsMax.x - boundsMin.x});
+    while (!stack.empty()) {
+        Item item = stack.back();
+        stack.pop_back();
+        const GPUNode& node = nodes[item.node];
+        if (nodeIsLeaf(node)) {
+            glm::vec4 color = unpackColor(node.color);
+            glm::ivec3 lo = glm::ivec3(item.min);
+            int size = static_cast<int>(item.size);
+            for (int z = 0; z < size; ++z)
+                for (int y = 0; y < size; ++y)
+                    for (int x = 0; x < size; ++x)
+                        out.emplace_back(lo + glm::ivec3(x, y, z), color);
+            continue;
+        }
+        float half = item.size * 0.5f;
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (mask & (1u << octant))
+                stack.push_back(Item{child++, item.min + glm::vec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1) * half, half});
+        }
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * Octree Editing
+ *
+ * Sculpt and paint brushes applied directly to a flattened octree (GPUNode
+ * layout, see octree.h) without rebuilding it from a voxel list.
+ *
+ * The node array is a persistent (copy-on-write) store. Nodes of committed
+ * versions are never written: an edit copies the root-to-leaf paths it
+ * changes into new child blocks appended at the end of the array, inside the
+ * slack the renderer reserves in the octree SSBO, and untouched subtrees stay
+ * shared between versions. commitTree() appends a whole replacement tree (a
+ * CSG result) as a version the same way. Blocks created by the open edit are private to it
+ * and are overwritten in place (repeated paint over the same voxels only
+ * rewrites leaf colors). Every written slot is recorded so only those byte
+ * ranges are re-uploaded.
+ *
+ * Slot 0 holds the root of the displayed version; each history entry keeps
+ * its own root value, so undo and redo just swap slot 0. Dropped versions
+ * (the redo branch after a new edit, history beyond MAX_HISTORY) leave
+ * garbage that compact() reclaims, keeping every retained version. History
+ * memory is proportional to the nodes edits copied, not to the scene.
+ *
+ * Strokes are cut into BRICK_SIZE^3 cells of the octree grid and step()
+ * applies as many bricks as fit in a time budget, so large brushes are spread
+ * over several frames. Edits are clipped to the current octree bounds.
+ */
+
+#ifndef OCTREE_EDITOR_H
+#define OCTREE_EDITOR_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "octree.h"
+#include "voxel.h"
+
+enum class BrushShape { Sphere, Box, Mask };
+enum class BrushMode { Add, Remove, Paint };
+
+/**
+ * Explicit voxel set for BrushShape::Mask: one byte per voxel of the box
+ * [min, min + size), x fastest
+ */
+struct VoxelMask {
+    glm::ivec3 min = glm::ivec3(0);
+    glm::ivec3 size = glm::ivec3(0);
+    std::vector<uint8_t> bits;
+
+    bool test(const glm::ivec3& p) const {
+        glm::ivec3 local = p - min;
+        if (glm::any(glm::lessThan(local, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(local, size))) return false;
+        return bits[(static_cast<size_t>(local.z) * size.y + local.y) * size.x + local.x] != 0;
+    }
+};
+
+struct Brush {
+    BrushShape shape = BrushShape::Sphere;
+    BrushMode mode = BrushMode::Add;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 4.0f;                // Sphere radius / box half extent, in voxels
+    glm::vec4 color = glm::vec4(1.0f);
+    std::shared_ptr<const VoxelMask> mask;  // BrushShape::Mask only; center and radius are unused
+};
+
+/**
+ * Half-open range of node indices [begin, end)
+ */
+struct NodeRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+class OctreeEditor {
+public:
+    static constexpr int BRICK_SIZE = 32;
+    // Child indices are 24 bits wide
+    static constexpr size_t MAX_NODES = size_t(1) << 24;
+    static constexpr int MAX_HISTORY = 64;
+
+    // Where a committed version sits relative to the displayed one
+    enum class VersionState {
+        Pending,    // Not committed yet
+        Shown,      // The displayed version or one of its ancestors
+        Undone,     // On the redo branch
+        Dropped     // Discarded redo branch
+    };
+
+    /**
+     * Queue a brush stroke against an octree covering [boundsMin, boundsMax)
+     * (a voxel is affected when its center lies inside the brush)
+     */
+    void beginStroke(const Brush& brush, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    /**
+     * Apply queued bricks until budgetMs is spent (at least one brick)
+     * @return true while queued work remains
+     */
+    bool step(GPUNodeList& nodes, double budgetMs);
+
+    void cancel();
+    bool busy() const { return !pending.empty(); }
+
+    /**
+     * Close the open edit as one undo step once its queued strokes are applied
+     */
+    void endEdit(GPUNodeList& nodes);
+
+    /**
+     * Show the previous / next version by swapping the root in slot 0
+     * @return false while strokes are queued or if there is no such version
+     */
+    bool undo(GPUNodeList& nodes);
+    bool redo(GPUNodeList& nodes);
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /**
+     * Commit tree, a complete octree over the cube at newMin of side newSize
+     * (e.g. an OctreeCSG result, no nodes when nothing remains), as one undo
+     * step replacing the displayed version. The current cube at boundsMin of
+     * side rootSize must be a cell of the new one; when it is smaller, every
+     * retained version is re-rooted into the new cube.
+     * @param voxelChange solid voxel count of tree minus that of the displayed version
+     * @return false while strokes are queued or if the nodes would exceed MAX_NODES
+     */
+    bool commitTree(GPUNodeList& nodes, const GPUNodeList& tree, int64_t voxelChange, const glm::vec3& boundsMin,
+                    float rootSize, const glm::vec3& newMin, float newSize);
+
+    /**
+     * Versions are numbered in commit order; the unedited tree is 0. The open
+     * edit becomes nextVersionId() once it is committed.
+     */
+    uint64_t nextVersionId() const { return nextId; }
+    VersionState versionState(uint64_t id) const;
+
+    /**
+     * True when every voxel of the displayed version was removed; slot 0 is
+     * then stale and the tree must be treated as having no nodes
+     */
+    bool rootEmpty() const { return emptyRoot; }
+
+    /**
+     * True when the array should be compacted before the next step: mostly
+     * garbage, or too close to the 24-bit index limit to take another brick
+     */
+    bool needsCompaction(const GPUNodeList& nodes) const;
+    size_t garbageNodes() const { return garbage; }
+
+    /**
+     * Written node ranges since the last call, sorted and merged
+     */
+    std::vector<NodeRange> takeDirtyRanges();
+    bool hasDirty() const { return !dirty.empty(); }
+
+    /**
+     * Change in solid voxel count since the last call
+     */
+    int64_t takeVoxelDelta();
+
+    /**
+     * Re-emit the nodes reachable from slot 0 and every retained version,
+     * preserving their sharing, and drop the garbage
+     */
+    void compact(GPUNodeList& nodes);
+
+    /**
+     * Expand the octree back into one voxel per solid unit cell
+     */
+    static void extractVoxels(const GPUNodeList& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                              VoxelList& out);
+
+private:
+    struct BrickWork {
+        Brush brush;
+        glm::vec3 rootMin;
+        float rootSize;
+        glm::vec3 brickMin;
+        float brickSize;
+    };
+
+    struct Version {
+        uint64_t id;
+        GPUNode root;
+        bool empty;
+        int64_t voxelTotal;     // Voxel count change relative to the unedited tree
+        size_t liveCreated;     // Nodes this version added that it still references
+        size_t replaced;        // Nodes of the previous version it no longer references
+    };
+
+    void applyBrick(GPUNodeList& nodes, const BrickWork& work);
+    void commitVersion(GPUNodeList& nodes);
+    void showVersion(GPUNodeList& nodes, size_t index);
+    void ensureBaseVersion(const GPUNodeList& nodes);
+    void markDirty(uint32_t begin, uint32_t end);
+
+    std::deque<BrickWork> pending;
+    std::vector<NodeRange> dirty;
+    size_t garbage = 0;
+    int64_t voxelDelta = 0;
+
+    std::vector<Version> versions;
+    size_t current = 0;
+    uint64_t nextId = 1;
+    bool editOpen = false;      // Bricks applied since the last committed version
+    bool commitRequested = false;
+    bool emptyRoot = false;
+    uint32_t frozenEnd = 0;     // Nodes below this belong to committed versions
+    int64_t voxelTotal = 0;
+    size_t editCreated = 0;
+    size_t editGarbage = 0;
+    size_t editReplaced = 0;
+};
+
+#endif // OCTREE_EDITOR_H
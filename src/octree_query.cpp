@@ -0,0 +1,275 @@
+/**
+ * CPU Octree Queries Implementation
+ */
+
+#include "octree_query.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Worst case stack: 7 deferred siblings per level plus the last level's 8
+constexpr int QUERY_STACK_SIZE = 8 * (OCTREE_MAX_DEPTH + 1);
+
+// Gap kept between a slid box and the surface it touched
+constexpr float SLIDE_SKIN = 1e-3f;
+
+inline glm::vec3 octantOffset(int octant) {
+    return glm::vec3(static_cast<float>(octant & 1), static_cast<float>((octant >> 1) & 1),
+                     static_cast<float>((octant >> 2) & 1));
+}
+
+inline float distanceToBox(const glm::vec3& p, const glm::vec3& bmin, const glm::vec3& bmax, glm::vec3& closest) {
+    closest = glm::clamp(p, bmin, bmax);
+    return glm::length(p - closest);
+}
+
+} // namespace
+
+OctreeQuery::OctreeQuery(const GPUNode* nodes, size_t nodeCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    : nodes(nodes)
+    , nodeCount(nodeCount)
+    , rootMin(boundsMin)
+    , rootSize(boundsMax.x - boundsMin.x)
+{
+}
+
+template <bool AnyHit>
+bool OctreeQuery::trace(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                        const glm::vec3& expand, RayHit* out) const {
+    if (nodeCount == 0) return false;
+
+    // Zero components become tiny ones so the slab test never computes 0 * inf
+    glm::vec3 dir = direction;
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(dir[i]) < 1e-20f) dir[i] = std::copysign(1e-20f, dir[i]);
+    }
+    const glm::vec3 inv = 1.0f / dir;
+
+    struct Item {
+        uint32_t node;
+        int axis;       // Slab axis of the entry point
+        glm::vec3 min;
+        float size;
+        float tEnter;
+    };
+
+    float best = maxDistance;
+    auto slab = [&](const glm::vec3& bmin, float size, float& tEnter, int& axis) {
+        glm::vec3 lo = (bmin - expand - origin) * inv;
+        glm::vec3 hi = (bmin + glm::vec3(size) + expand - origin) * inv;
+        glm::vec3 tn = glm::min(lo, hi), tf = glm::max(lo, hi);
+        axis = tn.x >= tn.y ? (tn.x >= tn.z ? 0 : 2) : (tn.y >= tn.z ? 1 : 2);
+        tEnter = tn[axis];
+        float tExit = std::min(tf.x, std::min(tf.y, tf.z));
+        return tEnter <= tExit && tExit >= 0.0f && tEnter <= best;
+    };
+
+    Item stack[QUERY_STACK_SIZE];
+    int top = 0;
+    {
+        Item root{0, 0, rootMin, rootSize, 0.0f};
+        if (!slab(root.min, root.size, root.tEnter, root.axis)) return false;
+        stack[top++] = root;
+    }
+
+    bool found = false;
+    while (top > 0) {
+        Item item = stack[--top];
+        if (item.tEnter > best) continue;
+
+        const GPUNode& node = nodes[item.node];
+        if (nodeIsLeaf(node)) {
+            float t = std::max(item.tEnter, 0.0f);
+            if (t > best || (found && t == best)) continue;
+            found = true;
+            best = t;
+            if (AnyHit) return true;
+            out->distance = t;
+            out->normal = glm::vec3(0.0f);
+            if (item.tEnter >= 0.0f) out->normal[item.axis] = dir[item.axis] > 0.0f ? -1.0f : 1.0f;
+            out->leaf = QueryLeaf{item.min, item.size, node.color, item.node};
+            continue;
+        }
+
+        // Children front to back: sort by entry distance, push farthest first
+        Item children[8];
+        int count = 0;
+        float half = item.size * 0.5f;
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (!(mask & (1u << octant))) continue;
+            Item c{child++, 0, item.min + octantOffset(octant) * half, half, 0.0f};
+            if (slab(c.min, c.size, c.tEnter, c.axis)) {
+                int k = count++;
+                while (k > 0 && children[k - 1].tEnter < c.tEnter) { children[k] = children[k - 1]; --k; }
+                children[k] = c;
+            }
+        }
+        for (int k = 0; k < count; ++k) stack[top++] = children[k];
+    }
+
+    if (out) out->hit = found;
+    return found;
+}
+
+RayHit OctreeQuery::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const {
+    RayHit hit;
+    trace<false>(origin, direction, maxDistance, glm::vec3(0.0f), &hit);
+    return hit;
+}
+
+bool OctreeQuery::anyHit(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const {
+    return trace<true>(origin, direction, maxDistance, glm::vec3(0.0f), nullptr);
+}
+
+template <typename LeafFn>
+bool OctreeQuery::visitBox(const glm::vec3& boxMin, const glm::vec3& boxMax, LeafFn&& fn) const {
+    if (nodeCount == 0) return false;
+
+    struct Item {
+        uint32_t node;
+        glm::vec3 min;
+        float size;
+    };
+    Item stack[QUERY_STACK_SIZE];
+    int top = 0;
+    stack[top++] = Item{0, rootMin, rootSize};
+
+    while (top > 0) {
+        Item item = stack[--top];
+        glm::vec3 itemMax = item.min + glm::vec3(item.size);
+        if (!glm::all(glm::lessThan(item.min, boxMax)) || !glm::all(glm::greaterThan(itemMax, boxMin))) continue;
+
+        const GPUNode& node = nodes[item.node];
+        if (nodeIsLeaf(node)) {
+            if (fn(QueryLeaf{item.min, item.size, node.color, item.node})) return true;
+            continue;
+        }
+
+        float half = item.size * 0.5f;
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (mask & (1u << octant)) stack[top++] = Item{child++, item.min + octantOffset(octant) * half, half};
+        }
+    }
+    return false;
+}
+
+bool OctreeQuery::overlaps(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    return visitBox(boxMin, boxMax, [](const QueryLeaf&) { return true; });
+}
+
+size_t OctreeQuery::collectLeaves(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<QueryLeaf>& out) const {
+    size_t before = out.size();
+    visitBox(boxMin, boxMax, [&](const QueryLeaf& leaf) {
+        out.push_back(leaf);
+        return false;
+    });
+    return out.size() - before;
+}
+
+SweepHit OctreeQuery::sweepAABB(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& delta) const {
+    // Minkowski sum: sweep the box center against leaves grown by the half extents
+    SweepHit result;
+    RayHit hit;
+    glm::vec3 half = (boxMax - boxMin) * 0.5f;
+    if (trace<false>((boxMin + boxMax) * 0.5f, delta, 1.0f, half, &hit)) {
+        result.hit = true;
+        result.fraction = hit.distance;
+        result.normal = hit.normal;
+        result.startsInside = hit.normal == glm::vec3(0.0f);
+    }
+    return result;
+}
+
+glm::vec3 OctreeQuery::slideAABB(const glm::vec3& center, const glm::vec3& halfExtents, const glm::vec3& delta,
+                                 int maxIterations) const {
+    glm::vec3 pos = center;
+    glm::vec3 remaining = delta;
+    for (int i = 0; i < maxIterations; ++i) {
+        float len = glm::length(remaining);
+        if (len < 1e-6f) break;
+
+        SweepHit hit = sweepAABB(pos - halfExtents, pos + halfExtents, remaining);
+        if (!hit.hit || hit.startsInside) {
+            // Free movement, or already stuck inside geometry: do not trap the box
+            return pos + remaining;
+        }
+
+        float travel = std::max(0.0f, hit.fraction - SLIDE_SKIN / len);
+        pos += remaining * travel;
+        remaining *= 1.0f - travel;
+        remaining -= hit.normal * glm::dot(remaining, hit.normal);
+    }
+    return pos;
+}
+
+NearestHit OctreeQuery::nearestSolid(const glm::vec3& point, float maxDistance) const {
+    NearestHit result;
+    if (nodeCount == 0) return result;
+
+    struct Item {
+        uint32_t node;
+        glm::vec3 min;
+        float size;
+        float distance;
+    };
+    Item stack[QUERY_STACK_SIZE];
+    int top = 0;
+    float best = maxDistance;
+
+    glm::vec3 closest;
+    float rootDist = distanceToBox(point, rootMin, rootMin + glm::vec3(rootSize), closest);
+    if (rootDist > best) return result;
+    stack[top++] = Item{0, rootMin, rootSize, rootDist};
+
+    while (top > 0) {
+        Item item = stack[--top];
+        if (item.distance > best || (result.found && item.distance == best)) continue;
+
+        const GPUNode& node = nodes[item.node];
+        if (nodeIsLeaf(node)) {
+            best = item.distance;
+            result.found = true;
+            result.distance = item.distance;
+            distanceToBox(point, item.min, item.min + glm::vec3(item.size), result.closestPoint);
+            result.leaf = QueryLeaf{item.min, item.size, node.color, item.node};
+            if (best == 0.0f) break;
+            continue;
+        }
+
+        // Nearest child popped first
+        Item children[8];
+        int count = 0;
+        float half = item.size * 0.5f;
+        uint32_t mask = nodeExistMask(node);
+        uint32_t child = nodeFirstChild(node);
+        for (int octant = 0; octant < 8; ++octant) {
+            if (!(mask & (1u << octant))) continue;
+            Item c{child++, item.min + octantOffset(octant) * half, half, 0.0f};
+            c.distance = distanceToBox(point, c.min, c.min + glm::vec3(half), closest);
+            if (c.distance > best) continue;
+            int k = count++;
+            while (k > 0 && children[k - 1].distance < c.distance) { children[k] = children[k - 1]; --k; }
+            children[k] = c;
+        }
+        for (int k = 0; k < count; ++k) stack[top++] = children[k];
+    }
+    return result;
+}
+
+void OctreeQuery::raycastBatch(const QueryRay* rays, size_t count, RayHit* hits) const {
+    JobSystem::instance().parallelFor(0, count, 256, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) hits[i] = raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance);
+    });
+}
+
+void OctreeQuery::anyHitBatch(const QueryRay* rays, size_t count, uint8_t* results) const {
+    JobSystem::instance().parallelFor(0, count, 256, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) results[i] = anyHit(rays[i].origin, rays[i].direction, rays[i].maxDistance) ? 1 : 0;
+    });
+}
@@ -0,0 +1,130 @@
+/**
+ * CPU Octree Queries
+ *
+ * Read-only spatial queries over a flattened octree (GPUNode layout, see
+ * octree.h): closest-hit and any-hit ray casts, AABB overlap, swept AABBs
+ * (with a collide-and-slide helper for camera collision) and nearest solid.
+ *
+ * OctreeQuery is a non-owning view: the node array must outlive it and not
+ * change while queries run. All methods are const and keep their traversal
+ * stacks on the call stack, so any number of threads may query one view.
+ * Coordinates are the renderer's world space (voxel units).
+ */
+
+#ifndef OCTREE_QUERY_H
+#define OCTREE_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+#include "octree.h"
+
+struct QueryRay {
+    glm::vec3 origin;
+    glm::vec3 direction;    // Need not be normalized; distances are in units of |direction|
+    float maxDistance = std::numeric_limits<float>::infinity();
+};
+
+/**
+ * Solid leaf cell (larger than one voxel when equal leaves were merged)
+ */
+struct QueryLeaf {
+    glm::vec3 min = glm::vec3(0.0f);
+    float size = 0.0f;
+    uint32_t color = 0;     // Packed RGBA8
+    uint32_t node = 0;      // Index in the node array
+};
+
+struct RayHit {
+    bool hit = false;
+    float distance = 0.0f;          // Ray parameter of the entry point (0 if the origin is inside)
+    glm::vec3 normal = glm::vec3(0.0f); // Entry face normal, zero if the origin is inside
+    QueryLeaf leaf;
+};
+
+struct SweepHit {
+    bool hit = false;
+    bool startsInside = false;      // The box already overlaps solid voxels
+    float fraction = 1.0f;          // Fraction of delta travelled before contact
+    glm::vec3 normal = glm::vec3(0.0f);
+};
+
+struct NearestHit {
+    bool found = false;
+    float distance = 0.0f;          // 0 if the point is inside a solid leaf
+    glm::vec3 closestPoint = glm::vec3(0.0f);
+    QueryLeaf leaf;
+};
+
+class OctreeQuery {
+public:
+    OctreeQuery() = default;
+    OctreeQuery(const GPUNode* nodes, size_t nodeCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    bool empty() const { return nodeCount == 0; }
+
+    /**
+     * Closest solid leaf along the ray
+     */
+    RayHit raycast(const glm::vec3& origin, const glm::vec3& direction,
+                   float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+    /**
+     * True if any solid leaf lies on the ray within maxDistance (shadow-style query)
+     */
+    bool anyHit(const glm::vec3& origin, const glm::vec3& direction,
+                float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+    /**
+     * True if the box [boxMin, boxMax) overlaps a solid leaf
+     */
+    bool overlaps(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    /**
+     * Append every solid leaf overlapping [boxMin, boxMax) to out
+     * @return Number of leaves appended
+     */
+    size_t collectLeaves(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<QueryLeaf>& out) const;
+
+    /**
+     * Move the box [boxMin, boxMax) by delta and report the first contact
+     */
+    SweepHit sweepAABB(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& delta) const;
+
+    /**
+     * Collide-and-slide: move a box centered at center by delta, sliding along
+     * contact planes. A box that already overlaps geometry moves freely.
+     * @return New center
+     */
+    glm::vec3 slideAABB(const glm::vec3& center, const glm::vec3& halfExtents, const glm::vec3& delta,
+                        int maxIterations = 3) const;
+
+    /**
+     * Closest solid leaf to point within maxDistance
+     */
+    NearestHit nearestSolid(const glm::vec3& point,
+                            float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+    /**
+     * Closest-hit / any-hit for many rays, spread over the job system
+     */
+    void raycastBatch(const QueryRay* rays, size_t count, RayHit* hits) const;
+    void anyHitBatch(const QueryRay* rays, size_t count, uint8_t* results) const;
+
+private:
+    template <bool AnyHit>
+    bool trace(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+               const glm::vec3& expand, RayHit* out) const;
+
+    template <typename LeafFn>
+    bool visitBox(const glm::vec3& boxMin, const glm::vec3& boxMax, LeafFn&& fn) const;
+
+    const GPUNode* nodes = nullptr;
+    size_t nodeCount = 0;
+    glm::vec3 rootMin = glm::vec3(0.0f);
+    float rootSize = 0.0f;
+};
+
+#endif // OCTREE_QUERY_H
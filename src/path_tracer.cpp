@@ -0,0 +1,400 @@
+/**
+ * Path Tracer Implementation
+ *
+ * The CPU reference mirrors path_trace.comp function by function; keep the
+ * two in step.
+ */
+
+#include "path_tracer.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "octree.h"
+#include "profiler.h"
+#include "sampling.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+constexpr GLuint GROUP_SIZE = 8;   // local_size_x/y of path_trace.comp
+constexpr size_t TABLE_HEADER_BYTES = sizeof(uint32_t) * 4;
+constexpr float ERROR_SCALE = 1024.0f;    // Fixed point of the summed relative error
+constexpr float PI = 3.14159265358979f;
+constexpr float RAY_OFFSET = 0.01f;       // Along the normal, off the face a bounce leaves from
+
+uint32_t unitToByte(float value) {
+    return static_cast<uint32_t>(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// ── CPU mirror of path_trace.comp ──────────────────────────────────────────
+
+uint32_t pcg(uint32_t& state) {
+    state = state * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random01(uint32_t& state) {
+    return static_cast<float>(pcg(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+float luma(const glm::vec3& c) {
+    return glm::dot(c, glm::vec3(0.299f, 0.587f, 0.114f));
+}
+
+struct SurfaceMaterial {
+    glm::vec3 albedo;
+    float roughness;
+    float metallic;
+    float emission;
+};
+
+glm::vec3 skyRadiance(const glm::vec3& dir) {
+    return glm::mix(glm::vec3(0.15f, 0.2f, 0.35f), glm::vec3(0.4f, 0.5f, 0.6f), glm::clamp(dir.y * 0.5f + 0.5f, 0.0f, 1.0f));
+}
+
+float ggxD(float nh, float a2) {
+    float d = nh * nh * (a2 - 1.0f) + 1.0f;
+    return a2 / (PI * d * d);
+}
+
+float smithG1(float nx, float a2) {
+    return 2.0f * nx / (nx + std::sqrt(a2 + (1.0f - a2) * nx * nx));
+}
+
+float alpha2(const SurfaceMaterial& m) {
+    float a = std::max(m.roughness * m.roughness, 1e-3f);
+    return a * a;
+}
+
+glm::vec3 specularF0(const SurfaceMaterial& m) {
+    return glm::mix(glm::vec3(0.04f), m.albedo, m.metallic);
+}
+
+// BRDF times the cosine at wi
+glm::vec3 evalBrdfCos(const SurfaceMaterial& m, const glm::vec3& n, const glm::vec3& wo, const glm::vec3& wi) {
+    float nl = glm::dot(n, wi), nv = glm::dot(n, wo);
+    if (nl <= 0.0f || nv <= 0.0f) return glm::vec3(0.0f);
+    glm::vec3 h = glm::normalize(wo + wi);
+    float nh = std::max(glm::dot(n, h), 0.0f), vh = std::max(glm::dot(wo, h), 0.0f);
+    float a2 = alpha2(m);
+    glm::vec3 f = specularF0(m) + (glm::vec3(1.0f) - specularF0(m)) * std::pow(1.0f - vh, 5.0f);
+    glm::vec3 specular = f * (ggxD(nh, a2) * smithG1(nl, a2) * smithG1(nv, a2) / (4.0f * nl * nv));
+    glm::vec3 diffuse = (glm::vec3(1.0f) - f) * (1.0f - m.metallic) * m.albedo / PI;
+    return (diffuse + specular) * nl;
+}
+
+float specularProbability(const SurfaceMaterial& m) {
+    float s = luma(specularF0(m)), d = luma(m.albedo) * (1.0f - m.metallic);
+    return glm::clamp(s / (s + d + 1e-4f), 0.1f, 0.9f);
+}
+
+float samplePdf(const SurfaceMaterial& m, const glm::vec3& n, const glm::vec3& wo, const glm::vec3& wi, float pSpec) {
+    float nl = glm::dot(n, wi);
+    if (nl <= 0.0f) return 0.0f;
+    glm::vec3 h = glm::normalize(wo + wi);
+    float nh = std::max(glm::dot(n, h), 0.0f), vh = std::max(glm::dot(wo, h), 1e-4f);
+    float specular = ggxD(nh, alpha2(m)) * nh / (4.0f * vh);
+    return glm::mix(nl / PI, specular, pSpec);
+}
+
+glm::vec3 sampleDirection(const SurfaceMaterial& m, const glm::vec3& n, const glm::vec3& wo, float pSpec,
+                          uint32_t& rng) {
+    glm::vec3 t, b;
+    Sampling::basis(n, t, b);
+    float u0 = random01(rng), u1 = random01(rng), u2 = random01(rng);
+    float phi = 2.0f * PI * u1;
+    if (u0 < pSpec) {
+        float a2 = alpha2(m);
+        float cosTheta = std::sqrt((1.0f - u2) / (1.0f + (a2 - 1.0f) * u2));
+        float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+        glm::vec3 h = t * (sinTheta * std::cos(phi)) + b * (sinTheta * std::sin(phi)) + n * cosTheta;
+        return glm::reflect(-wo, h);
+    }
+    float r = std::sqrt(u2);
+    return t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + n * std::sqrt(std::max(1.0f - u2, 0.0f));
+}
+
+} // namespace
+
+glm::vec3 PathTraceCamera::ray(const glm::vec2& uv, float aspect) const
+{
+    glm::vec3 forward = glm::normalize(target - position);
+    glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), forward));
+    glm::vec3 up = glm::cross(forward, right);
+    glm::vec2 ndc = uv * 2.0f - 1.0f;
+    ndc.x *= aspect;
+    float scale = std::tan(glm::radians(fov) * 0.5f);
+    return glm::normalize(forward + ndc.x * right * scale + ndc.y * up * scale);
+}
+
+void MaterialTable::build(const VoxelList& voxels)
+{
+    PROFILE_FUNCTION();
+    const VoxelMaterial defaults;
+    std::unordered_map<uint32_t, uint32_t> materials;
+    for (const Voxel& v : voxels) {
+        if (v.getRoughness() == defaults.roughness && v.getMetallic() == defaults.metallic &&
+            v.getEmission() == defaults.emission) continue;
+        uint32_t packed = unitToByte(v.getRoughness()) | (unitToByte(v.getMetallic()) << 8) |
+                          (unitToByte(v.getEmission()) << 16);
+        materials.emplace(packColor(v.getColor()), packed);
+    }
+    entries.clear();
+    entries.reserve(materials.size());
+    for (const auto& kv : materials) entries.emplace_back(kv.first, kv.second);
+    std::sort(entries.begin(), entries.end(), [](const glm::uvec2& a, const glm::uvec2& b) { return a.x < b.x; });
+}
+
+VoxelMaterial MaterialTable::lookup(uint32_t color) const
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), color,
+                               [](const glm::uvec2& e, uint32_t c) { return e.x < c; });
+    VoxelMaterial material;
+    if (it == entries.end() || it->x != color) return material;
+    material.roughness = static_cast<float>(it->y & 0xFFu) / 255.0f;
+    material.metallic = static_cast<float>((it->y >> 8) & 0xFFu) / 255.0f;
+    material.emission = static_cast<float>((it->y >> 16) & 0xFFu) / 255.0f;
+    return material;
+}
+
+PathTracer::PathTracer()
+    : traceShader(nullptr)
+    , framebuffer(0)
+    , accumulationTexture(0)
+    , displayTexture(0)
+    , materialBuffer(0)
+    , statsBuffer(0)
+    , width(0)
+    , height(0)
+    , lastViewProjection(1.0f)
+    , sampleCount(0)
+    , relativeError(0.0f)
+    , rateSamples(0.0)
+    , samplesPerSecond(0.0)
+{
+}
+
+PathTracer::~PathTracer()
+{
+    cleanup();
+}
+
+void PathTracer::init()
+{
+    traceShader = new Shader("assets/shaders/path_trace.comp");
+
+    glGenBuffers(1, &statsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t) * 4, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(statsBuffer, MemoryTag::GpuOther, sizeof(uint32_t) * 4);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    readback.init(sizeof(uint32_t));
+    setMaterials(MaterialTable());
+    rateStart = std::chrono::steady_clock::now();
+}
+
+void PathTracer::cleanup()
+{
+    release();
+    freeGLBuffer(materialBuffer);
+    freeGLBuffer(statsBuffer);
+    readback.cleanup();
+    delete traceShader; traceShader = nullptr;
+}
+
+void PathTracer::release()
+{
+    if (framebuffer != 0) { glDeleteFramebuffers(1, &framebuffer); framebuffer = 0; }
+    freeGLTexture(accumulationTexture);
+    freeGLTexture(displayTexture);
+    width = height = 0;
+    sampleCount = 0;
+}
+
+void PathTracer::allocate(int newWidth, int newHeight)
+{
+    release();
+    width = newWidth;
+    height = newHeight;
+    accumulationTexture = createTexture2D(GL_RGBA32F, width, height, 16);
+    displayTexture = createTexture2D(GL_RGBA8, width, height, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, displayTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PathTracer::setMaterials(const MaterialTable& materials)
+{
+    // [uint count, 3 pads, uvec2 entries[]]; never empty so the binding stays valid
+    const std::vector<glm::uvec2>& entries = materials.getEntries();
+    const uint32_t header[4] = {static_cast<uint32_t>(entries.size()), 0, 0, 0};
+    const size_t dataSize = TABLE_HEADER_BYTES + std::max<size_t>(entries.size(), 1) * sizeof(glm::uvec2);
+    if (materialBuffer == 0) glGenBuffers(1, &materialBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, materialBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, nullptr, GL_STATIC_DRAW);
+    MemoryStats::trackGLBuffer(materialBuffer, MemoryTag::GpuOther, dataSize);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+    if (!entries.empty()) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, TABLE_HEADER_BYTES, entries.size() * sizeof(glm::uvec2), entries.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    invalidate();
+}
+
+void PathTracer::render(int newWidth, int newHeight, const glm::mat4& viewProjection, const PathTraceSettings& settings,
+                        const std::function<void(const Shader&)>& setUniforms)
+{
+    PROFILE_FUNCTION();
+    if (newWidth != width || newHeight != height) allocate(newWidth, newHeight);
+    if (viewProjection != lastViewProjection) {
+        lastViewProjection = viewProjection;
+        invalidate();
+    }
+
+    const int samples = std::max(1, std::min(settings.samplesPerFrame, settings.maxSamples - sampleCount));
+    if (sampleCount < settings.maxSamples) {
+        const uint32_t zero[4] = {0, 0, 0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_BINDING, materialBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PATH_STATS_BINDING, statsBuffer);
+
+        traceShader->use();
+        setUniforms(*traceShader);
+        traceShader->setUint("u_sampleIndex", static_cast<uint32_t>(sampleCount));
+        traceShader->setInt("u_samplesPerFrame", samples);
+        traceShader->setInt("u_maxBounces", std::max(0, settings.maxBounces));
+        traceShader->setFloat("u_emissionScale", settings.emissionScale);
+        glBindImageTexture(0, accumulationTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+        glBindImageTexture(1, displayTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        glDispatchCompute((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+        glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                        GL_BUFFER_UPDATE_BARRIER_BIT);
+        sampleCount += samples;
+        rateSamples += static_cast<double>(width) * height * samples;
+
+        uint32_t sum = 0;
+        if (readback.readback(statsBuffer, 0, &sum))
+            relativeError = static_cast<float>(sum) / ERROR_SCALE / static_cast<float>(std::max(width * height, 1));
+    }
+
+    // Throughput as dispatched; the GPU runs at the same rate once the queue is full
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - rateStart).count();
+    if (elapsed >= 0.5) {
+        samplesPerSecond = rateSamples / elapsed;
+        rateSamples = 0.0;
+        rateStart = now;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PathTracer::renderReference(const OctreeQuery& scene, const MaterialTable& materials,
+                                 const PathTraceCamera& camera, const DirectionalLight* lights, int lightCount,
+                                 bool useVoxelColor, const PathTraceSettings& settings, int width, int height,
+                                 int samples, std::vector<glm::vec3>& out)
+{
+    PROFILE_FUNCTION();
+    out.assign(static_cast<size_t>(width) * height, glm::vec3(0.0f));
+    if (width <= 0 || height <= 0 || samples <= 0) return;
+    const float aspect = static_cast<float>(width) / static_cast<float>(height);
+
+    auto surfaceAt = [&](const RayHit& hit) {
+        VoxelMaterial material = materials.lookup(hit.leaf.color);
+        SurfaceMaterial m;
+        // Plain white would reflect everything; untextured mode uses a light gray
+        m.albedo = useVoxelColor ? glm::vec3(unpackColor(hit.leaf.color)) : glm::vec3(0.8f);
+        m.roughness = material.roughness;
+        m.metallic = material.metallic;
+        m.emission = material.emission;
+        return m;
+    };
+
+    auto tracePath = [&](glm::vec3 ro, glm::vec3 rd, uint32_t& rng) {
+        glm::vec3 radiance(0.0f), throughput(1.0f);
+        for (int bounce = 0; bounce <= settings.maxBounces; ++bounce) {
+            RayHit hit = scene.raycast(ro, rd);
+            if (!hit.hit) {
+                radiance += throughput * skyRadiance(rd);
+                break;
+            }
+            SurfaceMaterial m = surfaceAt(hit);
+            glm::vec3 n = hit.normal != glm::vec3(0.0f) ? hit.normal : -rd;
+            glm::vec3 pos = ro + rd * hit.distance + n * RAY_OFFSET;
+            glm::vec3 wo = -rd;
+            radiance += throughput * m.albedo * (m.emission * settings.emissionScale);
+
+            // Next-event estimation: every light is a delta direction
+            for (int i = 0; i < lightCount; ++i) {
+                const glm::vec3& d = lights[i].direction;
+                glm::vec3 l = glm::dot(d, d) > 0.0f ? glm::normalize(d) : glm::vec3(0.0f, 1.0f, 0.0f);
+                if (glm::dot(n, l) <= 0.0f || scene.anyHit(pos, l)) continue;
+                radiance += throughput * evalBrdfCos(m, n, wo, l) * lights[i].color;
+            }
+            if (bounce == settings.maxBounces) break;
+
+            float pSpec = specularProbability(m);
+            glm::vec3 wi = sampleDirection(m, n, wo, pSpec, rng);
+            float pdf = samplePdf(m, n, wo, wi, pSpec);
+            if (pdf <= 1e-6f) break;
+            throughput *= evalBrdfCos(m, n, wo, wi) / pdf;
+
+            // Russian roulette once paths had a few bounces to contribute
+            if (bounce >= 2) {
+                float q = glm::clamp(std::max(throughput.x, std::max(throughput.y, throughput.z)), 0.05f, 0.95f);
+                if (random01(rng) > q) break;
+                throughput /= q;
+            }
+            ro = pos;
+            rd = wi;
+        }
+        return radiance;
+    };
+
+    JobSystem::instance().parallelFor(0, static_cast<size_t>(height), 1, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            for (int x = 0; x < width; ++x) {
+                uint32_t pixel = static_cast<uint32_t>(y) * static_cast<uint32_t>(width) + static_cast<uint32_t>(x);
+                glm::vec3 sum(0.0f);
+                for (int s = 0; s < samples; ++s) {
+                    uint32_t sampleSeed = static_cast<uint32_t>(s);
+                    uint32_t rng = pixel ^ pcg(sampleSeed);
+                    pcg(rng);
+                    glm::vec2 jitter(random01(rng), random01(rng));
+                    glm::vec2 uv = (glm::vec2(static_cast<float>(x), static_cast<float>(y)) + jitter) /
+                                   glm::vec2(static_cast<float>(width), static_cast<float>(height));
+                    sum += tracePath(camera.position, camera.ray(uv, aspect), rng);
+                }
+                out[pixel] = sum / static_cast<float>(samples);
+            }
+        }
+    });
+}
+
+bool PathTracer::writePPM(const std::string& path, const std::vector<glm::vec3>& pixels, int width, int height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            const glm::vec3& c = pixels[static_cast<size_t>(y) * width + x];
+            for (int k = 0; k < 3; ++k) row[static_cast<size_t>(x) * 3 + k] = static_cast<uint8_t>(unitToByte(c[k]));
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,167 @@
+/**
+ * Path Tracer
+ *
+ * Progressive path tracing for stills, on the GPU (path_trace.comp, reusing
+ * the ray caster's octree traversal) and as a CPU reference over OctreeQuery
+ * that follows the same sampling. Surfaces are a Lambertian base with a GGX
+ * specular layer from the voxel's roughness and metallic; voxel emission adds
+ * radiance. Every bounce samples the directional lights directly (next-event
+ * estimation with a shadow ray) and picks the next direction from a
+ * cosine / GGX half-vector mixture; rays that escape collect the sky.
+ *
+ * The GPU tracer adds samples each frame to a running mean in a float
+ * buffer that starts over whenever the view or the size changes, or on
+ * invalidate(). Per-pixel second moments give the relative standard error of
+ * the mean, averaged over the frame as the convergence estimate.
+ *
+ * Octree leaves store only a packed color, so materials are looked up by
+ * that color in a MaterialTable built from the voxel list; voxels whose color
+ * has no entry use the default material.
+ */
+
+#ifndef PATH_TRACER_H
+#define PATH_TRACER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "gl_utils.h"
+#include "lighting.h"
+#include "octree_query.h"
+#include "shader.h"
+#include "voxel.h"
+
+// SSBO binding points of path_trace.comp
+constexpr GLuint MATERIAL_TABLE_BINDING = 11;
+constexpr GLuint PATH_STATS_BINDING = 12;
+
+struct VoxelMaterial {
+    float roughness = 0.5f;
+    float metallic = 0.0f;
+    float emission = 0.0f;
+};
+
+/**
+ * Materials by packed leaf color (see packColor), sorted for binary search on
+ * the GPU. Only colors with a non-default material get an entry; when voxels
+ * of one color disagree the first one wins.
+ */
+class MaterialTable {
+public:
+    void build(const VoxelList& voxels);
+    void clear() { entries.clear(); }
+
+    VoxelMaterial lookup(uint32_t color) const;
+
+    /**
+     * (packed color, roughness | metallic << 8 | emission << 16 in 8 bits each)
+     */
+    const std::vector<glm::uvec2>& getEntries() const { return entries; }
+
+private:
+    std::vector<glm::uvec2> entries;
+};
+
+struct PathTraceSettings {
+    int maxBounces = 4;         // Indirect bounces after the camera hit
+    int samplesPerFrame = 1;    // Paths per pixel added each frame (GPU)
+    int maxSamples = 4096;      // Stop accumulating at this many paths per pixel
+    float emissionScale = 4.0f; // Radiance of emission 1.0 relative to the albedo
+};
+
+/**
+ * Camera as the ray caster's getCameraRay(): y-up look-at, vertical fov in degrees
+ */
+struct PathTraceCamera {
+    glm::vec3 position;
+    glm::vec3 target;
+    float fov;
+
+    /**
+     * Normalized direction through uv in [0, 1]^2 of a view with this aspect
+     */
+    glm::vec3 ray(const glm::vec2& uv, float aspect) const;
+};
+
+class PathTracer {
+public:
+    PathTracer();
+    ~PathTracer();
+
+    void init();
+    void cleanup();
+
+    void setMaterials(const MaterialTable& materials);
+
+    /**
+     * Start the accumulation over (scene, lights or settings changed)
+     */
+    void invalidate() { sampleCount = 0; }
+
+    /**
+     * Add settings.samplesPerFrame paths per pixel and show the running mean
+     * in the default framebuffer; restarts when the size or viewProjection
+     * differs from the last call
+     * @param setUniforms sets the ray casting uniforms (raycast_common.glsl)
+     */
+    void render(int width, int height, const glm::mat4& viewProjection, const PathTraceSettings& settings,
+                const std::function<void(const Shader&)>& setUniforms);
+
+    /**
+     * Paths per pixel accumulated so far
+     */
+    int getSampleCount() const { return sampleCount; }
+
+    /**
+     * Paths traced per second, over the last half second or so
+     */
+    double getSamplesPerSecond() const { return samplesPerSecond; }
+
+    /**
+     * Mean relative standard error of the pixels, READBACK_LATENCY frames ago
+     */
+    float getRelativeError() const { return relativeError; }
+
+    /**
+     * CPU reference of the same estimator over the scene octree (debris is
+     * not included). out holds width x height radiance values, bottom row first.
+     */
+    static void renderReference(const OctreeQuery& scene, const MaterialTable& materials,
+                                const PathTraceCamera& camera, const DirectionalLight* lights, int lightCount,
+                                bool useVoxelColor, const PathTraceSettings& settings, int width, int height,
+                                int samples, std::vector<glm::vec3>& out);
+
+    /**
+     * Write radiance (bottom row first, as renderReference) as a binary PPM,
+     * clamped to [0, 1]
+     * @return false if the file cannot be written
+     */
+    static bool writePPM(const std::string& path, const std::vector<glm::vec3>& pixels, int width, int height);
+
+private:
+    void allocate(int width, int height);
+    void release();
+
+    Shader* traceShader;
+    GLuint framebuffer;         // Reads the display texture for the blit
+    GLuint accumulationTexture; // rgba32f: rgb = mean radiance, a = mean squared luma
+    GLuint displayTexture;      // rgba8
+    GLuint materialBuffer;
+    GLuint statsBuffer;         // Summed relative error (1/1024 units), 3 pad
+    ReadbackRing readback;
+    int width;
+    int height;
+    glm::mat4 lastViewProjection;
+    int sampleCount;
+    float relativeError;
+
+    std::chrono::steady_clock::time_point rateStart;
+    double rateSamples;
+    double samplesPerSecond;
+};
+
+#endif // PATH_TRACER_H
@@ -0,0 +1,658 @@
+/**
+ * Streaming Point-Cloud Importer Implementation
+ */
+
+#include "point_cloud_importer.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// ============================================================================
+// File layout
+// ============================================================================
+
+enum class ScalarType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+ScalarType parseScalarType(const std::string& s) {
+    if (s == "char" || s == "int8") return ScalarType::Int8;
+    if (s == "uchar" || s == "uint8") return ScalarType::UInt8;
+    if (s == "short" || s == "int16") return ScalarType::Int16;
+    if (s == "ushort" || s == "uint16") return ScalarType::UInt16;
+    if (s == "int" || s == "int32") return ScalarType::Int32;
+    if (s == "uint" || s == "uint32") return ScalarType::UInt32;
+    if (s == "float" || s == "float32") return ScalarType::Float32;
+    if (s == "double" || s == "float64") return ScalarType::Float64;
+    return ScalarType::Invalid;
+}
+
+size_t scalarSize(ScalarType t) {
+    switch (t) {
+        case ScalarType::Int8: case ScalarType::UInt8: return 1;
+        case ScalarType::Int16: case ScalarType::UInt16: return 2;
+        case ScalarType::Int32: case ScalarType::UInt32: case ScalarType::Float32: return 4;
+        case ScalarType::Float64: return 8;
+        default: return 0;
+    }
+}
+
+struct Field {
+    int column = -1;        // Text: token index; binary: unused
+    size_t offset = 0;      // Binary: byte offset in the record
+    ScalarType type = ScalarType::Float32;
+    bool present = false;
+};
+
+struct Layout {
+    bool text = true;
+    bool autoColumns = false;       // .xyz/.pts: columns decided per line
+    bool bigEndian = false;
+    size_t stride = 0;              // Binary record size
+    int columnCount = 0;            // PLY ASCII tokens per vertex line
+    uint64_t count = UINT64_MAX;    // Points in the file, if known
+    uint64_t dataOffset = 0;
+    Field x, y, z, r, g, b;
+};
+
+std::string lowerExtension(const std::string& filepath) {
+    size_t dot = filepath.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string ext = filepath.substr(dot + 1);
+    for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext;
+}
+
+/**
+ * Parse a PLY header. hasFaces is set when the file is a mesh.
+ */
+Layout readPlyLayout(const std::string& filepath, bool& hasFaces) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open point cloud: " + filepath);
+    }
+
+    Layout layout;
+    hasFaces = false;
+    bool inVertex = false, vertexSeen = false;
+    std::string line;
+    std::getline(file, line);
+    if (line.compare(0, 3, "ply") != 0) {
+        throw std::runtime_error("Invalid PLY file: missing magic in " + filepath);
+    }
+
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        char keyword[32] = {}, a[32] = {}, b[32] = {}, c[64] = {};
+        int n = std::sscanf(line.c_str(), "%31s %31s %31s %63s", keyword, a, b, c);
+        if (n < 1) continue;
+        std::string kw = keyword;
+
+        if (kw == "format") {
+            layout.text = std::strcmp(a, "ascii") == 0;
+            layout.bigEndian = std::strcmp(a, "binary_big_endian") == 0;
+        } else if (kw == "element") {
+            inVertex = std::strcmp(a, "vertex") == 0;
+            if (inVertex) {
+                layout.count = std::strtoull(b, nullptr, 10);
+                vertexSeen = true;
+            } else if (std::strcmp(a, "face") == 0 && std::strtoull(b, nullptr, 10) > 0) {
+                hasFaces = true;
+            } else if (!vertexSeen && std::strtoull(b, nullptr, 10) > 0) {
+                throw std::runtime_error("PLY point clouds must store the vertex element first: " + filepath);
+            }
+        } else if (kw == "property" && inVertex) {
+            if (std::strcmp(a, "list") == 0) {
+                throw std::runtime_error("PLY vertex list properties are not supported: " + filepath);
+            }
+            ScalarType type = parseScalarType(a);
+            std::string name = b;
+            Field field;
+            field.present = true;
+            field.type = type;
+            field.column = layout.columnCount++;
+            field.offset = layout.stride;
+            layout.stride += scalarSize(type);
+
+            if (name == "x") layout.x = field;
+            else if (name == "y") layout.y = field;
+            else if (name == "z") layout.z = field;
+            else if (name == "red" || name == "r") layout.r = field;
+            else if (name == "green" || name == "g") layout.g = field;
+            else if (name == "blue" || name == "b") layout.b = field;
+        } else if (kw == "end_header") {
+            layout.dataOffset = static_cast<uint64_t>(file.tellg());
+            break;
+        }
+    }
+
+    if (!layout.x.present || !layout.y.present || !layout.z.present) {
+        throw std::runtime_error("PLY file has no x/y/z vertex properties: " + filepath);
+    }
+    return layout;
+}
+
+Layout readLayout(const std::string& filepath) {
+    std::string ext = lowerExtension(filepath);
+    if (ext == "ply") {
+        bool hasFaces;
+        return readPlyLayout(filepath, hasFaces);
+    }
+    if (ext == "xyz" || ext == "pts" || ext == "txt") {
+        Layout layout;
+        layout.autoColumns = true;
+        return layout;
+    }
+    throw std::runtime_error("Unsupported point cloud format: " + filepath);
+}
+
+// ============================================================================
+// Block reader: hands out whole records, never a partial line or record
+// ============================================================================
+
+class BlockReader {
+public:
+    BlockReader(const std::string& filepath, const Layout& layout, size_t blockPoints)
+        : layout(layout), remaining(layout.count) {
+        file.open(filepath, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open point cloud: " + filepath);
+        }
+        file.seekg(static_cast<std::streamoff>(layout.dataOffset));
+        // Text lines average well under 64 bytes
+        blockBytes = layout.text ? blockPoints * 64 : blockPoints * layout.stride;
+    }
+
+    /**
+     * @return false at the end of the point data
+     */
+    bool next(std::string& block) {
+        block.clear();
+        if (remaining == 0) return false;
+        return layout.text ? nextText(block) : nextBinary(block);
+    }
+
+private:
+    bool nextBinary(std::string& block) {
+        size_t bytes = blockBytes;
+        if (remaining != UINT64_MAX) bytes = static_cast<size_t>(std::min<uint64_t>(bytes, remaining * layout.stride));
+        block.resize(bytes);
+        file.read(&block[0], static_cast<std::streamsize>(bytes));
+        size_t got = static_cast<size_t>(file.gcount());
+        block.resize(got - got % layout.stride);
+        if (remaining != UINT64_MAX) remaining -= block.size() / layout.stride;
+        return !block.empty();
+    }
+
+    bool nextText(std::string& block) {
+        block.swap(carry);
+        carry.clear();
+        size_t old = block.size();
+        block.resize(old + blockBytes);
+        file.read(&block[old], static_cast<std::streamsize>(blockBytes));
+        block.resize(old + static_cast<size_t>(file.gcount()));
+
+        // Keep the trailing partial line for the next block
+        if (file) {
+            size_t lastNewline = block.find_last_of('\n');
+            if (lastNewline != std::string::npos) {
+                carry.assign(block, lastNewline + 1, std::string::npos);
+                block.resize(lastNewline + 1);
+            }
+        }
+
+        // PLY ASCII: stop after the vertex element
+        if (remaining != UINT64_MAX) {
+            size_t pos = 0;
+            uint64_t lines = 0;
+            while (lines < remaining && pos < block.size()) {
+                const char* nl = static_cast<const char*>(std::memchr(block.data() + pos, '\n', block.size() - pos));
+                pos = nl ? static_cast<size_t>(nl - block.data()) + 1 : block.size();
+                ++lines;
+            }
+            block.resize(pos);
+            remaining -= lines;
+        }
+        return !block.empty();
+    }
+
+    std::ifstream file;
+    Layout layout;
+    uint64_t remaining;
+    size_t blockBytes;
+    std::string carry;
+};
+
+// ============================================================================
+// Record parsing
+// ============================================================================
+
+double readScalar(const char* p, ScalarType type, bool bigEndian) {
+    unsigned char b[8];
+    size_t n = scalarSize(type);
+    std::memcpy(b, p, n);
+    if (bigEndian) std::reverse(b, b + n);
+    switch (type) {
+        case ScalarType::Int8:   { int8_t v; std::memcpy(&v, b, 1); return v; }
+        case ScalarType::UInt8:  { uint8_t v; std::memcpy(&v, b, 1); return v; }
+        case ScalarType::Int16:  { int16_t v; std::memcpy(&v, b, 2); return v; }
+        case ScalarType::UInt16: { uint16_t v; std::memcpy(&v, b, 2); return v; }
+        case ScalarType::Int32:  { int32_t v; std::memcpy(&v, b, 4); return v; }
+        case ScalarType::UInt32: { uint32_t v; std::memcpy(&v, b, 4); return v; }
+        case ScalarType::Float32:{ float v; std::memcpy(&v, b, 4); return v; }
+        case ScalarType::Float64:{ double v; std::memcpy(&v, b, 8); return v; }
+        default: return 0.0;
+    }
+}
+
+// Color channel to 0-255: float properties are 0-1, integer ones 0-255
+uint8_t toByte(double v, ScalarType type) {
+    if (type == ScalarType::Float32 || type == ScalarType::Float64) v *= 255.0;
+    return static_cast<uint8_t>(std::clamp(v, 0.0, 255.0) + 0.5);
+}
+
+/**
+ * Call emit(position, rgb) for every point in [begin, end)
+ */
+template <typename F>
+void parseRecords(const Layout& layout, const char* begin, const char* end, F&& emit) {
+    const glm::u8vec3 white(255);
+
+    if (!layout.text) {
+        for (const char* p = begin; p + layout.stride <= end; p += layout.stride) {
+            glm::dvec3 pos(readScalar(p + layout.x.offset, layout.x.type, layout.bigEndian),
+                           readScalar(p + layout.y.offset, layout.y.type, layout.bigEndian),
+                           readScalar(p + layout.z.offset, layout.z.type, layout.bigEndian));
+            glm::u8vec3 rgb = white;
+            if (layout.r.present) rgb.r = toByte(readScalar(p + layout.r.offset, layout.r.type, layout.bigEndian), layout.r.type);
+            if (layout.g.present) rgb.g = toByte(readScalar(p + layout.g.offset, layout.g.type, layout.bigEndian), layout.g.type);
+            if (layout.b.present) rgb.b = toByte(readScalar(p + layout.b.offset, layout.b.type, layout.bigEndian), layout.b.type);
+            emit(pos, rgb);
+        }
+        return;
+    }
+
+    constexpr int MAX_COLUMNS = 16;
+    double values[MAX_COLUMNS];
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!lineEnd) lineEnd = end;
+
+        // strtod stops at the newline, so the line needs no terminator
+        int n = 0;
+        const char* q = p;
+        while (n < MAX_COLUMNS && q < lineEnd) {
+            char* next;
+            double v = std::strtod(q, &next);
+            if (next == q || next > lineEnd) break;
+            values[n++] = v;
+            q = next;
+        }
+        p = lineEnd + 1;
+
+        if (layout.autoColumns) {
+            if (n < 3) continue;    // Blank, comment or .pts count line
+            glm::u8vec3 rgb = white;
+            int c = n >= 7 ? 4 : (n >= 6 ? 3 : -1);
+            if (c >= 0) {
+                for (int i = 0; i < 3; ++i)
+                    rgb[i] = toByte(values[c + i], ScalarType::UInt8);
+            }
+            emit(glm::dvec3(values[0], values[1], values[2]), rgb);
+        } else {
+            if (n < layout.columnCount) continue;
+            glm::u8vec3 rgb = white;
+            if (layout.r.present) rgb.r = toByte(values[layout.r.column], layout.r.type);
+            if (layout.g.present) rgb.g = toByte(values[layout.g.column], layout.g.type);
+            if (layout.b.present) rgb.b = toByte(values[layout.b.column], layout.b.type);
+            emit(glm::dvec3(values[layout.x.column], values[layout.y.column], values[layout.z.column]), rgb);
+        }
+    }
+}
+
+/**
+ * Split a block into independently parseable pieces
+ */
+std::vector<std::pair<size_t, size_t>> splitBlock(const Layout& layout, const std::string& block) {
+    constexpr size_t PIECE_BYTES = 256 * 1024;
+    std::vector<std::pair<size_t, size_t>> pieces;
+    size_t pos = 0;
+    while (pos < block.size()) {
+        size_t end = std::min(block.size(), pos + PIECE_BYTES);
+        if (layout.text) {
+            size_t nl = block.find('\n', end > 0 ? end - 1 : 0);
+            end = nl == std::string::npos ? block.size() : nl + 1;
+        } else {
+            end -= (end - pos) % layout.stride;
+        }
+        pieces.emplace_back(pos, end);
+        pos = end;
+    }
+    return pieces;
+}
+
+// ============================================================================
+// Sharded accumulators
+// ============================================================================
+
+constexpr int KEY_BITS = 21;
+constexpr uint32_t MAX_CELL = (1u << KEY_BITS) - 1;
+// Sums stay below 2^32 for up to 2^24 samples per voxel; beyond that the
+// running average is rescaled
+constexpr uint64_t MAX_SAMPLES = 1u << 24;
+
+struct Accum {
+    uint32_t r = 0, g = 0, b = 0, count = 0;
+
+    void add(uint64_t ar, uint64_t ag, uint64_t ab, uint64_t acount) {
+        uint64_t total = count + acount;
+        uint64_t sr = r + ar, sg = g + ag, sb = b + ab;
+        if (total > MAX_SAMPLES) {
+            sr = sr * MAX_SAMPLES / total;
+            sg = sg * MAX_SAMPLES / total;
+            sb = sb * MAX_SAMPLES / total;
+            total = MAX_SAMPLES;
+        }
+        r = static_cast<uint32_t>(sr); g = static_cast<uint32_t>(sg); b = static_cast<uint32_t>(sb);
+        count = static_cast<uint32_t>(total);
+    }
+};
+
+struct SpillRecord {
+    uint64_t key;
+    Accum accum;
+};
+
+struct KeyHash {
+    size_t operator()(uint64_t k) const {
+        // splitmix64 finalizer
+        k ^= k >> 30; k *= 0xbf58476d1ce4e5b9ull;
+        k ^= k >> 27; k *= 0x94d049bb133111ebull;
+        k ^= k >> 31;
+        return static_cast<size_t>(k);
+    }
+};
+
+using BinAllocator = TrackedAllocator<std::pair<const uint64_t, Accum>, MemoryTag::PointCloudBins>;
+using BinMap = std::unordered_map<uint64_t, Accum, KeyHash, std::equal_to<uint64_t>, BinAllocator>;
+
+struct Shard {
+    std::mutex mutex;
+    BinMap bins;
+    std::string spillPath;
+    bool spilled = false;
+};
+
+inline uint64_t packKey(const glm::uvec3& c) {
+    return static_cast<uint64_t>(c.x) | (static_cast<uint64_t>(c.y) << KEY_BITS) | (static_cast<uint64_t>(c.z) << (2 * KEY_BITS));
+}
+
+inline glm::ivec3 unpackKey(uint64_t k) {
+    return glm::ivec3(static_cast<int>(k & MAX_CELL),
+                      static_cast<int>((k >> KEY_BITS) & MAX_CELL),
+                      static_cast<int>((k >> (2 * KEY_BITS)) & MAX_CELL));
+}
+
+inline int shardOf(uint64_t key) {
+    return static_cast<int>((KeyHash()(key) >> 32) & (PointCloudImporter::SHARD_COUNT - 1));
+}
+
+} // namespace
+
+// ============================================================================
+// PointCloudImporter
+// ============================================================================
+
+bool PointCloudImporter::isPointCloudFile(const std::string& filepath) {
+    std::string ext = lowerExtension(filepath);
+    if (ext == "xyz" || ext == "pts") return true;
+    if (ext != "ply") return false;
+    try {
+        bool hasFaces;
+        readPlyLayout(filepath, hasFaces);
+        return !hasFaces;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+PointCloudImporter::Stats PointCloudImporter::import(const std::string& filepath, const Options& options, VoxelList& out) {
+    PROFILE_FUNCTION();
+    Stats stats;
+    out.clear();
+
+    JobSystem& jobs = JobSystem::instance();
+    const Layout layout = readLayout(filepath);
+    const size_t blockPoints = std::max<size_t>(options.blockPoints, 1024);
+    std::string block;
+
+    // Pass 1: bounds
+    glm::dvec3 bmin(1e300), bmax(-1e300);
+    {
+        PROFILE_ZONE("Point cloud bounds");
+        std::mutex boundsMutex;
+        BlockReader reader(filepath, layout, blockPoints);
+        while (reader.next(block)) {
+            auto pieces = splitBlock(layout, block);
+            jobs.parallelFor(0, pieces.size(), 1, [&](size_t pb, size_t pe) {
+                glm::dvec3 lmin(1e300), lmax(-1e300);
+                uint64_t count = 0;
+                for (size_t i = pb; i < pe; ++i) {
+                    parseRecords(layout, block.data() + pieces[i].first, block.data() + pieces[i].second,
+                                 [&](const glm::dvec3& p, const glm::u8vec3&) {
+                                     lmin = glm::min(lmin, p);
+                                     lmax = glm::max(lmax, p);
+                                     ++count;
+                                 });
+                }
+                std::lock_guard<std::mutex> guard(boundsMutex);
+                bmin = glm::min(bmin, lmin);
+                bmax = glm::max(bmax, lmax);
+                stats.pointCount += count;
+            });
+        }
+    }
+    if (stats.pointCount == 0) return stats;
+
+    glm::dvec3 extent = bmax - bmin;
+    double longest = std::max(extent.x, std::max(extent.y, extent.z));
+    double voxelSize = options.voxelSize > 0.0f ? options.voxelSize
+                     : (longest > 0.0 ? longest / std::max(1, options.resolution) : 1.0);
+    // Points on the max face fall into the last cell instead of one past it
+    glm::ivec3 grid = glm::max(glm::ivec3(glm::ceil(extent / voxelSize)), glm::ivec3(1));
+    if (grid.x > static_cast<int>(MAX_CELL) || grid.y > static_cast<int>(MAX_CELL) || grid.z > static_cast<int>(MAX_CELL)) {
+        throw std::runtime_error("Point cloud grid exceeds 2^21 cells per axis; increase the voxel size");
+    }
+    stats.voxelSize = static_cast<float>(voxelSize);
+
+    std::string spillDir = options.spillDirectory.empty()
+        ? std::filesystem::temp_directory_path().string() : options.spillDirectory;
+    std::string spillPrefix = (std::filesystem::path(spillDir) /
+        ("homogeneous_points_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()))).string();
+
+    std::vector<Shard> shards(SHARD_COUNT);
+    for (int s = 0; s < SHARD_COUNT; ++s) {
+        shards[s].spillPath = spillPrefix + "_" + std::to_string(s) + ".bin";
+    }
+
+    std::atomic<bool> ioFailed{false};
+    auto spillAll = [&]() {
+        PROFILE_ZONE("Spill point bins");
+        std::atomic<uint64_t> bytes{0};
+        jobs.parallelFor(0, SHARD_COUNT, 1, [&](size_t sb, size_t se) {
+            for (size_t s = sb; s < se; ++s) {
+                Shard& shard = shards[s];
+                if (shard.bins.empty()) continue;
+                std::vector<SpillRecord> records;
+                records.reserve(shard.bins.size());
+                for (const auto& kv : shard.bins) records.push_back(SpillRecord{kv.first, kv.second});
+                BinMap().swap(shard.bins);
+
+                std::ofstream spill(shard.spillPath, std::ios::binary | std::ios::app);
+                spill.write(reinterpret_cast<const char*>(records.data()),
+                            static_cast<std::streamsize>(records.size() * sizeof(SpillRecord)));
+                if (!spill) ioFailed = true;
+                shard.spilled = true;
+                bytes += records.size() * sizeof(SpillRecord);
+            }
+        });
+        stats.spillCount++;
+        stats.spilledBytes += bytes.load();
+    };
+
+    auto cleanupSpills = [&]() {
+        for (auto& shard : shards) {
+            std::error_code ec;
+            if (shard.spilled) std::filesystem::remove(shard.spillPath, ec);
+        }
+    };
+
+    // Pass 2: quantize and accumulate
+    {
+        PROFILE_ZONE("Point cloud binning");
+        BlockReader reader(filepath, layout, blockPoints);
+        while (reader.next(block)) {
+            auto pieces = splitBlock(layout, block);
+            jobs.parallelFor(0, pieces.size(), 1, [&](size_t pb, size_t pe) {
+                // Batch per shard so each shard lock is taken once per piece
+                std::vector<std::pair<uint64_t, glm::u8vec3>> batches[SHARD_COUNT];
+                for (size_t i = pb; i < pe; ++i) {
+                    parseRecords(layout, block.data() + pieces[i].first, block.data() + pieces[i].second,
+                                 [&](const glm::dvec3& p, const glm::u8vec3& rgb) {
+                                     glm::ivec3 cell = glm::clamp(glm::ivec3(glm::floor((p - bmin) / voxelSize)),
+                                                                  glm::ivec3(0), grid - 1);
+                                     uint64_t key = packKey(glm::uvec3(cell));
+                                     batches[shardOf(key)].emplace_back(key, rgb);
+                                 });
+                }
+                for (int s = 0; s < SHARD_COUNT; ++s) {
+                    if (batches[s].empty()) continue;
+                    std::lock_guard<std::mutex> guard(shards[s].mutex);
+                    for (const auto& kr : batches[s]) {
+                        shards[s].bins[kr.first].add(kr.second.r, kr.second.g, kr.second.b, 1);
+                    }
+                }
+            });
+
+            if (MemoryStats::getTag(MemoryTag::PointCloudBins).current > options.memoryBudget) {
+                spillAll();
+                if (ioFailed) {
+                    cleanupSpills();
+                    throw std::runtime_error("Failed to write point cloud spill files to " + spillDir);
+                }
+            }
+        }
+    }
+
+    // Sorted records of a shard's bins; the bins are released
+    auto takeSorted = [](Shard& shard) {
+        std::vector<SpillRecord> sorted;
+        sorted.reserve(shard.bins.size());
+        for (const auto& kv : shard.bins) sorted.push_back(SpillRecord{kv.first, kv.second});
+        BinMap().swap(shard.bins);
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const SpillRecord& a, const SpillRecord& b) { return a.key < b.key; });
+        return sorted;
+    };
+
+    // Final merge, first pass: fold every spilled shard's partial sums into its
+    // bins and write them back as one sorted run, a shard per worker at a time,
+    // so only those few shards are rehydrated at once and the cell counts are
+    // known before the output is allocated
+    std::vector<size_t> counts(SHARD_COUNT, 0);
+    {
+        PROFILE_ZONE("Point cloud merge (fold)");
+        jobs.parallelFor(0, SHARD_COUNT, 1, [&](size_t sb, size_t se) {
+            for (size_t s = sb; s < se; ++s) {
+                Shard& shard = shards[s];
+                if (!shard.spilled) {
+                    counts[s] = shard.bins.size();
+                    continue;
+                }
+                {
+                    std::ifstream spill(shard.spillPath, std::ios::binary);
+                    std::vector<SpillRecord> records(64 * 1024);
+                    while (spill) {
+                        spill.read(reinterpret_cast<char*>(records.data()),
+                                   static_cast<std::streamsize>(records.size() * sizeof(SpillRecord)));
+                        size_t n = static_cast<size_t>(spill.gcount()) / sizeof(SpillRecord);
+                        for (size_t i = 0; i < n; ++i) {
+                            const Accum& a = records[i].accum;
+                            shard.bins[records[i].key].add(a.r, a.g, a.b, a.count);
+                        }
+                    }
+                    if (!spill.eof()) ioFailed = true;
+                }
+
+                std::vector<SpillRecord> sorted = takeSorted(shard);
+                std::ofstream spill(shard.spillPath, std::ios::binary | std::ios::trunc);
+                spill.write(reinterpret_cast<const char*>(sorted.data()),
+                            static_cast<std::streamsize>(sorted.size() * sizeof(SpillRecord)));
+                if (!spill) ioFailed = true;
+                counts[s] = sorted.size();
+            }
+        });
+    }
+    if (ioFailed) {
+        cleanupSpills();
+        throw std::runtime_error("Failed to merge point cloud spill files in " + spillDir);
+    }
+
+    // Second pass: each shard fills its own slice of the output, in key order
+    // so the result does not depend on scheduling. Spilled shards stream their
+    // sorted run back in blocks.
+    std::vector<size_t> offsets(SHARD_COUNT + 1, 0);
+    for (int s = 0; s < SHARD_COUNT; ++s) offsets[s + 1] = offsets[s] + counts[s];
+    out.resize(offsets.back());
+    {
+        PROFILE_ZONE("Point cloud merge (emit)");
+        const glm::ivec3 center = grid / 2;
+        auto emit = [&](const SpillRecord& rec, size_t index) {
+            float inv = 1.0f / (255.0f * rec.accum.count);
+            out[index] = Voxel(unpackKey(rec.key) - center,
+                               glm::vec4(rec.accum.r * inv, rec.accum.g * inv, rec.accum.b * inv, 1.0f));
+        };
+        jobs.parallelFor(0, SHARD_COUNT, 1, [&](size_t sb, size_t se) {
+            for (size_t s = sb; s < se; ++s) {
+                Shard& shard = shards[s];
+                size_t index = offsets[s];
+                if (!shard.spilled) {
+                    for (const auto& rec : takeSorted(shard)) emit(rec, index++);
+                    continue;
+                }
+                std::ifstream spill(shard.spillPath, std::ios::binary);
+                std::vector<SpillRecord> records(64 * 1024);
+                while (spill && index < offsets[s + 1]) {
+                    spill.read(reinterpret_cast<char*>(records.data()),
+                               static_cast<std::streamsize>(records.size() * sizeof(SpillRecord)));
+                    size_t n = static_cast<size_t>(spill.gcount()) / sizeof(SpillRecord);
+                    n = std::min(n, offsets[s + 1] - index);
+                    for (size_t i = 0; i < n; ++i) emit(records[i], index++);
+                }
+                if (index != offsets[s + 1]) ioFailed = true;
+            }
+        });
+    }
+    cleanupSpills();
+    if (ioFailed) {
+        throw std::runtime_error("Failed to read point cloud spill files from " + spillDir);
+    }
+    stats.voxelCount = out.size();
+
+    std::cout << "Point cloud: " << stats.pointCount << " points -> " << stats.voxelCount << " voxels ("
+              << grid.x << "x" << grid.y << "x" << grid.z << ", voxel size " << voxelSize << ", "
+              << stats.spillCount << " spills, " << stats.spilledBytes / (1024.0 * 1024.0) << " MB spilled)" << std::endl;
+    return stats;
+}
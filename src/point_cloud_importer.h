@@ -0,0 +1,61 @@
+/**
+ * Streaming Point-Cloud Importer
+ *
+ * Voxelizes point clouds that are far larger than memory (LiDAR scans,
+ * photogrammetry) from .xyz/.pts text files or vertex-only .ply files
+ * (ASCII or binary). The file is streamed twice in fixed-size blocks:
+ *   1. bounds pass: min/max of all points, which fixes the grid
+ *   2. binning pass: every block is quantized on the job system and the
+ *      per-voxel color sums are accumulated in a sharded hash map
+ *
+ * When the accumulators exceed the memory budget every shard is appended to
+ * its own spill file and cleared. The final merge folds each spilled shard's
+ * partial sums back in, a shard per worker at a time, and writes it back as
+ * one sorted run; the output is then allocated once at its exact size and
+ * every shard fills its slice with one voxel per occupied cell, ready for
+ * VoxelRenderer::setVoxels / buildOctree.
+ *
+ * Text colors are expected as 0-255 integers ("x y z r g b", or
+ * "x y z intensity r g b" for .pts); PLY colors follow their property type.
+ */
+
+#ifndef POINT_CLOUD_IMPORTER_H
+#define POINT_CLOUD_IMPORTER_H
+
+#include <cstdint>
+#include <string>
+#include "voxel.h"
+
+class PointCloudImporter {
+public:
+    static constexpr int SHARD_COUNT = 64;
+
+    struct Options {
+        int resolution = 1024;                  // Voxels along the longest axis
+        float voxelSize = 0.0f;                 // World units per voxel; overrides resolution if > 0
+        size_t blockPoints = 1 << 20;           // Points read per block
+        size_t memoryBudget = 512ull << 20;     // Accumulator bytes before spilling to disk
+        std::string spillDirectory;             // Empty: std::filesystem::temp_directory_path()
+    };
+
+    struct Stats {
+        uint64_t pointCount = 0;
+        size_t voxelCount = 0;
+        float voxelSize = 0.0f;
+        int spillCount = 0;                     // Times the accumulators were flushed to disk
+        uint64_t spilledBytes = 0;
+    };
+
+    /**
+     * @return true for .xyz/.pts files and .ply files without a face element
+     */
+    static bool isPointCloudFile(const std::string& filepath);
+
+    /**
+     * Stream a point cloud into voxels centered on the origin
+     * @throws std::runtime_error if the file cannot be read or a spill fails
+     */
+    static Stats import(const std::string& filepath, const Options& options, VoxelList& out);
+};
+
+#endif // POINT_CLOUD_IMPORTER_H
@@ -0,0 +1,261 @@
+/**
+ * CPU Profiler Implementation
+ */
+
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <imgui.h>
+
+// Zones kept per thread before the oldest are overwritten
+static constexpr uint64_t RING_CAPACITY = 1u << 16;
+
+namespace {
+
+// One ring entry. seq is a seqlock: 2 * index + 1 while zone `index` is being
+// written, 2 * (index + 1) once it is complete
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    ProfileEvent event{};
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<Slot[]> slots = std::unique_ptr<Slot[]>(new Slot[RING_CAPACITY]);
+    std::atomic<uint64_t> head{0};  // Total zones ever written (owner writes, others read)
+    uint32_t threadId = 0;
+    uint32_t depth = 0;             // Current nesting depth, owner only
+    std::string name;
+};
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+ThreadBuffer& threadBuffer() {
+    if (!tlsBuffer) {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        registry.push_back(std::make_unique<ThreadBuffer>());
+        tlsBuffer = registry.back().get();
+        tlsBuffer->threadId = static_cast<uint32_t>(registry.size() - 1);
+        tlsBuffer->name = "Thread " + std::to_string(tlsBuffer->threadId);
+    }
+    return *tlsBuffer;
+}
+
+// Start timestamps of the last two frames (written by the main loop)
+std::atomic<uint64_t> frameStart{0};
+std::atomic<uint64_t> prevFrameStart{0};
+
+/**
+ * Call fn with every complete zone written as index [begin, head) of tb's
+ * ring; zones overwritten by now or being written while read are skipped
+ */
+template <typename Fn>
+uint64_t scanRing(const ThreadBuffer& tb, uint64_t begin, Fn&& fn) {
+    uint64_t head = tb.head.load(std::memory_order_acquire);
+    if (head - begin > RING_CAPACITY) begin = head - RING_CAPACITY;
+    for (uint64_t i = begin; i < head; ++i) {
+        const Slot& slot = tb.slots[i & (RING_CAPACITY - 1)];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * (i + 1)) continue;
+        ProfileEvent ev = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+        fn(ev);
+    }
+    return head;
+}
+
+// drawFlameChart() state: the frame it shows and the ring positions scanned so far
+struct FlameCache {
+    uint64_t from = 0;
+    uint64_t to = 0;
+    std::vector<ProfileEvent> events;   // Zones overlapping [from, to]
+    std::vector<ProfileEvent> later;    // Zones ending at or after `to`, they may overlap the next frame
+    std::vector<uint64_t> cursor;       // Per thread: ring entries below this were scanned
+    std::vector<std::pair<uint32_t, std::string>> threads;
+};
+
+FlameCache flameCache;
+
+std::string jsonEscape(const char* s) {
+    std::string out;
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        out += *s;
+    }
+    return out;
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::enabled{true};
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::setThreadName(const char* name) {
+    ThreadBuffer& tb = threadBuffer();
+    std::lock_guard<std::mutex> guard(registryMutex);
+    tb.name = name;
+}
+
+void Profiler::markFrame() {
+    threadBuffer(); // make sure the main thread gets the first row
+    prevFrameStart.store(frameStart.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    frameStart.store(now(), std::memory_order_relaxed);
+}
+
+uint32_t Profiler::beginZone() {
+    return threadBuffer().depth++;
+}
+
+void Profiler::endZone(const char* name, uint64_t startNs, uint32_t depth) {
+    ThreadBuffer& tb = threadBuffer();
+    tb.depth = depth;
+    if (!enabled.load(std::memory_order_relaxed)) return;
+
+    uint64_t h = tb.head.load(std::memory_order_relaxed);
+    Slot& slot = tb.slots[h & (RING_CAPACITY - 1)];
+    slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = ProfileEvent{name, startNs, now(), tb.threadId, depth};
+    slot.seq.store(2 * (h + 1), std::memory_order_release);
+    tb.head.store(h + 1, std::memory_order_release);
+}
+
+void Profiler::collect(uint64_t fromNs, uint64_t toNs, std::vector<ProfileEvent>& out) {
+    std::lock_guard<std::mutex> guard(registryMutex);
+    for (const auto& tb : registry) {
+        scanRing(*tb, 0, [&](const ProfileEvent& ev) {
+            if (ev.endNs >= fromNs && ev.startNs <= toNs) out.push_back(ev);
+        });
+    }
+}
+
+bool Profiler::exportChromeTrace(const std::string& filepath) {
+    std::vector<ProfileEvent> events;
+    collect(0, UINT64_MAX, events);
+
+    std::ofstream file(filepath);
+    if (!file.is_open()) return false;
+
+    uint64_t origin = UINT64_MAX;
+    for (const auto& ev : events) origin = std::min(origin, ev.startNs);
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        for (const auto& tb : registry) {
+            file << (first ? "" : ",\n")
+                 << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tb->threadId
+                 << ",\"args\":{\"name\":\"" << jsonEscape(tb->name.c_str()) << "\"}}";
+            first = false;
+        }
+    }
+
+    char buf[64];
+    for (const auto& ev : events) {
+        file << (first ? "" : ",\n") << "{\"name\":\"" << jsonEscape(ev.name)
+             << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ev.threadId;
+        std::snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f}",
+                      (ev.startNs - origin) / 1000.0, (ev.endNs - ev.startNs) / 1000.0);
+        file << buf;
+        first = false;
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+void Profiler::drawFlameChart() {
+    uint64_t to = frameStart.load(std::memory_order_relaxed);
+    uint64_t from = prevFrameStart.load(std::memory_order_relaxed);
+    if (from == 0 || to <= from) {
+        ImGui::TextDisabled("No frame captured yet");
+        return;
+    }
+
+    // Once per frame, scan only the zones written since the last frame; the
+    // ones that ended after it are carried over
+    FlameCache& cache = flameCache;
+    if (from != cache.from || to != cache.to) {
+        std::vector<ProfileEvent> pool;
+        pool.swap(cache.later);
+        cache.events.clear();
+        cache.threads.clear();
+        {
+            std::lock_guard<std::mutex> guard(registryMutex);
+            cache.cursor.resize(registry.size(), 0);
+            for (size_t t = 0; t < registry.size(); ++t) {
+                const ThreadBuffer& tb = *registry[t];
+                cache.cursor[t] = scanRing(tb, cache.cursor[t], [&](const ProfileEvent& ev) { pool.push_back(ev); });
+                cache.threads.emplace_back(tb.threadId, tb.name);
+            }
+        }
+        for (const ProfileEvent& ev : pool) {
+            if (ev.endNs >= from && ev.startNs <= to) cache.events.push_back(ev);
+            if (ev.endNs >= to) cache.later.push_back(ev);
+        }
+        cache.from = from;
+        cache.to = to;
+    }
+    const std::vector<ProfileEvent>& events = cache.events;
+    const std::vector<std::pair<uint32_t, std::string>>& threads = cache.threads;
+
+    const float rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    const double nsPerPixel = static_cast<double>(to - from) / width;
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+
+    ImGui::Text("Frame: %.3f ms", (to - from) * 1e-6);
+    for (const auto& thread : threads) {
+        uint32_t maxDepth = 0;
+        bool any = false;
+        for (const auto& ev : events) {
+            if (ev.threadId != thread.first) continue;
+            maxDepth = std::max(maxDepth, ev.depth);
+            any = true;
+        }
+        if (!any) continue;
+
+        ImGui::TextUnformatted(thread.second.c_str());
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float height = rowHeight * (maxDepth + 1);
+        ImGui::InvisibleButton(thread.second.c_str(), ImVec2(width, height));
+        bool hovered = ImGui::IsItemHovered();
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+
+        for (const auto& ev : events) {
+            if (ev.threadId != thread.first) continue;
+            uint64_t s = std::max(ev.startNs, from);
+            uint64_t e = std::min(ev.endNs, to);
+            float x0 = origin.x + static_cast<float>((s - from) / nsPerPixel);
+            float x1 = origin.x + static_cast<float>((e - from) / nsPerPixel);
+            x1 = std::max(x1, x0 + 1.0f);
+            float y0 = origin.y + ev.depth * rowHeight;
+            float y1 = y0 + rowHeight - 1.0f;
+
+            // Stable color per zone name
+            uint32_t hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ev.name) * 2654435761u);
+            ImU32 col = IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 120 + ((hash >> 16) & 0x7F), 255);
+            draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), col);
+            if (x1 - x0 > 30.0f) {
+                draw->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+                draw->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(255, 255, 255, 255), ev.name);
+                draw->PopClipRect();
+            }
+            if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1) {
+                ImGui::SetTooltip("%s\n%.3f ms", ev.name, (ev.endNs - ev.startNs) * 1e-6);
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * CPU Profiler
+ *
+ * Lightweight scoped-zone profiler. Each thread records zones into its own
+ * fixed-size ring buffer (single writer, no locks on the hot path); the UI
+ * thread snapshots the rings to draw a flame chart or to export a Chrome
+ * trace_event JSON file (open in chrome://tracing or ui.perfetto.dev). Each
+ * ring slot carries a sequence number, so readers skip zones that are being
+ * overwritten while they copy.
+ *
+ * Usage:
+ *   void foo() {
+ *       PROFILE_FUNCTION();
+ *       { PROFILE_ZONE("inner work"); ... }
+ *   }
+ *
+ * Zone names must be string literals (only the pointer is stored).
+ * Configure with -DHOMOGENEOUS_ENABLE_PROFILER=OFF to compile all zones out.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * One completed zone
+ */
+struct ProfileEvent {
+    const char* name;   // Static string
+    uint64_t startNs;   // Profiler::now() at zone entry
+    uint64_t endNs;     // Profiler::now() at zone exit
+    uint32_t threadId;  // Profiler-assigned thread index
+    uint32_t depth;     // Nesting depth on its thread
+};
+
+class Profiler {
+public:
+    /**
+     * Monotonic timestamp in nanoseconds
+     */
+    static uint64_t now();
+
+    /**
+     * Name the calling thread in the flame chart and trace export
+     */
+    static void setThreadName(const char* name);
+
+    /**
+     * Mark the start of a new frame (main loop). The flame chart shows the
+     * last completed frame.
+     */
+    static void markFrame();
+
+    /**
+     * Copy all zones that overlap [fromNs, toNs] from every thread's ring
+     */
+    static void collect(uint64_t fromNs, uint64_t toNs, std::vector<ProfileEvent>& out);
+
+    /**
+     * Write every buffered zone as Chrome trace_event JSON
+     * @return false if the file could not be written
+     */
+    static bool exportChromeTrace(const std::string& filepath);
+
+    /**
+     * Draw the flame chart for the last completed frame into the current ImGui
+     * window; the zones are collected once per frame
+     */
+    static void drawFlameChart();
+
+    // Used by ProfileZone
+    static uint32_t beginZone();
+    static void endZone(const char* name, uint64_t startNs, uint32_t depth);
+
+    static std::atomic<bool> enabled;   // Record zones; read relaxed on every zone exit
+};
+
+/**
+ * RAII zone: records [construction, destruction) on the current thread
+ */
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* zoneName)
+        : name(zoneName)
+        , depth(Profiler::beginZone())
+        , start(Profiler::now())
+    {
+    }
+
+    ~ProfileZone() {
+        Profiler::endZone(name, start, depth);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint32_t depth;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef HOMOGENEOUS_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_FRAME() Profiler::markFrame()
+#define PROFILE_THREAD_NAME(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,137 @@
+/**
+ * Radiance Volume Implementation
+ */
+
+#include "radiance_volume.h"
+#include "gl_utils.h"
+#include "profiler.h"
+#include <algorithm>
+
+namespace {
+
+constexpr GLuint GROUP_SIZE = 8;    // local_size_x/y of radiance_inject.comp and radiance_mip.comp
+
+GLuint groups(int size) {
+    return (static_cast<GLuint>(size) + GROUP_SIZE - 1) / GROUP_SIZE;
+}
+
+} // namespace
+
+RadianceVolume::RadianceVolume()
+    : injectShader(nullptr)
+    , mipShader(nullptr)
+    , texture(0)
+    , resolution(0)
+    , levels(0)
+    , nextSlice(0)
+    , fullUpdate(true)
+{
+}
+
+RadianceVolume::~RadianceVolume()
+{
+    cleanup();
+}
+
+void RadianceVolume::init()
+{
+    injectShader = new Shader("assets/shaders/radiance_inject.comp");
+    mipShader = new Shader("assets/shaders/radiance_mip.comp");
+    timer.init(TIMER_PASS_COUNT);
+}
+
+void RadianceVolume::cleanup()
+{
+    release();
+    delete injectShader; injectShader = nullptr;
+    delete mipShader; mipShader = nullptr;
+    timer.cleanup();
+}
+
+void RadianceVolume::release()
+{
+    freeGLTexture(texture);
+    resolution = 0;
+    levels = 0;
+    nextSlice = 0;
+    fullUpdate = true;
+}
+
+void RadianceVolume::allocate(int newResolution)
+{
+    release();
+    resolution = newResolution;
+    levels = 1;
+    while ((resolution >> levels) > 0) ++levels;
+
+    size_t bytes = 0;
+    for (int level = 0; level < levels; ++level) {
+        size_t side = static_cast<size_t>(resolution >> level);
+        bytes += side * side * side * sizeof(uint16_t) * 4;
+    }
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexStorage3D(GL_TEXTURE_3D, levels, GL_RGBA16F, resolution, resolution, resolution);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Outside the scene bounds is empty space
+    const GLfloat border[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_3D, GL_TEXTURE_BORDER_COLOR, border);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    MemoryStats::trackGLTexture(texture, MemoryTag::GpuTexture, bytes);
+}
+
+void RadianceVolume::update(float extent, int slices, const std::function<void(const Shader&)>& setUniforms)
+{
+    PROFILE_FUNCTION();
+    if (injectShader == nullptr) return;
+
+    // One texel per voxel up to MAX_RESOLUTION; the octree extent is a power of two
+    int target = 1;
+    while (target < MAX_RESOLUTION && static_cast<float>(target) < extent) target *= 2;
+    if (target != resolution) allocate(target);
+    timer.beginFrame();
+
+    // Slices [begin, end) this frame; the last batch of a sweep may be short
+    const int begin = fullUpdate ? 0 : nextSlice;
+    const int end = fullUpdate ? resolution : std::min(begin + std::max(slices, 1), resolution);
+    nextSlice = end % resolution;
+    fullUpdate = false;
+
+    injectShader->use();
+    setUniforms(*injectShader);
+    injectShader->setInt("u_sliceBegin", begin);
+    glBindImageTexture(0, texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    timer.begin(TIMER_INJECT);
+    glDispatchCompute(groups(resolution), groups(resolution), static_cast<GLuint>(end - begin));
+    timer.end();
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // Every level above only where it covers the injected slices
+    mipShader->use();
+    timer.begin(TIMER_MIPMAP);
+    for (int level = 1; level < levels; ++level) {
+        const int side = resolution >> level;
+        const int levelBegin = begin >> level;
+        const int levelEnd = std::max((end - 1) >> level, levelBegin) + 1;
+        mipShader->setInt("u_sliceBegin", levelBegin);
+        glBindImageTexture(0, texture, level - 1, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
+        glBindImageTexture(1, texture, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glDispatchCompute(groups(side), groups(side), static_cast<GLuint>(levelEnd - levelBegin));
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    timer.end();
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void RadianceVolume::bind(const Shader& shader, GLuint unit, bool enabled) const
+{
+    shader.setBool("u_coneTracing", enabled && texture != 0);
+    shader.setInt("u_radianceVolume", static_cast<int>(unit));
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,95 @@
+/**
+ * Radiance Volume
+ *
+ * Direct lighting of the scene voxelized into a mipmapped 3D texture for
+ * voxel cone tracing (Crassin et al. 2011). radiance_inject.comp descends the
+ * scene octree to each texel's size for its coverage and albedo, lights it
+ * from every light with a shadow ray and stores premultiplied radiance (rgb)
+ * with the coverage (a); radiance_mip.comp averages the levels down. The
+ * volume spans the scene octree bounds at up to MAX_RESOLUTION texels a
+ * side, one voxel per texel for smaller scenes.
+ *
+ * The shaders (cone_trace.glsl) trace a few wide cones per pixel through the
+ * mip chain, reading the level whose texels match the cone's width, for
+ * one-bounce diffuse light and a soft occlusion of the ambient term.
+ *
+ * Injection costs a shadow ray per light and occupied texel, so update()
+ * refreshes a few z slices per frame, round robin; edits and light changes
+ * reach the volume within resolution / slices frames. Debris is not
+ * voxelized.
+ */
+
+#ifndef RADIANCE_VOLUME_H
+#define RADIANCE_VOLUME_H
+
+#include <glad/glad.h>
+#include <functional>
+#include "gpu_timer.h"
+#include "shader.h"
+
+// Texture unit of u_radianceVolume (cone_trace.glsl)
+constexpr GLuint RADIANCE_VOLUME_TEXTURE_UNIT = 2;
+
+class RadianceVolume {
+public:
+    static constexpr int MAX_RESOLUTION = 128;
+
+    // Passes timed by getPassMilliseconds()
+    enum TimedPass {
+        TIMER_INJECT,
+        TIMER_MIPMAP,
+        TIMER_PASS_COUNT
+    };
+
+    RadianceVolume();
+    ~RadianceVolume();
+
+    void init();
+    void cleanup();
+
+    /**
+     * Re-inject the next slices z slices and rebuild the mip levels above
+     * them; every slice when the resolution changed or after invalidate().
+     * The scene octree SSBO must be bound.
+     * @param extent side of the (cubic) scene octree bounds
+     * @param setUniforms sets the ray casting uniforms (raycast_common.glsl)
+     */
+    void update(float extent, int slices, const std::function<void(const Shader&)>& setUniforms);
+
+    /**
+     * Inject the whole volume with the next update (scene replaced)
+     */
+    void invalidate() { fullUpdate = true; }
+
+    /**
+     * Drop the texture while cone tracing is off
+     */
+    void release();
+
+    /**
+     * Bind the volume to unit and set u_radianceVolume and u_coneTracing
+     * (false when not enabled or nothing was injected yet)
+     */
+    void bind(const Shader& shader, GLuint unit, bool enabled) const;
+
+    int getResolution() const { return resolution; }
+
+    /**
+     * GPU time of a TimedPass, READBACK_LATENCY frames ago
+     */
+    double getPassMilliseconds(int pass) const { return timer.getMilliseconds(pass); }
+
+private:
+    void allocate(int newResolution);
+
+    Shader* injectShader;
+    Shader* mipShader;
+    GLuint texture;     // rgba16f, full mip chain: premultiplied radiance, coverage
+    int resolution;
+    int levels;
+    int nextSlice;
+    bool fullUpdate;
+    GpuTimer timer;
+};
+
+#endif // RADIANCE_VOLUME_H
@@ -0,0 +1,376 @@
+/**
+ * Sampling Implementation
+ */
+
+#include "sampling.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "path_tracer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float UNIT_24 = 1.0f / 16777216.0f;   // 24-bit fixed point to [0, 1)
+constexpr float BLUE_NOISE_SIGMA = 1.5f;        // Energy kernel width of void-and-cluster, in texels
+constexpr float AO_RAY_OFFSET = 0.02f;          // Along the normal, as in raycast_common.glsl
+
+uint32_t pcg(uint32_t& state) {
+    state = state * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random01(uint32_t& state) {
+    return static_cast<float>(pcg(state) >> 8) * UNIT_24;
+}
+
+uint32_t reverseBits(uint32_t v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+uint32_t mixBits(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+float fract(float v) {
+    return v - std::floor(v);
+}
+
+glm::vec2 fract(const glm::vec2& v) {
+    return v - glm::floor(v);
+}
+
+// Gaussian energy of every texel from the set texels of a pattern, on a torus
+class EnergyField {
+public:
+    explicit EnergyField(int size)
+        : size(size)
+        , kernel(static_cast<size_t>(size) * size)
+        , energy(static_cast<size_t>(size) * size, 0.0f)
+        , pattern(static_cast<size_t>(size) * size, 0)
+    {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                float dx = static_cast<float>(std::min(x, size - x));
+                float dy = static_cast<float>(std::min(y, size - y));
+                kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+            }
+        }
+    }
+
+    bool isSet(int index) const { return pattern[index] != 0; }
+
+    void set(int index, bool value) {
+        if (index < 0 || isSet(index) == value) return;
+        pattern[index] = value ? 1 : 0;
+        const float sign = value ? 1.0f : -1.0f;
+        const int mask = size - 1;
+        const int px = index % size, py = index / size;
+        for (int y = 0; y < size; ++y) {
+            const float* row = &kernel[((y - py) & mask) * size];
+            float* out = &energy[y * size];
+            for (int x = 0; x < size; ++x) out[x] += sign * row[(x - px) & mask];
+        }
+    }
+
+    // Set texel with the most energy
+    int tightestCluster() const {
+        int best = -1;
+        for (int i = 0; i < static_cast<int>(energy.size()); ++i) {
+            if (pattern[i] && (best < 0 || energy[i] > energy[best])) best = i;
+        }
+        return best;
+    }
+
+    // Empty texel with the least energy
+    int largestVoid() const {
+        int best = -1;
+        for (int i = 0; i < static_cast<int>(energy.size()); ++i) {
+            if (!pattern[i] && (best < 0 || energy[i] < energy[best])) best = i;
+        }
+        return best;
+    }
+
+private:
+    int size;
+    std::vector<float> kernel;
+    std::vector<float> energy;
+    std::vector<uint8_t> pattern;
+};
+
+} // namespace
+
+namespace Sampling {
+
+glm::vec2 sobol(uint32_t index)
+{
+    // Second dimension: direction numbers of the primitive polynomial x + 1
+    uint32_t y = 0;
+    for (uint32_t i = index, v = 1u << 31; i != 0; i >>= 1, v ^= v >> 1) {
+        if (i & 1u) y ^= v;
+    }
+    return glm::vec2(static_cast<float>(reverseBits(index) >> 8), static_cast<float>(y >> 8)) * UNIT_24;
+}
+
+glm::vec2 r2(uint32_t index)
+{
+    // 2^32 / plastic number and its square
+    return glm::vec2(static_cast<float>((index * 3242174890u) >> 8), static_cast<float>((index * 2447445414u) >> 8)) *
+           UNIT_24;
+}
+
+glm::vec2 cellShift(const glm::vec3& cell)
+{
+    glm::ivec3 c(glm::floor(cell));
+    uint32_t h = mixBits(static_cast<uint32_t>(c.x) * 73856093u ^ static_cast<uint32_t>(c.y) * 19349663u ^
+                         static_cast<uint32_t>(c.z) * 83492791u);
+    return glm::vec2(static_cast<float>(h >> 8), static_cast<float>(mixBits(h) >> 8)) * UNIT_24;
+}
+
+void basis(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
+{
+    float s = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (s + n.z);
+    float c = n.x * n.y * a;
+    t = glm::vec3(1.0f + s * n.x * n.x * a, s * c, -s * n.x);
+    b = glm::vec3(c, s + n.y * n.y * a, -n.y);
+}
+
+glm::vec3 cosineHemisphere(const glm::vec2& u, const glm::vec3& n)
+{
+    glm::vec3 t, b;
+    basis(n, t, b);
+    float r = std::sqrt(u.x);
+    float phi = 2.0f * PI * u.y;
+    return t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + n * std::sqrt(std::max(1.0f - u.x, 0.0f));
+}
+
+} // namespace Sampling
+
+BlueNoise::BlueNoise()
+    : texture(0)
+{
+}
+
+BlueNoise::~BlueNoise()
+{
+    cleanup();
+}
+
+std::vector<float> BlueNoise::generate(int size, uint32_t seed)
+{
+    PROFILE_FUNCTION();
+    if (size <= 0 || (size & (size - 1)) != 0) return {};
+    const int count = size * size;
+    EnergyField field(size);
+
+    // Initial binary pattern: a tenth of the texels at random, relaxed by
+    // moving the tightest cluster into the largest void until that is a no-op
+    const int initial = std::max(count / 10, 1);
+    uint32_t state = seed;
+    for (int placed = 0; placed < initial;) {
+        int index = static_cast<int>(pcg(state) % static_cast<uint32_t>(count));
+        if (field.isSet(index)) continue;
+        field.set(index, true);
+        ++placed;
+    }
+    for (int iteration = 0; iteration < count; ++iteration) {
+        int cluster = field.tightestCluster();
+        field.set(cluster, false);
+        int gap = field.largestVoid();
+        field.set(gap, true);
+        if (gap == cluster) break;
+    }
+
+    // Ranks below the initial count: take tightest clusters out of a copy
+    std::vector<int> rank(count, 0);
+    EnergyField thinning = field;
+    for (int r = initial - 1; r >= 0; --r) {
+        int cluster = thinning.tightestCluster();
+        thinning.set(cluster, false);
+        rank[cluster] = r;
+    }
+
+    // The rest: fill the largest voids. Past half full this is the tightest
+    // cluster of the empty texels, as the toroidal kernel sums to a constant.
+    for (int r = initial; r < count; ++r) {
+        int gap = field.largestVoid();
+        field.set(gap, true);
+        rank[gap] = r;
+    }
+
+    std::vector<float> mask(count);
+    for (int i = 0; i < count; ++i) mask[i] = (static_cast<float>(rank[i]) + 0.5f) / static_cast<float>(count);
+    return mask;
+}
+
+void BlueNoise::init()
+{
+    PROFILE_FUNCTION();
+    std::vector<float> first = generate(SIZE, 1u);
+    std::vector<float> second = generate(SIZE, 2u);
+    std::vector<uint16_t> data(static_cast<size_t>(SIZE) * SIZE * 2);
+    texels.resize(static_cast<size_t>(SIZE) * SIZE);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        data[i * 2] = static_cast<uint16_t>(first[i] * 65535.0f + 0.5f);
+        data[i * 2 + 1] = static_cast<uint16_t>(second[i] * 65535.0f + 0.5f);
+        texels[i] = glm::vec2(data[i * 2], data[i * 2 + 1]) / 65535.0f;
+    }
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG16, SIZE, SIZE);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SIZE, SIZE, GL_RG, GL_UNSIGNED_SHORT, data.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    MemoryStats::trackGLTexture(texture, MemoryTag::GpuTexture, data.size() * sizeof(uint16_t));
+}
+
+void BlueNoise::cleanup()
+{
+    freeGLTexture(texture);
+    texels.clear();
+}
+
+glm::vec2 BlueNoise::shift(int x, int y, uint32_t frame) const
+{
+    if (texels.empty()) return fract(Sampling::r2(frame));
+    const glm::vec2& mask = texels[(y & (SIZE - 1)) * SIZE + (x & (SIZE - 1))];
+    return fract(mask + Sampling::r2(frame));
+}
+
+void BlueNoise::bind(const Shader& shader, GLuint unit, uint32_t frame) const
+{
+    shader.setInt("u_blueNoise", static_cast<int>(unit));
+    shader.setUint("u_noiseFrame", frame);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Sampling::measureAoConvergence(const OctreeQuery& scene, const PathTraceCamera& camera, const BlueNoise& noise,
+                                    int width, int height, int pixelLimit, int trials,
+                                    std::vector<AoErrorPoint>& out)
+{
+    PROFILE_FUNCTION();
+    using Sampling::MAX_AO_SAMPLES;
+    out.clear();
+    if (scene.empty() || width <= 0 || height <= 0 || pixelLimit <= 0 || trials < 2) return;
+    const float aspect = static_cast<float>(width) / static_cast<float>(height);
+
+    // Hit points on a regular grid of pixels over the view
+    struct HitPoint {
+        glm::vec3 position;
+        glm::vec3 normal;
+        int x, y;
+    };
+    int stride = 1;
+    while (static_cast<int64_t>((width + stride - 1) / stride) * ((height + stride - 1) / stride) > pixelLimit) ++stride;
+    std::vector<HitPoint> points;
+    for (int y = stride / 2; y < height; y += stride) {
+        for (int x = stride / 2; x < width; x += stride) {
+            glm::vec2 uv = (glm::vec2(static_cast<float>(x), static_cast<float>(y)) + 0.5f) /
+                           glm::vec2(static_cast<float>(width), static_cast<float>(height));
+            glm::vec3 rd = camera.ray(uv, aspect);
+            RayHit hit = scene.raycast(camera.position, rd);
+            if (hit.hit && hit.normal != glm::vec3(0.0f))
+                points.push_back({camera.position + rd * hit.distance, hit.normal, x, y});
+        }
+    }
+    if (points.empty()) return;
+
+    // Estimates after 1, 2, 4, ... rays
+    int levels = 0;
+    while ((1 << levels) <= MAX_AO_SAMPLES) ++levels;
+    constexpr int ESTIMATORS = 3;
+    auto slot = [&](size_t point, int estimator, int level) {
+        return (point * ESTIMATORS + estimator) * levels + level;
+    };
+    std::vector<double> variance(points.size() * ESTIMATORS * levels, 0.0);
+
+    JobSystem::instance().parallelFor(0, points.size(), 16, [&](size_t begin, size_t end) {
+        std::vector<float> estimates(static_cast<size_t>(trials) * ESTIMATORS * levels);
+        for (size_t p = begin; p < end; ++p) {
+            const HitPoint& point = points[p];
+            const glm::vec3 origin = point.position + point.normal * AO_RAY_OFFSET;
+            auto occluded = [&](const glm::vec3& dir) { return scene.anyHit(origin, dir, Sampling::AO_RADIUS); };
+            const float cellSeed = glm::dot(glm::floor(point.position), glm::vec3(127.1f, 311.7f, 74.7f));
+
+            for (int t = 0; t < trials; ++t) {
+                float* hashOut = &estimates[(static_cast<size_t>(t) * ESTIMATORS + 0) * levels];
+                float* randomOut = &estimates[(static_cast<size_t>(t) * ESTIMATORS + 1) * levels];
+                float* sequenceOut = &estimates[(static_cast<size_t>(t) * ESTIMATORS + 2) * levels];
+                uint32_t rng = static_cast<uint32_t>(p) * 0x9E3779B9u ^ static_cast<uint32_t>(t) * 0x85EBCA6Bu;
+                pcg(rng);
+                const glm::vec2 shift = noise.shift(point.x, point.y, static_cast<uint32_t>(t));
+                float hashSum = 0.0f, weight = 1.0f;
+                int randomHits = 0, sequenceHits = 0;
+                for (int i = 0, level = 0; i < MAX_AO_SAMPLES; ++i) {
+                    // Former ao(): sin hash, flipped into the hemisphere, halving weights
+                    float fi = static_cast<float>(i + t * MAX_AO_SAMPLES) + cellSeed;
+                    glm::vec3 dir(fract(std::sin(fi * 12.9898f) * 43758.5453f) * 2.0f - 1.0f,
+                                  fract(std::sin(fi * 78.233f) * 43758.5453f) * 2.0f - 1.0f,
+                                  fract(std::sin(fi * 45.164f) * 43758.5453f) * 2.0f - 1.0f);
+                    if (glm::dot(dir, dir) > 0.0f) {
+                        dir = glm::normalize(dir);
+                        if (glm::dot(dir, point.normal) < 0.0f) dir = -dir;
+                        if (occluded(dir)) hashSum += weight;
+                    }
+                    weight *= 0.5f;
+
+                    glm::vec2 u(random01(rng), random01(rng));
+                    if (occluded(Sampling::cosineHemisphere(u, point.normal))) ++randomHits;
+                    if (occluded(Sampling::cosineHemisphere(fract(Sampling::sobol(static_cast<uint32_t>(i)) + shift),
+                                                            point.normal))) ++sequenceHits;
+
+                    if (i + 1 == (1 << level)) {
+                        const float rays = static_cast<float>(i + 1);
+                        hashOut[level] = std::min(hashSum, 1.0f);
+                        randomOut[level] = static_cast<float>(randomHits) / rays;
+                        sequenceOut[level] = static_cast<float>(sequenceHits) / rays;
+                        ++level;
+                    }
+                }
+            }
+
+            // Sample variance over the trials
+            for (int e = 0; e < ESTIMATORS; ++e) {
+                for (int level = 0; level < levels; ++level) {
+                    double mean = 0.0;
+                    for (int t = 0; t < trials; ++t) mean += estimates[(static_cast<size_t>(t) * ESTIMATORS + e) * levels + level];
+                    mean /= trials;
+                    double sum = 0.0;
+                    for (int t = 0; t < trials; ++t) {
+                        double d = estimates[(static_cast<size_t>(t) * ESTIMATORS + e) * levels + level] - mean;
+                        sum += d * d;
+                    }
+                    variance[slot(p, e, level)] = sum / (trials - 1);
+                }
+            }
+        }
+    });
+
+    for (int level = 0; level < levels; ++level) {
+        double sums[ESTIMATORS] = {};
+        for (size_t p = 0; p < points.size(); ++p) {
+            for (int e = 0; e < ESTIMATORS; ++e) sums[e] += variance[slot(p, e, level)];
+        }
+        const double count = static_cast<double>(points.size());
+        out.push_back({1 << level, std::sqrt(sums[0] / count), std::sqrt(sums[1] / count), std::sqrt(sums[2] / count)});
+    }
+}
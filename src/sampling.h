@@ -0,0 +1,129 @@
+/**
+ * Sampling
+ *
+ * Sample points for the ray caster's AO rays; sampling.glsl mirrors the
+ * functions in Sampling, keep the two in step. A ray set is the first points
+ * of a 2D Sobol sequence, rotated modulo 1 by a shift (Cranley-Patterson)
+ * and mapped to cosine-distributed directions, so each set stays stratified
+ * however it is shifted. The shift comes from a blue noise mask per pixel,
+ * offset by the R2 sequence per frame, so neighbouring pixels get different
+ * rays and the remaining error is high-frequency noise that the AO denoiser
+ * removes easily; the per-voxel AO of the forward path shifts by a hash of
+ * the voxel cell instead.
+ *
+ * BlueNoise generates the masks at init with void-and-cluster (Ulichney
+ * 1993): every texel gets a rank such that each threshold of the ranks is a
+ * well-spread point set.
+ */
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "octree_query.h"
+#include "shader.h"
+
+struct PathTraceCamera;
+
+// Texture unit of u_blueNoise (sampling.glsl)
+constexpr GLuint BLUE_NOISE_TEXTURE_UNIT = 1;
+
+namespace Sampling {
+
+constexpr float AO_RADIUS = 4.0f;   // Hits further away do not occlude
+constexpr int MAX_AO_SAMPLES = 16;  // As in raycast_common.glsl
+
+/**
+ * Point index of the first two Sobol dimensions in [0, 1)^2; every
+ * power-of-two prefix is stratified
+ */
+glm::vec2 sobol(uint32_t index);
+
+/**
+ * Point index of the R2 sequence (Roberts 2018) in [0, 1)^2, in 32-bit fixed
+ * point so large indices keep their precision
+ */
+glm::vec2 r2(uint32_t index);
+
+/**
+ * Shift of a voxel cell's ray set, from a hash of its integer coordinates
+ */
+glm::vec2 cellShift(const glm::vec3& cell);
+
+/**
+ * Orthonormal basis around n (Duff et al. 2017)
+ */
+void basis(const glm::vec3& n, glm::vec3& t, glm::vec3& b);
+
+/**
+ * Map u in [0, 1)^2 to a direction around n with density cos(theta) / pi
+ */
+glm::vec3 cosineHemisphere(const glm::vec2& u, const glm::vec3& n);
+
+} // namespace Sampling
+
+class BlueNoise {
+public:
+    static constexpr int SIZE = 64; // Texels per side, a power of two
+
+    BlueNoise();
+    ~BlueNoise();
+
+    /**
+     * Void-and-cluster rank mask of size x size texels (size a power of two),
+     * as (rank + 0.5) / texels, row by row
+     */
+    static std::vector<float> generate(int size, uint32_t seed);
+
+    /**
+     * Generate the two masks and upload them as one rg16 texture
+     */
+    void init();
+    void cleanup();
+
+    /**
+     * The masks at a pixel (wrapped) as the shaders read them, plus the R2
+     * offset of frame, modulo 1
+     */
+    glm::vec2 shift(int x, int y, uint32_t frame) const;
+
+    /**
+     * Bind the texture to unit and set u_blueNoise and u_noiseFrame
+     */
+    void bind(const Shader& shader, GLuint unit, uint32_t frame) const;
+
+private:
+    std::vector<glm::vec2> texels;  // As uploaded (16-bit unorm)
+    GLuint texture;
+};
+
+/**
+ * RMS error of an AO estimator after samples rays per pixel
+ */
+struct AoErrorPoint {
+    int samples;
+    double hashError;       // Sin-hash directions flipped into the hemisphere, halving weights (AO before Sampling)
+    double randomError;     // Cosine-distributed directions from independent random numbers
+    double sequenceError;   // Sobol points shifted by the blue noise mask, as aoPixel()
+};
+
+namespace Sampling {
+
+/**
+ * Measure AO convergence on the CPU over the scene octree: hit points of a
+ * width x height view (at most pixelLimit of them, spread over the view) are
+ * estimated with each estimator at 1, 2, 4, ... MAX_AO_SAMPLES rays, once for
+ * every one of trials independent seeds (scramble frames for the blue noise
+ * sequence). The error is the deviation from the mean over those trials, so
+ * it measures noise alone; the cosine-weighted estimators share one
+ * expectation, the hash estimator has its own.
+ */
+void measureAoConvergence(const OctreeQuery& scene, const PathTraceCamera& camera, const BlueNoise& noise,
+                          int width, int height, int pixelLimit, int trials, std::vector<AoErrorPoint>& out);
+
+} // namespace Sampling
+
+#endif // SAMPLING_H
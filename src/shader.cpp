@@ -1,4 +1,5 @@
 #include "shader.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -34,6 +35,24 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char* computePath)
+{
+    std::string computeCode = readFile(computePath);
+    const char* cShaderCode = computeCode.c_str();
+
+    GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+
+    glDeleteShader(compute);
+}
+
 Shader::~Shader()
 {
     glDeleteProgram(ID);
@@ -54,6 +73,11 @@ void Shader::setInt(const std::string& name, int value) const
     glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setUint(const std::string& name, unsigned int value) const
+{
+    glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+}
+
 void Shader::setFloat(const std::string& name, float value) const
 {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
@@ -107,6 +131,48 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type)
 }
 
 std::string Shader::readFile(const char* filePath)
+{
+    std::vector<std::string> chain;
+    std::set<std::string> included;
+    return readFile(filePath, chain, included);
+}
+
+namespace {
+
+// Nested includes deeper than this are reported instead of expanded
+constexpr size_t MAX_INCLUDE_DEPTH = 16;
+
+// Lexically resolve "." and "dir/.." so one file always gets the same key
+std::string normalizePath(const std::string& path)
+{
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= path.size())
+    {
+        size_t end = path.find_first_of("/\\", begin);
+        if (end == std::string::npos) end = path.size();
+        std::string part = path.substr(begin, end - begin);
+        if (part == ".." && !parts.empty() && parts.back() != ".." && !parts.back().empty())
+            parts.pop_back();
+        else if (part != "." && (!part.empty() || parts.empty()))
+            parts.push_back(part);
+        begin = end + 1;
+    }
+    std::string out;
+    for (size_t i = 0; i < parts.size(); ++i) out += (i ? "/" : "") + parts[i];
+    return out;
+}
+
+std::string includeChain(const std::vector<std::string>& chain, const std::string& last)
+{
+    std::string out;
+    for (const std::string& file : chain) out += file + " -> ";
+    return out + last;
+}
+
+} // namespace
+
+std::string Shader::readFile(const char* filePath, std::vector<std::string>& chain, std::set<std::string>& included)
 {
     std::string content;
     std::ifstream fileStream;
@@ -124,7 +190,44 @@ std::string Shader::readFile(const char* filePath)
     catch (std::ifstream::failure& e)
     {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << std::endl;
+        return content;
     }
 
-    return content;
+    // Expand #include "file" lines (paths relative to the including file) so
+    // shaders can share GLSL code, e.g. the octree traversal. Every file is
+    // expanded once per shader, as with #pragma once; a cycle or too deep a
+    // nesting becomes an #error so the compile log shows the include chain.
+    std::string path = normalizePath(filePath);
+    chain.push_back(path);
+    included.insert(path);
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+    std::istringstream lines(content);
+    std::string expanded;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close != std::string::npos)
+            {
+                std::string target = normalizePath(directory + line.substr(open + 1, close - open - 1));
+                if (std::find(chain.begin(), chain.end(), target) != chain.end())
+                    expanded += "#error include cycle: " + includeChain(chain, target);
+                else if (chain.size() >= MAX_INCLUDE_DEPTH)
+                    expanded += "#error includes nested deeper than " + std::to_string(MAX_INCLUDE_DEPTH) + ": " +
+                                includeChain(chain, target);
+                else if (included.count(target) == 0)
+                    expanded += readFile(target.c_str(), chain, included);
+                expanded += '\n';
+                continue;
+            }
+        }
+        expanded += line;
+        expanded += '\n';
+    }
+    chain.pop_back();
+    return expanded;
 }
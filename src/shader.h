@@ -3,7 +3,9 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <set>
 #include <string>
+#include <vector>
 
 class Shader
 {
@@ -11,11 +13,13 @@ public:
     GLuint ID;
 
     Shader(const char* vertexPath, const char* fragmentPath);
+    explicit Shader(const char* computePath);
     ~Shader();
 
     void use() const;
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
+    void setUint(const std::string& name, unsigned int value) const;
     void setFloat(const std::string& name, float value) const;
     void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
@@ -25,6 +29,8 @@ public:
 private:
     void checkCompileErrors(GLuint shader, const std::string& type);
     std::string readFile(const char* filePath);
+    // chain: files being expanded, outermost first; included: every file expanded so far
+    std::string readFile(const char* filePath, std::vector<std::string>& chain, std::set<std::string>& included);
 };
 
 #endif // SHADER_H
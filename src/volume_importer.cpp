@@ -0,0 +1,489 @@
+/**
+ * Dense Volume Importer Implementation
+ */
+
+#include "volume_importer.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// ============================================================================
+// Memory-mapped file
+// ============================================================================
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filepath) {
+#ifdef _WIN32
+        file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open volume: " + filepath);
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        bytes = static_cast<size_t>(fileSize.QuadPart);
+        if (bytes == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) ptr = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Failed to open volume: " + filepath);
+        struct stat st;
+        fstat(fd, &st);
+        bytes = static_cast<size_t>(st.st_size);
+        if (bytes == 0) return;
+        void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) ptr = static_cast<const uint8_t*>(p);
+#endif
+        if (!ptr) {
+            close();
+            throw std::runtime_error("Failed to map volume: " + filepath);
+        }
+    }
+
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return bytes; }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap(const_cast<uint8_t*>(ptr), bytes);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        ptr = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    const uint8_t* ptr = nullptr;
+    size_t bytes = 0;
+};
+
+// ============================================================================
+// Volume access
+// ============================================================================
+
+/**
+ * Dense grid, x fastest then y then z
+ */
+struct DenseVolume {
+    const uint8_t* data = nullptr;
+    glm::ivec3 dims = glm::ivec3(0);
+    VolumeImporter::SampleType type = VolumeImporter::SampleType::UInt8;
+    bool bigEndian = false;
+
+    uint32_t sample(int x, int y, int z) const {
+        size_t i = (static_cast<size_t>(z) * dims.y + y) * dims.x + x;
+        if (type == VolumeImporter::SampleType::UInt8) return data[i];
+        const uint8_t* p = data + 2 * i;
+        return bigEndian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]);
+    }
+};
+
+std::string lowerString(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string lowerExtension(const std::string& filepath) {
+    size_t dot = filepath.find_last_of('.');
+    return dot == std::string::npos ? std::string() : lowerString(filepath.substr(dot + 1));
+}
+
+/**
+ * Find "WxHxD" and a sample type in a file name like "head_256x256x113_uint16.raw"
+ */
+bool parseRawName(const std::string& filepath, glm::ivec3& dims, VolumeImporter::SampleType& type) {
+    size_t slash = filepath.find_last_of("/\\");
+    std::string name = lowerString(slash == std::string::npos ? filepath : filepath.substr(slash + 1));
+
+    type = (name.find("uint16") != std::string::npos || name.find("u16") != std::string::npos ||
+            name.find("16bit") != std::string::npos)
+        ? VolumeImporter::SampleType::UInt16 : VolumeImporter::SampleType::UInt8;
+
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(name[i])) || (i > 0 && std::isdigit(static_cast<unsigned char>(name[i - 1])))) continue;
+        int w, h, d;
+        if (std::sscanf(name.c_str() + i, "%dx%dx%d", &w, &h, &d) == 3 && w > 0 && h > 0 && d > 0) {
+            dims = glm::ivec3(w, h, d);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Decode a .binvox file (run-length encoded 0/1 cells) into x-fastest order
+ */
+std::vector<uint8_t> decodeBinvox(const MappedFile& file, glm::ivec3& dims) {
+    const char* p = reinterpret_cast<const char*>(file.data());
+    const char* end = p + file.size();
+    if (file.size() < 8 || std::strncmp(p, "#binvox", 7) != 0) {
+        throw std::runtime_error("Invalid binvox header");
+    }
+
+    // Header lines up to "data"
+    int d = 0, h = 0, w = 0;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!nl) throw std::runtime_error("Invalid binvox header");
+        std::string line(p, nl);
+        p = nl + 1;
+        if (line.compare(0, 3, "dim") == 0) std::sscanf(line.c_str() + 3, "%d %d %d", &d, &h, &w);
+        else if (line.compare(0, 4, "data") == 0) break;
+    }
+    if (d <= 0 || h <= 0 || w <= 0) throw std::runtime_error("Invalid binvox dimensions");
+
+    // binvox order: index = x * (w * h) + z * w + y, y fastest
+    dims = glm::ivec3(d, w, h);
+    std::vector<uint8_t> dense(static_cast<size_t>(d) * w * h, 0);
+    size_t index = 0, total = dense.size();
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(p);
+    const uint8_t* uend = reinterpret_cast<const uint8_t*>(end);
+    while (u + 1 < uend && index < total) {
+        uint8_t value = u[0];
+        size_t count = std::min<size_t>(u[1], total - index);
+        u += 2;
+        if (value) {
+            for (size_t k = index; k < index + count; ++k) {
+                int y = static_cast<int>(k % w);
+                int z = static_cast<int>((k / w) % h);
+                int x = static_cast<int>(k / (static_cast<size_t>(w) * h));
+                dense[(static_cast<size_t>(z) * dims.y + y) * dims.x + x] = 1;
+            }
+        }
+        index += count;
+    }
+    return dense;
+}
+
+// ============================================================================
+// Level-order octree construction
+// ============================================================================
+
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8)  & 0x100f00f00f00f00full;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2)  & 0x1249249249249249ull;
+    return v;
+}
+
+uint64_t compactBits(uint64_t v) {
+    v &= 0x1249249249249249ull;
+    v = (v ^ (v >> 2))  & 0x10c30c30c30c30c3ull;
+    v = (v ^ (v >> 4))  & 0x100f00f00f00f00full;
+    v = (v ^ (v >> 8))  & 0x1f0000ff0000ffull;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffffull;
+    v = (v ^ (v >> 32)) & 0x1fffff;
+    return v;
+}
+
+// Octant bit order of octree.h: x = bit 0, y = bit 1, z = bit 2
+inline uint64_t morton(const glm::ivec3& c) {
+    return spreadBits(c.x) | spreadBits(c.y) << 1 | spreadBits(c.z) << 2;
+}
+
+inline glm::ivec3 unmorton(uint64_t m) {
+    return glm::ivec3(static_cast<int>(compactBits(m)), static_cast<int>(compactBits(m >> 1)),
+                      static_cast<int>(compactBits(m >> 2)));
+}
+
+struct Entry {
+    uint64_t code;      // Morton code at this entry's level
+    GPUNode node;       // firstChild relative to the kept list of the level below
+    uint32_t payload;   // Brick index for brick roots
+};
+
+using EntryLevel = std::vector<Entry>;
+
+/**
+ * Build the parent level of `children` (sorted by code). Children that are
+ * merged into a leaf parent are removed from `children`.
+ */
+void reduceLevel(EntryLevel& children, EntryLevel& parents, bool mergeUniform) {
+    parents.clear();
+    EntryLevel kept;
+    kept.reserve(children.size());
+
+    for (size_t i = 0; i < children.size();) {
+        uint64_t parentCode = children[i].code >> 3;
+        size_t j = i;
+        uint32_t mask = 0;
+        bool uniform = true;
+        while (j < children.size() && (children[j].code >> 3) == parentCode) {
+            mask |= 1u << (children[j].code & 7u);
+            uniform = uniform && nodeIsLeaf(children[j].node) && children[j].node.color == children[i].node.color;
+            ++j;
+        }
+
+        Entry parent;
+        parent.code = parentCode;
+        parent.payload = 0;
+        if (mergeUniform && uniform && mask == 0xFFu) {
+            parent.node = GPUNode{0u, children[i].node.color};
+        } else {
+            parent.node = GPUNode{static_cast<uint32_t>(kept.size()) << 8 | mask, 0u};
+            kept.insert(kept.end(), children.begin() + static_cast<std::ptrdiff_t>(i),
+                        children.begin() + static_cast<std::ptrdiff_t>(j));
+        }
+        parents.push_back(parent);
+        i = j;
+    }
+    children.swap(kept);
+}
+
+/**
+ * Transfer function lookup: packed color per sample value, 0 = empty
+ */
+std::vector<uint32_t> buildTransferLUT(const VolumeImporter::Options& options, VolumeImporter::SampleType type) {
+    uint32_t maxValue = type == VolumeImporter::SampleType::UInt8 ? 0xFFu : 0xFFFFu;
+    uint32_t windowMax = options.windowMax ? std::min(options.windowMax, maxValue) : maxValue;
+    int levels = std::clamp(options.paletteSize, 1, 255);
+
+    std::vector<uint32_t> lut(maxValue + 1, 0u);
+    for (uint32_t v = options.threshold; v <= maxValue; ++v) {
+        float t = windowMax > options.threshold
+            ? std::min(1.0f, static_cast<float>(v - options.threshold) / static_cast<float>(windowMax - options.threshold))
+            : 1.0f;
+        float level = levels > 1 ? std::round(t * (levels - 1)) / (levels - 1) : 1.0f;
+        glm::vec4 color = glm::mix(options.lowColor, options.highColor, level);
+        color.a = 1.0f;     // keeps every solid color non-zero
+        lut[v] = packColor(color);
+    }
+    return lut;
+}
+
+} // namespace
+
+// ============================================================================
+// VolumeImporter
+// ============================================================================
+
+bool VolumeImporter::isVolumeFile(const std::string& filepath) {
+    std::string ext = lowerExtension(filepath);
+    return ext == "raw" || ext == "binvox";
+}
+
+VolumeImporter::Result VolumeImporter::import(const std::string& filepath, const Options& options) {
+    PROFILE_FUNCTION();
+    Result result;
+    MappedFile file(filepath);
+
+    DenseVolume volume;
+    Options effective = options;
+    std::vector<uint8_t> decoded;
+
+    if (lowerExtension(filepath) == "binvox") {
+        PROFILE_ZONE("Decode binvox");
+        decoded = decodeBinvox(file, volume.dims);
+        volume.data = decoded.data();
+        volume.type = SampleType::UInt8;
+        // Cells are 0/1: one solid color
+        effective.threshold = 1;
+        effective.windowMax = 1;
+    } else {
+        volume.dims = options.dims;
+        volume.type = options.type;
+        if (volume.dims.x <= 0 || volume.dims.y <= 0 || volume.dims.z <= 0) {
+            if (!parseRawName(filepath, volume.dims, volume.type)) {
+                throw std::runtime_error("Unknown raw volume dimensions (expected e.g. name_256x256x256_uint8.raw): " + filepath);
+            }
+        }
+        size_t sampleBytes = volume.type == SampleType::UInt8 ? 1 : 2;
+        size_t needed = static_cast<size_t>(options.headerBytes) +
+                        static_cast<size_t>(volume.dims.x) * volume.dims.y * volume.dims.z * sampleBytes;
+        if (file.size() < needed) {
+            throw std::runtime_error("Raw volume is smaller than its dimensions: " + filepath);
+        }
+        volume.data = file.data() + options.headerBytes;
+        volume.bigEndian = options.bigEndian;
+    }
+    result.dims = volume.dims;
+
+    const glm::ivec3 dims = volume.dims;
+    const std::vector<uint32_t> lut = buildTransferLUT(effective, volume.type);
+
+    // Octree extent: power of two covering the longest axis
+    int levels = 0;
+    while ((1 << levels) < std::max(dims.x, std::max(dims.y, dims.z))) ++levels;
+    if (levels > OCTREE_MAX_DEPTH) {
+        throw std::runtime_error("Volume exceeds the maximum octree depth: " + filepath);
+    }
+    const int brickLevels = std::min(levels, 5);      // log2(BRICK_SIZE)
+    const int topLevels = levels - brickLevels;
+    const int brick = 1 << brickLevels;
+
+    // Bricks that intersect the volume, in Morton order
+    glm::ivec3 brickGrid = (dims + brick - 1) / brick;
+    std::vector<uint64_t> brickCodes;
+    brickCodes.reserve(static_cast<size_t>(brickGrid.x) * brickGrid.y * brickGrid.z);
+    for (int z = 0; z < brickGrid.z; ++z)
+        for (int y = 0; y < brickGrid.y; ++y)
+            for (int x = 0; x < brickGrid.x; ++x)
+                brickCodes.push_back(morton(glm::ivec3(x, y, z)));
+    std::sort(brickCodes.begin(), brickCodes.end());
+
+    // Local Morton order inside a brick
+    const size_t brickCells = static_cast<size_t>(brick) * brick * brick;
+    std::vector<glm::ivec3> localCell(brickCells);
+    for (size_t m = 0; m < brickCells; ++m) localCell[m] = unmorton(m);
+
+    // Reduce every brick to a subtree: bricks[b][k] = level k below the brick root
+    std::vector<std::vector<EntryLevel>> bricks(brickCodes.size());
+    std::atomic<size_t> solidCount{0};
+    {
+        PROFILE_ZONE("Volume bricks");
+        JobSystem::instance().parallelFor(0, brickCodes.size(), 1, [&](size_t bb, size_t be) {
+            // Brick plus a one-cell apron for the hollow test
+            const int apron = brick + 2;
+            std::vector<uint32_t> colors(static_cast<size_t>(apron) * apron * apron);
+            auto at = [&](int x, int y, int z) -> uint32_t& {
+                return colors[(static_cast<size_t>(z + 1) * apron + (y + 1)) * apron + (x + 1)];
+            };
+
+            for (size_t bi = bb; bi < be; ++bi) {
+                glm::ivec3 origin = unmorton(brickCodes[bi]) * brick;
+                size_t solid = 0;
+
+                for (int z = -1; z <= brick; ++z)
+                    for (int y = -1; y <= brick; ++y)
+                        for (int x = -1; x <= brick; ++x) {
+                            glm::ivec3 c = origin + glm::ivec3(x, y, z);
+                            bool inside = glm::all(glm::greaterThanEqual(c, glm::ivec3(0))) && glm::all(glm::lessThan(c, dims));
+                            at(x, y, z) = inside ? lut[volume.sample(c.x, c.y, c.z)] : 0u;
+                        }
+
+                EntryLevel finest;
+                for (size_t m = 0; m < brickCells; ++m) {
+                    glm::ivec3 l = localCell[m];
+                    uint32_t color = at(l.x, l.y, l.z);
+                    if (!color) continue;
+                    ++solid;
+                    if (effective.hollow && at(l.x - 1, l.y, l.z) && at(l.x + 1, l.y, l.z) &&
+                        at(l.x, l.y - 1, l.z) && at(l.x, l.y + 1, l.z) &&
+                        at(l.x, l.y, l.z - 1) && at(l.x, l.y, l.z + 1)) continue;
+                    finest.push_back(Entry{m, GPUNode{0u, color}, 0u});
+                }
+                solidCount += solid;
+                if (finest.empty()) continue;
+
+                auto& brickTree = bricks[bi];
+                brickTree.resize(brickLevels + 1);
+                brickTree[brickLevels].swap(finest);
+                for (int k = brickLevels - 1; k >= 0; --k) {
+                    reduceLevel(brickTree[k + 1], brickTree[k], effective.mergeUniform);
+                }
+            }
+        });
+    }
+    result.solidCount = solidCount.load();
+
+    // Top levels above the bricks; level topLevels holds the brick roots
+    std::vector<EntryLevel> top(topLevels + 1);
+    for (size_t bi = 0; bi < bricks.size(); ++bi) {
+        if (!bricks[bi].empty()) top[topLevels].push_back(Entry{brickCodes[bi], bricks[bi][0][0].node, static_cast<uint32_t>(bi)});
+    }
+    for (int d = topLevels - 1; d >= 0; --d) {
+        reduceLevel(top[d + 1], top[d], effective.mergeUniform);
+    }
+
+    const glm::ivec3 center = dims / 2;
+    result.boundsMin = glm::vec3(-center);
+    result.boundsMax = result.boundsMin + glm::vec3(static_cast<float>(1 << levels));
+    if (top[topLevels].empty()) {
+        std::cout << "Volume " << dims.x << "x" << dims.y << "x" << dims.z << " has no cells above the threshold" << std::endl;
+        return result;
+    }
+
+    // Stitch: global level topLevels + k is the concatenation of the kept
+    // bricks' level k, in brick Morton order
+    PROFILE_ZONE("Volume stitch");
+    const EntryLevel& roots = top[topLevels];
+    const int totalLevels = levels + 1;
+    std::vector<size_t> levelStart(totalLevels + 1, 0);
+    std::vector<std::vector<size_t>> brickOffset(brickLevels + 1, std::vector<size_t>(roots.size() + 1, 0));
+    for (int k = 1; k <= brickLevels; ++k) {
+        for (size_t j = 0; j < roots.size(); ++j) {
+            const auto& tree = bricks[roots[j].payload];
+            size_t n = nodeIsLeaf(roots[j].node) ? 0 : tree[k].size();
+            brickOffset[k][j + 1] = brickOffset[k][j] + n;
+        }
+    }
+    for (int d = 0; d < totalLevels; ++d) {
+        size_t n = d <= topLevels ? top[d].size() : brickOffset[d - topLevels][roots.size()];
+        levelStart[d + 1] = levelStart[d] + n;
+    }
+    if (levelStart[totalLevels] >= (1u << 24)) {
+        throw std::runtime_error("Volume octree exceeds 2^24 nodes; raise the threshold or enable hollow");
+    }
+
+    auto relocate = [](GPUNode node, size_t base) {
+        if (!nodeIsLeaf(node)) node.childMask += static_cast<uint32_t>(base) << 8;
+        return node;
+    };
+
+    result.nodes.resize(levelStart[totalLevels]);
+    for (int d = 0; d < topLevels; ++d) {
+        for (size_t i = 0; i < top[d].size(); ++i) {
+            result.nodes[levelStart[d] + i] = relocate(top[d][i].node, levelStart[d + 1]);
+        }
+    }
+
+    JobSystem::instance().parallelFor(0, roots.size(), 64, [&](size_t jb, size_t je) {
+        for (size_t j = jb; j < je; ++j) {
+            const auto& tree = bricks[roots[j].payload];
+            result.nodes[levelStart[topLevels] + j] =
+                relocate(roots[j].node, brickLevels > 0 ? levelStart[topLevels + 1] + brickOffset[1][j] : 0);
+            // A root merged into a leaf at the brick level keeps no descendants
+            if (nodeIsLeaf(roots[j].node)) continue;
+            for (int k = 1; k <= brickLevels; ++k) {
+                size_t dst = levelStart[topLevels + k] + brickOffset[k][j];
+                size_t childBase = k < brickLevels ? levelStart[topLevels + k + 1] + brickOffset[k + 1][j] : 0;
+                for (size_t i = 0; i < tree[k].size(); ++i) {
+                    result.nodes[dst + i] = relocate(tree[k][i].node, childBase);
+                }
+            }
+        }
+    });
+
+    std::cout << "Volume " << dims.x << "x" << dims.y << "x" << dims.z << ": " << result.solidCount
+              << " solid cells -> " << result.nodes.size() << " octree nodes" << std::endl;
+    return result;
+}
@@ -0,0 +1,72 @@
+/**
+ * Dense Volume Importer
+ *
+ * Loads scanned volumes (CT/MRI style raw uint8/uint16 grids, and .binvox)
+ * and builds the flattened octree (GPUNode layout, see octree.h) directly
+ * from the dense grid, without a per-voxel Voxel list.
+ *
+ * - raw files are memory-mapped; dimensions and sample type come from
+ *   Options or from the file name ("head_256x256x113_uint16.raw")
+ * - a threshold / window transfer function maps samples to a color ramp
+ *   quantized to paletteSize entries; samples below the threshold are empty
+ * - the grid is cut into BRICK_SIZE^3 bricks that are reduced to subtrees in
+ *   parallel; the bricks are then stitched under the top levels in level order
+ * - optional: interior cells (all 6 neighbors solid) are dropped and eight
+ *   equal leaves are merged into one larger leaf
+ */
+
+#ifndef VOLUME_IMPORTER_H
+#define VOLUME_IMPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "octree.h"
+
+class VolumeImporter {
+public:
+    static constexpr int BRICK_SIZE = 32;
+
+    enum class SampleType { UInt8, UInt16 };
+
+    struct Options {
+        glm::ivec3 dims = glm::ivec3(0);    // 0: parse from the file name
+        SampleType type = SampleType::UInt8; // Used when dims are given explicitly
+        bool bigEndian = false;
+        uint64_t headerBytes = 0;           // Bytes to skip before the samples
+
+        // Transfer function
+        uint32_t threshold = 1;             // Samples below are empty
+        uint32_t windowMax = 0;             // Sample mapped to highColor; 0: type maximum
+        int paletteSize = 255;
+        glm::vec4 lowColor = glm::vec4(0.25f, 0.2f, 0.2f, 1.0f);
+        glm::vec4 highColor = glm::vec4(1.0f, 0.95f, 0.85f, 1.0f);
+
+        // Drop cells hidden behind 6 solid neighbors: a much smaller octree that
+        // renders the same, but edits and CSG cut into an empty interior
+        bool hollow = false;
+        bool mergeUniform = true;           // Merge 8 equal leaves into their parent
+    };
+
+    struct Result {
+        GPUNodeList nodes;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        glm::ivec3 dims = glm::ivec3(0);
+        size_t solidCount = 0;              // Cells at or above the threshold
+    };
+
+    /**
+     * @return true for .raw and .binvox files
+     */
+    static bool isVolumeFile(const std::string& filepath);
+
+    /**
+     * Load a volume and build its octree; voxels are centered on the origin
+     * @throws std::runtime_error on I/O errors, unknown dimensions or when the
+     *         octree exceeds the 24-bit child index
+     */
+    static Result import(const std::string& filepath, const Options& options);
+};
+
+#endif // VOLUME_IMPORTER_H
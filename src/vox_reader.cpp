@@ -3,10 +3,12 @@
  */
 
 #include "vox_reader.h"
+#include "profiler.h"
 #include <fstream>
 #include <iostream>
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
 #include <stdexcept>
 
 // Magic number for VOX files
@@ -23,8 +25,10 @@ static constexpr char CHUNK_ID_RGBA[4] = {'R', 'G', 'B', 'A'};
 static constexpr char CHUNK_ID_nTRN[4] = {'n', 'T', 'R', 'N'};
 static constexpr char CHUNK_ID_nGRP[4] = {'n', 'G', 'R', 'P'};
 static constexpr char CHUNK_ID_nSHP[4] = {'n', 'S', 'H', 'P'};
+static constexpr char CHUNK_ID_MATL[4] = {'M', 'A', 'T', 'L'};
 
 VoxFile VoxReader::load(const std::string& filepath) {
+    PROFILE_ZONE("VoxReader::load");
     VoxFile voxFile;
     voxFile.version = 0;
     voxFile.models.clear();
@@ -64,11 +68,15 @@ VoxFile VoxReader::load(const std::string& filepath) {
 
     // Parse children of MAIN chunk
     if (childrenSize > 0) {
+        PROFILE_ZONE("parseMainChunk");
         parseMainChunk(file, voxFile);
     }
 
     file.close();
-    computeModelTransforms(voxFile);
+    {
+        PROFILE_ZONE("computeModelTransforms");
+        computeModelTransforms(voxFile);
+    }
     return voxFile;
 }
 
@@ -200,6 +208,10 @@ void VoxReader::parseMainChunk(std::ifstream& file, VoxFile& voxFile) {
             parseShapeNode(file, voxFile, contentSize);
             if (childrenSize > 0) skipChunkContent(file, childrenSize);
 
+        } else if (std::memcmp(chunkId, CHUNK_ID_MATL, 4) == 0) {
+            parseMaterialChunk(file, voxFile, contentSize);
+            if (childrenSize > 0) skipChunkContent(file, childrenSize);
+
         } else {
             // Unknown chunk - skip content and children
             skipChunkContent(file, contentSize);
@@ -291,7 +303,7 @@ void VoxReader::parseTransformNode(std::ifstream& file, VoxFile& voxFile, uint32
         }
     }
 
-    voxFile.transformNodes[node.nodeId] = node;
+    voxFile.transformNodes.push_back(node);
 
     // Skip any remaining bytes
     auto bytesRead = static_cast<uint32_t>(file.tellg() - startPos);
@@ -313,7 +325,7 @@ void VoxReader::parseGroupNode(std::ifstream& file, VoxFile& voxFile, uint32_t c
         node.childNodeIds[i] = static_cast<int32_t>(readInt32(file));
     }
 
-    voxFile.groupNodes[node.nodeId] = node;
+    voxFile.groupNodes.push_back(node);
 
     auto bytesRead = static_cast<uint32_t>(file.tellg() - startPos);
     if (bytesRead < contentSize) {
@@ -326,6 +338,7 @@ void VoxReader::parseShapeNode(std::ifstream& file, VoxFile& voxFile, uint32_t c
 
     VoxShapeNode node;
     node.nodeId = static_cast<int32_t>(readInt32(file));
+    node.modelId = -1;
     auto attrs = readDict(file);  // node attributes
     (void)attrs;
     uint32_t numModels = readInt32(file);
@@ -335,7 +348,7 @@ void VoxReader::parseShapeNode(std::ifstream& file, VoxFile& voxFile, uint32_t c
         (void)modelAttrs;
     }
     // Skip remaining models if any (spec says numModels must be 1)
-    voxFile.shapeNodes[node.nodeId] = node;
+    voxFile.shapeNodes.push_back(node);
 
     auto bytesRead = static_cast<uint32_t>(file.tellg() - startPos);
     if (bytesRead < contentSize) {
@@ -343,54 +356,144 @@ void VoxReader::parseShapeNode(std::ifstream& file, VoxFile& voxFile, uint32_t c
     }
 }
 
-void VoxReader::walkSceneGraph(const VoxFile& voxFile, int32_t nodeId,
-                                int32_t accTx, int32_t accTy, int32_t accTz,
-                                std::vector<ModelTransform>& out) {
-    // Check if it's a transform node
-    auto tIt = voxFile.transformNodes.find(nodeId);
-    if (tIt != voxFile.transformNodes.end()) {
-        const auto& tn = tIt->second;
-        int32_t newTx = accTx + tn.tx;
-        int32_t newTy = accTy + tn.ty;
-        int32_t newTz = accTz + tn.tz;
-        walkSceneGraph(voxFile, tn.childNodeId, newTx, newTy, newTz, out);
-        return;
+void VoxReader::parseMaterialChunk(std::ifstream& file, VoxFile& voxFile, uint32_t contentSize) {
+    auto startPos = file.tellg();
+
+    VoxMaterial material;
+    material.id = static_cast<int32_t>(readInt32(file));
+    material.properties = readDict(file);
+    voxFile.materials.push_back(material);
+
+    auto bytesRead = static_cast<uint32_t>(file.tellg() - startPos);
+    if (bytesRead < contentSize) {
+        skipChunkContent(file, contentSize - bytesRead);
     }
+}
 
-    // Check if it's a group node
-    auto gIt = voxFile.groupNodes.find(nodeId);
-    if (gIt != voxFile.groupNodes.end()) {
-        for (int32_t childId : gIt->second.childNodeIds) {
-            walkSceneGraph(voxFile, childId, accTx, accTy, accTz, out);
+void VoxReader::densifySceneGraph(VoxFile& voxFile) {
+    struct Entry {
+        int32_t id;
+        VoxNodeRef ref;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(voxFile.transformNodes.size() + voxFile.groupNodes.size() + voxFile.shapeNodes.size());
+    for (size_t i = 0; i < voxFile.transformNodes.size(); ++i)
+        entries.push_back({voxFile.transformNodes[i].nodeId, {VoxNodeType::Transform, static_cast<uint32_t>(i)}});
+    for (size_t i = 0; i < voxFile.groupNodes.size(); ++i)
+        entries.push_back({voxFile.groupNodes[i].nodeId, {VoxNodeType::Group, static_cast<uint32_t>(i)}});
+    for (size_t i = 0; i < voxFile.shapeNodes.size(); ++i)
+        entries.push_back({voxFile.shapeNodes[i].nodeId, {VoxNodeType::Shape, static_cast<uint32_t>(i)}});
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.id < b.id; });
+
+    // Duplicates keep the first node in file order
+    std::vector<Entry> unique;
+    unique.reserve(entries.size());
+    for (const auto& e : entries) {
+        if (!unique.empty() && unique.back().id == e.id) {
+            std::cerr << "Warning: duplicate VOX scene node id " << e.id << " ignored" << std::endl;
+            continue;
         }
+        unique.push_back(e);
+    }
+
+    voxFile.nodes.clear();
+    if (unique.empty()) return;
+    if (unique[0].id != 0) {
+        std::cerr << "Warning: VOX scene graph has no root node, ignoring it" << std::endl;
+        voxFile.transformNodes.clear();
+        voxFile.groupNodes.clear();
+        voxFile.shapeNodes.clear();
         return;
     }
 
-    // Check if it's a shape node
-    auto sIt = voxFile.shapeNodes.find(nodeId);
-    if (sIt != voxFile.shapeNodes.end()) {
-        int32_t modelId = sIt->second.modelId;
-        // Ensure out vector is large enough
-        if (modelId >= static_cast<int32_t>(out.size())) {
-            out.resize(modelId + 1, {0, 0, 0});
+    auto remap = [&](int32_t id) -> int32_t {
+        auto it = std::lower_bound(unique.begin(), unique.end(), id, [](const Entry& e, int32_t v) { return e.id < v; });
+        return (it != unique.end() && it->id == id) ? static_cast<int32_t>(it - unique.begin()) : -1;
+    };
+
+    for (auto& node : voxFile.transformNodes) node.childNodeId = remap(node.childNodeId);
+    for (auto& node : voxFile.groupNodes) {
+        for (auto& child : node.childNodeIds) child = remap(child);
+    }
+    // Dropped duplicates keep id -1 and are unreachable through nodes[]
+    for (auto& node : voxFile.transformNodes) node.nodeId = -1;
+    for (auto& node : voxFile.groupNodes) node.nodeId = -1;
+    for (auto& node : voxFile.shapeNodes) node.nodeId = -1;
+
+    voxFile.nodes.resize(unique.size());
+    for (size_t id = 0; id < unique.size(); ++id) {
+        const VoxNodeRef& ref = unique[id].ref;
+        voxFile.nodes[id] = ref;
+        int32_t dense = static_cast<int32_t>(id);
+        switch (ref.type) {
+            case VoxNodeType::Transform: voxFile.transformNodes[ref.index].nodeId = dense; break;
+            case VoxNodeType::Group:     voxFile.groupNodes[ref.index].nodeId = dense; break;
+            case VoxNodeType::Shape:     voxFile.shapeNodes[ref.index].nodeId = dense; break;
+            default: break;
         }
-        out[modelId] = {accTx, accTy, accTz};
     }
 }
 
 void VoxReader::computeModelTransforms(VoxFile& voxFile) {
     voxFile.modelTransforms.resize(voxFile.models.size(), {0, 0, 0});
 
-    if (voxFile.transformNodes.empty()) {
+    densifySceneGraph(voxFile);
+    if (voxFile.nodes.empty()) {
         // No scene graph — single model, no offset needed
         return;
     }
 
-    // Root node is always node 0
-    std::vector<ModelTransform> computed;
-    walkSceneGraph(voxFile, 0, 0, 0, 0, computed);
-
-    for (size_t i = 0; i < voxFile.models.size() && i < computed.size(); ++i) {
-        voxFile.modelTransforms[i] = computed[i];
+    // Iterative walk from the root (node 0) with accumulated translation.
+    // Every node is entered at most once, which also breaks cycles.
+    struct Frame {
+        int32_t nodeId;
+        int32_t tx, ty, tz;
+        int depth;
+    };
+    std::vector<Frame> stack;
+    std::vector<uint8_t> visited(voxFile.nodes.size(), 0);
+    stack.push_back({0, 0, 0, 0, 0});
+    bool warned = false;
+
+    while (!stack.empty()) {
+        Frame f = stack.back();
+        stack.pop_back();
+        if (f.nodeId < 0 || f.nodeId >= static_cast<int32_t>(voxFile.nodes.size())) continue;
+
+        if (visited[f.nodeId] || f.depth > MAX_SCENE_GRAPH_DEPTH) {
+            if (!warned) {
+                std::cerr << "Warning: VOX scene graph has a cycle, a shared node or is too deep; skipping" << std::endl;
+                warned = true;
+            }
+            continue;
+        }
+        visited[f.nodeId] = 1;
+
+        const VoxNodeRef& ref = voxFile.nodes[f.nodeId];
+        switch (ref.type) {
+            case VoxNodeType::Transform: {
+                const auto& tn = voxFile.transformNodes[ref.index];
+                stack.push_back({tn.childNodeId, f.tx + tn.tx, f.ty + tn.ty, f.tz + tn.tz, f.depth + 1});
+                break;
+            }
+            case VoxNodeType::Group: {
+                // Reverse push keeps the children in file order
+                const auto& children = voxFile.groupNodes[ref.index].childNodeIds;
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    stack.push_back({*it, f.tx, f.ty, f.tz, f.depth + 1});
+                }
+                break;
+            }
+            case VoxNodeType::Shape: {
+                int32_t modelId = voxFile.shapeNodes[ref.index].modelId;
+                if (modelId >= 0 && modelId < static_cast<int32_t>(voxFile.modelTransforms.size())) {
+                    voxFile.modelTransforms[modelId] = {f.tx, f.ty, f.tz};
+                }
+                break;
+            }
+            default:
+                break;
+        }
     }
 }
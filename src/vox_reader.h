@@ -23,6 +23,7 @@
 #include <map>
 #include <cstdint>
 #include <string>
+#include "memory_stats.h"
 
 /**
  * Single voxel with position and color index (VOX file format)
@@ -52,12 +53,27 @@ struct VoxelModel {
     int sizeX;                   // Model X dimension
     int sizeY;                   // Model Y dimension
     int sizeZ;                   // Model Z dimension
-    std::vector<VoxData> voxels; // List of voxels in this model
+    TrackedVector<VoxData, MemoryTag::VoxFile> voxels; // List of voxels in this model
 };
 
 /**
  * Scene graph node types for VOX format
  */
+enum class VoxNodeType : uint8_t {
+    None = 0,   // id not used by the file
+    Transform,
+    Group,
+    Shape
+};
+
+/**
+ * Location of a node in the per-type arrays of VoxFile
+ */
+struct VoxNodeRef {
+    VoxNodeType type;
+    uint32_t index;
+};
+
 struct VoxTransformNode {
     int32_t nodeId;
     int32_t childNodeId;
@@ -75,6 +91,15 @@ struct VoxShapeNode {
     int32_t modelId;
 };
 
+/**
+ * MATL chunk: material properties of one palette index
+ * (e.g. "_type" = "_emit", "_emit" = "0.5", "_rough" = "0.1")
+ */
+struct VoxMaterial {
+    int32_t id;
+    std::map<std::string, std::string> properties;
+};
+
 /**
  * Per-model world-space translation computed from scene graph
  */
@@ -89,11 +114,15 @@ struct VoxFile {
     int version;                            // File version (typically 150 for MagicaVoxel)
     std::vector<VoxelModel> models;         // All models in the file
     std::array<RGBAColor, 256> palette;    // Color palette (index 0 is unused)
-
-    // Scene graph data
-    std::map<int32_t, VoxTransformNode> transformNodes;
-    std::map<int32_t, VoxGroupNode> groupNodes;
-    std::map<int32_t, VoxShapeNode> shapeNodes;
+    std::vector<VoxMaterial> materials;     // MATL chunks, in file order
+
+    // Scene graph data. Node ids are densified on load (root = 0) and
+    // nodes[id] locates each node in the per-type arrays; child ids of
+    // missing nodes become -1.
+    std::vector<VoxNodeRef> nodes;
+    std::vector<VoxTransformNode> transformNodes;
+    std::vector<VoxGroupNode> groupNodes;
+    std::vector<VoxShapeNode> shapeNodes;
     std::vector<ModelTransform> modelTransforms; // World transform per model
 };
 
@@ -118,6 +147,17 @@ public:
      */
     static bool isValidVoxFile(const std::string& filepath);
 
+    /**
+     * Renumber scene graph node ids to 0..n-1 (in id order) and rebuild
+     * VoxFile::nodes. Duplicate ids keep their first node; a graph without a
+     * node 0 (the root) is dropped.
+     * @param voxFile The VoxFile whose per-type node arrays were filled
+     */
+    static void densifySceneGraph(VoxFile& voxFile);
+
+    // Transform chains deeper than this are treated as malformed
+    static constexpr int MAX_SCENE_GRAPH_DEPTH = 1024;
+
 private:
     /**
      * Initialize the default MagicaVoxel palette
@@ -182,10 +222,8 @@ private:
     static void parseTransformNode(std::ifstream& file, VoxFile& voxFile, uint32_t contentSize);
     static void parseGroupNode(std::ifstream& file, VoxFile& voxFile, uint32_t contentSize);
     static void parseShapeNode(std::ifstream& file, VoxFile& voxFile, uint32_t contentSize);
+    static void parseMaterialChunk(std::ifstream& file, VoxFile& voxFile, uint32_t contentSize);
     static void computeModelTransforms(VoxFile& voxFile);
-    static void walkSceneGraph(const VoxFile& voxFile, int32_t nodeId,
-                               int32_t accTx, int32_t accTy, int32_t accTz,
-                               std::vector<ModelTransform>& out);
 };
 
 #endif // VOX_READER_H
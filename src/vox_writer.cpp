@@ -0,0 +1,443 @@
+/**
+ * VOX File Writer Implementation
+ */
+
+#include "vox_writer.h"
+#include "octree.h"
+#include "profiler.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+static constexpr int VOX_VERSION = 150;
+
+namespace {
+
+/**
+ * Growable little-endian byte buffer with chunk framing
+ */
+class ChunkBuffer {
+public:
+    void put32(uint32_t v) {
+        char b[4] = {static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+        bytes.insert(bytes.end(), b, b + 4);
+    }
+
+    void putId(const char id[4]) { bytes.insert(bytes.end(), id, id + 4); }
+
+    void putString(const std::string& s) {
+        put32(static_cast<uint32_t>(s.size()));
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    void putDict(const std::map<std::string, std::string>& dict) {
+        put32(static_cast<uint32_t>(dict.size()));
+        for (const auto& kv : dict) {
+            putString(kv.first);
+            putString(kv.second);
+        }
+    }
+
+    /**
+     * Start a chunk; its content size is patched by endChunk()
+     * @return Offset of the chunk header
+     */
+    size_t beginChunk(const char id[4]) {
+        size_t at = bytes.size();
+        putId(id);
+        put32(0);   // content size
+        put32(0);   // children size
+        return at;
+    }
+
+    void endChunk(size_t at) { patch(at + 4, static_cast<uint32_t>(bytes.size() - at - 12)); }
+
+    /**
+     * Reserve n raw bytes and return a pointer to them
+     */
+    char* grow(size_t n) {
+        size_t at = bytes.size();
+        bytes.resize(at + n);
+        return bytes.data() + at;
+    }
+
+    void patch(size_t at, uint32_t v) {
+        for (int i = 0; i < 4; ++i) bytes[at + i] = static_cast<char>(v >> (8 * i));
+    }
+
+    size_t size() const { return bytes.size(); }
+    const char* data() const { return bytes.data(); }
+    void reserve(size_t n) { bytes.reserve(n); }
+
+private:
+    std::vector<char> bytes;
+};
+
+constexpr char CHUNK_ID_MAIN[4] = {'M', 'A', 'I', 'N'};
+constexpr char CHUNK_ID_SIZE[4] = {'S', 'I', 'Z', 'E'};
+constexpr char CHUNK_ID_XYZI[4] = {'X', 'Y', 'Z', 'I'};
+constexpr char CHUNK_ID_RGBA[4] = {'R', 'G', 'B', 'A'};
+constexpr char CHUNK_ID_nTRN[4] = {'n', 'T', 'R', 'N'};
+constexpr char CHUNK_ID_nGRP[4] = {'n', 'G', 'R', 'P'};
+constexpr char CHUNK_ID_nSHP[4] = {'n', 'S', 'H', 'P'};
+constexpr char CHUNK_ID_MATL[4] = {'M', 'A', 'T', 'L'};
+
+/**
+ * Root transform -> group -> one transform + shape per model
+ */
+void buildFlatSceneGraph(VoxFile& voxFile) {
+    voxFile.transformNodes.clear();
+    voxFile.groupNodes.clear();
+    voxFile.shapeNodes.clear();
+
+    voxFile.transformNodes.push_back(VoxTransformNode{0, 1, -1, 0, 0, 0});
+    VoxGroupNode group{1, {}};
+    for (size_t i = 0; i < voxFile.models.size(); ++i) {
+        int32_t trnId = static_cast<int32_t>(2 + 2 * i);
+        ModelTransform t = i < voxFile.modelTransforms.size() ? voxFile.modelTransforms[i] : ModelTransform{0, 0, 0};
+        voxFile.transformNodes.push_back(VoxTransformNode{trnId, trnId + 1, 0, t.tx, t.ty, t.tz});
+        voxFile.shapeNodes.push_back(VoxShapeNode{trnId + 1, static_cast<int32_t>(i)});
+        group.childNodeIds.push_back(trnId);
+    }
+    voxFile.groupNodes.push_back(group);
+    VoxReader::densifySceneGraph(voxFile);
+}
+
+void writeSceneGraph(ChunkBuffer& out, const VoxFile& voxFile) {
+    // Dense ids, written in id order as MagicaVoxel does
+    const std::map<std::string, std::string> noAttributes;
+    for (const VoxNodeRef& ref : voxFile.nodes) {
+        if (ref.type == VoxNodeType::Transform) {
+            const VoxTransformNode& node = voxFile.transformNodes[ref.index];
+            size_t at = out.beginChunk(CHUNK_ID_nTRN);
+            out.put32(static_cast<uint32_t>(node.nodeId));
+            out.putDict(noAttributes);
+            out.put32(static_cast<uint32_t>(node.childNodeId));
+            out.put32(static_cast<uint32_t>(-1));   // reserved
+            out.put32(static_cast<uint32_t>(node.layerId));
+            out.put32(1);                           // frames
+            std::map<std::string, std::string> frame;
+            if (node.tx || node.ty || node.tz) {
+                // Undo the reader's Y/Z swap
+                frame["_t"] = std::to_string(node.tx) + " " + std::to_string(node.tz) + " " + std::to_string(node.ty);
+            }
+            out.putDict(frame);
+            out.endChunk(at);
+        } else if (ref.type == VoxNodeType::Group) {
+            const VoxGroupNode& node = voxFile.groupNodes[ref.index];
+            size_t at = out.beginChunk(CHUNK_ID_nGRP);
+            out.put32(static_cast<uint32_t>(node.nodeId));
+            out.putDict(noAttributes);
+            out.put32(static_cast<uint32_t>(node.childNodeIds.size()));
+            for (int32_t child : node.childNodeIds) out.put32(static_cast<uint32_t>(child));
+            out.endChunk(at);
+        } else if (ref.type == VoxNodeType::Shape) {
+            const VoxShapeNode& shape = voxFile.shapeNodes[ref.index];
+            size_t at = out.beginChunk(CHUNK_ID_nSHP);
+            out.put32(static_cast<uint32_t>(shape.nodeId));
+            out.putDict(noAttributes);
+            out.put32(1);                           // models
+            out.put32(static_cast<uint32_t>(shape.modelId));
+            out.putDict(noAttributes);
+            out.endChunk(at);
+        }
+    }
+}
+
+uint32_t toRGBA8(const glm::vec4& c) {
+    return packColor(glm::clamp(c, glm::vec4(0.0f), glm::vec4(1.0f)));
+}
+
+RGBAColor toPaletteColor(uint32_t packed) {
+    return RGBAColor{static_cast<uint8_t>(packed >> 24), static_cast<uint8_t>(packed >> 16),
+                     static_cast<uint8_t>(packed >> 8), static_cast<uint8_t>(packed)};
+}
+
+/**
+ * Palette for arbitrary colors: exact when there are at most 255 distinct
+ * colors, otherwise the 255 most common 4-bit-per-channel bins (averaged)
+ * @return Color index (1-255) per packed color
+ */
+std::unordered_map<uint32_t, uint8_t> buildPalette(const VoxelList& voxels, std::array<RGBAColor, 256>& palette) {
+    std::unordered_map<uint32_t, uint32_t> counts;
+    std::vector<uint32_t> firstSeen;
+    for (const auto& v : voxels) {
+        uint32_t c = toRGBA8(v.getColor());
+        if (counts[c]++ == 0) firstSeen.push_back(c);
+    }
+
+    std::unordered_map<uint32_t, uint8_t> index;
+    if (firstSeen.size() <= 255) {
+        for (size_t i = 0; i < firstSeen.size(); ++i) {
+            palette[i] = toPaletteColor(firstSeen[i]);
+            index[firstSeen[i]] = static_cast<uint8_t>(i + 1);
+        }
+        return index;
+    }
+
+    auto binOf = [](uint32_t c) { return ((c >> 28) << 8) | (((c >> 20) & 0xF) << 4) | ((c >> 12) & 0xF); };
+    std::vector<uint64_t> binCount(4096, 0);
+    std::vector<glm::dvec4> binSum(4096, glm::dvec4(0.0));
+    for (const auto& kv : counts) {
+        uint32_t bin = binOf(kv.first);
+        binCount[bin] += kv.second;
+        binSum[bin] += glm::dvec4(unpackColor(kv.first)) * static_cast<double>(kv.second);
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t bin = 0; bin < 4096; ++bin) if (binCount[bin]) order.push_back(bin);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return binCount[a] > binCount[b]; });
+    order.resize(std::min<size_t>(order.size(), 255));
+
+    std::vector<glm::vec3> entries(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        glm::vec4 avg = glm::vec4(binSum[order[i]] / static_cast<double>(binCount[order[i]]));
+        palette[i] = toPaletteColor(toRGBA8(avg));
+        entries[i] = glm::vec3(avg);
+    }
+
+    // Every bin maps to the nearest entry; colors map through their bin
+    std::vector<uint8_t> binIndex(4096, 1);
+    for (uint32_t bin = 0; bin < 4096; ++bin) {
+        glm::vec3 c((bin >> 8) / 15.0f, ((bin >> 4) & 0xF) / 15.0f, (bin & 0xF) / 15.0f);
+        float best = 1e30f;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            glm::vec3 d = entries[i] - c;
+            if (glm::dot(d, d) < best) { best = glm::dot(d, d); binIndex[bin] = static_cast<uint8_t>(i + 1); }
+        }
+    }
+    for (const auto& kv : counts) index[kv.first] = binIndex[binOf(kv.first)];
+    return index;
+}
+
+std::string formatFloat(float v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", v);
+    return buf;
+}
+
+} // namespace
+
+void VoxWriter::save(const std::string& filepath, const VoxFile& voxFile) {
+    PROFILE_FUNCTION();
+
+    size_t voxelCount = 0;
+    for (const auto& model : voxFile.models) voxelCount += model.voxels.size();
+
+    ChunkBuffer out;
+    out.reserve(1024 + voxFile.models.size() * 64 + voxelCount * 4 + 2048);
+
+    out.putId("VOX ");
+    out.put32(static_cast<uint32_t>(voxFile.version > 0 ? voxFile.version : VOX_VERSION));
+    size_t mainAt = out.beginChunk(CHUNK_ID_MAIN);
+
+    for (const auto& model : voxFile.models) {
+        size_t at = out.beginChunk(CHUNK_ID_SIZE);
+        out.put32(static_cast<uint32_t>(model.sizeX));
+        out.put32(static_cast<uint32_t>(model.sizeY));
+        out.put32(static_cast<uint32_t>(model.sizeZ));
+        out.endChunk(at);
+
+        at = out.beginChunk(CHUNK_ID_XYZI);
+        out.put32(static_cast<uint32_t>(model.voxels.size()));
+        char* dst = out.grow(model.voxels.size() * 4);
+        for (const auto& v : model.voxels) {
+            // VOX stores z before y (see VoxReader::parseXYZIChunk)
+            *dst++ = static_cast<char>(v.x);
+            *dst++ = static_cast<char>(v.z);
+            *dst++ = static_cast<char>(v.y);
+            *dst++ = static_cast<char>(v.colorIndex);
+        }
+        out.endChunk(at);
+    }
+
+    if (!voxFile.nodes.empty()) {
+        writeSceneGraph(out, voxFile);
+    } else if (voxFile.models.size() > 1 || !voxFile.modelTransforms.empty()) {
+        VoxFile graph;
+        graph.models.resize(voxFile.models.size());
+        graph.modelTransforms = voxFile.modelTransforms;
+        buildFlatSceneGraph(graph);
+        writeSceneGraph(out, graph);
+    }
+
+    size_t at = out.beginChunk(CHUNK_ID_RGBA);
+    char* dst = out.grow(256 * 4);
+    for (const auto& c : voxFile.palette) {
+        *dst++ = static_cast<char>(c.r);
+        *dst++ = static_cast<char>(c.g);
+        *dst++ = static_cast<char>(c.b);
+        *dst++ = static_cast<char>(c.a);
+    }
+    out.endChunk(at);
+
+    for (const auto& material : voxFile.materials) {
+        at = out.beginChunk(CHUNK_ID_MATL);
+        out.put32(static_cast<uint32_t>(material.id));
+        out.putDict(material.properties);
+        out.endChunk(at);
+    }
+
+    // MAIN has no content; everything after its header is children
+    out.patch(mainAt + 8, static_cast<uint32_t>(out.size() - mainAt - 12));
+
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open VOX file for writing: " + filepath);
+    }
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write VOX file: " + filepath);
+    }
+
+    std::cout << "Saved " << voxelCount << " voxels in " << voxFile.models.size() << " models to "
+              << filepath << " (" << out.size() / 1024 << " KB)" << std::endl;
+}
+
+VoxFile VoxWriter::fromVoxels(const VoxelList& voxels) {
+    PROFILE_FUNCTION();
+    VoxFile voxFile;
+    voxFile.version = VOX_VERSION;
+    voxFile.palette.fill(RGBAColor{0, 0, 0, 255});
+    if (voxels.empty()) return voxFile;
+
+    // Keep the original palette when every voxel carries a consistent index
+    // (VOX loads, palettized imports); otherwise quantize the colors.
+    // Index c uses palette[c - 1], as in loadVoxFile().
+    std::vector<int64_t> indexColor(256, -1);
+    bool keepIndices = true;
+    for (const auto& v : voxels) {
+        uint8_t ci = v.getColorIndex();
+        int64_t c = toRGBA8(v.getColor());
+        if (ci == 0 || (indexColor[ci] >= 0 && indexColor[ci] != c)) { keepIndices = false; break; }
+        indexColor[ci] = c;
+    }
+
+    std::unordered_map<uint32_t, uint8_t> colorIndex;
+    if (keepIndices) {
+        for (int ci = 1; ci < 256; ++ci) {
+            if (indexColor[ci] >= 0) voxFile.palette[ci - 1] = toPaletteColor(static_cast<uint32_t>(indexColor[ci]));
+        }
+    } else {
+        colorIndex = buildPalette(voxels, voxFile.palette);
+    }
+    auto indexOf = [&](const Voxel& v) {
+        return keepIndices ? v.getColorIndex() : colorIndex.at(toRGBA8(v.getColor()));
+    };
+
+    // Materials from the first voxel of each index with non-default properties
+    std::vector<bool> materialDone(256, false);
+    for (const auto& v : voxels) {
+        uint8_t ci = indexOf(v);
+        if (materialDone[ci]) continue;
+        materialDone[ci] = true;
+        VoxMaterial material{ci, {}};
+        if (v.isEmissive()) {
+            material.properties["_type"] = "_emit";
+            material.properties["_emit"] = formatFloat(v.getEmission());
+        } else if (v.getMetallic() > 0.0f) {
+            material.properties["_type"] = "_metal";
+            material.properties["_metal"] = formatFloat(v.getMetallic());
+            material.properties["_rough"] = formatFloat(v.getRoughness());
+        } else {
+            continue;
+        }
+        voxFile.materials.push_back(material);
+    }
+
+    // Split into MAX_MODEL_SIZE^3 models on a grid anchored at the minimum
+    glm::ivec3 bmin(INT_MAX);
+    for (const auto& v : voxels) bmin = glm::min(bmin, v.getPosition());
+
+    std::unordered_map<uint64_t, size_t> modelOfChunk;
+    std::vector<glm::ivec3> chunkOrigin;
+    std::vector<glm::ivec3> chunkExtent;
+    std::vector<size_t> voxelModel(voxels.size());
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        glm::ivec3 chunk = (voxels[i].getPosition() - bmin) / MAX_MODEL_SIZE;
+        uint64_t key = static_cast<uint64_t>(chunk.x) | static_cast<uint64_t>(chunk.y) << 21 | static_cast<uint64_t>(chunk.z) << 42;
+        auto it = modelOfChunk.find(key);
+        if (it == modelOfChunk.end()) {
+            it = modelOfChunk.emplace(key, chunkOrigin.size()).first;
+            chunkOrigin.push_back(bmin + chunk * MAX_MODEL_SIZE);
+            chunkExtent.push_back(glm::ivec3(0));
+            voxFile.models.push_back(VoxelModel{0, 0, 0, {}});
+        }
+        size_t m = it->second;
+        voxelModel[i] = m;
+        chunkExtent[m] = glm::max(chunkExtent[m], voxels[i].getPosition() - chunkOrigin[m] + 1);
+    }
+
+    std::vector<size_t> modelCounts(voxFile.models.size(), 0);
+    for (size_t m : voxelModel) modelCounts[m]++;
+    for (size_t m = 0; m < voxFile.models.size(); ++m) voxFile.models[m].voxels.reserve(modelCounts[m]);
+
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        size_t m = voxelModel[i];
+        glm::ivec3 local = voxels[i].getPosition() - chunkOrigin[m];
+        voxFile.models[m].voxels.push_back(VoxData{static_cast<uint8_t>(local.x), static_cast<uint8_t>(local.y),
+                                                   static_cast<uint8_t>(local.z), indexOf(voxels[i])});
+    }
+
+    // Y and Z share one size: loadVoxFile() centers internal y with sizeY while
+    // MagicaVoxel uses the file's z size, and equal sizes satisfy both
+    voxFile.modelTransforms.resize(voxFile.models.size());
+    for (size_t m = 0; m < voxFile.models.size(); ++m) {
+        VoxelModel& model = voxFile.models[m];
+        model.sizeX = chunkExtent[m].x;
+        model.sizeY = model.sizeZ = std::max(chunkExtent[m].y, chunkExtent[m].z);
+        glm::ivec3 t = chunkOrigin[m] + glm::ivec3(model.sizeX / 2, model.sizeY / 2, model.sizeZ / 2);
+        voxFile.modelTransforms[m] = ModelTransform{t.x, t.y, t.z};
+    }
+    buildFlatSceneGraph(voxFile);
+    return voxFile;
+}
+
+bool VoxWriter::verify(const std::string& filepath, const VoxFile& expected) {
+    PROFILE_FUNCTION();
+    VoxFile loaded;
+    try {
+        loaded = VoxReader::load(filepath);
+    } catch (const std::exception& e) {
+        std::cerr << "VOX verify: " << e.what() << std::endl;
+        return false;
+    }
+
+    auto fail = [&](const std::string& what) {
+        std::cerr << "VOX verify failed for " << filepath << ": " << what << std::endl;
+        return false;
+    };
+
+    if (loaded.models.size() != expected.models.size()) return fail("model count");
+    for (size_t m = 0; m < expected.models.size(); ++m) {
+        const VoxelModel& a = expected.models[m];
+        const VoxelModel& b = loaded.models[m];
+        if (a.sizeX != b.sizeX || a.sizeY != b.sizeY || a.sizeZ != b.sizeZ) return fail("size of model " + std::to_string(m));
+        if (a.voxels.size() != b.voxels.size() ||
+            (!a.voxels.empty() && std::memcmp(a.voxels.data(), b.voxels.data(), a.voxels.size() * sizeof(VoxData)) != 0)) {
+            return fail("voxels of model " + std::to_string(m));
+        }
+    }
+    if (std::memcmp(loaded.palette.data(), expected.palette.data(), sizeof(RGBAColor) * 256) != 0) return fail("palette");
+
+    if (loaded.materials.size() != expected.materials.size()) return fail("material count");
+    for (size_t i = 0; i < expected.materials.size(); ++i) {
+        if (loaded.materials[i].id != expected.materials[i].id ||
+            loaded.materials[i].properties != expected.materials[i].properties) {
+            return fail("material " + std::to_string(expected.materials[i].id));
+        }
+    }
+
+    for (size_t m = 0; m < expected.models.size(); ++m) {
+        ModelTransform a = m < expected.modelTransforms.size() ? expected.modelTransforms[m] : ModelTransform{0, 0, 0};
+        const ModelTransform& b = loaded.modelTransforms[m];
+        if (a.tx != b.tx || a.ty != b.ty || a.tz != b.tz) return fail("transform of model " + std::to_string(m));
+    }
+
+    std::cout << "VOX verify passed: " << filepath << std::endl;
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * VOX File Writer
+ *
+ * Writes MagicaVoxel .vox files readable by VoxReader and MagicaVoxel:
+ * SIZE/XYZI per model, the scene graph (nTRN/nGRP/nSHP), RGBA and MATL.
+ * Every chunk is serialized into one in-memory buffer and written with a
+ * single bulk write.
+ *
+ * fromVoxels() converts a runtime VoxelList (imported, voxelized or edited)
+ * into a VoxFile: colors are mapped to a 255-entry palette and the voxels are
+ * split into models of at most MAX_MODEL_SIZE^3, each placed by its own
+ * transform node under one group.
+ */
+
+#ifndef VOX_WRITER_H
+#define VOX_WRITER_H
+
+#include <string>
+#include "vox_reader.h"
+#include "voxel.h"
+
+class VoxWriter {
+public:
+    static constexpr int MAX_MODEL_SIZE = 256;
+
+    /**
+     * Write a VOX file. Stored scene graph nodes (VoxFile::nodes) are written as they are;
+     * without them a flat graph is generated from modelTransforms.
+     * @param filepath Destination path
+     * @param voxFile Models, palette, materials and scene graph to write
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void save(const std::string& filepath, const VoxFile& voxFile);
+
+    /**
+     * Build a VoxFile from runtime voxels
+     * @param voxels Voxels in renderer coordinates (y up, may be negative)
+     * @return VoxFile whose loadVoxFile() positions equal the input positions
+     *         up to the common centering offset
+     */
+    static VoxFile fromVoxels(const VoxelList& voxels);
+
+    /**
+     * Reload a written file with VoxReader and compare it with what was saved
+     * @return true if models, voxels, palette, materials and model transforms match
+     */
+    static bool verify(const std::string& filepath, const VoxFile& expected);
+};
+
+#endif // VOX_WRITER_H
@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <glm/glm.hpp>
+#include "memory_stats.h"
 
 /**
  * Voxel class representing a single volumetric pixel
@@ -41,6 +42,7 @@ public:
     // Convert to/from VOX file format
     void setFromVoxFormat(uint8_t x, uint8_t y, uint8_t z, uint8_t colorIndex, const glm::vec4& paletteColor);
     uint8_t getColorIndex() const { return colorIndex; }
+    void setColorIndex(uint8_t index) { colorIndex = index; }
 
     // Material properties
     float getEmission() const { return emission; }
@@ -67,4 +69,11 @@ private:
     float metallic;         // Metallic property [0.0, 1.0]
 };
 
+/**
+ * Scene voxel list; counted under MemoryTag::Voxels unless constructed with
+ * another tag, e.g. VoxelList(VoxelAllocator(MemoryTag::OctreeBuild))
+ */
+using VoxelAllocator = TrackedAllocator<Voxel, MemoryTag::Voxels>;
+using VoxelList = std::vector<Voxel, VoxelAllocator>;
+
 #endif // VOXEL_H
@@ -1,84 +1,33 @@
 #include "voxel_renderer.h"
+#include "gl_utils.h"
+#include "profiler.h"
 #include <iostream>
 #include <cstring>
+#include <climits>
+#include <algorithm>
 #include <memory>
-#include <queue>
-constexpr int MAX_DEPTH = 16;
-
-bool allPointsSameColor(const std::vector<Voxel>& points) {
-    if (points.empty()) return true;
-    glm::vec4 firstColor = points[0].getColor();
-    for (const auto& p : points) {
-        if (p.getColor() != firstColor) {
-            return false;
-        }
-    }
-    return true;
-}
-
-// build tree in [min, max]
-std::shared_ptr<OctreeNode> buildOctree(const std::vector<Voxel>& points, glm::vec3 min, glm::vec3 max, int depth) {
-    if (points.empty()) return nullptr;
-
-    auto node = std::make_shared<OctreeNode>();
-
-    // leaf: create leaf when node size reaches voxel resolution (1x1x1) or at max depth
-    float nodeSize = max.x - min.x;
-    if (depth >= MAX_DEPTH || nodeSize <= 1.0f) {
-        node->leaf = true;
-        node->color = points[0].getColor();
-        return node;
-    }
-
-    glm::vec3 center = (min + max) * 0.5f;
-    // distribute points to 8 sub-cubes
-    std::vector<Voxel> subPoints[8];
-    for (const auto& p : points) {
-        glm::vec3 pos = glm::vec3(p.getPosition());
-        int idx = (pos.x >= center.x ? 1 : 0) |
-                  (pos.y >= center.y ? 2 : 0) |
-                  (pos.z >= center.z ? 4 : 0);
-        subPoints[idx].push_back(p);
-    }
-
-    for (int i = 0; i < 8; ++i) {
-        glm::vec3 subMin = min, subMax = max;
-
-        subMin.x = (i & 1) ? center.x : min.x;
-        subMax.x = (i & 1) ? max.x : center.x;
-        subMin.y = (i & 2) ? center.y : min.y;
-        subMax.y = (i & 2) ? max.y : center.y;
-        subMin.z = (i & 4) ? center.z : min.z;
-        subMax.z = (i & 4) ? max.z : center.z;
-
-        node->children[i] = buildOctree(subPoints[i], subMin, subMax, depth + 1);
-        if (node->children[i]) {
-            node->childMask |= (1 << i);
-        }
-    }
-    return node;
-}
-
-void VoxelRenderer::buildOctreeFromVoxels(const std::vector<Voxel>& points) {
+#include <string>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+// Spare node slots allocated with every full octree upload for brush edits
+constexpr size_t OCTREE_EDIT_SLACK = 1 << 16;
+
+// Side of the voxel list chunks culled by the point splat backend
+constexpr int VOXEL_CHUNK_SIZE = 32;
+
+// Debris fall acceleration in voxels/s^2, and the largest step between collision tests
+constexpr float DEBRIS_GRAVITY = 60.0f;
+constexpr float DEBRIS_STEP = 0.5f;
+// Bisection steps closing the gap between landed debris and the surface
+constexpr int DEBRIS_CONTACT_ITERATIONS = 4;
+
+void VoxelRenderer::buildOctreeFromVoxels(const VoxelList& points) {
+    PROFILE_FUNCTION();
     if (points.empty()) return;
 
-    // Compute per-axis bounding box
-    glm::vec3 bmin(1e9f), bmax(-1e9f);
-    for (const auto& v : points) {
-        glm::vec3 pos = glm::vec3(v.getPosition());
-        bmin = glm::min(bmin, pos);
-        bmax = glm::max(bmax, pos);
-    }
-
-    // Each voxel at integer position P occupies [P, P+1), so the octree must cover
-    // [bmin, bmax+1). Round the extent up to a power of two and keep min integer-aligned
-    // so that every subdivision boundary falls on an integer — matching voxel grid coords.
-    float extent = glm::max(glm::max(bmax.x - bmin.x + 1.0f, bmax.y - bmin.y + 1.0f), bmax.z - bmin.z + 1.0f);
-    float pot = 1.0f;
-    while (pot < extent) pot *= 2.0f;
-
-    octreeBoundsMin = glm::floor(bmin);
-    octreeBoundsMax = octreeBoundsMin + glm::vec3(pot);
+    computeOctreeBounds(points, octreeBoundsMin, octreeBoundsMax);
 
     std::cout << "Build info: " << points.size() << " voxels, octree bounds ["
               << octreeBoundsMin.x << ", " << octreeBoundsMax.x << "]" << std::endl;
@@ -86,78 +35,67 @@ void VoxelRenderer::buildOctreeFromVoxels(const std::vector<Voxel>& points) {
     auto octreeRoot = buildOctree(points, octreeBoundsMin, octreeBoundsMax, 0);
     if (!octreeRoot) return;
 
-    octreeData.clear();
-
-    // Helper function to pack color into uint32_t (RGBA8)
-    auto packColor = [](const glm::vec4& color) -> uint32_t {
-        uint8_t r = static_cast<uint8_t>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f);
-        uint8_t g = static_cast<uint8_t>(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f);
-        uint8_t b = static_cast<uint8_t>(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f);
-        uint8_t a = static_cast<uint8_t>(glm::clamp(color.a, 0.0f, 1.0f) * 255.0f);
-        return (r << 24) | (g << 16) | (b << 8) | a;
-    };
+    flattenOctree(octreeRoot, octreeData);
+}
 
-    // BFS: collect nodes in level-order, track each node's index in octreeData
-    // and which octreeData slot needs its childMask updated with the first child index.
-    struct QueueEntry {
-        std::shared_ptr<OctreeNode> node;
-        uint32_t selfIdx; // index in octreeData for this node
+const RenderBackendDesc& backendDesc(RenderBackend backend) {
+    static const RenderBackendDesc descs[static_cast<int>(RenderBackend::Count)] = {
+        {"Ray casting",           false, true,  false},
+        {"Point splat (debug)",   true,  false, false},
+        {"Chunk meshes (raster)", false, false, true},
+        {"Path tracing (progressive)", false, true, false},
     };
-
-    std::queue<QueueEntry> queue;
-
-    // Allocate root slot
-    octreeData.push_back(GPUNode{0, 0});
-    QueueEntry rootEntry;
-    rootEntry.node = octreeRoot;
-    rootEntry.selfIdx = 0;
-    queue.push(rootEntry);
-
-    while (!queue.empty()) {
-        QueueEntry entry = queue.front();
-        queue.pop();
-
-        octreeData[entry.selfIdx].color = packColor(entry.node->color);
-
-        if (entry.node->leaf) {
-            // Leaf: childMask stays 0
-            octreeData[entry.selfIdx].childMask = 0;
-        } else {
-            // Allocate contiguous slots for all existing children
-            uint32_t firstChildIdx = static_cast<uint32_t>(octreeData.size());
-
-            for (int i = 0; i < 8; ++i) {
-                if (entry.node->children[i]) {
-                    uint32_t childSlot = static_cast<uint32_t>(octreeData.size());
-                    octreeData.push_back(GPUNode{0, 0});
-
-                    QueueEntry childEntry;
-                    childEntry.node = entry.node->children[i];
-                    childEntry.selfIdx = childSlot;
-                    queue.push(childEntry);
-                }
-            }
-
-            // Encode: upper 24 bits = first child index, lower 8 bits = existence mask
-            octreeData[entry.selfIdx].childMask = (firstChildIdx << 8) | static_cast<uint32_t>(entry.node->childMask);
-        }
-    }
+    return descs[static_cast<int>(backend)];
 }
 
 VoxelRenderer::VoxelRenderer()
     : shader(nullptr)
+    , pointShader(nullptr)
     , VAO(0)
     , VBO(0)
+    , emptyVAO(0)
     , ssbo(0)
     , octreeSSBO(0)
+    , debrisSSBO(0)
+    , backend(RenderBackend::RayCast)
     , cameraPos(0.0f, 0.0f, 5.0f)
     , cameraTarget(0.0f, 0.0f, 0.0f)
     , fov(45.0f)
-    , voxelDataDirty(true)
-    , octreeDataDirty(false)
     , shadow(true)
     , aoSampleCount(4)
     , useVoxelColor(true)
+    , lowMemoryMode(false)
+    , gpuOctreeBuild(false)
+    , editBudgetMs(4.0f)
+    , detachDebris(true)
+    , viewCulling(true)
+    , cullDistance(0.0f)
+    , occlusionCulling(true)
+    , edgeSamples(4)
+    , deferredShading(true)
+    , aoDenoiseIterations(3)
+    , animateNoise(false)
+    , coneTracedGI(false)
+    , giSlicesPerFrame(8)
+    , giStrength(1.0f)
+    , coneDistance(64.0f)
+    , lights{{glm::vec3(1.0f, 1.0f, -1.0f), glm::vec3(1.0f)},
+             {glm::vec3(-1.0f, 0.5f, 1.0f), glm::vec3(0.35f, 0.4f, 0.55f)},
+             {glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.3f)},
+             {glm::vec3(1.0f, 0.2f, 1.0f), glm::vec3(0.5f, 0.35f, 0.2f)}}
+    , lightCount(1)
+    , noiseFrame(0)
+    , octreeBuiltOnGpu(false)
+    , voxelCount(0)
+    , voxelDataDirty(true)
+    , octreeDataDirty(false)
+    , octreeGpuCapacity(0)
+    , octreeEdited(false)
+    , debrisDataDirty(false)
+    , debrisCheckPending(false)
+    , debrisRegionValid(false)
+    , debrisRegionMin(0)
+    , debrisRegionMax(0)
 {
 }
 
@@ -169,20 +107,35 @@ VoxelRenderer::~VoxelRenderer()
 void VoxelRenderer::init(const std::string& vertShader, const std::string& fragShader)
 {
     shader = new Shader(vertShader.c_str(), fragShader.c_str());
+    pointShader = new Shader("assets/shaders/point_splat.vert", "assets/shaders/point_splat.frag");
     setupQuad();
-
-    // Create SSBO for voxel data (binding point 0)
-    glGenBuffers(1, &ssbo);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * 4, nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glGenVertexArrays(1, &emptyVAO);
+    gpuBuilder.init();
+    chunkMeshes.init();
+    hiz.init();
+    debrisOcclusion.init(MAX_DEBRIS_OBJECTS);
+    edgeAA.init();
+    deferred.init();
+    pathTracer.init();
+    blueNoise.init();
+    radiance.init();
+
+    // The flat voxel SSBO (binding point 0) is created on demand by
+    // uploadVoxelData() for backends that consume it.
 
     // Create SSBO for octree data (binding point 1)
     glGenBuffers(1, &octreeSSBO);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeSSBO);
     glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * 4, nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, octreeSSBO);
+    MemoryStats::trackGLBuffer(octreeSSBO, MemoryTag::GpuOctreeBuffer, sizeof(int) * 4);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OCTREE_BINDING, octreeSSBO);
+
+    // Debris octrees (binding point 2), empty until an edit detaches something
+    glGenBuffers(1, &debrisSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, debrisSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * 4, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(debrisSSBO, MemoryTag::GpuOctreeBuffer, sizeof(int) * 4);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEBRIS_BINDING, debrisSSBO);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
     std::cout << "VoxelRenderer initialized" << std::endl;
@@ -205,6 +158,7 @@ void VoxelRenderer::setupQuad()
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    MemoryStats::trackGLBuffer(VBO, MemoryTag::GpuOther, sizeof(quadVertices));
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -214,6 +168,11 @@ void VoxelRenderer::setupQuad()
 void VoxelRenderer::uploadVoxelData()
 {
     if (!voxelDataDirty) return;
+    if (!backendDesc(backend).usesVoxelList) return;
+    PROFILE_FUNCTION();
+
+    if (ssbo == 0) glGenBuffers(1, &ssbo);
+    buildVoxelChunks();
 
     // SSBO layout: [int voxelCount, int pad0, int pad1, int pad2, GPUVoxel[] voxels]
     int count = static_cast<int>(voxelData.size());
@@ -222,6 +181,7 @@ void VoxelRenderer::uploadVoxelData()
 
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
     glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(ssbo, MemoryTag::GpuVoxelBuffer, dataSize);
 
     // Upload count
     glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &count);
@@ -234,82 +194,781 @@ void VoxelRenderer::uploadVoxelData()
 
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     voxelDataDirty = false;
+
+    if (lowMemoryMode) releaseCpuMirrors();
 }
 
 void VoxelRenderer::uploadOctreeData()
 {
-    if (!octreeDataDirty) return;
-    if (octreeData.empty()) return;
+    if (!octreeDataDirty && !editor.hasDirty()) return;
+    PROFILE_FUNCTION();
 
-    int count = static_cast<int>(octreeData.size());
+    int count = editor.rootEmpty() ? 0 : static_cast<int>(octreeData.size());
     size_t headerSize = sizeof(int) * 4;
-    size_t dataSize = headerSize + octreeData.size() * sizeof(GPUNode);
+
+    // Edits that still fit in the reserved slack upload only the nodes they wrote
+    if (!octreeDataDirty && octreeData.size() <= octreeGpuCapacity) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &count);
+        for (const NodeRange& range : editor.takeDirtyRanges()) {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, headerSize + range.begin * sizeof(GPUNode),
+                            (range.end - range.begin) * sizeof(GPUNode), octreeData.data() + range.begin);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return;
+    }
+    // Full upload covers any pending edit ranges
+    editor.takeDirtyRanges();
+    if (octreeData.empty()) {
+        // Nothing to draw (e.g. an empty CSG result): just clear the node count
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &count);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        octreeGpuCapacity = 0;
+        octreeDataDirty = false;
+        return;
+    }
+    octreeGpuCapacity = octreeData.size() + octreeData.size() / 8 + OCTREE_EDIT_SLACK;
+    size_t dataSize = headerSize + octreeGpuCapacity * sizeof(GPUNode);
 
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, octreeSSBO);
     glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(octreeSSBO, MemoryTag::GpuOctreeBuffer, dataSize);
     glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &count);
     glBufferSubData(GL_SHADER_STORAGE_BUFFER, headerSize, octreeData.size() * sizeof(GPUNode), octreeData.data());
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
     octreeDataDirty = false;
+
+    if (lowMemoryMode) releaseCpuMirrors();
+}
+
+void VoxelRenderer::uploadDebrisData()
+{
+    // Debris of a discarded redo branch can never come back
+    auto dropped = [this](const Debris& d) { return editor.versionState(d.version) == OctreeEditor::VersionState::Dropped; };
+    size_t before = debris.size();
+    debris.erase(std::remove_if(debris.begin(), debris.end(), dropped), debris.end());
+    if (debris.size() != before) debrisDataDirty = true;
+
+    if (!debrisDataDirty) return;
+    PROFILE_FUNCTION();
+
+    // SSBO layout as the octree: [int nodeCount, 3 pads, GPUNode[]], every piece's
+    // child indices rebased onto where its nodes land
+    GPUNodeList packed;
+    for (Debris& d : debris) {
+        uint32_t base = static_cast<uint32_t>(packed.size());
+        d.gpuRoot = base;
+        for (const GPUNode& node : d.nodes) {
+            packed.push_back(nodeIsLeaf(node) ? node : GPUNode{node.childMask + (base << 8), node.color});
+        }
+    }
+    int count = static_cast<int>(packed.size());
+    size_t headerSize = sizeof(int) * 4;
+    size_t dataSize = headerSize + packed.size() * sizeof(GPUNode);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, debrisSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, nullptr, GL_DYNAMIC_DRAW);
+    MemoryStats::trackGLBuffer(debrisSSBO, MemoryTag::GpuOctreeBuffer, dataSize);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &count);
+    if (!packed.empty()) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, headerSize, packed.size() * sizeof(GPUNode), packed.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    debrisDataDirty = false;
+}
+
+void VoxelRenderer::buildVoxelChunks()
+{
+    PROFILE_FUNCTION();
+    voxelChunks.clear();
+    chunkFirst.clear();
+    chunkCount.clear();
+    if (voxelData.empty()) return;
+
+    // Sort by chunk so each chunk is one contiguous range of the list (21 bits per axis)
+    std::vector<std::pair<uint64_t, uint32_t>> keys(voxelData.size());
+    for (size_t i = 0; i < voxelData.size(); ++i) {
+        glm::ivec3 chunk = glm::ivec3(glm::floor(glm::vec3(voxelData[i].posAndSize) / static_cast<float>(VOXEL_CHUNK_SIZE)));
+        glm::ivec3 biased = (chunk + glm::ivec3(1 << 20)) & glm::ivec3(0x1FFFFF);
+        uint64_t key = (static_cast<uint64_t>(biased.z) << 42) | (static_cast<uint64_t>(biased.y) << 21) |
+                       static_cast<uint64_t>(biased.x);
+        keys[i] = {key, static_cast<uint32_t>(i)};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    TrackedVector<GPUVoxel, MemoryTag::VoxelMirror> sorted;
+    sorted.reserve(voxelData.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i == 0 || keys[i].first != keys[i - 1].first) {
+            chunkFirst.push_back(static_cast<GLint>(i));
+            chunkCount.push_back(0);
+        }
+        ++chunkCount.back();
+        sorted.push_back(voxelData[keys[i].second]);
+    }
+    voxelData.swap(sorted);
+
+    // Tight chunk bounds from the voxels each one holds
+    voxelChunks.reserve(chunkFirst.size());
+    for (size_t c = 0; c < chunkFirst.size(); ++c) {
+        glm::vec3 lo(std::numeric_limits<float>::max());
+        glm::vec3 hi(-std::numeric_limits<float>::max());
+        for (GLint i = chunkFirst[c]; i < chunkFirst[c] + chunkCount[c]; ++i) {
+            glm::vec3 pos = glm::vec3(voxelData[i].posAndSize);
+            lo = glm::min(lo, pos);
+            hi = glm::max(hi, pos + glm::vec3(voxelData[i].posAndSize.w));
+        }
+        voxelChunks.add(lo, hi);
+    }
+}
+
+bool VoxelRenderer::applyBrush(const Brush& brush)
+{
+    if (octreeBuiltOnGpu || lowMemoryMode || octreeData.empty() || !backendDesc(backend).usesOctree) return false;
+    editor.beginStroke(brush, octreeBoundsMin, octreeBoundsMax);
+    octreeEdited = true;
+
+    if (detachDebris && brush.mode == BrushMode::Remove) {
+        glm::ivec3 lo = glm::ivec3(glm::floor(brush.center - glm::vec3(brush.radius)));
+        glm::ivec3 hi = glm::ivec3(glm::ceil(brush.center + glm::vec3(brush.radius)));
+        debrisRegionMin = debrisRegionValid ? glm::min(debrisRegionMin, lo) : lo;
+        debrisRegionMax = debrisRegionValid ? glm::max(debrisRegionMax, hi) : hi;
+        debrisRegionValid = true;
+    }
+    return true;
+}
+
+void VoxelRenderer::findDebris()
+{
+    PROFILE_FUNCTION();
+    debrisCheckPending = false;
+    if (!debrisRegionValid) return;
+    debrisRegionValid = false;
+    if (editor.rootEmpty() || octreeData.empty() || debris.size() >= static_cast<size_t>(MAX_DEBRIS_OBJECTS)) return;
+
+    OctreeComponents::Stats stats;
+    std::vector<OctreeComponents::Detached> pieces = OctreeComponents::findDetached(
+        octreeData.data(), octreeData.size(), octreeBoundsMin, octreeBoundsMax, debrisRegionMin, debrisRegionMax,
+        MAX_DEBRIS_OBJECTS - debris.size(), &stats);
+    if (pieces.empty()) return;
+
+    // The pieces leave the scene in an edit of their own, which their debris follows through undo/redo
+    size_t debrisNodes = 0;
+    for (const Debris& d : debris) debrisNodes += d.nodes.size();
+    size_t detached = 0;
+    for (OctreeComponents::Detached& piece : pieces) {
+        // Child indices in the debris SSBO are 24 bits wide as well
+        if (debrisNodes + piece.nodes.size() > OctreeEditor::MAX_NODES) continue;
+        debrisNodes += piece.nodes.size();
+
+        Brush cut;
+        cut.shape = BrushShape::Mask;
+        cut.mode = BrushMode::Remove;
+        cut.mask = piece.mask;
+        editor.beginStroke(cut, octreeBoundsMin, octreeBoundsMax);
+
+        Debris d;
+        d.boundsMin = piece.boundsMin;
+        d.boundsMax = piece.boundsMax;
+        d.offset = glm::vec3(0.0f);
+        d.velocity = 0.0f;
+        d.resting = false;
+        d.version = editor.nextVersionId();
+        d.gpuRoot = 0;
+        OctreeQuery(piece.nodes.data(), piece.nodes.size(), piece.boundsMin, piece.boundsMax)
+            .collectLeaves(piece.boundsMin, piece.boundsMax, d.leaves);
+        d.nodes = std::move(piece.nodes);
+        debris.push_back(std::move(d));
+        ++detached;
+    }
+    if (detached == 0) return;
+    editor.endEdit(octreeData);
+    debrisDataDirty = true;
+
+    std::cout << "Detached " << detached << " debris pieces (" << stats.passes << " labeling passes, "
+              << stats.regionVoxels << " voxels labeled)" << std::endl;
+}
+
+bool VoxelRenderer::debrisOverlapsScene(const OctreeQuery& scene, size_t index, const glm::vec3& offset) const
+{
+    // Shrunk a little so resting on a face does not count as overlapping
+    const glm::vec3 skin(1e-3f);
+    for (const QueryLeaf& leaf : debris[index].leaves) {
+        glm::vec3 lo = leaf.min + offset;
+        if (scene.overlaps(lo + skin, lo + glm::vec3(leaf.size) - skin)) return true;
+    }
+    return false;
+}
+
+void VoxelRenderer::updateDebris(float deltaTime)
+{
+    if (debris.empty()) return;
+    PROFILE_FUNCTION();
+    OctreeQuery scene = getQuery();
+    float killY = octreeBoundsMin.y - (octreeBoundsMax.y - octreeBoundsMin.y);
+
+    for (size_t i = 0; i < debris.size();) {
+        Debris& d = debris[i];
+        if (d.resting || editor.versionState(d.version) != OctreeEditor::VersionState::Shown) {
+            ++i;
+            continue;
+        }
+
+        d.velocity -= DEBRIS_GRAVITY * deltaTime;
+        float move = d.velocity * deltaTime;
+        int steps = std::max(1, static_cast<int>(std::ceil(std::abs(move) / DEBRIS_STEP)));
+        glm::vec3 step(0.0f, move / static_cast<float>(steps), 0.0f);
+        for (int s = 0; s < steps; ++s) {
+            if (!debrisOverlapsScene(scene, i, d.offset + step)) {
+                d.offset += step;
+                continue;
+            }
+            // Landed somewhere in this step: close most of the gap
+            float lo = 0.0f, hi = 1.0f;
+            for (int k = 0; k < DEBRIS_CONTACT_ITERATIONS; ++k) {
+                float mid = 0.5f * (lo + hi);
+                if (debrisOverlapsScene(scene, i, d.offset + step * mid)) hi = mid;
+                else lo = mid;
+            }
+            d.offset += step * lo;
+            d.velocity = 0.0f;
+            d.resting = true;
+            break;
+        }
+
+        if (d.boundsMax.y + d.offset.y < killY) {
+            debris.erase(debris.begin() + static_cast<std::ptrdiff_t>(i));
+            debrisDataDirty = true;
+            continue;
+        }
+        ++i;
+    }
+}
+
+void VoxelRenderer::wakeDebris()
+{
+    for (Debris& d : debris) d.resting = false;
+}
+
+void VoxelRenderer::clearDebris()
+{
+    if (!debris.empty()) debrisDataDirty = true;
+    debris.clear();
+    debrisCheckPending = false;
+    debrisRegionValid = false;
+}
+
+void VoxelRenderer::stepEdits()
+{
+    PROFILE_FUNCTION();
+    if (editor.needsCompaction(octreeData)) {
+        editor.compact(octreeData);
+        octreeDataDirty = true;
+    }
+    if (editor.busy()) {
+        editor.step(octreeData, editBudgetMs);
+        wakeDebris();
+    }
+    applyVoxelDelta();
+}
+
+void VoxelRenderer::applyVoxelDelta()
+{
+    int64_t count = static_cast<int64_t>(voxelCount) + editor.takeVoxelDelta();
+    voxelCount = static_cast<int>(std::min<int64_t>(std::max<int64_t>(count, 0), INT_MAX));
+}
+
+void VoxelRenderer::endEdit()
+{
+    editor.endEdit(octreeData);
+    if (debrisRegionValid) debrisCheckPending = true;
+}
+
+bool VoxelRenderer::undoEdit()
+{
+    if (!editor.undo(octreeData)) return false;
+    applyVoxelDelta();
+    wakeDebris();
+    return true;
+}
+
+bool VoxelRenderer::redoEdit()
+{
+    if (!editor.redo(octreeData)) return false;
+    applyVoxelDelta();
+    wakeDebris();
+    return true;
+}
+
+bool VoxelRenderer::applyCsg(OctreeCSG::Op op, const OctreeCSG::Operand& other)
+{
+    PROFILE_FUNCTION();
+    if (octreeBuiltOnGpu || lowMemoryMode || octreeData.empty() || !backendDesc(backend).usesOctree || editor.busy())
+        return false;
+
+    OctreeCSG::Operand current;
+    current.nodes = octreeData.data();
+    current.nodeCount = editor.rootEmpty() ? 0 : octreeData.size();
+    current.boundsMin = octreeBoundsMin;
+    current.boundsMax = octreeBoundsMax;
+    OctreeCSG::Result result = OctreeCSG::apply(op, current, other);
+    std::cout << "CSG result: " << result.nodes.size() << " nodes, " << result.solidCount << " voxels" << std::endl;
+
+    // The result is committed as an edit like a brush stroke, so it can be undone;
+    // debris and materials stay
+    if (editor.garbageNodes() > 0 && octreeData.size() + result.nodes.size() > OctreeEditor::MAX_NODES) {
+        editor.compact(octreeData);
+        octreeDataDirty = true;
+    }
+    int64_t voxelChange = static_cast<int64_t>(result.solidCount) - voxelCount;
+    if (!editor.commitTree(octreeData, result.nodes, voxelChange, octreeBoundsMin, octreeBoundsMax.x - octreeBoundsMin.x,
+                           result.boundsMin, result.boundsMax.x - result.boundsMin.x))
+        throw std::runtime_error("CSG result and edit history exceed the 24-bit octree child index");
+    applyVoxelDelta();
+    octreeEdited = true;
+    octreeBoundsMin = result.boundsMin;
+    octreeBoundsMax = result.boundsMax;
+    radiance.invalidate();
+    wakeDebris();
+
+    // Subtraction may cut pieces loose anywhere the operand reached
+    if (detachDebris && op == OctreeCSG::Op::Subtract && !editor.rootEmpty()) {
+        debrisRegionMin = glm::ivec3(glm::floor(other.boundsMin));
+        debrisRegionMax = glm::ivec3(glm::ceil(other.boundsMax));
+        debrisRegionValid = true;
+        debrisCheckPending = true;
+    }
+    return true;
+}
+
+bool VoxelRenderer::renderPathReference(int width, int height, int samples, std::vector<glm::vec3>& out) const
+{
+    OctreeQuery scene = getQuery();
+    if (scene.empty()) return false;
+    PathTracer::renderReference(scene, materials, PathTraceCamera{cameraPos, cameraTarget, fov}, lights,
+                                std::min(lightCount, MAX_LIGHTS), useVoxelColor, pathSettings, width, height,
+                                samples, out);
+    return true;
+}
+
+bool VoxelRenderer::measureAoConvergence(int width, int height, std::vector<AoErrorPoint>& out) const
+{
+    OctreeQuery scene = getQuery();
+    if (scene.empty()) return false;
+    Sampling::measureAoConvergence(scene, PathTraceCamera{cameraPos, cameraTarget, fov}, blueNoise, width, height,
+                                   4096, 16, out);
+    return true;
+}
+
+void VoxelRenderer::extractVoxels(VoxelList& out) const
+{
+    out.clear();
+    if (!editor.rootEmpty()) OctreeEditor::extractVoxels(octreeData, octreeBoundsMin, octreeBoundsMax, out);
+
+    // Shown debris is written back into the grid where it is now
+    VoxelList pieceVoxels;
+    for (const Debris& d : debris) {
+        if (editor.versionState(d.version) != OctreeEditor::VersionState::Shown) continue;
+        glm::vec3 offset = glm::round(d.offset);
+        OctreeEditor::extractVoxels(d.nodes, d.boundsMin + offset, d.boundsMax + offset, pieceVoxels);
+        out.insert(out.end(), pieceVoxels.begin(), pieceVoxels.end());
+    }
 }
 
 void VoxelRenderer::render(int width, int height)
 {
-    uploadVoxelData();
-    uploadOctreeData();
+    PROFILE_FUNCTION();
+    const RenderBackendDesc& desc = backendDesc(backend);
+    if (editor.busy() || editor.needsCompaction(octreeData)) stepEdits();
+    if (debrisCheckPending && !editor.busy()) findDebris();
+    const bool sceneChanged = octreeDataDirty || editor.hasDirty() || debrisDataDirty;
+    if (desc.usesVoxelList) uploadVoxelData();
+    if (desc.usesOctree) {
+        uploadOctreeData();
+        uploadDebrisData();
+    }
+
+    // Same view as the ray caster's getCameraRay() and the point splat projection
+    float aspect = static_cast<float>(width) / static_cast<float>(height > 0 ? height : 1);
+    glm::mat4 viewProjection = glm::perspective(glm::radians(fov), aspect, 0.1f, 10000.0f) *
+                               glm::lookAt(cameraPos, cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromViewProjection(viewProjection);
+
+    // Occlusion tests use the last frame's depth, reprojected into this view
+    bool occlusion = viewCulling && occlusionCulling && backend != RenderBackend::PointSplat &&
+                     hiz.build(viewProjection);
+
+    if (backend == RenderBackend::ChunkMesh) {
+        chunkMeshes.render(viewProjection, frustum, cameraPos, cullDistance, viewCulling, hiz, occlusion, useVoxelColor);
+        cullStats = chunkMeshes.getStats();
+        if (viewCulling && occlusionCulling) hiz.captureDepth(width, height, viewProjection);
+        return;
+    }
+
+    if (backend == RenderBackend::PointSplat) {
+        if (voxelCount == 0 || ssbo == 0) return;
+
+        // Visible chunks as draw ranges; neighbouring chunks are adjacent in the list
+        drawFirst.clear();
+        drawCount.clear();
+        if (viewCulling) {
+            cullStats = voxelChunks.cull(frustum, cameraPos, cullDistance, visibleList);
+        } else {
+            visibleList.resize(chunkFirst.size());
+            for (size_t i = 0; i < visibleList.size(); ++i) visibleList[i] = static_cast<uint32_t>(i);
+            cullStats = CullStats();
+            cullStats.total = cullStats.visible = static_cast<int>(chunkFirst.size());
+        }
+        for (uint32_t chunk : visibleList) {
+            if (!drawFirst.empty() && drawFirst.back() + drawCount.back() == chunkFirst[chunk]) {
+                drawCount.back() += chunkCount[chunk];
+            } else {
+                drawFirst.push_back(chunkFirst[chunk]);
+                drawCount.push_back(chunkCount[chunk]);
+            }
+        }
+        if (drawFirst.empty()) return;
+
+        pointShader->use();
+        pointShader->setMat4("u_viewProjection", viewProjection);
+        pointShader->setFloat("u_pointScale", static_cast<float>(height) / (2.0f * glm::tan(glm::radians(fov) * 0.5f)));
+        pointShader->setBool("u_useVoxelColor", useVoxelColor);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VOXEL_LIST_BINDING, ssbo);
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(emptyVAO);
+        glMultiDrawArrays(GL_POINTS, drawFirst.data(), drawCount.data(), static_cast<GLsizei>(drawFirst.size()));
+        glBindVertexArray(0);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        glDisable(GL_DEPTH_TEST);
+        return;
+    }
+
+    // Top-level candidates: the scene octree (index 0), then every shown debris piece.
+    // Primary rays only test the visible ones; shadow and AO rays still see them all.
+    std::vector<const Debris*> shown;
+    rayCandidates.clear();
+    rayCandidates.add(octreeBoundsMin, octreeBoundsMax);
+    for (const Debris& d : debris) {
+        if (editor.versionState(d.version) != OctreeEditor::VersionState::Shown) continue;
+        rayCandidates.add(d.boundsMin + d.offset, d.boundsMax + d.offset);
+        shown.push_back(&d);
+        if (shown.size() == static_cast<size_t>(MAX_DEBRIS_OBJECTS)) break;
+    }
+    std::vector<uint8_t> visible(rayCandidates.size(), 1);
+    if (viewCulling) {
+        cullStats = rayCandidates.cull(frustum, cameraPos, cullDistance, visibleList);
+        std::fill(visible.begin(), visible.end(), 0);
+        for (uint32_t i : visibleList) visible[i] = 1;
+    } else {
+        cullStats = CullStats();
+        cullStats.total = cullStats.visible = static_cast<int>(rayCandidates.size());
+    }
+
+    // Visible pieces first so primary rays stop at the primary count
+    std::vector<const Debris*> slots;
+    for (int pass = 1; pass >= 0; --pass) {
+        for (size_t i = 0; i < shown.size(); ++i) {
+            if (visible[i + 1] == pass) slots.push_back(shown[i]);
+        }
+    }
+    const int primaryCount = static_cast<int>(std::count(visible.begin() + 1, visible.end(), 1));
 
+    // Visible pieces hidden behind the last frame's depth get their flag cleared for primary rays
+    std::vector<glm::vec3> primaryBoxes;
+    for (int i = 0; i < primaryCount; ++i) {
+        primaryBoxes.push_back(slots[i]->boundsMin + slots[i]->offset);
+        primaryBoxes.push_back(slots[i]->boundsMax + slots[i]->offset);
+    }
+    debrisOcclusion.cull(primaryBoxes, hiz, occlusion);
+    if (occlusion) {
+        cullStats.occlusionCulled = std::min(debrisOcclusion.getOccludedCount(), cullStats.visible);
+        cullStats.visible -= cullStats.occlusionCulled;
+    }
+
+    // Blue noise offset of the per-pixel AO rays (animateNoise)
+    ++noiseFrame;
+    bool coneTracing = false;
+
+    // Uniforms of raycast_common.glsl, for the ray caster, the deferred passes and edge resolve
+    auto setTraceUniforms = [&](const Shader& s) {
+        s.setVec3("u_cameraPos", cameraPos);
+        s.setVec3("u_cameraTarget", cameraTarget);
+        s.setFloat("u_fov", fov);
+        s.setVec2("u_resolution", glm::vec2(width, height));
+        s.setMat4("u_viewProjection", viewProjection);
+        s.setVec3("u_octreeMin", octreeBoundsMin);
+        s.setVec3("u_octreeMax", octreeBoundsMax);
+        s.setBool("u_shadow", shadow);
+        s.setInt("u_aoSampleCount", aoSampleCount);
+        s.setBool("u_useVoxelColor", useVoxelColor);
+        blueNoise.bind(s, BLUE_NOISE_TEXTURE_UNIT, animateNoise ? noiseFrame : 0u);
+        radiance.bind(s, RADIANCE_VOLUME_TEXTURE_UNIT, coneTracing);
+        s.setFloat("u_coneDistance", coneDistance);
+        s.setFloat("u_giStrength", giStrength);
+        const int lightTotal = std::max(0, std::min(lightCount, MAX_LIGHTS));
+        for (int i = 0; i < lightTotal; ++i) {
+            std::string index = "[" + std::to_string(i) + "]";
+            const glm::vec3& d = lights[i].direction;
+            s.setVec3("u_lightDir" + index, glm::dot(d, d) > 0.0f ? glm::normalize(d) : glm::vec3(0.0f, 1.0f, 0.0f));
+            s.setVec3("u_lightColor" + index, lights[i].color);
+        }
+        s.setInt("u_lightCount", lightTotal);
+        s.setBool("u_sceneVisible", visible[0] != 0);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            std::string index = "[" + std::to_string(i) + "]";
+            s.setVec3("u_debrisMin" + index, slots[i]->boundsMin + slots[i]->offset);
+            s.setVec3("u_debrisMax" + index, slots[i]->boundsMax + slots[i]->offset);
+            s.setUint("u_debrisRoot" + index, slots[i]->gpuRoot);
+        }
+        s.setInt("u_debrisPrimaryCount", primaryCount);
+        s.setInt("u_debrisCount", static_cast<int>(slots.size()));
+    };
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OCTREE_BINDING, octreeSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEBRIS_BINDING, debrisSSBO);
+
+    // Progressive path tracing; the view is checked by the tracer, everything
+    // else that changes the image restarts the accumulation here
+    if (backend == RenderBackend::PathTrace) {
+        std::vector<float> key = {static_cast<float>(lightCount), useVoxelColor ? 1.0f : 0.0f,
+                                  static_cast<float>(pathSettings.maxBounces), pathSettings.emissionScale,
+                                  static_cast<float>(primaryCount), visible[0] != 0 ? 1.0f : 0.0f};
+        for (int i = 0; i < std::min(lightCount, MAX_LIGHTS); ++i) {
+            key.insert(key.end(), {lights[i].direction.x, lights[i].direction.y, lights[i].direction.z,
+                                   lights[i].color.r, lights[i].color.g, lights[i].color.b});
+        }
+        for (const Debris* d : slots) {
+            glm::vec3 position = d->boundsMin + d->offset;
+            key.insert(key.end(), {position.x, position.y, position.z});
+        }
+        if (sceneChanged || key != pathTraceKey) {
+            pathTracer.invalidate();
+            pathTraceKey = std::move(key);
+        }
+        pathTracer.render(width, height, viewProjection, pathSettings, setTraceUniforms);
+        return;
+    }
+
+    // Cone traced GI: refresh a few slices of the radiance volume before anything samples it
+    if (coneTracedGI && !editor.rootEmpty()) {
+        radiance.update(octreeBoundsMax.x - octreeBoundsMin.x, giSlicesPerFrame, setTraceUniforms);
+        coneTracing = true;
+    } else if (!coneTracedGI) {
+        radiance.release();
+    }
+
+    // Deferred: traverse once per pixel, then shade only the hit pixels
+    if (deferredShading) {
+        deferred.visibility(width, height, VAO, setTraceUniforms);
+        if (viewCulling && occlusionCulling)
+            hiz.captureDepth(width, height, viewProjection, deferred.getFramebuffer());
+        deferred.shade(setTraceUniforms, aoDenoiseIterations, coneTracing);
+        if (edgeSamples > 0) {
+            edgeAA.resolve(deferred.getColorTexture(), deferred.getSurfaceIdTexture(), width, height, edgeSamples,
+                           setTraceUniforms, deferred.getOcclusionTexture());
+        }
+        deferred.present();
+        return;
+    }
+
+    // With edge supersampling the frame is cast offscreen, next to its surface ids
+    const bool supersample = edgeSamples > 0;
+    if (supersample) edgeAA.begin(width, height);
     shader->use();
-    shader->setVec3("u_cameraPos", cameraPos);
-    shader->setVec3("u_cameraTarget", cameraTarget);
-    shader->setFloat("u_fov", fov);
-    shader->setVec2("u_resolution", glm::vec2(width, height));
-    shader->setFloat("u_voxelSize", 1.0f);
-    shader->setVec3("u_octreeMin", octreeBoundsMin);
-    shader->setVec3("u_octreeMax", octreeBoundsMax);
-    shader->setBool("u_shadow", shadow);
-    shader->setInt("u_aoSampleCount", aoSampleCount);
-    shader->setBool("u_useVoxelColor", useVoxelColor);
-
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, octreeSSBO);
+    setTraceUniforms(*shader);
 
+    // Hits write their depth for the next frame's Hi-Z pyramid
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_ALWAYS);
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_DEPTH_TEST);
+    if (viewCulling && occlusionCulling)
+        hiz.captureDepth(width, height, viewProjection, supersample ? edgeAA.getFramebuffer() : 0);
+
+    if (supersample) {
+        edgeAA.resolve(edgeSamples, setTraceUniforms);
+        edgeAA.end();
+    }
 }
 
 void VoxelRenderer::cleanup()
 {
     if (VAO != 0) { glDeleteVertexArrays(1, &VAO); VAO = 0; }
-    if (VBO != 0) { glDeleteBuffers(1, &VBO); VBO = 0; }
-    if (ssbo != 0) { glDeleteBuffers(1, &ssbo); ssbo = 0; }
-    if (octreeSSBO != 0) { glDeleteBuffers(1, &octreeSSBO); octreeSSBO = 0; }
+    if (emptyVAO != 0) { glDeleteVertexArrays(1, &emptyVAO); emptyVAO = 0; }
+    freeGLBuffer(VBO);
+    freeGLBuffer(ssbo);
+    freeGLBuffer(octreeSSBO);
+    freeGLBuffer(debrisSSBO);
     if (shader != nullptr) { delete shader; shader = nullptr; }
+    if (pointShader != nullptr) { delete pointShader; pointShader = nullptr; }
+    gpuBuilder.cleanup();
+    chunkMeshes.cleanup();
+    hiz.cleanup();
+    debrisOcclusion.cleanup();
+    edgeAA.cleanup();
+    deferred.cleanup();
+    pathTracer.cleanup();
+    blueNoise.cleanup();
+    radiance.cleanup();
+}
+
+void VoxelRenderer::setVoxels(const VoxelList& voxels)
+{
+    setVoxels(voxels, GPUNodeList(), glm::vec3(0.0f), glm::vec3(0.0f));
+}
+
+void VoxelRenderer::setVoxels(const VoxelList& voxels, GPUNodeList&& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    PROFILE_FUNCTION();
+    voxelCount = static_cast<int>(voxels.size());
+    editor = OctreeEditor();
+    octreeEdited = false;
+    clearDebris();
+    hiz.invalidate();
+    radiance.invalidate();
+
+    // The flat list is only needed by backends that read SSBO binding 0
+    if (backendDesc(backend).usesVoxelList) buildVoxelList(voxels);
+    else releaseVoxelList();
+    if (backendDesc(backend).usesChunkMeshes) buildChunkMeshes(voxels);
+    else chunkMeshes.release();
+    materials.build(voxels);
+    pathTracer.setMaterials(materials);
+
+    // Build octree from voxels, on the GPU when enabled and the scene fits
+    octreeBuiltOnGpu = false;
+    if (gpuOctreeBuild && !voxels.empty()) {
+        computeOctreeBounds(voxels, octreeBoundsMin, octreeBoundsMax);
+        if (gpuBuilder.build(voxels, octreeBoundsMin, octreeBoundsMax, octreeSSBO)) {
+            releaseVector(octreeData);
+            octreeDataDirty = false;
+            octreeBuiltOnGpu = true;
+            std::cout << "Built octree on GPU: " << voxels.size() << " voxels, node capacity "
+                      << gpuBuilder.getNodeCapacity() << std::endl;
+            return;
+        }
+        std::cout << "Scene exceeds GPU octree builder limits, using CPU builder" << std::endl;
+    }
+
+    if (nodes.empty()) {
+        buildOctreeFromVoxels(voxels);
+    } else {
+        octreeBoundsMin = boundsMin;
+        octreeBoundsMax = boundsMax;
+        octreeData = std::move(nodes);
+    }
+    octreeDataDirty = true;
+}
+
+void VoxelRenderer::setOctree(GPUNodeList&& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax, int solidCount)
+{
+    PROFILE_FUNCTION();
+    voxelCount = solidCount;
+    editor = OctreeEditor();
+    octreeEdited = false;
+    clearDebris();
+    hiz.invalidate();
+    radiance.invalidate();
+    releaseVoxelList();
+    chunkMeshes.release();
+    materials.clear();
+    pathTracer.setMaterials(materials);
+    if (backendDesc(backend).needsVoxels()) {
+        std::cout << backendDesc(backend).name << " needs a voxel list; volumes only render with octree backends" << std::endl;
+    }
+
+    octreeBuiltOnGpu = false;
+    octreeBoundsMin = boundsMin;
+    octreeBoundsMax = boundsMax;
+    octreeData = std::move(nodes);
+    octreeDataDirty = true;
+}
+
+bool VoxelRenderer::validateGpuOctree(const VoxelList& voxels)
+{
+    if (!octreeBuiltOnGpu) {
+        std::cerr << "GPU octree validation: current octree was not built on the GPU" << std::endl;
+        return false;
+    }
+
+    glm::vec3 bmin, bmax;
+    computeOctreeBounds(voxels, bmin, bmax);
+    GPUNodeList reference;
+    flattenOctree(buildOctree(voxels, bmin, bmax, 0), reference);
+    return GpuOctreeBuilder::validate(octreeSSBO, reference);
+}
+
+void VoxelRenderer::setBackend(RenderBackend newBackend, const VoxelList& voxels)
+{
+    if (newBackend == backend) return;
+    backend = newBackend;
+    hiz.invalidate();
+
+    if (!backendDesc(backend).usesVoxelList) {
+        releaseVoxelList();
+    } else if (voxelData.empty() && !voxels.empty()) {
+        buildVoxelList(voxels);
+    }
+
+    if (!backendDesc(backend).usesChunkMeshes) {
+        chunkMeshes.release();
+    } else if (chunkMeshes.empty() && !voxels.empty()) {
+        buildChunkMeshes(voxels);
+    }
+}
+
+void VoxelRenderer::buildChunkMeshes(const VoxelList& voxels)
+{
+    std::vector<uint32_t> palette;
+    std::vector<ChunkMesh> meshes = ChunkMesher::build(voxels, palette);
+    chunkMeshes.upload(meshes, palette);
 }
 
-void VoxelRenderer::setVoxels(const std::vector<Voxel>& voxels)
+void VoxelRenderer::buildVoxelList(const VoxelList& voxels)
 {
+    PROFILE_FUNCTION();
     voxelData.clear();
     voxelData.reserve(voxels.size());
     for (const auto& v : voxels)
     {
         GPUVoxel gv;
-        gv.posAndSize = glm::vec4(glm::vec3(v.getPosition()), 0.0f);
+        gv.posAndSize = glm::vec4(glm::vec3(v.getPosition()), 1.0f);
         gv.color = v.getColor();
         voxelData.push_back(gv);
     }
     voxelDataDirty = true;
+}
 
-    // Build octree from voxels
-    buildOctreeFromVoxels(voxels);
-    octreeDataDirty = true;
+void VoxelRenderer::releaseVoxelList()
+{
+    releaseVector(voxelData);
+    voxelDataDirty = false;
+    voxelChunks.clear();
+    chunkFirst.clear();
+    chunkCount.clear();
+    freeGLBuffer(ssbo);
+}
+
+void VoxelRenderer::releaseCpuMirrors()
+{
+    if (!voxelDataDirty) releaseVector(voxelData);
+    if (!octreeDataDirty) releaseVector(octreeData);
 }
 
 void VoxelRenderer::addVoxel(const Voxel& voxel)
 {
+    ++voxelCount;
+    if (!backendDesc(backend).usesVoxelList) return;
+
     GPUVoxel gv;
-    gv.posAndSize = glm::vec4(glm::vec3(voxel.getPosition()), 0.0f);
+    gv.posAndSize = glm::vec4(glm::vec3(voxel.getPosition()), 1.0f);
     gv.color = voxel.getColor();
     voxelData.push_back(gv);
     voxelDataDirty = true;
@@ -318,5 +977,6 @@ void VoxelRenderer::addVoxel(const Voxel& voxel)
 void VoxelRenderer::clearVoxels()
 {
     voxelData.clear();
-    voxelDataDirty = true;
+    voxelCount = 0;
+    voxelDataDirty = backendDesc(backend).usesVoxelList;
 }
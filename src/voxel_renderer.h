@@ -8,16 +8,53 @@
 #include <memory>
 #include "shader.h"
 #include "voxel.h"
+#include "octree.h"
+#include "gpu_octree_builder.h"
+#include "octree_query.h"
+#include "octree_editor.h"
+#include "octree_csg.h"
+#include "octree_components.h"
+#include "chunk_culling.h"
+#include "chunk_mesh_renderer.h"
+#include "hiz_culling.h"
+#include "edge_supersampler.h"
+#include "deferred_shading.h"
+#include "radiance_volume.h"
+#include "path_tracer.h"
+#include "sampling.h"
+#include "lighting.h"
 
-struct OctreeNode {
-    uint8_t childMask = 0;
-    std::shared_ptr<OctreeNode> children[8];
-    glm::vec4 color = glm::vec4(0.0f);
-    bool leaf = false;
-}; // only for cpu & memory.
+/**
+ * Render paths. Each backend declares which SSBOs it consumes (see
+ * backendDesc()); data for unused bindings is neither built nor uploaded.
+ */
+enum class RenderBackend {
+    RayCast,     // Octree ray casting (raymarching.frag), octree SSBO only
+    PointSplat,  // Debug view: one point per voxel from the flat voxel SSBO
+    ChunkMesh,   // Rasterized chunk meshes, culled and drawn GPU-driven (ChunkMeshRenderer)
+    PathTrace,   // Progressive path tracing over the octree SSBOs (PathTracer)
+    Count
+};
+
+// SSBO binding points shared with the shaders
+constexpr GLuint VOXEL_LIST_BINDING = 0;
+constexpr GLuint OCTREE_BINDING = 1;
+constexpr GLuint DEBRIS_BINDING = 2;
+
+// Debris objects the ray caster draws (MAX_DEBRIS in raymarching.frag)
+constexpr int MAX_DEBRIS_OBJECTS = 32;
 
-bool allPointsSameColor(const std::vector<Voxel>& points);
-std::shared_ptr<OctreeNode> buildOctree(const std::vector<Voxel>& points, glm::vec3 min, glm::vec3 max, int depth);
+struct RenderBackendDesc {
+    const char* name;
+    bool usesVoxelList;  // SSBO binding 0 (GPUVoxel[])
+    bool usesOctree;     // SSBO binding 1 (GPUNode[]) and the debris nodes at binding 2
+    bool usesChunkMeshes; // Meshed chunks (ChunkMeshRenderer), SSBO bindings 3-5
+
+    // Backends that are built from a voxel list rather than an octree
+    bool needsVoxels() const { return usesVoxelList || usesChunkMeshes; }
+};
+
+const RenderBackendDesc& backendDesc(RenderBackend backend);
 
 class VoxelRenderer
 {
@@ -34,26 +71,193 @@ public:
     void setCameraTarget(const glm::vec3& target) { cameraTarget = target; }
     void setFOV(float fovValue) { this->fov = fovValue; }
 
-    void setVoxels(const std::vector<Voxel>& voxels);
+    void setVoxels(const VoxelList& voxels);
+    /**
+     * As setVoxels(), with the CPU octree of voxels already built off the GL
+     * thread (e.g. by a loader job); nodes may be empty to build it here. The
+     * GPU builder, when enabled and the scene fits, still takes precedence.
+     */
+    void setVoxels(const VoxelList& voxels, GPUNodeList&& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    /**
+     * Render a prebuilt octree (e.g. from VolumeImporter) without a voxel list;
+     * backends that need the flat voxel list have nothing to draw
+     */
+    void setOctree(GPUNodeList&& nodes, const glm::vec3& boundsMin, const glm::vec3& boundsMax, int solidCount);
+    /**
+     * Switch render path. The flat voxel list and the chunk meshes are built
+     * from voxels when the new backend consumes them and freed (CPU and GPU)
+     * when it does not.
+     */
+    void setBackend(RenderBackend newBackend, const VoxelList& voxels);
+    RenderBackend getBackend() const { return backend; }
+
+    /**
+     * Rebuild the octree on the CPU and compare it with the current GPU-built
+     * octree SSBO (only meaningful while gpuOctreeBuild is active)
+     */
+    bool validateGpuOctree(const VoxelList& voxels);
     void addVoxel(const Voxel& voxel);
     void clearVoxels();
-    int getVoxelCount() const { return static_cast<int>(voxelData.size()); }
+    int getVoxelCount() const { return voxelCount; }
+    void releaseCpuMirrors(); // free CPU copies that are already uploaded
+
+    /**
+     * Queue a brush stroke on the CPU octree. Strokes are applied a few bricks
+     * per frame in render() and only the changed node ranges are uploaded.
+     * @return false if there is no CPU octree to edit (GPU-built octree,
+     *         low memory mode or a backend that does not draw the octree)
+     */
+    bool applyBrush(const Brush& brush);
+    /**
+     * Close the current edit (all strokes since the last endEdit) as one undo step
+     */
+    void endEdit();
+    /**
+     * Step through the edit history; each step uploads only the root node
+     */
+    bool undoEdit();
+    bool redoEdit();
+    bool canUndo() const { return editor.canUndo(); }
+    bool canRedo() const { return editor.canRedo(); }
+    bool isEditing() const { return editor.busy(); }
+    bool hasEdits() const { return octreeEdited; }
+    /**
+     * Replace the current octree with `current op other` (see OctreeCSG) as
+     * one undo step; a union reaching outside the bounds grows them
+     * @return false if there is no CPU octree to edit (as applyBrush) or a
+     *         stroke is still running
+     * @throws std::runtime_error if the result does not fit the octree format
+     */
+    bool applyCsg(OctreeCSG::Op op, const OctreeCSG::Operand& other);
+    /**
+     * Expand the edited octree back into a voxel list (e.g. for saving)
+     */
+    void extractVoxels(VoxelList& out) const;
+
+    /**
+     * Let debris fall; it stops where its voxels would enter the scene and is
+     * dropped once it falls far below it
+     */
+    void updateDebris(float deltaTime);
+    int getDebrisCount() const { return static_cast<int>(debris.size()); }
+
+    /**
+     * Culling counters of the last frame: voxel chunks for the point splat
+     * backend, the scene octree and debris pieces for ray casting, mesh
+     * chunks (a few frames late, see ChunkMeshRenderer) for chunk meshes.
+     * Occlusion counts are read back from the GPU a few frames late.
+     */
+    const CullStats& getCullStats() const { return cullStats; }
+    /**
+     * Pixels re-traced by edge supersampling a few frames ago
+     */
+    int getEdgePixelCount() const { return edgeSamples > 0 ? edgeAA.getEdgeCount() : 0; }
+    /**
+     * Pixels the deferred shading passes ran over a few frames ago
+     */
+    int getHitPixelCount() const { return deferredShading ? deferred.getHitCount() : 0; }
+    /**
+     * GPU time of a deferred shading pass (DeferredShading::TimedPass) a few frames ago
+     */
+    double getDeferredPassMilliseconds(int pass) const { return deferred.getPassMilliseconds(pass); }
+    /**
+     * Radiance volume side in texels (0 while cone tracing is off) and the GPU
+     * time of its passes (RadianceVolume::TimedPass) a few frames ago
+     */
+    int getRadianceResolution() const { return radiance.getResolution(); }
+    double getRadiancePassMilliseconds(int pass) const { return radiance.getPassMilliseconds(pass); }
+
+    /**
+     * Path tracer progress: paths per pixel so far, paths per second and the
+     * mean relative standard error (a few frames late)
+     */
+    int getPathSampleCount() const { return pathTracer.getSampleCount(); }
+    double getPathSamplesPerSecond() const { return pathTracer.getSamplesPerSecond(); }
+    float getPathRelativeError() const { return pathTracer.getRelativeError(); }
+    /**
+     * Path trace the current view on the CPU (PathTracer::renderReference,
+     * scene octree only) with pathSettings and the lights
+     * @return false if there is no CPU octree
+     */
+    bool renderPathReference(int width, int height, int samples, std::vector<glm::vec3>& out) const;
+
+    /**
+     * AO noise against rays per pixel for the current view on the CPU
+     * (measureAoConvergence, scene octree only)
+     * @return false if there is no CPU octree
+     */
+    bool measureAoConvergence(int width, int height, std::vector<AoErrorPoint>& out) const;
+
+    /**
+     * CPU query view over the current octree. Empty when there is no CPU
+     * mirror (GPU-built octree or released in low memory mode); invalidated
+     * by the next setVoxels/setOctree.
+     */
+    OctreeQuery getQuery() const {
+        return OctreeQuery(octreeData.data(), editor.rootEmpty() ? 0 : octreeData.size(), octreeBoundsMin, octreeBoundsMax);
+    }
 
     // public render state
     bool shadow;
     int aoSampleCount;
     bool useVoxelColor;
+    bool lowMemoryMode; // drop CPU mirrors once their data is resident on the GPU
+    bool gpuOctreeBuild; // build the octree with compute shaders (no CPU mirror)
+    float editBudgetMs;  // CPU time per frame spent applying brush strokes
+    bool detachDebris;   // cut pieces that removals leave floating out of the scene as debris
+    bool viewCulling;    // skip chunks / objects outside the view frustum or beyond cullDistance
+    float cullDistance;  // 0 = no distance limit
+    bool occlusionCulling; // with viewCulling: also skip chunks / debris behind the last frame's depth (Hi-Z)
+    int edgeSamples;     // ray casting: rays per edge pixel (4 or 8), 0 = no edge supersampling
+    bool deferredShading; // ray casting: visibility pass, then AO and lighting over the hit pixels only
+    int aoDenoiseIterations; // deferred: à-trous iterations over per-pixel AO, 0 = per-voxel AO unfiltered
+    bool animateNoise;   // per-pixel AO: new blue noise offset every frame instead of the same rays
+    bool coneTracedGI;   // ray casting: bounced light and ambient occlusion from cones through a radiance volume
+    int giSlicesPerFrame; // radiance volume z slices re-injected per frame
+    float giStrength;    // scale of the cone traced bounced light
+    float coneDistance;  // furthest a GI cone travels, in voxels
+    DirectionalLight lights[MAX_LIGHTS];
+    int lightCount;      // lights[0, lightCount) are shaded, each with a shadow ray
+    PathTraceSettings pathSettings;
 
 private:
     void setupQuad();
+    void buildVoxelList(const VoxelList& voxels);
+    void releaseVoxelList();
+    void buildChunkMeshes(const VoxelList& voxels);
+    void buildVoxelChunks();
     void uploadVoxelData();
     void uploadOctreeData();
-    void buildOctreeFromVoxels(const std::vector<Voxel>& points);
+    void buildOctreeFromVoxels(const VoxelList& points);
+    void stepEdits();
+    void applyVoxelDelta();
+    void findDebris();
+    void uploadDebrisData();
+    void clearDebris();
+    void wakeDebris();
+    bool debrisOverlapsScene(const OctreeQuery& scene, size_t index, const glm::vec3& offset) const;
 
     Shader* shader;
+    Shader* pointShader;
     GLuint VAO, VBO;
-    GLuint ssbo;
+    GLuint emptyVAO;   // attribute-less draws (point splat)
+    GLuint ssbo;       // flat voxel list, only allocated for backends that use it
     GLuint octreeSSBO;
+    GLuint debrisSSBO;
+    RenderBackend backend;
+    GpuOctreeBuilder gpuBuilder;
+    ChunkMeshRenderer chunkMeshes;
+    HiZPyramid hiz;
+    HiZInstanceCuller debrisOcclusion;
+    EdgeSupersampler edgeAA;
+    DeferredShading deferred;
+    PathTracer pathTracer;
+    MaterialTable materials;
+    std::vector<float> pathTraceKey;  // Lights, settings and debris placement the accumulation was started with
+    BlueNoise blueNoise;
+    RadianceVolume radiance;
+    uint32_t noiseFrame;
+    bool octreeBuiltOnGpu;
 
     glm::vec3 cameraPos;
     glm::vec3 cameraTarget;
@@ -66,16 +270,47 @@ private:
         glm::vec4 color;       // rgba
     };
 
-    struct GPUNode
-    {
-        uint32_t childMask;
-        uint32_t color; // Packed RGBA as uint32_t
-    };
-
-    std::vector<GPUVoxel> voxelData;
-    std::vector<GPUNode> octreeData;
+    TrackedVector<GPUVoxel, MemoryTag::VoxelMirror> voxelData;
+    // The flat list sorted into VOXEL_CHUNK_SIZE^3 chunks, one draw range each
+    ChunkCuller voxelChunks;
+    std::vector<GLint> chunkFirst;
+    std::vector<GLsizei> chunkCount;
+    // Per-frame culling results
+    ChunkCuller rayCandidates;       // scene octree, then the shown debris pieces
+    std::vector<uint32_t> visibleList;
+    std::vector<GLint> drawFirst;
+    std::vector<GLsizei> drawCount;
+    CullStats cullStats;
+    GPUNodeList octreeData;
+    int voxelCount;
     bool voxelDataDirty;
-    bool octreeDataDirty;
+    bool octreeDataDirty;      // full octree upload pending
+    size_t octreeGpuCapacity;  // nodes the octree SSBO can hold, including edit slack
+    OctreeEditor editor;
+    bool octreeEdited;
+
+    /**
+     * A piece cut out of the scene, drawn from its own octree at an offset.
+     * It belongs to the edit that removed it and is only shown while that
+     * edit is (not after undoing it).
+     */
+    struct Debris {
+        GPUNodeList nodes;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec3 offset;
+        float velocity;                 // Along y
+        bool resting;
+        uint64_t version;
+        uint32_t gpuRoot;               // Root index in the debris SSBO
+        std::vector<QueryLeaf> leaves;  // Collision shape
+    };
+    std::vector<Debris> debris;
+    bool debrisDataDirty;
+    bool debrisCheckPending;   // edit finished, look for detached pieces once its strokes are applied
+    bool debrisRegionValid;
+    glm::ivec3 debrisRegionMin;  // voxels removed since the last check
+    glm::ivec3 debrisRegionMax;
 
     // Octree world-space bounds (power-of-two aligned cube)
     glm::vec3 octreeBoundsMin = glm::vec3(-128.0f);
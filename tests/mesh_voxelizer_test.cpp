@@ -0,0 +1,68 @@
+/**
+ * MeshVoxelizer determinism: a mesh large enough to be binned by several
+ * jobs (over 16K triangles) must voxelize to the same voxels every time,
+ * colors included, since the first triangle in file order that touches a
+ * cell decides its color.
+ */
+
+#include <cstdio>
+#include <random>
+#include "mesh_voxelizer.h"
+
+namespace {
+
+// Many small, differently colored triangles crowded into a small grid, so
+// most cells are touched by several of them
+MeshData crowdedMesh(size_t triangles) {
+    MeshData mesh;
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> position(0.0f, 64.0f);
+    std::uniform_real_distribution<float> spread(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+    for (size_t t = 0; t < triangles; ++t) {
+        glm::vec3 anchor(position(rng), position(rng), position(rng));
+        glm::vec4 color(channel(rng), channel(rng), channel(rng), 1.0f);
+        for (int v = 0; v < 3; ++v) {
+            mesh.indices.push_back(static_cast<uint32_t>(mesh.positions.size()));
+            mesh.positions.push_back(anchor + glm::vec3(spread(rng), spread(rng), spread(rng)));
+            mesh.colors.push_back(color);
+        }
+    }
+    return mesh;
+}
+
+bool sameVoxels(const VoxelList& a, const VoxelList& b) {
+    if (a.size() != b.size()) {
+        std::printf("voxel count %zu != %zu\n", a.size(), b.size());
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].getPosition() != b[i].getPosition() || a[i].getColor() != b[i].getColor()) {
+            std::printf("voxel %zu differs\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    const MeshData mesh = crowdedMesh(100 * 1024);
+    MeshVoxelizer::Options options;
+    options.resolution = 64;
+    options.buildPalette = false;
+
+    VoxelList first;
+    MeshVoxelizer::voxelize(mesh, options, first);
+    for (int run = 1; run < 4; ++run) {
+        VoxelList again;
+        MeshVoxelizer::voxelize(mesh, options, again);
+        if (!sameVoxels(first, again)) {
+            std::printf("FAILED: run %d differs from run 0\n", run);
+            return 1;
+        }
+    }
+    std::printf("passed: %zu triangles, %zu voxels, identical over 4 runs\n", mesh.triangleCount(), first.size());
+    return 0;
+}